@@ -124,6 +124,100 @@ inline void ConvPerChannel(
   }
 }
 
+// Same as the int8 ConvPerChannel above, for a kFilterHeight x kFilterWidth
+// filter, a stride of kStride in both dimensions and no dilation. The filter
+// loops have compile-time bounds so that the compiler can unroll them, and
+// the accumulation order is unchanged so the results are bit-exact.
+template <int kFilterHeight, int kFilterWidth, int kStride>
+inline void ConvPerChannelWithFilterShape(
+    const ConvParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data) {
+  const int32_t input_offset = params.input_offset;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  const int32_t output_offset = params.output_offset;
+  const int32_t output_activation_min = params.quantized_activation_min;
+  const int32_t output_activation_max = params.quantized_activation_max;
+
+  TFLITE_DCHECK_EQ(params.stride_height, kStride);
+  TFLITE_DCHECK_EQ(params.stride_width, kStride);
+  TFLITE_DCHECK_EQ(params.dilation_height_factor, 1);
+  TFLITE_DCHECK_EQ(params.dilation_width_factor, 1);
+  TFLITE_DCHECK_LE(output_activation_min, output_activation_max);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.Dims(1), kFilterHeight);
+  TFLITE_DCHECK_EQ(filter_shape.Dims(2), kFilterWidth);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  if (bias_data) {
+    TFLITE_DCHECK_EQ(bias_shape.FlatSize(), output_depth);
+  }
+
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int filter_size = kFilterHeight * kFilterWidth * input_depth;
+  for (int batch = 0; batch < batches; ++batch) {
+    const int8_t* input_batch =
+        input_data + batch * input_height * input_width * input_depth;
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int in_y_origin = (out_y * kStride) - pad_height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin = (out_x * kStride) - pad_width;
+        int8_t* output_ptr =
+            output_data + Offset(output_shape, batch, out_y, out_x, 0);
+        for (int out_channel = 0; out_channel < output_depth; ++out_channel) {
+          const int8_t* filter_ptr = filter_data + out_channel * filter_size;
+          int32_t acc = 0;
+          for (int filter_y = 0; filter_y < kFilterHeight; ++filter_y) {
+            const int in_y = in_y_origin + filter_y;
+            for (int filter_x = 0; filter_x < kFilterWidth; ++filter_x) {
+              const int in_x = in_x_origin + filter_x;
+
+              // Zero padding by omitting the areas outside the image.
+              const bool is_point_inside_image =
+                  (in_x >= 0) && (in_x < input_width) && (in_y >= 0) &&
+                  (in_y < input_height);
+
+              if (!is_point_inside_image) {
+                continue;
+              }
+
+              const int8_t* input_ptr =
+                  input_batch + (in_y * input_width + in_x) * input_depth;
+              const int8_t* filter_tap =
+                  filter_ptr + (filter_y * kFilterWidth + filter_x) *
+                                   input_depth;
+              for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
+                acc += filter_tap[in_channel] *
+                       (input_ptr[in_channel] + input_offset);
+              }
+            }
+          }
+
+          if (bias_data) {
+            acc += bias_data[out_channel];
+          }
+          acc = MultiplyByQuantizedMultiplier(
+              acc, output_multiplier[out_channel], output_shift[out_channel]);
+          acc += output_offset;
+          acc = std::max(acc, output_activation_min);
+          acc = std::min(acc, output_activation_max);
+          output_ptr[out_channel] = static_cast<int8_t>(acc);
+        }
+      }
+    }
+  }
+}
+
 // Fixed-point per-channel-quantization convolution reference kernel.
 // 16-bit data and 8-bit filter
 inline void ConvPerChannel(
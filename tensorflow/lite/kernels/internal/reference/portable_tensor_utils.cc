@@ -339,6 +339,109 @@ void PortableMatrixBatchVectorMultiplyAccumulate(
       n_output, output_zp, output);
 }
 
+namespace {
+
+// Requantizes `acc` and adds it to `output` with the rounding and saturation
+// of PortableMatrixBatchVectorMultiplyAccumulateImpl.
+template <typename T>
+inline void RequantizeAccumulate(int32_t acc, int32_t multiplier,
+                                 int32_t shift, int32_t output_zp, T* output) {
+  acc = MultiplyByQuantizedMultiplier(acc, multiplier, shift);
+  acc += output_zp;
+  acc += *output;
+  acc = std::min<int32_t>(std::numeric_limits<T>::max(), acc);
+  acc = std::max<int32_t>(std::numeric_limits<T>::min(), acc);
+  *output = static_cast<T>(acc);
+}
+
+// Computes the rows [start_row, n_output) of every matrix that are left over
+// after the blocks of four rows, one row at a time.
+template <typename T>
+void MultiMatrixRowsMultiplyAccumulate(
+    const int8_t* input_row, int32_t batch, int32_t n_matrices,
+    const int8_t* const* weights, const int32_t* const* biases,
+    const int32_t* multipliers, const int32_t* shifts, int32_t start_row,
+    int32_t n_input, int32_t n_output, int32_t output_zp, T* const* outputs) {
+  for (int row = start_row; row < n_output; ++row) {
+    for (int k = 0; k < n_matrices; ++k) {
+      const int8_t* weights_row = weights[k] + row * n_input;
+      int32_t acc = biases[k][row];
+      for (int col = 0; col < n_input; ++col) {
+        acc += input_row[col] * weights_row[col];
+      }
+      RequantizeAccumulate(acc, multipliers[k], shifts[k], output_zp,
+                           outputs[k] + batch * n_output + row);
+    }
+  }
+}
+
+template <typename T>
+void PortableMultiMatrixBatchVectorMultiplyAccumulateImpl(
+    const int8_t* input, int32_t n_matrices, const int8_t* const* weights,
+    const int32_t* const* biases, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_batch, int32_t n_input, int32_t n_output,
+    int32_t output_zp, T* const* outputs) {
+  constexpr int kRowBlock = 4;
+  const int blocked_rows = n_output - n_output % kRowBlock;
+  for (int batch = 0; batch < n_batch; ++batch) {
+    const int8_t* input_row = input + batch * n_input;
+    for (int row = 0; row < blocked_rows; row += kRowBlock) {
+      for (int k = 0; k < n_matrices; ++k) {
+        const int8_t* weights_row0 = weights[k] + row * n_input;
+        const int8_t* weights_row1 = weights_row0 + n_input;
+        const int8_t* weights_row2 = weights_row1 + n_input;
+        const int8_t* weights_row3 = weights_row2 + n_input;
+        int32_t acc0 = biases[k][row];
+        int32_t acc1 = biases[k][row + 1];
+        int32_t acc2 = biases[k][row + 2];
+        int32_t acc3 = biases[k][row + 3];
+        for (int col = 0; col < n_input; ++col) {
+          const int32_t input_val = input_row[col];
+          acc0 += input_val * weights_row0[col];
+          acc1 += input_val * weights_row1[col];
+          acc2 += input_val * weights_row2[col];
+          acc3 += input_val * weights_row3[col];
+        }
+        T* output = outputs[k] + batch * n_output + row;
+        RequantizeAccumulate(acc0, multipliers[k], shifts[k], output_zp,
+                             output);
+        RequantizeAccumulate(acc1, multipliers[k], shifts[k], output_zp,
+                             output + 1);
+        RequantizeAccumulate(acc2, multipliers[k], shifts[k], output_zp,
+                             output + 2);
+        RequantizeAccumulate(acc3, multipliers[k], shifts[k], output_zp,
+                             output + 3);
+      }
+    }
+    MultiMatrixRowsMultiplyAccumulate(input_row, batch, n_matrices, weights,
+                                      biases, multipliers, shifts,
+                                      blocked_rows, n_input, n_output,
+                                      output_zp, outputs);
+  }
+}
+
+}  // namespace
+
+void PortableMultiMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, int32_t n_matrices, const int8_t* const* weights,
+    const int32_t* const* biases, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_batch, int32_t n_input, int32_t n_output,
+    int32_t output_zp, int16_t* const* outputs) {
+  PortableMultiMatrixBatchVectorMultiplyAccumulateImpl(
+      input, n_matrices, weights, biases, multipliers, shifts, n_batch,
+      n_input, n_output, output_zp, outputs);
+}
+
+void PortableMultiMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, int32_t n_matrices, const int8_t* const* weights,
+    const int32_t* const* biases, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_batch, int32_t n_input, int32_t n_output,
+    int32_t output_zp, int8_t* const* outputs) {
+  PortableMultiMatrixBatchVectorMultiplyAccumulateImpl(
+      input, n_matrices, weights, biases, multipliers, shifts, n_batch,
+      n_input, n_output, output_zp, outputs);
+}
+
 void PortableMatrixBatchVectorMultiply(const int8_t* input,
                                        int32_t input_zeropoint,
                                        const int8_t* input_to_gate_weights,
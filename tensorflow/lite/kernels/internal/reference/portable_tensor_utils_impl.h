@@ -117,6 +117,24 @@ void PortableMatrixBatchVectorMultiplyAccumulate(
     int32_t n_batch, int32_t n_input, int32_t n_output, int32_t output_zp,
     int32_t* scratch, int8_t* output, CpuBackendContext* context);
 
+// Multiplies the same batch of input vectors by `n_matrices` weight matrices
+// of size {n_output, n_input}, such as the gates of a recurrent layer. Four
+// output rows of a matrix are computed at a time, so each input value is
+// loaded once per four rows. Each product k is requantized with
+// multipliers[k] and shifts[k], added to outputs[k] and saturated exactly like
+// PortableMatrixBatchVectorMultiplyAccumulate would.
+void PortableMultiMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, int32_t n_matrices, const int8_t* const* weights,
+    const int32_t* const* biases, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_batch, int32_t n_input, int32_t n_output,
+    int32_t output_zp, int16_t* const* outputs);
+
+void PortableMultiMatrixBatchVectorMultiplyAccumulate(
+    const int8_t* input, int32_t n_matrices, const int8_t* const* weights,
+    const int32_t* const* biases, const int32_t* multipliers,
+    const int32_t* shifts, int32_t n_batch, int32_t n_input, int32_t n_output,
+    int32_t output_zp, int8_t* const* outputs);
+
 void PortableMatrixBatchVectorMultiply(const int8_t* input,
                                        int32_t input_zeropoint,
                                        const int8_t* input_to_gate_weights,
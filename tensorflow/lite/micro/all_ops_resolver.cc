@@ -27,6 +27,7 @@ AllOpsResolver::AllOpsResolver() {
   AddArgMax();
   AddArgMin();
   AddAveragePool2D();
+  AddBatchMatMul();
   AddBatchToSpaceNd();
   AddCeil();
   AddConcatenation();
@@ -94,6 +95,7 @@ AllOpsResolver::AllOpsResolver() {
   AddTanh();
   AddTransposeConv();
   AddTranspose();
+  AddUnidirectionalSequenceLSTM();
   AddUnpack();
 }
 
@@ -0,0 +1,126 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/kernels/internal/reference/portable_tensor_utils_impl.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_time.h"
+#include "tensorflow/lite/micro/system_setup.h"
+
+/*
+ * Recurrent Matmul Benchmark comparing the gate matmuls of an int8 LSTM step
+ * computed one gate at a time against the fused multi-matrix path. The weights
+ * are scrambled, only the timing and the agreement of the two paths are
+ * meaningful.
+ */
+
+namespace tflite {
+
+constexpr int kNumGates = 4;
+constexpr int kNumBatches = 1;
+// Not a multiple of the row block, so the blocked tail is covered too.
+constexpr int kNumCells = 30;
+constexpr int kNumInputs = 64;
+constexpr int kGateSize = kNumBatches * kNumCells;
+
+int8_t input[kNumBatches * kNumInputs];
+int8_t gate_weights[kNumGates][kNumCells * kNumInputs];
+int32_t gate_biases[kNumGates][kNumCells];
+int16_t single_output[kNumGates * kGateSize];
+int16_t fused_output[kNumGates * kGateSize];
+
+const int32_t kMultipliers[kNumGates] = {1518500250, 1276901417, 1859775393,
+                                         1073741824};
+const int32_t kShifts[kNumGates] = {-6, -5, -7, -6};
+
+void InitializeData() {
+  // A linear congruential generator keeps the data identical on all targets.
+  uint32_t seed = 1;
+  auto next = [&seed]() {
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<int8_t>(seed >> 24);
+  };
+  for (int i = 0; i < kNumBatches * kNumInputs; ++i) {
+    input[i] = next();
+  }
+  for (int gate = 0; gate < kNumGates; ++gate) {
+    for (int i = 0; i < kNumCells * kNumInputs; ++i) {
+      gate_weights[gate][i] = next();
+    }
+    for (int i = 0; i < kNumCells; ++i) {
+      gate_biases[gate][i] = next() * 64;
+    }
+  }
+}
+
+void RunSingleMatrix(int16_t* output) {
+  std::memset(output, 0, kNumGates * kGateSize * sizeof(int16_t));
+  for (int gate = 0; gate < kNumGates; ++gate) {
+    tensor_utils::PortableMatrixBatchVectorMultiplyAccumulate(
+        input, gate_biases[gate], gate_weights[gate], kMultipliers[gate],
+        kShifts[gate], kNumBatches, kNumInputs, kNumCells, /*output_zp=*/0,
+        /*scratch=*/nullptr, output + gate * kGateSize, /*context=*/nullptr);
+  }
+}
+
+void RunMultiMatrix(int16_t* output) {
+  const int8_t* weights[kNumGates];
+  const int32_t* biases[kNumGates];
+  int16_t* outputs[kNumGates];
+  for (int gate = 0; gate < kNumGates; ++gate) {
+    weights[gate] = gate_weights[gate];
+    biases[gate] = gate_biases[gate];
+    outputs[gate] = output + gate * kGateSize;
+  }
+  std::memset(output, 0, kNumGates * kGateSize * sizeof(int16_t));
+  tensor_utils::PortableMultiMatrixBatchVectorMultiplyAccumulate(
+      input, kNumGates, weights, biases, kMultipliers, kShifts, kNumBatches,
+      kNumInputs, kNumCells, /*output_zp=*/0, outputs);
+}
+
+template <typename Function>
+void RunNIterations(int iterations, const char* tag, Function function,
+                    int16_t* output) {
+  const int32_t start_ticks = GetCurrentTimeTicks();
+  for (int i = 0; i < iterations; ++i) {
+    function(output);
+  }
+  const int32_t ticks = GetCurrentTimeTicks() - start_ticks;
+  MicroPrintf("%s took %d ticks (%d ms)", tag, ticks, TicksToMs(ticks));
+}
+
+}  // namespace tflite
+
+int main(int argc, char** argv) {
+  tflite::InitializeTarget();
+  tflite::InitializeData();
+
+  constexpr int kIterations = 1000;
+  tflite::RunNIterations(kIterations, "SingleMatrix(1000)",
+                         tflite::RunSingleMatrix, tflite::single_output);
+  tflite::RunNIterations(kIterations, "MultiMatrix(1000)",
+                         tflite::RunMultiMatrix, tflite::fused_output);
+
+  const size_t output_bytes =
+      tflite::kNumGates * tflite::kGateSize * sizeof(int16_t);
+  if (std::memcmp(tflite::single_output, tflite::fused_output, output_bytes) !=
+      0) {
+    MicroPrintf("Fused outputs differ from the single matrix outputs.");
+    return 1;
+  }
+  return 0;
+}
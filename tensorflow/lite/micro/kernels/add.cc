@@ -107,23 +107,26 @@ TfLiteStatus CalculateOpData(TfLiteContext* context, TfLiteAddParams* params,
 void EvalAdd(TfLiteContext* context, TfLiteNode* node, TfLiteAddParams* params,
              const OpData* data, const TfLiteEvalTensor* input1,
              const TfLiteEvalTensor* input2, TfLiteEvalTensor* output) {
+  const RuntimeShape& input1_shape =
+      tflite::micro::GetEvalInputShape(node, kInputTensor1);
+  const RuntimeShape& input2_shape =
+      tflite::micro::GetEvalInputShape(node, kInputTensor2);
+  const RuntimeShape& output_shape =
+      tflite::micro::GetEvalOutputShape(node, kOutputTensor);
   tflite::ArithmeticParams op_params;
   SetActivationParams(data->output_activation_min_f32,
                       data->output_activation_max_f32, &op_params);
   if (data->requires_broadcast) {
     reference_ops::BroadcastAdd4DSlow(
-        op_params, tflite::micro::GetTensorShape(input1),
-        tflite::micro::GetTensorData<float>(input1),
-        tflite::micro::GetTensorShape(input2),
-        tflite::micro::GetTensorData<float>(input2),
-        tflite::micro::GetTensorShape(output),
+        op_params, input1_shape, tflite::micro::GetTensorData<float>(input1),
+        input2_shape, tflite::micro::GetTensorData<float>(input2), output_shape,
         tflite::micro::GetTensorData<float>(output));
   } else {
-    reference_ops::Add(op_params, tflite::micro::GetTensorShape(input1),
+    reference_ops::Add(op_params, input1_shape,
                        tflite::micro::GetTensorData<float>(input1),
-                       tflite::micro::GetTensorShape(input2),
+                       input2_shape,
                        tflite::micro::GetTensorData<float>(input2),
-                       tflite::micro::GetTensorShape(output),
+                       output_shape,
                        tflite::micro::GetTensorData<float>(output));
   }
 }
@@ -133,6 +136,12 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
                               const TfLiteEvalTensor* input1,
                               const TfLiteEvalTensor* input2,
                               TfLiteEvalTensor* output) {
+  const RuntimeShape& input1_shape =
+      tflite::micro::GetEvalInputShape(node, kInputTensor1);
+  const RuntimeShape& input2_shape =
+      tflite::micro::GetEvalInputShape(node, kInputTensor2);
+  const RuntimeShape& output_shape =
+      tflite::micro::GetEvalOutputShape(node, kOutputTensor);
   tflite::ArithmeticParams op_params;
   op_params.left_shift = data->left_shift;
   op_params.input1_offset = data->input1_offset;
@@ -147,26 +156,21 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
   SetActivationParams(data->output_activation_min, data->output_activation_max,
                       &op_params);
   bool need_broadcast = reference_ops::ProcessBroadcastShapes(
-      tflite::micro::GetTensorShape(input1),
-      tflite::micro::GetTensorShape(input2), &op_params);
+      input1_shape, input2_shape, &op_params);
 
   switch (output->type) {
     case kTfLiteInt8: {
       if (need_broadcast) {
         reference_integer_ops::BroadcastAdd4DSlow(
-            op_params, tflite::micro::GetTensorShape(input1),
-            tflite::micro::GetTensorData<int8_t>(input1),
-            tflite::micro::GetTensorShape(input2),
-            tflite::micro::GetTensorData<int8_t>(input2),
-            tflite::micro::GetTensorShape(output),
+            op_params, input1_shape,
+            tflite::micro::GetTensorData<int8_t>(input1), input2_shape,
+            tflite::micro::GetTensorData<int8_t>(input2), output_shape,
             tflite::micro::GetTensorData<int8_t>(output));
       } else {
         reference_integer_ops::Add(
-            op_params, tflite::micro::GetTensorShape(input1),
-            tflite::micro::GetTensorData<int8_t>(input1),
-            tflite::micro::GetTensorShape(input2),
-            tflite::micro::GetTensorData<int8_t>(input2),
-            tflite::micro::GetTensorShape(output),
+            op_params, input1_shape,
+            tflite::micro::GetTensorData<int8_t>(input1), input2_shape,
+            tflite::micro::GetTensorData<int8_t>(input2), output_shape,
             tflite::micro::GetTensorData<int8_t>(output));
       }
       break;
@@ -174,18 +178,16 @@ TfLiteStatus EvalAddQuantized(TfLiteContext* context, TfLiteNode* node,
     case kTfLiteInt16: {
       if (need_broadcast) {
         reference_ops::BroadcastAdd4DSlow(
-            op_params, tflite::micro::GetTensorShape(input1),
-            tflite::micro::GetTensorData<int16_t>(input1),
-            tflite::micro::GetTensorShape(input2),
-            tflite::micro::GetTensorData<int16_t>(input2),
-            tflite::micro::GetTensorShape(output),
+            op_params, input1_shape,
+            tflite::micro::GetTensorData<int16_t>(input1), input2_shape,
+            tflite::micro::GetTensorData<int16_t>(input2), output_shape,
             tflite::micro::GetTensorData<int16_t>(output));
       } else {
-        reference_ops::Add(op_params, tflite::micro::GetTensorShape(input1),
+        reference_ops::Add(op_params, input1_shape,
                            tflite::micro::GetTensorData<int16_t>(input1),
-                           tflite::micro::GetTensorShape(input2),
+                           input2_shape,
                            tflite::micro::GetTensorData<int16_t>(input2),
-                           tflite::micro::GetTensorShape(output),
+                           output_shape,
                            tflite::micro::GetTensorData<int16_t>(output),
                            false);
       }
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_node.h"
 #include "tensorflow/lite/micro/testing/micro_test.h"
 #include "tensorflow/lite/micro/testing/test_utils.h"
 
@@ -85,7 +86,10 @@ TfLiteStatus ValidateDepthwiseConvGoldens(const T* expected_output_data,
   int temporaries_array_data[] = {0};
   TfLiteIntArray* temporaries_array = IntArrayFromInts(temporaries_array_data);
 
-  TfLiteNode node;
+  // Kernels look up their tensor tables next to the node, which stay empty
+  // here.
+  NodeAndRegistration node_and_registration = {};
+  TfLiteNode& node = node_and_registration.node;
   node.inputs = inputs_array;
   node.outputs = outputs_array;
   node.temporaries = temporaries_array;
@@ -26,6 +26,7 @@ limitations under the License.
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_node.h"
 #include "tensorflow/lite/micro/testing/micro_test.h"
 #include "tensorflow/lite/micro/testing/test_utils.h"
 
@@ -80,7 +81,10 @@ void TestAveragePoolingQuantized(
   int temporaries_array_data[] = {0};
   TfLiteIntArray* temporaries_array = IntArrayFromInts(temporaries_array_data);
 
-  TfLiteNode node;
+  // Kernels look up their tensor tables next to the node, which stay empty
+  // here.
+  NodeAndRegistration node_and_registration = {};
+  TfLiteNode& node = node_and_registration.node;
   node.inputs = inputs_array;
   node.outputs = outputs_array;
   node.temporaries = temporaries_array;
@@ -155,7 +159,10 @@ void TestMaxPoolQuantized(int* input_dims_data, const T* input_data,
   int temporaries_array_data[] = {0};
   TfLiteIntArray* temporaries_array = IntArrayFromInts(temporaries_array_data);
 
-  TfLiteNode node;
+  // Kernels look up their tensor tables next to the node, which stay empty
+  // here.
+  NodeAndRegistration node_and_registration = {};
+  TfLiteNode& node = node_and_registration.node;
   node.inputs = inputs_array;
   node.outputs = outputs_array;
   node.temporaries = temporaries_array;
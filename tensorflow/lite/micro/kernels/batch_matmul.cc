@@ -0,0 +1,421 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/internal/reference/batch_matmul.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+
+namespace tflite {
+namespace {
+
+constexpr int kInputLhsTensor = 0;
+constexpr int kInputRhsTensor = 1;
+constexpr int kOutputTensor = 0;
+
+// The reference kernel works on shapes of up to five dimensions, the last two
+// of which are the matrices.
+constexpr int kMaxDimensions = 5;
+
+// Number of RHS columns computed together by the quantized kernel, so that
+// each LHS value is loaded once per block and the block of RHS columns stays
+// in cache while all LHS rows stream past it.
+constexpr int kColumnBlockSize = 4;
+
+struct OpData {
+  // Requantization of the quantized accumulators into the output.
+  int32_t output_multiplier;
+  int output_shift;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+  int32_t lhs_offset;
+  int32_t rhs_offset;
+  int32_t output_offset;
+
+  // The kernels read the LHS as {..., rows, depth} and the RHS as
+  // {..., cols, depth}, so inputs in any other layout are transposed first.
+  // A constant RHS is transposed once in Prepare into a persistent buffer.
+  void* transposed_rhs;
+  int rhs_scratch_index;
+  int lhs_scratch_index;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+// Swaps the two innermost dimensions of `shape`.
+void SwapRowColumnDims(RuntimeShape* shape) {
+  const int32_t dims = shape->DimensionsCount();
+  const int32_t rows = shape->Dims(dims - 2);
+  shape->SetDim(dims - 2, shape->Dims(dims - 1));
+  shape->SetDim(dims - 1, rows);
+}
+
+// Transposes the two innermost dimensions of each matrix in `input`.
+template <typename T>
+void TransposeRowsColumns(const RuntimeShape& input_shape, const T* input,
+                          T* output) {
+  const int dims = input_shape.DimensionsCount();
+  const int rows = input_shape.Dims(dims - 2);
+  const int cols = input_shape.Dims(dims - 1);
+  const int batches = input_shape.FlatSize() / (rows * cols);
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int row = 0; row < rows; ++row) {
+      for (int col = 0; col < cols; ++col) {
+        output[col * rows + row] = input[row * cols + col];
+      }
+    }
+    input += rows * cols;
+    output += rows * cols;
+  }
+}
+
+TfLiteStatus TransposeRowsColumns(TfLiteContext* context,
+                                  const RuntimeShape& input_shape,
+                                  TfLiteType type, const void* input,
+                                  void* output) {
+  switch (type) {
+    case kTfLiteFloat32:
+      TransposeRowsColumns(input_shape, static_cast<const float*>(input),
+                           static_cast<float*>(output));
+      return kTfLiteOk;
+    case kTfLiteInt8:
+      TransposeRowsColumns(input_shape, static_cast<const int8_t*>(input),
+                           static_cast<int8_t*>(output));
+      return kTfLiteOk;
+    case kTfLiteInt16:
+      TransposeRowsColumns(input_shape, static_cast<const int16_t*>(input),
+                           static_cast<int16_t*>(output));
+      return kTfLiteOk;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
+                         TfLiteTypeGetName(type), type);
+      return kTfLiteError;
+  }
+}
+
+template <typename T, typename AccumT>
+inline T Requantize(const OpData& data, AccumT acc) {
+  int32_t scaled = MultiplyByQuantizedMultiplier(acc, data.output_multiplier,
+                                                 data.output_shift);
+  scaled += data.output_offset;
+  scaled = std::max(scaled, data.output_activation_min);
+  scaled = std::min(scaled, data.output_activation_max);
+  return static_cast<T>(scaled);
+}
+
+// Quantized batch matmul of `lhs`, laid out as {..., rows, depth}, with
+// `rhs`, laid out as {..., cols, depth}, into an output of
+// {..., rows, cols}. Computes the same values as
+// reference_ops::BatchMatMul<T, AccumT>, but blocks the RHS columns.
+template <typename T, typename AccumT>
+void BatchMatMulQuantized(const OpData& data, const RuntimeShape& lhs_shape,
+                          const T* lhs_data, const RuntimeShape& rhs_shape,
+                          const T* rhs_data, T* output_data) {
+  const RuntimeShape extended_lhs_shape =
+      RuntimeShape::ExtendedShape(kMaxDimensions, lhs_shape);
+  const RuntimeShape extended_rhs_shape =
+      RuntimeShape::ExtendedShape(kMaxDimensions, rhs_shape);
+
+  const int batch_dim0 = reference_ops::batch_matmul::broadcast_dim(
+      extended_lhs_shape.Dims(0), extended_rhs_shape.Dims(0));
+  const int batch_dim1 = reference_ops::batch_matmul::broadcast_dim(
+      extended_lhs_shape.Dims(1), extended_rhs_shape.Dims(1));
+  const int batch_dim2 = reference_ops::batch_matmul::broadcast_dim(
+      extended_lhs_shape.Dims(2), extended_rhs_shape.Dims(2));
+
+  const int lhs_ext0 =
+      reference_ops::batch_matmul::extent(extended_lhs_shape, 0);
+  const int lhs_ext1 =
+      reference_ops::batch_matmul::extent(extended_lhs_shape, 1);
+  const int lhs_ext2 =
+      reference_ops::batch_matmul::extent(extended_lhs_shape, 2);
+  const int rhs_ext0 =
+      reference_ops::batch_matmul::extent(extended_rhs_shape, 0);
+  const int rhs_ext1 =
+      reference_ops::batch_matmul::extent(extended_rhs_shape, 1);
+  const int rhs_ext2 =
+      reference_ops::batch_matmul::extent(extended_rhs_shape, 2);
+
+  const int lhs_rows = extended_lhs_shape.Dims(3);
+  const int rhs_cols = extended_rhs_shape.Dims(3);
+  const int accum_depth = extended_lhs_shape.Dims(4);
+  const int blocked_cols = rhs_cols - rhs_cols % kColumnBlockSize;
+  const AccumT lhs_offset = data.lhs_offset;
+  const AccumT rhs_offset = data.rhs_offset;
+
+  for (int b0 = 0; b0 < batch_dim0; ++b0) {
+    for (int b1 = 0; b1 < batch_dim1; ++b1) {
+      for (int b2 = 0; b2 < batch_dim2; ++b2) {
+        const T* lhs_batch =
+            lhs_data + b0 * lhs_ext0 + b1 * lhs_ext1 + b2 * lhs_ext2;
+        const T* rhs_batch =
+            rhs_data + b0 * rhs_ext0 + b1 * rhs_ext1 + b2 * rhs_ext2;
+        T* out_batch = output_data +
+                       ((b0 * batch_dim1 + b1) * batch_dim2 + b2) * lhs_rows *
+                           rhs_cols;
+
+        for (int col = 0; col < blocked_cols; col += kColumnBlockSize) {
+          const T* rhs_col0 = rhs_batch + col * accum_depth;
+          const T* rhs_col1 = rhs_col0 + accum_depth;
+          const T* rhs_col2 = rhs_col1 + accum_depth;
+          const T* rhs_col3 = rhs_col2 + accum_depth;
+          for (int row = 0; row < lhs_rows; ++row) {
+            const T* lhs_row = lhs_batch + row * accum_depth;
+            AccumT acc0 = 0;
+            AccumT acc1 = 0;
+            AccumT acc2 = 0;
+            AccumT acc3 = 0;
+            for (int k = 0; k < accum_depth; ++k) {
+              const AccumT lhs_val = lhs_row[k] + lhs_offset;
+              acc0 += lhs_val * (rhs_col0[k] + rhs_offset);
+              acc1 += lhs_val * (rhs_col1[k] + rhs_offset);
+              acc2 += lhs_val * (rhs_col2[k] + rhs_offset);
+              acc3 += lhs_val * (rhs_col3[k] + rhs_offset);
+            }
+            T* out_row = out_batch + row * rhs_cols + col;
+            out_row[0] = Requantize<T>(data, acc0);
+            out_row[1] = Requantize<T>(data, acc1);
+            out_row[2] = Requantize<T>(data, acc2);
+            out_row[3] = Requantize<T>(data, acc3);
+          }
+        }
+        for (int col = blocked_cols; col < rhs_cols; ++col) {
+          const T* rhs_col = rhs_batch + col * accum_depth;
+          for (int row = 0; row < lhs_rows; ++row) {
+            const T* lhs_row = lhs_batch + row * accum_depth;
+            AccumT acc = 0;
+            for (int k = 0; k < accum_depth; ++k) {
+              acc += (lhs_row[k] + lhs_offset) * (rhs_col[k] + rhs_offset);
+            }
+            out_batch[row * rhs_cols + col] = Requantize<T>(data, acc);
+          }
+        }
+      }
+    }
+  }
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  const auto* params =
+      static_cast<const TfLiteBatchMatMulParams*>(node->builtin_data);
+
+  TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  const TfLiteTensor* lhs = GetInput(context, node, kInputLhsTensor);
+  TF_LITE_ENSURE(context, lhs != nullptr);
+  const TfLiteTensor* rhs = GetInput(context, node, kInputRhsTensor);
+  TF_LITE_ENSURE(context, rhs != nullptr);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+
+  TF_LITE_ENSURE(context, lhs->type == kTfLiteFloat32 ||
+                              lhs->type == kTfLiteInt8 ||
+                              lhs->type == kTfLiteInt16);
+  TF_LITE_ENSURE_TYPES_EQ(context, rhs->type, lhs->type);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, lhs->type);
+
+  // Micro does not resize tensors, so the output must already have the
+  // broadcast shape.
+  const int lhs_rank = NumDimensions(lhs);
+  const int rhs_rank = NumDimensions(rhs);
+  const int output_rank = NumDimensions(output);
+  TF_LITE_ENSURE(context, lhs_rank >= 2 && lhs_rank <= kMaxDimensions);
+  TF_LITE_ENSURE(context, rhs_rank >= 2 && rhs_rank <= kMaxDimensions);
+  TF_LITE_ENSURE_EQ(context, output_rank, std::max(lhs_rank, rhs_rank));
+  const RuntimeShape lhs_shape = GetTensorShape(lhs);
+  const RuntimeShape rhs_shape = GetTensorShape(rhs);
+  const RuntimeShape extended_lhs_shape =
+      RuntimeShape::ExtendedShape(output_rank, lhs_shape);
+  const RuntimeShape extended_rhs_shape =
+      RuntimeShape::ExtendedShape(output_rank, rhs_shape);
+  for (int i = 0; i < output_rank - 2; ++i) {
+    const int lhs_dim = extended_lhs_shape.Dims(i);
+    const int rhs_dim = extended_rhs_shape.Dims(i);
+    TF_LITE_ENSURE(context, lhs_dim == rhs_dim || lhs_dim == 1 || rhs_dim == 1);
+    TF_LITE_ENSURE_EQ(context, output->dims->data[i],
+                      std::max(lhs_dim, rhs_dim));
+  }
+  const int accum_depth = lhs_shape.Dims(lhs_rank - (params->adj_x ? 2 : 1));
+  TF_LITE_ENSURE_EQ(context, rhs_shape.Dims(rhs_rank - (params->adj_y ? 1 : 2)),
+                    accum_depth);
+  TF_LITE_ENSURE_EQ(context, output->dims->data[output_rank - 2],
+                    lhs_shape.Dims(lhs_rank - (params->adj_x ? 1 : 2)));
+  TF_LITE_ENSURE_EQ(context, output->dims->data[output_rank - 1],
+                    rhs_shape.Dims(rhs_rank - (params->adj_y ? 2 : 1)));
+
+  data->output_multiplier = 0;
+  data->output_shift = 0;
+  data->lhs_offset = 0;
+  data->rhs_offset = 0;
+  data->output_offset = 0;
+  if (lhs->type == kTfLiteInt8 || lhs->type == kTfLiteInt16) {
+    const double real_multiplier =
+        static_cast<double>(lhs->params.scale) *
+        static_cast<double>(rhs->params.scale) /
+        static_cast<double>(output->params.scale);
+    QuantizeMultiplier(real_multiplier, &data->output_multiplier,
+                       &data->output_shift);
+    data->lhs_offset = -lhs->params.zero_point;
+    data->rhs_offset = -rhs->params.zero_point;
+    data->output_offset = output->params.zero_point;
+    // BATCH_MATMUL has no fused activation, so outputs only saturate.
+    if (lhs->type == kTfLiteInt8) {
+      data->output_activation_min = std::numeric_limits<int8_t>::min();
+      data->output_activation_max = std::numeric_limits<int8_t>::max();
+    } else {
+      TF_LITE_ENSURE_EQ(context, lhs->params.zero_point, 0);
+      TF_LITE_ENSURE_EQ(context, rhs->params.zero_point, 0);
+      TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
+      data->output_activation_min = std::numeric_limits<int16_t>::min();
+      data->output_activation_max = std::numeric_limits<int16_t>::max();
+    }
+  }
+
+  TFLITE_DCHECK(context->RequestScratchBufferInArena != nullptr);
+  data->transposed_rhs = nullptr;
+  data->rhs_scratch_index = -1;
+  if (!params->adj_y) {
+    const size_t rhs_bytes = rhs->bytes;
+    if (IsConstantTensor(rhs)) {
+      data->transposed_rhs =
+          context->AllocatePersistentBuffer(context, rhs_bytes);
+      TF_LITE_ENSURE(context, data->transposed_rhs != nullptr);
+      TF_LITE_ENSURE_OK(context,
+                        TransposeRowsColumns(context, rhs_shape, rhs->type,
+                                             rhs->data.data,
+                                             data->transposed_rhs));
+    } else {
+      TF_LITE_ENSURE_OK(context, context->RequestScratchBufferInArena(
+                                     context, rhs_bytes,
+                                     &data->rhs_scratch_index));
+    }
+  }
+  data->lhs_scratch_index = -1;
+  if (params->adj_x) {
+    TF_LITE_ENSURE_OK(context, context->RequestScratchBufferInArena(
+                                   context, lhs->bytes,
+                                   &data->lhs_scratch_index));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  const OpData& data = *static_cast<const OpData*>(node->user_data);
+  const auto* params =
+      static_cast<const TfLiteBatchMatMulParams*>(node->builtin_data);
+
+  const TfLiteEvalTensor* lhs =
+      tflite::micro::GetEvalInput(context, node, kInputLhsTensor);
+  const TfLiteEvalTensor* rhs =
+      tflite::micro::GetEvalInput(context, node, kInputRhsTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  // Bring the LHS into {..., rows, depth} and the RHS into {..., cols, depth}.
+  RuntimeShape lhs_shape = tflite::micro::GetTensorShape(lhs);
+  const void* lhs_data = lhs->data.data;
+  if (params->adj_x) {
+    void* transposed_lhs =
+        context->GetScratchBuffer(context, data.lhs_scratch_index);
+    TF_LITE_ENSURE(context, transposed_lhs != nullptr);
+    TF_LITE_ENSURE_OK(context, TransposeRowsColumns(context, lhs_shape,
+                                                    lhs->type, lhs_data,
+                                                    transposed_lhs));
+    SwapRowColumnDims(&lhs_shape);
+    lhs_data = transposed_lhs;
+  }
+  RuntimeShape rhs_shape = tflite::micro::GetTensorShape(rhs);
+  const void* rhs_data = rhs->data.data;
+  if (!params->adj_y) {
+    void* transposed_rhs = data.transposed_rhs;
+    if (transposed_rhs == nullptr) {
+      transposed_rhs =
+          context->GetScratchBuffer(context, data.rhs_scratch_index);
+      TF_LITE_ENSURE(context, transposed_rhs != nullptr);
+      TF_LITE_ENSURE_OK(context, TransposeRowsColumns(context, rhs_shape,
+                                                      rhs->type, rhs_data,
+                                                      transposed_rhs));
+    }
+    SwapRowColumnDims(&rhs_shape);
+    rhs_data = transposed_rhs;
+  }
+
+  switch (lhs->type) {
+    case kTfLiteFloat32: {
+      // The reference kernel writes element (i, j) of its own LHS times RHS
+      // product to j * rows + i, so computing RHS times LHS with the LHS dims
+      // swapped yields the row-major {rows, cols} output.
+      RuntimeShape swapped_lhs_shape(lhs_shape);
+      SwapRowColumnDims(&swapped_lhs_shape);
+      reference_ops::BatchMatMul(
+          rhs_shape, static_cast<const float*>(rhs_data), swapped_lhs_shape,
+          static_cast<const float*>(lhs_data),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<float>(output));
+      break;
+    }
+    case kTfLiteInt8:
+      BatchMatMulQuantized<int8_t, int32_t>(
+          data, lhs_shape, static_cast<const int8_t*>(lhs_data), rhs_shape,
+          static_cast<const int8_t*>(rhs_data),
+          tflite::micro::GetTensorData<int8_t>(output));
+      break;
+    case kTfLiteInt16:
+      BatchMatMulQuantized<int16_t, int64_t>(
+          data, lhs_shape, static_cast<const int16_t*>(lhs_data), rhs_shape,
+          static_cast<const int16_t*>(rhs_data),
+          tflite::micro::GetTensorData<int16_t>(output));
+      break;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
+                         TfLiteTypeGetName(lhs->type), lhs->type);
+      return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TfLiteRegistration Register_BATCH_MATMUL() {
+  return {/*init=*/Init,
+          /*free=*/nullptr,
+          /*prepare=*/Prepare,
+          /*invoke=*/Eval,
+          /*profiling_string=*/nullptr,
+          /*builtin_code=*/0,
+          /*custom_name=*/nullptr,
+          /*version=*/0};
+}
+
+}  // namespace tflite
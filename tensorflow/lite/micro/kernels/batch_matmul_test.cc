@@ -0,0 +1,279 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/batch_matmul.h"
+#include "tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr int kMaxElements = 128;
+
+// lhs {1, 2, 3} times rhs {1, 3, 4}.
+int basic_lhs_dims[] = {3, 1, 2, 3};
+const float basic_lhs[] = {1, 2, 3, 4, 5, 6};
+int basic_rhs_dims[] = {3, 1, 3, 4};
+const float basic_rhs[] = {7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18};
+int basic_output_dims[] = {3, 1, 2, 4};
+const float basic_golden[] = {74., 80., 86., 92., 173., 188., 203., 218.};
+
+// The same product with the lhs stored as {1, 3, 2} and the rhs as {1, 4, 3}.
+int adjoint_lhs_dims[] = {3, 1, 3, 2};
+const float adjoint_lhs[] = {1, 4, 2, 5, 3, 6};
+int adjoint_rhs_dims[] = {3, 1, 4, 3};
+const float adjoint_rhs[] = {7, 11, 15, 8, 12, 16, 9, 13, 17, 10, 14, 18};
+
+// lhs {2, 2, 3} times a rank 2 rhs {3, 4} broadcast over the batch.
+int broadcast_lhs_dims[] = {3, 2, 2, 3};
+const float broadcast_lhs[] = {1, 2, 3, 4, 5, 6, 1, 0, 0, 0, 1, 0};
+int broadcast_rhs_dims[] = {2, 3, 4};
+int broadcast_output_dims[] = {3, 2, 2, 4};
+const float broadcast_golden[] = {74., 80.,  86.,  92.,  173., 188., 203., 218.,
+                                  7.,  8.,   9.,   10.,  11.,  12.,  13.,  14.};
+
+template <typename T>
+TfLiteStatus ValidateBatchMatMulGoldens(TfLiteTensor* tensors, bool adj_x,
+                                        bool adj_y, const T* golden, T* output,
+                                        int output_size) {
+  int inputs_array_data[] = {2, 0, 1};
+  TfLiteIntArray* inputs_array = IntArrayFromInts(inputs_array_data);
+  int outputs_array_data[] = {1, 2};
+  TfLiteIntArray* outputs_array = IntArrayFromInts(outputs_array_data);
+
+  TfLiteBatchMatMulParams params = {adj_x, adj_y,
+                                    /*asymmetric_quantize_inputs=*/false};
+  const TfLiteRegistration registration = Register_BATCH_MATMUL();
+  micro::KernelRunner runner(registration, tensors, /*tensors_size=*/3,
+                             inputs_array, outputs_array, &params);
+
+  TF_LITE_ENSURE_STATUS(runner.InitAndPrepare());
+  // Invoke twice so a RHS transposed into the arena or persistent memory is
+  // reused correctly.
+  for (int invoke = 0; invoke < 2; ++invoke) {
+    TF_LITE_ENSURE_STATUS(runner.Invoke());
+    for (int i = 0; i < output_size; ++i) {
+      TF_LITE_MICRO_EXPECT_EQ(golden[i], output[i]);
+    }
+  }
+  return kTfLiteOk;
+}
+
+void TestBatchMatMulFloat(int* lhs_dims_data, const float* lhs_data,
+                          int* rhs_dims_data, const float* rhs_data,
+                          bool rhs_constant, int* output_dims_data, bool adj_x,
+                          bool adj_y, const float* golden,
+                          float* output_data) {
+  TfLiteIntArray* lhs_dims = IntArrayFromInts(lhs_dims_data);
+  TfLiteIntArray* rhs_dims = IntArrayFromInts(rhs_dims_data);
+  TfLiteIntArray* output_dims = IntArrayFromInts(output_dims_data);
+  const int output_size = ElementCount(*output_dims);
+
+  TfLiteTensor tensors[] = {
+      CreateTensor(lhs_data, lhs_dims),
+      CreateTensor(rhs_data, rhs_dims),
+      CreateTensor(output_data, output_dims),
+  };
+  if (rhs_constant) {
+    tensors[1].allocation_type = kTfLiteMmapRo;
+  }
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, ValidateBatchMatMulGoldens(tensors, adj_x, adj_y, golden,
+                                            output_data, output_size));
+}
+
+// Fills `data` with a repeating pattern covering negative and positive values.
+template <typename T>
+void FillPattern(T* data, int size, int seed) {
+  for (int i = 0; i < size; ++i) {
+    data[i] = static_cast<T>((i * 37 + seed * 11) % 61 - 30);
+  }
+}
+
+// Transposes the innermost two dimensions of each matrix in `input`.
+template <typename T>
+void TransposeMatrices(const T* input, int batches, int rows, int cols,
+                       T* output) {
+  for (int b = 0; b < batches; ++b) {
+    for (int r = 0; r < rows; ++r) {
+      for (int c = 0; c < cols; ++c) {
+        output[b * rows * cols + c * rows + r] =
+            input[b * rows * cols + r * cols + c];
+      }
+    }
+  }
+}
+
+// Runs a quantized lhs {2, 1, 3, 5} times rhs {1, 2, 5, 7} and compares the
+// kernel bit for bit against reference_ops::BatchMatMul. 7 output columns
+// exercise both the blocked columns and the remaining one at a time.
+template <typename T, typename AccumT>
+void TestBatchMatMulQuantized(bool adj_x, bool adj_y, bool rhs_constant,
+                              int32_t lhs_zero_point, int32_t rhs_zero_point,
+                              int32_t output_zero_point) {
+  constexpr int kRows = 3;
+  constexpr int kDepth = 5;
+  constexpr int kCols = 7;
+  constexpr int kLhsBatches = 2;
+  constexpr int kRhsBatches = 2;
+  constexpr int kOutputSize = 2 * 2 * kRows * kCols;
+  constexpr float kLhsScale = 0.5f;
+  constexpr float kRhsScale = 0.25f;
+  constexpr float kOutputScale = 2.0f;
+
+  // Row-major {rows, depth} lhs and {depth, cols} rhs matrices.
+  T lhs[kLhsBatches * kRows * kDepth];
+  T rhs[kRhsBatches * kDepth * kCols];
+  FillPattern(lhs, kLhsBatches * kRows * kDepth, 1);
+  FillPattern(rhs, kRhsBatches * kDepth * kCols, 2);
+
+  // The reference computes its rhs argument times its lhs argument, which must
+  // be the transposed rhs laid out as {cols, depth}.
+  T transposed_rhs[kRhsBatches * kDepth * kCols];
+  TransposeMatrices(rhs, kRhsBatches, kDepth, kCols, transposed_rhs);
+  FullyConnectedParams op_params;
+  op_params.input_offset = -lhs_zero_point;
+  op_params.weights_offset = -rhs_zero_point;
+  op_params.output_offset = output_zero_point;
+  int shift;
+  QuantizeMultiplier(
+      static_cast<double>(kLhsScale) * static_cast<double>(kRhsScale) /
+          static_cast<double>(kOutputScale),
+      &op_params.output_multiplier, &shift);
+  op_params.output_shift = shift;
+  op_params.quantized_activation_min = std::numeric_limits<T>::min();
+  op_params.quantized_activation_max = std::numeric_limits<T>::max();
+  const int32_t reference_lhs_dims[] = {1, 2, kCols, kDepth};
+  const int32_t reference_rhs_dims[] = {2, 1, kDepth, kRows};
+  const int32_t reference_output_dims[] = {2, 2, kRows, kCols};
+  T golden[kOutputSize];
+  reference_ops::BatchMatMul<T, AccumT>(
+      op_params, RuntimeShape(4, reference_lhs_dims), transposed_rhs,
+      RuntimeShape(4, reference_rhs_dims), lhs,
+      RuntimeShape(4, reference_output_dims), golden);
+
+  T lhs_input[kLhsBatches * kRows * kDepth];
+  int lhs_dims_data[] = {4, 2, 1, kRows, kDepth};
+  if (adj_x) {
+    TransposeMatrices(lhs, kLhsBatches, kRows, kDepth, lhs_input);
+    lhs_dims_data[3] = kDepth;
+    lhs_dims_data[4] = kRows;
+  } else {
+    std::copy_n(lhs, kLhsBatches * kRows * kDepth, lhs_input);
+  }
+  T rhs_input[kRhsBatches * kDepth * kCols];
+  int rhs_dims_data[] = {4, 1, 2, kDepth, kCols};
+  if (adj_y) {
+    std::copy_n(transposed_rhs, kRhsBatches * kDepth * kCols, rhs_input);
+    rhs_dims_data[3] = kCols;
+    rhs_dims_data[4] = kDepth;
+  } else {
+    std::copy_n(rhs, kRhsBatches * kDepth * kCols, rhs_input);
+  }
+  int output_dims_data[] = {4, 2, 2, kRows, kCols};
+
+  T output[kOutputSize];
+  TfLiteTensor tensors[] = {
+      CreateQuantizedTensor(lhs_input, IntArrayFromInts(lhs_dims_data),
+                            kLhsScale, lhs_zero_point),
+      CreateQuantizedTensor(rhs_input, IntArrayFromInts(rhs_dims_data),
+                            kRhsScale, rhs_zero_point),
+      CreateQuantizedTensor(output, IntArrayFromInts(output_dims_data),
+                            kOutputScale, output_zero_point),
+  };
+  if (rhs_constant) {
+    tensors[1].allocation_type = kTfLiteMmapRo;
+  }
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, ValidateBatchMatMulGoldens(tensors, adj_x, adj_y, golden,
+                                            output, kOutputSize));
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(BatchMatMulFloatBasic) {
+  float output[tflite::testing::kMaxElements];
+  tflite::testing::TestBatchMatMulFloat(
+      tflite::testing::basic_lhs_dims, tflite::testing::basic_lhs,
+      tflite::testing::basic_rhs_dims, tflite::testing::basic_rhs,
+      /*rhs_constant=*/false, tflite::testing::basic_output_dims,
+      /*adj_x=*/false, /*adj_y=*/false, tflite::testing::basic_golden, output);
+}
+
+TF_LITE_MICRO_TEST(BatchMatMulFloatConstantRhs) {
+  float output[tflite::testing::kMaxElements];
+  tflite::testing::TestBatchMatMulFloat(
+      tflite::testing::basic_lhs_dims, tflite::testing::basic_lhs,
+      tflite::testing::basic_rhs_dims, tflite::testing::basic_rhs,
+      /*rhs_constant=*/true, tflite::testing::basic_output_dims,
+      /*adj_x=*/false, /*adj_y=*/false, tflite::testing::basic_golden, output);
+}
+
+TF_LITE_MICRO_TEST(BatchMatMulFloatAdjoints) {
+  float output[tflite::testing::kMaxElements];
+  tflite::testing::TestBatchMatMulFloat(
+      tflite::testing::adjoint_lhs_dims, tflite::testing::adjoint_lhs,
+      tflite::testing::adjoint_rhs_dims, tflite::testing::adjoint_rhs,
+      /*rhs_constant=*/false, tflite::testing::basic_output_dims,
+      /*adj_x=*/true, /*adj_y=*/true, tflite::testing::basic_golden, output);
+}
+
+TF_LITE_MICRO_TEST(BatchMatMulFloatBroadcast) {
+  float output[tflite::testing::kMaxElements];
+  tflite::testing::TestBatchMatMulFloat(
+      tflite::testing::broadcast_lhs_dims, tflite::testing::broadcast_lhs,
+      tflite::testing::broadcast_rhs_dims, tflite::testing::basic_rhs,
+      /*rhs_constant=*/false, tflite::testing::broadcast_output_dims,
+      /*adj_x=*/false, /*adj_y=*/false, tflite::testing::broadcast_golden,
+      output);
+}
+
+TF_LITE_MICRO_TEST(BatchMatMulInt8MatchesReference) {
+  for (int adjoints = 0; adjoints < 4; ++adjoints) {
+    for (int rhs_constant = 0; rhs_constant < 2; ++rhs_constant) {
+      tflite::testing::TestBatchMatMulQuantized<int8_t, int32_t>(
+          /*adj_x=*/(adjoints & 1) != 0, /*adj_y=*/(adjoints & 2) != 0,
+          rhs_constant != 0, /*lhs_zero_point=*/3, /*rhs_zero_point=*/-2,
+          /*output_zero_point=*/5);
+    }
+  }
+}
+
+TF_LITE_MICRO_TEST(BatchMatMulInt16MatchesReference) {
+  for (int adjoints = 0; adjoints < 4; ++adjoints) {
+    for (int rhs_constant = 0; rhs_constant < 2; ++rhs_constant) {
+      tflite::testing::TestBatchMatMulQuantized<int16_t, int64_t>(
+          /*adj_x=*/(adjoints & 1) != 0, /*adj_y=*/(adjoints & 2) != 0,
+          rhs_constant != 0, /*lhs_zero_point=*/0, /*rhs_zero_point=*/0,
+          /*output_zero_point=*/0);
+    }
+  }
+}
+
+TF_LITE_MICRO_TESTS_END
@@ -22,7 +22,9 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/copy_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 
 namespace tflite {
 namespace ops {
@@ -34,6 +36,10 @@ constexpr int kOutputTensor = 0;
 
 struct OpData {
   ConcatenationParams params;
+  // Number of slices of the output before the concatenation axis.
+  int outer_size;
+  // Bytes in one unit of the concatenation axis.
+  int inner_bytes;
 };
 
 // Handles negative axis index, coerces to positive index value.
@@ -45,63 +51,31 @@ inline int CalculatePositiveAxis(int axis, const TfLiteTensor* output_tensor) {
   }
 }
 
-// The following functions are helpers to get tensor data in the format that the
-// reference op implementation expects. They provide the same functionality as
-// class VectorOfTensors and class VectorOfQuantizedTensors in TFLite.
-
-// Gets shapes from a list of tensors.
-inline void GetAllInputTensorShapes(const TfLiteContext* context,
-                                    const TfLiteNode* node,
-                                    RuntimeShape all_shapes[kMaxInputNum]) {
-  TFLITE_DCHECK(context != nullptr);
-  TFLITE_DCHECK(node != nullptr);
-  for (int i = 0; i < node->inputs->size; ++i) {
-    const TfLiteEvalTensor* t = tflite::micro::GetEvalInput(context, node, i);
-    RuntimeShape shape = tflite::micro::GetTensorShape(t);
-    all_shapes[i].ReplaceWith(shape.DimensionsCount(), shape.DimsData());
-  }
-}
-
-// Get shape pointers from a list of shapes.
-inline void GetShapesPointers(const RuntimeShape* shapes, size_t num,
-                              const RuntimeShape* pointers[]) {
-  for (size_t i = 0; i < num; ++i) {
-    pointers[i] = &shapes[i];
-  }
-}
-
-// Gets data pointers from a list of tensors.
-template <typename T>
-inline void GetAllInputTensorData(const TfLiteContext* context,
-                                  const TfLiteNode* node,
-                                  T* all_data[kMaxInputNum]) {
-  TFLITE_DCHECK(context != nullptr);
-  TFLITE_DCHECK(node != nullptr);
-  for (int i = 0; i < node->inputs->size; ++i) {
-    const TfLiteEvalTensor* t = tflite::micro::GetEvalInput(context, node, i);
-    all_data[i] = tflite::micro::GetTensorData<T>(t);
-  }
-}
-
-template <typename data_type>
-void EvalUnquantized(TfLiteContext* context, TfLiteNode* node) {
-  // Collect the shapes and data pointer of input tensors
-  RuntimeShape inputs_shape[kMaxInputNum];
-  const RuntimeShape* inputs_shape_ptr[kMaxInputNum];
-  const data_type* inputs_data[kMaxInputNum];
-  GetAllInputTensorShapes(context, node, inputs_shape);
-  GetShapesPointers(inputs_shape, node->inputs->size, inputs_shape_ptr);
-  GetAllInputTensorData(context, node, inputs_data);
-
+// Copies each input as outer_size runs into the matching slice of the output
+// rows. Concatenation only moves data around, so this works on bytes
+// independently of the tensor type.
+void EvalConcatenation(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kOutputTensor);
 
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData* data = static_cast<const OpData*>(node->user_data);
+  const int axis = data->params.axis;
+  const int output_run_bytes = output->dims->data[axis] * data->inner_bytes;
 
-  reference_ops::Concatenation(data->params, inputs_shape_ptr, inputs_data,
-                               tflite::micro::GetTensorShape(output),
-                               tflite::micro::GetTensorData<data_type>(output));
+  uint8_t* output_ptr = tflite::micro::GetTensorData<uint8_t>(output);
+  for (int i = 0; i < node->inputs->size; ++i) {
+    const TfLiteEvalTensor* t = tflite::micro::GetEvalInput(context, node, i);
+    const int run_bytes = t->dims->data[axis] * data->inner_bytes;
+    const uint8_t* input_ptr = tflite::micro::GetTensorData<uint8_t>(t);
+    // The memory planner may have placed the input at its slice of the
+    // output already, in which case the producer wrote it there directly.
+    if (input_ptr != output_ptr) {
+      tflite::micro::CopyRuns(input_ptr, run_bytes, output_ptr,
+                              output_run_bytes, run_bytes, data->outer_size);
+    }
+    output_ptr += run_bytes;
+  }
 }
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
@@ -202,38 +176,24 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteError;
   }
 
+  for (int i = 0; i < num_inputs; ++i) {
+    const TfLiteTensor* input = GetInput(context, node, i);
+    TF_LITE_ENSURE_EQ(context, NumDimensions(input), NumDimensions(output));
+  }
+  size_t element_size;
+  TF_LITE_ENSURE_OK(context, TfLiteTypeSizeOf(output_type, &element_size));
+  const int axis = data->params.axis;
+  data->outer_size = tflite::micro::FlatSizeOfDims(output->dims, 0, axis);
+  data->inner_bytes = static_cast<int>(element_size) *
+                      tflite::micro::FlatSizeOfDims(output->dims, axis + 1,
+                                                    output->dims->size);
+
   return kTfLiteOk;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
-  const TfLiteTensor* output_tensor = GetOutput(context, node, kOutputTensor);
-  TF_LITE_ENSURE(context, output_tensor != nullptr);
-  TfLiteType output_type = output_tensor->type;
-
-  switch (output_type) {  // Already know in/outtypes are same.
-    case kTfLiteFloat32:
-      EvalUnquantized<float>(context, node);
-      break;
-    case kTfLiteInt32:
-      EvalUnquantized<int32_t>(context, node);
-      break;
-    case kTfLiteInt8:
-      EvalUnquantized<int8_t>(context, node);
-      break;
-    case kTfLiteInt64:
-      EvalUnquantized<int64_t>(context, node);
-      break;
-    case kTfLiteInt16:
-      EvalUnquantized<int16_t>(context, node);
-      break;
-
-    default:
-      TF_LITE_KERNEL_LOG(
-          context, "Op Concatenation does not currently support Type '%s'.",
-          TfLiteTypeGetName(output_type));
-      return kTfLiteError;
-  }
-
+  // The types were checked in Prepare().
+  EvalConcatenation(context, node);
   return kTfLiteOk;
 }
 
@@ -24,6 +24,25 @@ limitations under the License.
 
 namespace tflite {
 
+// Int8 per-channel kernels with the signature of
+// reference_integer_ops::ConvPerChannel and DepthwiseConvPerChannel. Prepare
+// picks a specialization for the filter shape and stride of the node when
+// there is one, and the generic reference kernel otherwise.
+typedef void (*ConvPerChannelInt8Fn)(
+    const ConvParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data);
+typedef void (*DepthwiseConvPerChannelInt8Fn)(
+    const DepthwiseParams& params, const int32_t* output_multiplier,
+    const int32_t* output_shift, const RuntimeShape& input_shape,
+    const int8_t* input_data, const RuntimeShape& filter_shape,
+    const int8_t* filter_data, const RuntimeShape& bias_shape,
+    const int32_t* bias_data, const RuntimeShape& output_shape,
+    int8_t* output_data);
+
 struct OpDataConv {
   TfLitePaddingValues padding;
 
@@ -45,6 +64,11 @@ struct OpDataConv {
   // uint8_t these would be 0 and 255.
   int32_t output_activation_min;
   int32_t output_activation_max;
+
+  // The int8 kernel of the node, set by CalculateOpDataConv or
+  // CalculateOpDataDepthwiseConv.
+  ConvPerChannelInt8Fn conv_per_channel_int8;
+  DepthwiseConvPerChannelInt8Fn depthwise_conv_per_channel_int8;
 };
 
 extern const int kConvInputTensor;
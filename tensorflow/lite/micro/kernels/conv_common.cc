@@ -36,6 +36,33 @@ const int kConvOutputTensor = 0;
 // https://www.tensorflow.org/lite/performance/quantization_spec
 const int kConvQuantizedDimension = 0;
 
+namespace {
+
+// Returns the int8 kernel for a convolution with the given parameters and
+// filter size. Only undilated filters with the same stride in both dimensions
+// are specialized.
+ConvPerChannelInt8Fn SelectConvPerChannelInt8(const TfLiteConvParams& params,
+                                              int filter_width,
+                                              int filter_height) {
+  if (params.dilation_width_factor == 1 && params.dilation_height_factor == 1 &&
+      params.stride_width == params.stride_height) {
+    if (filter_width == 1 && filter_height == 1 && params.stride_width == 1) {
+      return reference_integer_ops::ConvPerChannelWithFilterShape<1, 1, 1>;
+    }
+    if (filter_width == 3 && filter_height == 3) {
+      if (params.stride_width == 1) {
+        return reference_integer_ops::ConvPerChannelWithFilterShape<3, 3, 1>;
+      }
+      if (params.stride_width == 2) {
+        return reference_integer_ops::ConvPerChannelWithFilterShape<3, 3, 2>;
+      }
+    }
+  }
+  return reference_integer_ops::ConvPerChannel;
+}
+
+}  // namespace
+
 // Returns a ConvParams struct with all the parameters needed for a
 // float computation.
 ConvParams ConvParamsFloat(const TfLiteConvParams& params,
@@ -118,6 +145,8 @@ TfLiteStatus CalculateOpDataConv(TfLiteContext* context, TfLiteNode* node,
   data->input_zero_point = input->params.zero_point;
   data->filter_zero_point = filter->params.zero_point;
   data->output_zero_point = output->params.zero_point;
+  data->conv_per_channel_int8 =
+      SelectConvPerChannelInt8(params, filter_width, filter_height);
 
   return kTfLiteOk;
 }
@@ -145,13 +174,9 @@ TfLiteStatus ConvPrepare(TfLiteContext* context, TfLiteNode* node) {
   const int output_height = output->dims->data[1];
 
   // Dynamically allocate per-channel quantization parameters.
-  const int num_channels = filter->dims->data[kConvQuantizedDimension];
-  data->per_channel_output_multiplier =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
-  data->per_channel_output_shift =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
+  TF_LITE_ENSURE_STATUS(micro::AllocatePerChannelQuantizationParams(
+      context, input->type, filter->dims->data[kConvQuantizedDimension],
+      &data->per_channel_output_multiplier, &data->per_channel_output_shift));
 
   // All per-channel quantized tensors need valid zero point and scale arrays.
   if (input->type == kTfLiteInt8 || input->type == kTfLiteInt16) {
@@ -15,8 +15,14 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/kernels/conv_test.h"
 
+#include <limits>
+
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/padding.h"
 #include "tensorflow/lite/micro/kernels/kernel_runner.h"
 #include "tensorflow/lite/micro/kernels/testdata/conv_test_data.h"
 #include "tensorflow/lite/micro/micro_utils.h"
@@ -56,6 +62,129 @@ static TfLiteConvParams common_conv_params = {
     1,                    // dilation_height_factor
 };
 
+#if !defined(XTENSA)  // Needed to avoid build errors from unused functions.
+// Runs an int8 convolution with a filter_size x filter_size filter through
+// CONV_2D and checks that the output is bit-exact with the generic reference
+// kernel, whichever kernel Prepare picked for the shape.
+void TestInt8ConvMatchesGenericKernel(int filter_size, int stride,
+                                      TfLitePadding padding) {
+  constexpr int kBatches = 2;
+  constexpr int kInputHeight = 7;
+  constexpr int kInputWidth = 9;
+  constexpr int kInputDepth = 5;
+  constexpr int kOutputDepth = 4;
+  constexpr int kMaxFilterSize = 3;
+  constexpr int kInputLength =
+      kBatches * kInputHeight * kInputWidth * kInputDepth;
+  constexpr int kMaxFilterLength =
+      kOutputDepth * kMaxFilterSize * kMaxFilterSize * kInputDepth;
+  constexpr int kMaxOutputLength =
+      kBatches * kInputHeight * kInputWidth * kOutputDepth;
+  TF_LITE_MICRO_EXPECT_LE(filter_size, kMaxFilterSize);
+
+  int output_height;
+  int output_width;
+  const TfLitePaddingValues padding_values = ComputePaddingHeightWidth(
+      stride, stride, 1, 1, kInputHeight, kInputWidth, filter_size,
+      filter_size, padding, &output_height, &output_width);
+
+  int input_shape[] = {4, kBatches, kInputHeight, kInputWidth, kInputDepth};
+  int filter_shape[] = {4, kOutputDepth, filter_size, filter_size,
+                        kInputDepth};
+  int bias_shape[] = {1, kOutputDepth};
+  int output_shape[] = {4, kBatches, output_height, output_width,
+                        kOutputDepth};
+  const int output_length =
+      kBatches * output_height * output_width * kOutputDepth;
+
+  int8_t input_data[kInputLength];
+  for (int i = 0; i < kInputLength; ++i) {
+    input_data[i] = static_cast<int8_t>((i * 37) % 256 - 128);
+  }
+  int8_t filter_data[kMaxFilterLength];
+  for (int i = 0; i < kMaxFilterLength; ++i) {
+    filter_data[i] = static_cast<int8_t>((i * 53) % 255 - 127);
+  }
+  int32_t bias_data[kOutputDepth];
+  for (int i = 0; i < kOutputDepth; ++i) {
+    bias_data[i] = i * 300 - 500;
+  }
+
+  const float input_scale = 0.5f;
+  const int input_zero_point = -3;
+  const float output_scale = 40.0f;
+  const int output_zero_point = 5;
+  float input_scales[] = {1, input_scale};
+  int input_zero_points[] = {1, input_zero_point};
+  TfLiteAffineQuantization input_quant = {FloatArrayFromFloats(input_scales),
+                                          IntArrayFromInts(input_zero_points),
+                                          0};
+  float filter_scales[] = {kOutputDepth, 0.25f, 0.5f, 0.125f, 0.375f};
+  int filter_zero_points[] = {kOutputDepth, 0, 0, 0, 0};
+  TfLiteAffineQuantization filter_quant = {
+      FloatArrayFromFloats(filter_scales),
+      IntArrayFromInts(filter_zero_points), 0};
+  float output_scales[] = {1, output_scale};
+  int output_zero_points[] = {1, output_zero_point};
+  TfLiteAffineQuantization output_quant = {
+      FloatArrayFromFloats(output_scales),
+      IntArrayFromInts(output_zero_points), 0};
+
+  int8_t output_data[kMaxOutputLength];
+  constexpr int kTensorsSize = 4;
+  TfLiteTensor tensors[kTensorsSize] = {
+      CreateQuantizedTensor(input_data, IntArrayFromInts(input_shape),
+                            input_scale, input_zero_point),
+      CreateTensor(filter_data, IntArrayFromInts(filter_shape)),
+      CreateTensor(bias_data, IntArrayFromInts(bias_shape)),
+      CreateQuantizedTensor(output_data, IntArrayFromInts(output_shape),
+                            output_scale, output_zero_point),
+  };
+  tensors[0].quantization = {kTfLiteAffineQuantization, &input_quant};
+  tensors[1].quantization = {kTfLiteAffineQuantization, &filter_quant};
+  tensors[3].quantization = {kTfLiteAffineQuantization, &output_quant};
+
+  TfLiteConvParams conv_params = {padding, stride, stride, kTfLiteActNone, 1,
+                                  1};
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, InvokeConv(tensors, kTensorsSize, output_length,
+                            &conv_params, Register_CONV_2D(), output_data));
+
+  // Same multipliers as PopulateConvolutionQuantizationParams.
+  int32_t output_multiplier[kOutputDepth];
+  int32_t output_shift[kOutputDepth];
+  for (int i = 0; i < kOutputDepth; ++i) {
+    int shift;
+    QuantizeMultiplier(static_cast<double>(input_scale) *
+                           static_cast<double>(filter_scales[i + 1]) /
+                           static_cast<double>(output_scale),
+                       &output_multiplier[i], &shift);
+    output_shift[i] = shift;
+  }
+  ConvParams op_params;
+  op_params.input_offset = -input_zero_point;
+  op_params.output_offset = output_zero_point;
+  op_params.stride_height = stride;
+  op_params.stride_width = stride;
+  op_params.dilation_height_factor = 1;
+  op_params.dilation_width_factor = 1;
+  op_params.padding_values.height = padding_values.height;
+  op_params.padding_values.width = padding_values.width;
+  op_params.quantized_activation_min = std::numeric_limits<int8_t>::min();
+  op_params.quantized_activation_max = std::numeric_limits<int8_t>::max();
+  int8_t expected_output_data[kMaxOutputLength];
+  reference_integer_ops::ConvPerChannel(
+      op_params, output_multiplier, output_shift,
+      GetTensorShape(&tensors[0]), input_data, GetTensorShape(&tensors[1]),
+      filter_data, GetTensorShape(&tensors[2]), bias_data,
+      GetTensorShape(&tensors[3]), expected_output_data);
+
+  for (int i = 0; i < output_length; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(expected_output_data[i], output_data[i]);
+  }
+}
+#endif  // !defined(XTENSA)
+
 }  // namespace
 }  // namespace testing
 }  // namespace tflite
@@ -575,6 +704,28 @@ TF_LITE_MICRO_TEST(BroadcastPerLayerQuantizationToPerChannelShouldMatchGolden) {
                      tflite::Register_CONV_2D(), output_data, 1e-5, true));
 }
 
+TF_LITE_MICRO_TEST(Int8Filter3x3Stride1MatchesGenericKernel) {
+  tflite::testing::TestInt8ConvMatchesGenericKernel(3, 1, kTfLitePaddingSame);
+  tflite::testing::TestInt8ConvMatchesGenericKernel(3, 1,
+                                                    kTfLitePaddingValid);
+}
+
+TF_LITE_MICRO_TEST(Int8Filter3x3Stride2MatchesGenericKernel) {
+  tflite::testing::TestInt8ConvMatchesGenericKernel(3, 2, kTfLitePaddingSame);
+  tflite::testing::TestInt8ConvMatchesGenericKernel(3, 2,
+                                                    kTfLitePaddingValid);
+}
+
+TF_LITE_MICRO_TEST(Int8Filter1x1Stride1MatchesGenericKernel) {
+  tflite::testing::TestInt8ConvMatchesGenericKernel(1, 1, kTfLitePaddingSame);
+}
+
+TF_LITE_MICRO_TEST(Int8UnspecializedFilterMatchesGenericKernel) {
+  tflite::testing::TestInt8ConvMatchesGenericKernel(2, 1, kTfLitePaddingSame);
+  tflite::testing::TestInt8ConvMatchesGenericKernel(1, 2,
+                                                    kTfLitePaddingValid);
+}
+
 #endif  // !defined(XTENSA)
 
 TF_LITE_MICRO_TEST(FilterDimsNotMatchingAffineQuantization) {
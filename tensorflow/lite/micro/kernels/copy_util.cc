@@ -0,0 +1,77 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/copy_util.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+
+namespace tflite {
+namespace micro {
+
+int FlatSizeOfDims(const TfLiteIntArray* dims, int begin, int end) {
+  int size = 1;
+  for (int i = begin; i < end; ++i) {
+    size *= dims->data[i];
+  }
+  return size;
+}
+
+void CopyRuns(const void* src, int src_stride, void* dst, int dst_stride,
+              int run_bytes, int count) {
+  const uint8_t* src_bytes = static_cast<const uint8_t*>(src);
+  uint8_t* dst_bytes = static_cast<uint8_t*>(dst);
+  if (src_stride == run_bytes && dst_stride == run_bytes) {
+    std::memcpy(dst_bytes, src_bytes, run_bytes * count);
+    return;
+  }
+  for (int i = 0; i < count; ++i) {
+    std::memcpy(dst_bytes, src_bytes, run_bytes);
+    src_bytes += src_stride;
+    dst_bytes += dst_stride;
+  }
+}
+
+void FillElements(void* dst, const void* value, int element_bytes,
+                  int count) {
+  if (count <= 0) {
+    return;
+  }
+  const uint8_t* value_bytes = static_cast<const uint8_t*>(value);
+  uint8_t* dst_bytes = static_cast<uint8_t*>(dst);
+  bool uniform = true;
+  for (int i = 1; i < element_bytes; ++i) {
+    uniform = uniform && value_bytes[i] == value_bytes[0];
+  }
+  const int total_bytes = element_bytes * count;
+  if (uniform) {
+    std::memset(dst_bytes, value_bytes[0], total_bytes);
+    return;
+  }
+  // Writes the value once and then doubles the filled prefix with each copy.
+  std::memcpy(dst_bytes, value_bytes, element_bytes);
+  int filled = element_bytes;
+  while (filled < total_bytes) {
+    const int chunk =
+        filled < total_bytes - filled ? filled : total_bytes - filled;
+    std::memcpy(dst_bytes + filled, dst_bytes, chunk);
+    filled += chunk;
+  }
+}
+
+}  // namespace micro
+}  // namespace tflite
@@ -0,0 +1,49 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_COPY_UTIL_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_COPY_UTIL_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+// Helpers shared by the data movement kernels (CONCATENATION, SPLIT, PAD,
+// STRIDED_SLICE, ...). The kernels describe their work at Prepare time as runs
+// of contiguous bytes so that Eval reduces to a few memcpy/memset calls,
+// independently of the tensor type.
+
+namespace tflite {
+namespace micro {
+
+// Returns the product of dims->data[begin, end).
+int FlatSizeOfDims(const TfLiteIntArray* dims, int begin, int end);
+
+// Copies `count` runs of `run_bytes` contiguous bytes. Run i is read at
+// `src + i * src_stride` and written at `dst + i * dst_stride`, strides being
+// in bytes. Runs that follow each other in both buffers are copied with a
+// single memcpy.
+void CopyRuns(const void* src, int src_stride, void* dst, int dst_stride,
+              int run_bytes, int count);
+
+// Writes `count` copies of the `element_bytes` wide value at `value` to
+// `dst`. Uses memset when all the bytes of the value are equal, which covers
+// int8 tensors and zero padding of any type.
+void FillElements(void* dst, const void* value, int element_bytes, int count);
+
+}  // namespace micro
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_COPY_UTIL_H_
@@ -0,0 +1,139 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/copy_util.h"
+
+#include <cstdint>
+
+#include "tensorflow/lite/micro/test_helpers.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr uint8_t kUnwritten = 0xAB;
+constexpr int kBufferBytes = 32;
+
+void FillSource(uint8_t* src) {
+  for (int i = 0; i < kBufferBytes; ++i) {
+    src[i] = static_cast<uint8_t>(i + 1);
+  }
+}
+
+void ClearDestination(uint8_t* dst) {
+  for (int i = 0; i < kBufferBytes; ++i) {
+    dst[i] = kUnwritten;
+  }
+}
+
+// Runs CopyRuns and checks every byte of the destination: bytes covered by a
+// run hold the matching source byte, all the others are left untouched.
+void TestCopyRuns(int src_stride, int dst_stride, int run_bytes, int count) {
+  uint8_t src[kBufferBytes];
+  uint8_t dst[kBufferBytes];
+  FillSource(src);
+  ClearDestination(dst);
+
+  micro::CopyRuns(src, src_stride, dst, dst_stride, run_bytes, count);
+
+  uint8_t expected[kBufferBytes];
+  ClearDestination(expected);
+  for (int run = 0; run < count; ++run) {
+    for (int i = 0; i < run_bytes; ++i) {
+      expected[run * dst_stride + i] = src[run * src_stride + i];
+    }
+  }
+  for (int i = 0; i < kBufferBytes; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(expected[i], dst[i]);
+  }
+}
+
+template <typename T>
+void TestFillElements(T value, int count) {
+  constexpr int kMaxElements = kBufferBytes / sizeof(T);
+  T dst[kMaxElements];
+  ClearDestination(reinterpret_cast<uint8_t*>(dst));
+
+  micro::FillElements(dst, &value, sizeof(T), count);
+
+  for (int i = 0; i < count; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(value, dst[i]);
+  }
+  const uint8_t* dst_bytes = reinterpret_cast<const uint8_t*>(dst);
+  for (int i = count * sizeof(T); i < kBufferBytes; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(kUnwritten, dst_bytes[i]);
+  }
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(FlatSizeOfDimsMultipliesRange) {
+  int dims_data[] = {4, 2, 3, 4, 5};
+  TfLiteIntArray* dims = tflite::testing::IntArrayFromInts(dims_data);
+  TF_LITE_MICRO_EXPECT_EQ(120, tflite::micro::FlatSizeOfDims(dims, 0, 4));
+  TF_LITE_MICRO_EXPECT_EQ(12, tflite::micro::FlatSizeOfDims(dims, 1, 3));
+  TF_LITE_MICRO_EXPECT_EQ(1, tflite::micro::FlatSizeOfDims(dims, 2, 2));
+}
+
+TF_LITE_MICRO_TEST(CopyRunsContiguousInBothBuffers) {
+  // Both strides equal the run length, so the runs are copied as one block.
+  tflite::testing::TestCopyRuns(/*src_stride=*/4, /*dst_stride=*/4,
+                                /*run_bytes=*/4, /*count=*/5);
+}
+
+TF_LITE_MICRO_TEST(CopyRunsStridedSource) {
+  // Extracts columns of a row major source, like SPLIT on an inner axis.
+  tflite::testing::TestCopyRuns(/*src_stride=*/7, /*dst_stride=*/3,
+                                /*run_bytes=*/3, /*count=*/4);
+}
+
+TF_LITE_MICRO_TEST(CopyRunsStridedDestination) {
+  // Writes columns of a row major destination, like CONCATENATION on an inner
+  // axis.
+  tflite::testing::TestCopyRuns(/*src_stride=*/2, /*dst_stride=*/5,
+                                /*run_bytes=*/2, /*count=*/6);
+}
+
+TF_LITE_MICRO_TEST(CopyRunsStridedInBothBuffers) {
+  tflite::testing::TestCopyRuns(/*src_stride=*/6, /*dst_stride=*/4,
+                                /*run_bytes=*/1, /*count=*/5);
+}
+
+TF_LITE_MICRO_TEST(CopyRunsNoRuns) {
+  tflite::testing::TestCopyRuns(/*src_stride=*/4, /*dst_stride=*/4,
+                                /*run_bytes=*/4, /*count=*/0);
+}
+
+TF_LITE_MICRO_TEST(FillElementsUniformBytes) {
+  tflite::testing::TestFillElements<int8_t>(-3, 13);
+  tflite::testing::TestFillElements<float>(0.0f, 7);
+}
+
+TF_LITE_MICRO_TEST(FillElementsMixedBytes) {
+  tflite::testing::TestFillElements<int16_t>(0x0102, 11);
+  tflite::testing::TestFillElements<float>(1.5f, 5);
+  tflite::testing::TestFillElements<int32_t>(-7, 1);
+}
+
+TF_LITE_MICRO_TEST(FillElementsNoElements) {
+  tflite::testing::TestFillElements<int16_t>(0x0102, 0);
+}
+
+TF_LITE_MICRO_TESTS_END
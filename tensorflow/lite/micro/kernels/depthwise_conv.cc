@@ -53,32 +53,56 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           ? tflite::micro::GetEvalInput(context, node, kDepthwiseConvBiasTensor)
           : nullptr;
 
+  // Output rows are independent, so they are split across the thread pool
+  // bound to the context, if any, unless the memory planner placed the
+  // output over the input, which then has to be consumed in order.
+  const bool in_place = tflite::micro::IsComputedInPlace(node, input, output);
+  const RuntimeShape& input_shape =
+      tflite::micro::GetEvalInputShape(node, kDepthwiseConvInputTensor);
+  const RuntimeShape& filter_shape =
+      tflite::micro::GetEvalInputShape(node, kDepthwiseConvWeightsTensor);
+  const RuntimeShape bias_shape = tflite::micro::GetTensorShape(bias);
+  const RuntimeShape& output_shape =
+      tflite::micro::GetEvalOutputShape(node, kDepthwiseConvOutputTensor);
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32: {
-      tflite::reference_ops::DepthwiseConv(
-          DepthwiseConvParamsFloat(params, data),
-          tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<float>(input),
-          tflite::micro::GetTensorShape(filter),
-          tflite::micro::GetTensorData<float>(filter),
-          tflite::micro::GetTensorShape(bias),
-          tflite::micro::GetTensorData<float>(bias),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<float>(output));
+      const DepthwiseParams op_params = DepthwiseConvParamsFloat(params, data);
+      const float* input_data = tflite::micro::GetTensorData<float>(input);
+      float* output_data = tflite::micro::GetTensorData<float>(output);
+      tflite::micro::ParallelForOutputRows(
+          context, in_place, input_shape, output_shape,
+          op_params.stride_height, op_params.padding_values.height,
+          [&](const tflite::micro::OutputRowBand& band) {
+            DepthwiseParams band_params = op_params;
+            band_params.padding_values.height = band.padding_height;
+            tflite::reference_ops::DepthwiseConv(
+                band_params, band.input_shape, input_data + band.input_offset,
+                filter_shape, tflite::micro::GetTensorData<float>(filter),
+                bias_shape, tflite::micro::GetTensorData<float>(bias),
+                band.output_shape, output_data + band.output_offset);
+          });
       break;
     }
     case kTfLiteInt8: {
-      reference_integer_ops::DepthwiseConvPerChannel(
-          DepthwiseConvParamsQuantized(params, data),
-          data.per_channel_output_multiplier, data.per_channel_output_shift,
-          tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int8_t>(input),
-          tflite::micro::GetTensorShape(filter),
-          tflite::micro::GetTensorData<int8_t>(filter),
-          tflite::micro::GetTensorShape(bias),
-          tflite::micro::GetTensorData<int32_t>(bias),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int8_t>(output));
+      TFLITE_DCHECK(data.depthwise_conv_per_channel_int8 != nullptr);
+      const DepthwiseParams op_params =
+          DepthwiseConvParamsQuantized(params, data);
+      const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+      int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+      tflite::micro::ParallelForOutputRows(
+          context, in_place, input_shape, output_shape,
+          op_params.stride_height, op_params.padding_values.height,
+          [&](const tflite::micro::OutputRowBand& band) {
+            DepthwiseParams band_params = op_params;
+            band_params.padding_values.height = band.padding_height;
+            data.depthwise_conv_per_channel_int8(
+                band_params, data.per_channel_output_multiplier,
+                data.per_channel_output_shift, band.input_shape,
+                input_data + band.input_offset, filter_shape,
+                tflite::micro::GetTensorData<int8_t>(filter), bias_shape,
+                tflite::micro::GetTensorData<int32_t>(bias), band.output_shape,
+                output_data + band.output_offset);
+          });
       break;
     }
     default:
@@ -36,6 +36,31 @@ const int kDepthwiseConvOutputTensor = 0;
 // https://www.tensorflow.org/lite/performance/quantization_spec
 const int kDepthwiseConvQuantizedDimension = 3;
 
+namespace {
+
+// Returns the int8 kernel for a depthwise convolution with the given
+// parameters and filter size. Only undilated 3x3 filters with the same stride
+// in both dimensions are specialized.
+DepthwiseConvPerChannelInt8Fn SelectDepthwiseConvPerChannelInt8(
+    const TfLiteDepthwiseConvParams& params, int filter_width,
+    int filter_height) {
+  if (params.dilation_width_factor == 1 && params.dilation_height_factor == 1 &&
+      params.stride_width == params.stride_height && filter_width == 3 &&
+      filter_height == 3) {
+    if (params.stride_width == 1) {
+      return reference_integer_ops::DepthwiseConvPerChannelWithFilterShape<
+          3, 3, 1>;
+    }
+    if (params.stride_width == 2) {
+      return reference_integer_ops::DepthwiseConvPerChannelWithFilterShape<
+          3, 3, 2>;
+    }
+  }
+  return reference_integer_ops::DepthwiseConvPerChannel;
+}
+
+}  // namespace
+
 // Returns a DepthwiseParams struct with all the parameters needed for a
 // float computation.
 DepthwiseParams DepthwiseConvParamsFloat(
@@ -119,6 +144,8 @@ TfLiteStatus CalculateOpDataDepthwiseConv(
   data->input_zero_point = input->params.zero_point;
   data->filter_zero_point = filter->params.zero_point;
   data->output_zero_point = output->params.zero_point;
+  data->depthwise_conv_per_channel_int8 =
+      SelectDepthwiseConvPerChannelInt8(params, filter_width, filter_height);
 
   return kTfLiteOk;
 }
@@ -148,13 +175,10 @@ TfLiteStatus DepthwiseConvPrepare(TfLiteContext* context, TfLiteNode* node) {
   const int output_height = output->dims->data[1];
 
   // Dynamically allocate per-channel quantization parameters.
-  const int num_channels = filter->dims->data[kDepthwiseConvQuantizedDimension];
-  data->per_channel_output_multiplier =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
-  data->per_channel_output_shift =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
+  TF_LITE_ENSURE_STATUS(micro::AllocatePerChannelQuantizationParams(
+      context, input->type,
+      filter->dims->data[kDepthwiseConvQuantizedDimension],
+      &data->per_channel_output_multiplier, &data->per_channel_output_shift));
 
   // All per-channel quantized tensors need valid zero point and scale arrays.
   if (input->type == kTfLiteInt8) {
@@ -80,21 +80,23 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
   TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+  const RuntimeShape& input_shape = tflite::micro::GetEvalInputShape(node, 0);
+  const RuntimeShape& output_shape = tflite::micro::GetEvalOutputShape(node, 0);
 
   if (output->type == kTfLiteFloat32) {
     switch (input->type) {
       case kTfLiteInt8:
         reference_ops::Dequantize(data->quantization_params,
-                                  tflite::micro::GetTensorShape(input),
+                                  input_shape,
                                   tflite::micro::GetTensorData<int8_t>(input),
-                                  tflite::micro::GetTensorShape(output),
+                                  output_shape,
                                   tflite::micro::GetTensorData<float>(output));
         break;
       case kTfLiteInt16:
         reference_ops::Dequantize(data->quantization_params,
-                                  tflite::micro::GetTensorShape(input),
+                                  input_shape,
                                   tflite::micro::GetTensorData<int16_t>(input),
-                                  tflite::micro::GetTensorShape(output),
+                                  output_shape,
                                   tflite::micro::GetTensorData<float>(output));
         break;
       default:
@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cmath>
+#include <cstring>
 #include <numeric>
 
 #include "flatbuffers/flexbuffers.h"
@@ -36,6 +38,9 @@ namespace {
  * 1.) Temporaries (temporary tensors) - Micro use instead scratch buffer API.
  * 2.) Output dimensions - the TFLite version does not support undefined out
  * dimensions. So model must have static out dimensions.
+ * 3.) Candidate ordering - candidates are bucketed by score and each bucket is
+ * sorted only when the selection reaches it, which gives the same order as a
+ * full stable sort.
  */
 
 // Input tensors
@@ -54,6 +59,9 @@ constexpr int kBatchSize = 1;
 
 constexpr int kNumDetectionsPerClass = 100;
 
+// Number of buckets the candidate scores are spread over before sorting.
+constexpr int kNumScoreBuckets = 256;
+
 // Object Detection model produces axis-aligned boxes in two formats:
 // BoxCorner represents the lower left corner (xmin, ymin) and
 // the upper right corner (xmax, ymax).
@@ -97,11 +105,11 @@ struct OpData {
   CenterSizeEncoding scale_values;
 
   // Scratch buffers indexes
-  int active_candidate_idx;
   int decoded_boxes_idx;
+  int box_areas_idx;
   int scores_idx;
   int score_buffer_idx;
-  int keep_scores_idx;
+  int bucket_starts_idx;
   int scores_after_regular_non_max_suppression_idx;
   int sorted_values_idx;
   int keep_indices_idx;
@@ -179,11 +187,11 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   op_data->input_anchors.zero_point = input_anchors->params.zero_point;
 
   // Scratch tensors
-  context->RequestScratchBufferInArena(context, num_boxes,
-                                       &op_data->active_candidate_idx);
   context->RequestScratchBufferInArena(context,
                                        num_boxes * kNumCoordBox * sizeof(float),
                                        &op_data->decoded_boxes_idx);
+  context->RequestScratchBufferInArena(context, num_boxes * sizeof(float),
+                                       &op_data->box_areas_idx);
   context->RequestScratchBufferInArena(
       context,
       input_class_predictions->dims->data[1] *
@@ -193,8 +201,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   // Additional buffers
   context->RequestScratchBufferInArena(context, num_boxes * sizeof(float),
                                        &op_data->score_buffer_idx);
-  context->RequestScratchBufferInArena(context, num_boxes * sizeof(float),
-                                       &op_data->keep_scores_idx);
+  context->RequestScratchBufferInArena(context,
+                                       (kNumScoreBuckets + 1) * sizeof(int),
+                                       &op_data->bucket_starts_idx);
   context->RequestScratchBufferInArena(
       context, op_data->max_detections * num_boxes * sizeof(float),
       &op_data->scores_after_regular_non_max_suppression_idx);
@@ -245,8 +254,16 @@ T ReInterpretTensor(TfLiteEvalTensor* tensor) {
   return reinterpret_cast<T>(tensor_base);
 }
 
+// The decoded boxes and their areas, which are cached for the IoU computation.
+struct DecodedBoxes {
+  int num_boxes;
+  BoxCornerEncoding* boxes;
+  float* areas;
+};
+
 TfLiteStatus DecodeCenterSizeBoxes(TfLiteContext* context, TfLiteNode* node,
-                                   OpData* op_data) {
+                                   OpData* op_data,
+                                   DecodedBoxes* decoded_boxes) {
   // Parse input tensor boxencodings
   const TfLiteEvalTensor* input_box_encodings =
       tflite::micro::GetEvalInput(context, node, kInputTensorBoxEncodings);
@@ -256,6 +273,12 @@ TfLiteStatus DecodeCenterSizeBoxes(TfLiteContext* context, TfLiteNode* node,
   const TfLiteEvalTensor* input_anchors =
       tflite::micro::GetEvalInput(context, node, kInputTensorAnchors);
 
+  decoded_boxes->num_boxes = num_boxes;
+  decoded_boxes->boxes = reinterpret_cast<BoxCornerEncoding*>(
+      context->GetScratchBuffer(context, op_data->decoded_boxes_idx));
+  decoded_boxes->areas = reinterpret_cast<float*>(
+      context->GetScratchBuffer(context, op_data->box_areas_idx));
+
   // Decode the boxes to get (ymin, xmin, ymax, xmax) based on the anchors
   CenterSizeEncoding box_centersize;
   CenterSizeEncoding scale_values = op_data->scale_values;
@@ -299,13 +322,13 @@ TfLiteStatus DecodeCenterSizeBoxes(TfLiteContext* context, TfLiteNode* node,
                                      static_cast<double>(scale_values.w))) *
                            static_cast<double>(anchor.w));
 
-    float* decoded_boxes = reinterpret_cast<float*>(
-        context->GetScratchBuffer(context, op_data->decoded_boxes_idx));
-    auto& box = reinterpret_cast<BoxCornerEncoding*>(decoded_boxes)[idx];
+    auto& box = decoded_boxes->boxes[idx];
     box.ymin = ycenter - half_h;
     box.xmin = xcenter - half_w;
     box.ymax = ycenter + half_h;
     box.xmax = xcenter + half_w;
+    decoded_boxes->areas[idx] =
+        (box.ymax - box.ymin) * (box.xmax - box.xmin);
   }
   return kTfLiteOk;
 }
@@ -360,33 +383,35 @@ void MergeSort(int* values, int* scratch, const int num_values,
   TopDownMerge(values, scratch, half_num_values, num_values, compare);
 }
 
-void DecreasingArgSort(const float* values, int num_values, int* indices,
-                       int* scratch) {
-  std::iota(indices, indices + num_values, 0);
-
-  MergeSort(indices, scratch, num_values, [&values](const int i, const int j) {
-    return values[i] > values[j];
-  });
-}
-
-int SelectDetectionsAboveScoreThreshold(const float* values, int size,
-                                        const float threshold,
-                                        float* keep_values, int* keep_indices) {
-  int counter = 0;
-  for (int i = 0; i < size; i++) {
-    if (values[i] >= threshold) {
-      keep_values[counter] = values[i];
-      keep_indices[counter] = i;
-      counter++;
+// Maps the scores in [min_score, max_score] to kNumScoreBuckets buckets. The
+// mapping is monotonic, so a higher score never lands in a lower bucket.
+class ScoreBucketizer {
+ public:
+  ScoreBucketizer(float min_score, float max_score)
+      : min_score_(min_score), scale_(0.0f) {
+    // An empty or non-finite range puts every score in the first bucket.
+    const float scale = kNumScoreBuckets / (max_score - min_score);
+    if (std::isfinite(scale)) {
+      scale_ = scale;
     }
   }
-  return counter;
-}
+  int operator()(float score) const {
+    if (scale_ == 0.0f) {
+      return 0;
+    }
+    return std::min(static_cast<int>((score - min_score_) * scale_),
+                    kNumScoreBuckets - 1);
+  }
 
-bool ValidateBoxes(const float* decoded_boxes, const int num_boxes) {
-  for (int i = 0; i < num_boxes; ++i) {
+ private:
+  float min_score_;
+  float scale_;
+};
+
+bool ValidateBoxes(const DecodedBoxes* decoded_boxes) {
+  for (int i = 0; i < decoded_boxes->num_boxes; ++i) {
     // ymax>=ymin, xmax>=xmin
-    auto& box = reinterpret_cast<const BoxCornerEncoding*>(decoded_boxes)[i];
+    auto& box = decoded_boxes->boxes[i];
     if (box.ymin >= box.ymax || box.xmin >= box.xmax) {
       return false;
     }
@@ -394,12 +419,12 @@ bool ValidateBoxes(const float* decoded_boxes, const int num_boxes) {
   return true;
 }
 
-float ComputeIntersectionOverUnion(const float* decoded_boxes, const int i,
-                                   const int j) {
-  auto& box_i = reinterpret_cast<const BoxCornerEncoding*>(decoded_boxes)[i];
-  auto& box_j = reinterpret_cast<const BoxCornerEncoding*>(decoded_boxes)[j];
-  const float area_i = (box_i.ymax - box_i.ymin) * (box_i.xmax - box_i.xmin);
-  const float area_j = (box_j.ymax - box_j.ymin) * (box_j.xmax - box_j.xmin);
+float ComputeIntersectionOverUnion(const DecodedBoxes* decoded_boxes,
+                                   const int i, const int j) {
+  const auto& box_i = decoded_boxes->boxes[i];
+  const auto& box_j = decoded_boxes->boxes[j];
+  const float area_i = decoded_boxes->areas[i];
+  const float area_j = decoded_boxes->areas[j];
   if (area_i <= 0 || area_j <= 0) return 0.0;
   const float intersection_ymin = std::max<float>(box_i.ymin, box_j.ymin);
   const float intersection_xmin = std::max<float>(box_i.xmin, box_j.xmin);
@@ -413,17 +438,18 @@ float ComputeIntersectionOverUnion(const float* decoded_boxes, const int i,
 
 // NonMaxSuppressionSingleClass() prunes out the box locations with high overlap
 // before selecting the highest scoring boxes (max_detections in number)
-// It assumes all boxes are good in beginning and sorts based on the scores.
-// If lower-scoring box has too much overlap with a higher-scoring box,
-// we get rid of the lower-scoring box.
-// Complexity is O(N^2) pairwise comparison between boxes
+// It visits the boxes above the score threshold in decreasing score order.
+// If a box has too much overlap with a higher-scoring box that was already
+// selected, we get rid of it, otherwise it is selected.
+// The boxes are bucketed by score first and a bucket is only sorted once the
+// selection reaches it, so the visit stops as soon as max_detections boxes are
+// selected.
+// Complexity is O(N * max_detections) pairwise comparison between boxes
 TfLiteStatus NonMaxSuppressionSingleClassHelper(
     TfLiteContext* context, TfLiteNode* node, OpData* op_data,
-    const float* scores, int* selected, int* selected_size,
-    int max_detections) {
-  const TfLiteEvalTensor* input_box_encodings =
-      tflite::micro::GetEvalInput(context, node, kInputTensorBoxEncodings);
-  const int num_boxes = input_box_encodings->dims->data[1];
+    DecodedBoxes* decoded_boxes, const float* scores, int* selected,
+    int* selected_size, int max_detections) {
+  const int num_boxes = decoded_boxes->num_boxes;
   const float non_max_suppression_score_threshold =
       op_data->non_max_suppression_score_threshold;
   const float intersection_over_union_threshold =
@@ -435,65 +461,83 @@ TfLiteStatus NonMaxSuppressionSingleClassHelper(
   TF_LITE_ENSURE(context, (intersection_over_union_threshold > 0.0f) &&
                               (intersection_over_union_threshold <= 1.0f));
   // Validate boxes
-  float* decoded_boxes = reinterpret_cast<float*>(
-      context->GetScratchBuffer(context, op_data->decoded_boxes_idx));
-
-  TF_LITE_ENSURE(context, ValidateBoxes(decoded_boxes, num_boxes));
+  TF_LITE_ENSURE(context, ValidateBoxes(decoded_boxes));
 
   // threshold scores
-  int* keep_indices = reinterpret_cast<int*>(
-      context->GetScratchBuffer(context, op_data->keep_indices_idx));
-  float* keep_scores = reinterpret_cast<float*>(
-      context->GetScratchBuffer(context, op_data->keep_scores_idx));
-  int num_scores_kept = SelectDetectionsAboveScoreThreshold(
-      scores, num_boxes, non_max_suppression_score_threshold, keep_scores,
-      keep_indices);
-  int* sorted_indices = reinterpret_cast<int*>(
-      context->GetScratchBuffer(context, op_data->sorted_indices_idx));
-
-  // Reusing keep_indices for scratch buffer and write back its values
-  // after the sorting is done.
-  DecreasingArgSort(keep_scores, num_scores_kept, sorted_indices, keep_indices);
-  int counter = 0;
+  int num_boxes_kept = 0;
+  float min_score = 0.0f;
+  float max_score = 0.0f;
   for (int i = 0; i < num_boxes; i++) {
     if (scores[i] >= non_max_suppression_score_threshold) {
-      keep_indices[counter] = i;
-      counter++;
+      if (num_boxes_kept == 0) {
+        min_score = scores[i];
+        max_score = scores[i];
+      } else {
+        min_score = std::min(min_score, scores[i]);
+        max_score = std::max(max_score, scores[i]);
+      }
+      num_boxes_kept++;
     }
   }
 
-  const int num_boxes_kept = num_scores_kept;
   const int output_size = std::min(num_boxes_kept, max_detections);
   *selected_size = 0;
+  if (output_size == 0) {
+    return kTfLiteOk;
+  }
 
-  int num_active_candidate = num_boxes_kept;
-  uint8_t* active_box_candidate = reinterpret_cast<uint8_t*>(
-      context->GetScratchBuffer(context, op_data->active_candidate_idx));
-
-  for (int row = 0; row < num_boxes_kept; row++) {
-    active_box_candidate[row] = 1;
+  // Counting sort of the kept boxes into buckets, from the highest scores to
+  // the lowest. Within a bucket the boxes stay in index order.
+  const ScoreBucketizer bucketizer(min_score, max_score);
+  int* bucket_starts = reinterpret_cast<int*>(
+      context->GetScratchBuffer(context, op_data->bucket_starts_idx));
+  int* sorted_indices = reinterpret_cast<int*>(
+      context->GetScratchBuffer(context, op_data->sorted_indices_idx));
+  int* keep_indices = reinterpret_cast<int*>(
+      context->GetScratchBuffer(context, op_data->keep_indices_idx));
+  std::fill(bucket_starts, bucket_starts + kNumScoreBuckets + 1, 0);
+  for (int i = 0; i < num_boxes; i++) {
+    if (scores[i] >= non_max_suppression_score_threshold) {
+      bucket_starts[kNumScoreBuckets - bucketizer(scores[i])]++;
+    }
   }
-  for (int i = 0; i < num_boxes_kept; ++i) {
-    if (num_active_candidate == 0 || *selected_size >= output_size) break;
-    if (active_box_candidate[i] == 1) {
-      selected[(*selected_size)++] = keep_indices[sorted_indices[i]];
-      active_box_candidate[i] = 0;
-      num_active_candidate--;
-    } else {
-      continue;
+  for (int bucket = 1; bucket <= kNumScoreBuckets; bucket++) {
+    bucket_starts[bucket] += bucket_starts[bucket - 1];
+  }
+  for (int i = 0; i < num_boxes; i++) {
+    if (scores[i] >= non_max_suppression_score_threshold) {
+      const int bucket = kNumScoreBuckets - 1 - bucketizer(scores[i]);
+      sorted_indices[bucket_starts[bucket]++] = i;
     }
-    for (int j = i + 1; j < num_boxes_kept; ++j) {
-      if (active_box_candidate[j] == 1) {
-        float intersection_over_union = ComputeIntersectionOverUnion(
-            decoded_boxes, keep_indices[sorted_indices[i]],
-            keep_indices[sorted_indices[j]]);
+  }
 
+  // bucket_starts[bucket] now holds the end of the bucket.
+  int bucket_begin = 0;
+  for (int bucket = 0;
+       bucket < kNumScoreBuckets && *selected_size < output_size; bucket++) {
+    const int bucket_end = bucket_starts[bucket];
+    // Stable, so equal scores keep the lower box index first.
+    MergeSort(sorted_indices + bucket_begin, keep_indices,
+              bucket_end - bucket_begin, [&scores](const int i, const int j) {
+                return scores[i] > scores[j];
+              });
+    for (int i = bucket_begin; i < bucket_end && *selected_size < output_size;
+         ++i) {
+      const int candidate = sorted_indices[i];
+      bool suppressed = false;
+      for (int j = 0; j < *selected_size; ++j) {
+        float intersection_over_union =
+            ComputeIntersectionOverUnion(decoded_boxes, selected[j], candidate);
         if (intersection_over_union > intersection_over_union_threshold) {
-          active_box_candidate[j] = 0;
-          num_active_candidate--;
+          suppressed = true;
+          break;
         }
       }
+      if (!suppressed) {
+        selected[(*selected_size)++] = candidate;
+      }
     }
+    bucket_begin = bucket_end;
   }
 
   return kTfLiteOk;
@@ -506,10 +550,9 @@ TfLiteStatus NonMaxSuppressionSingleClassHelper(
 // 3) The worst runtime of the regular NMS is O(K*N^2)
 // where N is the number of anchors and K the number of
 // classes.
-TfLiteStatus NonMaxSuppressionMultiClassRegularHelper(TfLiteContext* context,
-                                                      TfLiteNode* node,
-                                                      OpData* op_data,
-                                                      const float* scores) {
+TfLiteStatus NonMaxSuppressionMultiClassRegularHelper(
+    TfLiteContext* context, TfLiteNode* node, OpData* op_data,
+    DecodedBoxes* decoded_boxes, const float* scores) {
   const TfLiteEvalTensor* input_box_encodings =
       tflite::micro::GetEvalInput(context, node, kInputTensorBoxEncodings);
   const TfLiteEvalTensor* input_class_predictions =
@@ -559,8 +602,8 @@ TfLiteStatus NonMaxSuppressionMultiClassRegularHelper(TfLiteContext* context,
     int* selected = reinterpret_cast<int*>(
         context->GetScratchBuffer(context, op_data->selected_idx));
     TF_LITE_ENSURE_STATUS(NonMaxSuppressionSingleClassHelper(
-        context, node, op_data, class_scores, selected, &selected_size,
-        num_detections_per_class));
+        context, node, op_data, decoded_boxes, class_scores, selected,
+        &selected_size, num_detections_per_class));
     // Add selected indices from non-max suppression of boxes in this class
     int output_index = size_of_sorted_indices;
     for (int i = 0; i < selected_size; i++) {
@@ -605,10 +648,8 @@ TfLiteStatus NonMaxSuppressionMultiClassRegularHelper(TfLiteContext* context,
       const float selected_score =
           scores_after_regular_non_max_suppression[output_box_index];
       // detection_boxes
-      float* decoded_boxes = reinterpret_cast<float*>(
-          context->GetScratchBuffer(context, op_data->decoded_boxes_idx));
       ReInterpretTensor<BoxCornerEncoding*>(detection_boxes)[output_box_index] =
-          reinterpret_cast<BoxCornerEncoding*>(decoded_boxes)[anchor_index];
+          decoded_boxes->boxes[anchor_index];
       // detection_classes
       tflite::micro::GetTensorData<float>(detection_classes)[output_box_index] =
           class_index;
@@ -642,6 +683,7 @@ TfLiteStatus NonMaxSuppressionMultiClassRegularHelper(TfLiteContext* context,
 TfLiteStatus NonMaxSuppressionMultiClassFastHelper(TfLiteContext* context,
                                                    TfLiteNode* node,
                                                    OpData* op_data,
+                                                   DecodedBoxes* decoded_boxes,
                                                    const float* scores) {
   const TfLiteEvalTensor* input_box_encodings =
       tflite::micro::GetEvalInput(context, node, kInputTensorBoxEncodings);
@@ -673,13 +715,18 @@ TfLiteStatus NonMaxSuppressionMultiClassFastHelper(TfLiteContext* context,
   int* sorted_class_indices = reinterpret_cast<int*>(
       context->GetScratchBuffer(context, op_data->buffer_idx));
 
+  // The classes are only sorted for the selected anchors, the suppression
+  // needs the highest class score alone.
   for (int row = 0; row < num_boxes; row++) {
     const float* box_scores =
         scores + row * num_classes_with_background + label_offset;
-    int* class_indices = sorted_class_indices + row * num_classes;
-    DecreasingPartialArgSort(box_scores, num_classes, num_categories_per_anchor,
-                             class_indices);
-    max_scores[row] = box_scores[class_indices[0]];
+    float max_score = box_scores[0];
+    for (int col = 1; col < num_classes; ++col) {
+      if (box_scores[col] > max_score) {
+        max_score = box_scores[col];
+      }
+    }
+    max_scores[row] = max_score;
   }
 
   // Perform non-maximal suppression on max scores
@@ -687,8 +734,8 @@ TfLiteStatus NonMaxSuppressionMultiClassFastHelper(TfLiteContext* context,
   int* selected = reinterpret_cast<int*>(
       context->GetScratchBuffer(context, op_data->selected_idx));
   TF_LITE_ENSURE_STATUS(NonMaxSuppressionSingleClassHelper(
-      context, node, op_data, max_scores, selected, &selected_size,
-      op_data->max_detections));
+      context, node, op_data, decoded_boxes, max_scores, selected,
+      &selected_size, op_data->max_detections));
 
   // Allocate output tensors
   int output_box_index = 0;
@@ -698,17 +745,16 @@ TfLiteStatus NonMaxSuppressionMultiClassFastHelper(TfLiteContext* context,
 
     const float* box_scores =
         scores + selected_index * num_classes_with_background + label_offset;
-    const int* class_indices =
-        sorted_class_indices + selected_index * num_classes;
+    int* class_indices = sorted_class_indices + selected_index * num_classes;
+    DecreasingPartialArgSort(box_scores, num_classes, num_categories_per_anchor,
+                             class_indices);
 
     for (int col = 0; col < num_categories_per_anchor; ++col) {
       int box_offset = num_categories_per_anchor * output_box_index + col;
 
       // detection_boxes
-      float* decoded_boxes = reinterpret_cast<float*>(
-          context->GetScratchBuffer(context, op_data->decoded_boxes_idx));
       ReInterpretTensor<BoxCornerEncoding*>(detection_boxes)[box_offset] =
-          reinterpret_cast<BoxCornerEncoding*>(decoded_boxes)[selected_index];
+          decoded_boxes->boxes[selected_index];
 
       // detection_classes
       tflite::micro::GetTensorData<float>(detection_classes)[box_offset] =
@@ -727,7 +773,8 @@ TfLiteStatus NonMaxSuppressionMultiClassFastHelper(TfLiteContext* context,
 }
 
 TfLiteStatus NonMaxSuppressionMultiClass(TfLiteContext* context,
-                                         TfLiteNode* node, OpData* op_data) {
+                                         TfLiteNode* node, OpData* op_data,
+                                         DecodedBoxes* decoded_boxes) {
   // Get the input tensors
   const TfLiteEvalTensor* input_box_encodings =
       tflite::micro::GetEvalInput(context, node, kInputTensorBoxEncodings);
@@ -757,10 +804,10 @@ TfLiteStatus NonMaxSuppressionMultiClass(TfLiteContext* context,
 
   if (op_data->use_regular_non_max_suppression) {
     TF_LITE_ENSURE_STATUS(NonMaxSuppressionMultiClassRegularHelper(
-        context, node, op_data, scores));
+        context, node, op_data, decoded_boxes, scores));
   } else {
-    TF_LITE_ENSURE_STATUS(
-        NonMaxSuppressionMultiClassFastHelper(context, node, op_data, scores));
+    TF_LITE_ENSURE_STATUS(NonMaxSuppressionMultiClassFastHelper(
+        context, node, op_data, decoded_boxes, scores));
   }
 
   return kTfLiteOk;
@@ -779,13 +826,16 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   // This fills in temporary decoded_boxes
   // by transforming input_box_encodings and input_anchors from
   // CenterSizeEncodings to BoxCornerEncoding
-  TF_LITE_ENSURE_STATUS(DecodeCenterSizeBoxes(context, node, op_data));
+  DecodedBoxes decoded_boxes;
+  TF_LITE_ENSURE_STATUS(
+      DecodeCenterSizeBoxes(context, node, op_data, &decoded_boxes));
 
   // This fills in the output tensors
   // by choosing effective set of decoded boxes
   // based on Non Maximal Suppression, i.e. selecting
   // highest scoring non-overlapping boxes.
-  TF_LITE_ENSURE_STATUS(NonMaxSuppressionMultiClass(context, node, op_data));
+  TF_LITE_ENSURE_STATUS(
+      NonMaxSuppressionMultiClass(context, node, op_data, &decoded_boxes));
 
   return kTfLiteOk;
 }
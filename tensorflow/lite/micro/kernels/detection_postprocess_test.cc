@@ -13,6 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstring>
+#include <limits>
+
 #include "flatbuffers/flexbuffers.h"
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
@@ -74,16 +77,12 @@ constexpr float kGolden2[] = {1, 0, 0};
 constexpr float kGolden3[] = {0.95, 0.9, 0.3};
 constexpr float kGolden4[] = {3.0};
 
-void TestDetectionPostprocess(int* input_dims_data1, const float* input_data1,
-                              int* input_dims_data2, const float* input_data2,
-                              int* input_dims_data3, const float* input_data3,
-                              int* output_dims_data1, float* output_data1,
-                              int* output_dims_data2, float* output_data2,
-                              int* output_dims_data3, float* output_data3,
-                              int* output_dims_data4, float* output_data4,
-                              const float* golden1, const float* golden2,
-                              const float* golden3, const float* golden4,
-                              const float tolerance, bool use_regular_nms) {
+TfLiteStatus InvokeDetectionPostprocess(
+    int* input_dims_data1, const float* input_data1, int* input_dims_data2,
+    const float* input_data2, int* input_dims_data3, const float* input_data3,
+    int* output_dims_data1, float* output_data1, int* output_dims_data2,
+    float* output_data2, int* output_dims_data3, float* output_data3,
+    int* output_dims_data4, float* output_data4, bool use_regular_nms) {
   TfLiteIntArray* input_dims1 = IntArrayFromInts(input_dims_data1);
   TfLiteIntArray* input_dims2 = IntArrayFromInts(input_dims_data2);
   TfLiteIntArray* input_dims3 = IntArrayFromInts(input_dims_data3);
@@ -137,12 +136,35 @@ void TestDetectionPostprocess(int* input_dims_data1, const float* input_data1,
       kTfLiteOk, runner.InitAndPrepare(reinterpret_cast<const char*>(init_data),
                                        data_size));
 
-  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, runner.Invoke());
+  return runner.Invoke();
+}
 
-  int output_elements_count1 = ElementCount(*tensors[3].dims);
-  int output_elements_count2 = ElementCount(*tensors[4].dims);
-  int output_elements_count3 = ElementCount(*tensors[5].dims);
-  int output_elements_count4 = ElementCount(*tensors[6].dims);
+void TestDetectionPostprocess(int* input_dims_data1, const float* input_data1,
+                              int* input_dims_data2, const float* input_data2,
+                              int* input_dims_data3, const float* input_data3,
+                              int* output_dims_data1, float* output_data1,
+                              int* output_dims_data2, float* output_data2,
+                              int* output_dims_data3, float* output_data3,
+                              int* output_dims_data4, float* output_data4,
+                              const float* golden1, const float* golden2,
+                              const float* golden3, const float* golden4,
+                              const float tolerance, bool use_regular_nms) {
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk,
+      InvokeDetectionPostprocess(
+          input_dims_data1, input_data1, input_dims_data2, input_data2,
+          input_dims_data3, input_data3, output_dims_data1, output_data1,
+          output_dims_data2, output_data2, output_dims_data3, output_data3,
+          output_dims_data4, output_data4, use_regular_nms));
+
+  const int output_elements_count1 =
+      ElementCount(*IntArrayFromInts(output_dims_data1));
+  const int output_elements_count2 =
+      ElementCount(*IntArrayFromInts(output_dims_data2));
+  const int output_elements_count3 =
+      ElementCount(*IntArrayFromInts(output_dims_data3));
+  const int output_elements_count4 =
+      ElementCount(*IntArrayFromInts(output_dims_data4));
 
   for (int i = 0; i < output_elements_count1; ++i) {
     TF_LITE_MICRO_EXPECT_NEAR(golden1[i], output_data1[i], tolerance);
@@ -157,6 +179,32 @@ void TestDetectionPostprocess(int* input_dims_data1, const float* input_data1,
     TF_LITE_MICRO_EXPECT_NEAR(golden4[i], output_data4[i], tolerance);
   }
 }
+
+// Runs the default inputs with a malformed anchor whose scores are below the
+// score threshold, so that its box is never selected.
+void TestMalformedAnchorFails(bool use_regular_nms) {
+  float input_data2[18];
+  float input_data3[24];
+  memcpy(input_data2, kInputData2, sizeof(input_data2));
+  memcpy(input_data3, kInputData3, sizeof(input_data3));
+  // Anchor #6 has a height of 0, so its ymin equals its ymax.
+  input_data3[5 * 4 + 2] = 0.0f;
+  input_data2[5 * 3 + 1] = -0.3f;
+  input_data2[5 * 3 + 2] = -0.2f;
+
+  float output_data1[12];
+  float output_data2[3];
+  float output_data3[3];
+  float output_data4[1];
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteError,
+      InvokeDetectionPostprocess(
+          kInputShape1, kInputData1, kInputShape2, input_data2, kInputShape3,
+          input_data3, kOutputShape1, output_data1, kOutputShape2,
+          output_data2, kOutputShape3, output_data3, kOutputShape4,
+          output_data4, use_regular_nms));
+}
+
 }  // namespace
 }  // namespace testing
 }  // namespace tflite
@@ -338,4 +386,147 @@ TF_LITE_MICRO_TEST(
       /* tolerance */ 3e-1, /* Use regular NMS: */ false);
 }
 
+TF_LITE_MICRO_TEST(DetectionPostprocessFloatFastNMSManyAnchorsWithTies) {
+  int kInputShape1[] = {3, 1, 20, 4};
+  int kInputShape2[] = {3, 1, 20, 3};
+  int kInputShape3[] = {2, 20, 4};
+
+  // twenty boxes with no offset from their anchors
+  float input_data1[20 * 4] = {};
+
+  // class scores - two classes with background. Scores are spread over a wide
+  // range and tie across anchors, so the selection order depends on the
+  // anchor index for equal scores.
+  const float kInputData2[] = {
+      0., .001, .3,   0., .8,  .1,   0., .8,   .2,   0., .5,   .6,    // #1-4
+      0., .05,  .02,  0., .2,  .8,   0., .7,   .01,  0., .8,   .3,    // #5-8
+      0., .8,   .1,   0., .4,  .25,  0., .8,   .79,  0., .15,  .002,  // #9-12
+      0., .9,   .1,   0., .3,  .9,   0., .95,  .0,   0., .6,   .0,    // #13-16
+      0., -.5,  -.1,  0., -.2, -.3,  0., -.05, -.9,  0., -.7,  -.4};  // #17-20
+
+  // five groups of four overlapping anchors in center-size encoding
+  const float kInputData3[] = {
+      0.5, 0.5,  1.0, 1.0, 0.5, 0.6,  1.0, 1.0, 0.5, 0.7,  1.0, 1.0,
+      0.5, 0.8,  1.0, 1.0, 0.5, 10.5, 1.0, 1.0, 0.5, 10.6, 1.0, 1.0,
+      0.5, 10.7, 1.0, 1.0, 0.5, 10.8, 1.0, 1.0, 0.5, 20.5, 1.0, 1.0,
+      0.5, 20.6, 1.0, 1.0, 0.5, 20.7, 1.0, 1.0, 0.5, 20.8, 1.0, 1.0,
+      0.5, 30.5, 1.0, 1.0, 0.5, 30.6, 1.0, 1.0, 0.5, 30.7, 1.0, 1.0,
+      0.5, 30.8, 1.0, 1.0, 0.5, 40.5, 1.0, 1.0, 0.5, 40.6, 1.0, 1.0,
+      0.5, 40.7, 1.0, 1.0, 0.5, 40.8, 1.0, 1.0};
+
+  const float kGolden1[] = {0.0, 30.2, 1.0, 31.2, 0.0, 0.1,
+                            1.0, 1.1,  0.0, 10.1, 1.0, 11.1};
+  const float kGolden2[] = {0, 0, 1};
+  const float kGolden3[] = {0.95, 0.8, 0.8};
+  const float kGolden4[] = {3.0};
+
+  float output_data1[12];
+  float output_data2[3];
+  float output_data3[3];
+  float output_data4[1];
+
+  tflite::testing::TestDetectionPostprocess(
+      kInputShape1, input_data1, kInputShape2, kInputData2, kInputShape3,
+      kInputData3, tflite::testing::kOutputShape1, output_data1,
+      tflite::testing::kOutputShape2, output_data2,
+      tflite::testing::kOutputShape3, output_data3,
+      tflite::testing::kOutputShape4, output_data4, kGolden1, kGolden2,
+      kGolden3, kGolden4,
+      /* tolerance */ 1e-5, /* Use regular NMS: */ false);
+}
+
+TF_LITE_MICRO_TEST(DetectionPostprocessFloatRegularNMSManyAnchorsWithTies) {
+  int kInputShape1[] = {3, 1, 20, 4};
+  int kInputShape2[] = {3, 1, 20, 3};
+  int kInputShape3[] = {2, 20, 4};
+
+  // twenty boxes with no offset from their anchors
+  float input_data1[20 * 4] = {};
+
+  // class scores - two classes with background. Scores are spread over a wide
+  // range and tie across anchors, so the selection order depends on the
+  // anchor index for equal scores.
+  const float kInputData2[] = {
+      0., .001, .3,   0., .8,  .1,   0., .8,   .2,   0., .5,   .6,    // #1-4
+      0., .05,  .02,  0., .2,  .8,   0., .7,   .01,  0., .8,   .3,    // #5-8
+      0., .8,   .1,   0., .4,  .25,  0., .8,   .79,  0., .15,  .002,  // #9-12
+      0., .9,   .1,   0., .3,  .9,   0., .95,  .0,   0., .6,   .0,    // #13-16
+      0., -.5,  -.1,  0., -.2, -.3,  0., -.05, -.9,  0., -.7,  -.4};  // #17-20
+
+  // five groups of four overlapping anchors in center-size encoding
+  const float kInputData3[] = {
+      0.5, 0.5,  1.0, 1.0, 0.5, 0.6,  1.0, 1.0, 0.5, 0.7,  1.0, 1.0,
+      0.5, 0.8,  1.0, 1.0, 0.5, 10.5, 1.0, 1.0, 0.5, 10.6, 1.0, 1.0,
+      0.5, 10.7, 1.0, 1.0, 0.5, 10.8, 1.0, 1.0, 0.5, 20.5, 1.0, 1.0,
+      0.5, 20.6, 1.0, 1.0, 0.5, 20.7, 1.0, 1.0, 0.5, 20.8, 1.0, 1.0,
+      0.5, 30.5, 1.0, 1.0, 0.5, 30.6, 1.0, 1.0, 0.5, 30.7, 1.0, 1.0,
+      0.5, 30.8, 1.0, 1.0, 0.5, 40.5, 1.0, 1.0, 0.5, 40.6, 1.0, 1.0,
+      0.5, 40.7, 1.0, 1.0, 0.5, 40.8, 1.0, 1.0};
+
+  const float kGolden1[] = {0.0, 30.2, 1.0, 31.2, 0.0, 30.1,
+                            1.0, 31.1, 0.0, 0.0,  0.0, 0.0};
+  const float kGolden2[] = {0, 1, 0};
+  const float kGolden3[] = {0.95, 0.9, 0.0};
+  const float kGolden4[] = {2.0};
+
+  float output_data1[12];
+  float output_data2[3];
+  float output_data3[3];
+  float output_data4[1];
+
+  tflite::testing::TestDetectionPostprocess(
+      kInputShape1, input_data1, kInputShape2, kInputData2, kInputShape3,
+      kInputData3, tflite::testing::kOutputShape1, output_data1,
+      tflite::testing::kOutputShape2, output_data2,
+      tflite::testing::kOutputShape3, output_data3,
+      tflite::testing::kOutputShape4, output_data4, kGolden1, kGolden2,
+      kGolden3, kGolden4,
+      /* tolerance */ 1e-5, /* Use regular NMS: */ true);
+}
+
+TF_LITE_MICRO_TEST(
+    DetectionPostprocessFastNMSFailsOnUnselectedMalformedAnchor) {
+  tflite::testing::TestMalformedAnchorFails(/* Use regular NMS: */ false);
+}
+
+TF_LITE_MICRO_TEST(
+    DetectionPostprocessRegularNMSFailsOnUnselectedMalformedAnchor) {
+  tflite::testing::TestMalformedAnchorFails(/* Use regular NMS: */ true);
+}
+
+TF_LITE_MICRO_TEST(DetectionPostprocessFloatFastNMSAcceptsNaNBox) {
+  // Box #6 decodes to NaN coordinates, which do not fail the ymin >= ymax and
+  // xmin >= xmax validation.
+  float input_data1[24];
+  memcpy(input_data1, tflite::testing::kInputData1, sizeof(input_data1));
+  input_data1[5 * 4] = std::numeric_limits<float>::quiet_NaN();
+
+  float output_data1[12];
+  float output_data2[3];
+  float output_data3[3];
+  float output_data4[1];
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk,
+      tflite::testing::InvokeDetectionPostprocess(
+          tflite::testing::kInputShape1, input_data1,
+          tflite::testing::kInputShape2, tflite::testing::kInputData2,
+          tflite::testing::kInputShape3, tflite::testing::kInputData3,
+          tflite::testing::kOutputShape1, output_data1,
+          tflite::testing::kOutputShape2, output_data2,
+          tflite::testing::kOutputShape3, output_data3,
+          tflite::testing::kOutputShape4, output_data4,
+          /* Use regular NMS: */ false));
+
+  // The NaN box overlaps no other box, so it is still the third detection.
+  TF_LITE_MICRO_EXPECT_EQ(3.0f, output_data4[0]);
+  for (int i = 0; i < 8; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(tflite::testing::kGolden1[i], output_data1[i]);
+  }
+  TF_LITE_MICRO_EXPECT_NE(output_data1[8], output_data1[8]);
+  for (int i = 0; i < 3; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(tflite::testing::kGolden2[i], output_data2[i]);
+    TF_LITE_MICRO_EXPECT_EQ(tflite::testing::kGolden3[i], output_data3[i]);
+  }
+}
+
 TF_LITE_MICRO_TESTS_END
@@ -15,8 +15,7 @@ limitations under the License.
 
 #include "tensorflow/lite/kernels/internal/reference/elu.h"
 
-#include <algorithm>
-#include <limits>
+#include <cmath>
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/cppmath.h"
@@ -25,7 +24,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
-#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
 
 namespace tflite {
 namespace {
@@ -38,45 +37,12 @@ constexpr int kOutputTensor = 0;
 // of the activation ops below.
 
 struct OpData {
-  int8_t table[256];
+  // Lookup table for the int8 path, built in Prepare.
+  int8_t* lut;
 };
 
-using TransformFunc = float (*)(float);
-
-template <typename T>
-void PopulateLookupTable(const TfLiteTensor* input, const TfLiteTensor* output,
-                         const TransformFunc transform, OpData* data) {
-  if (sizeof(T) != 1) {
-    MicroPrintf("Lookup table valid only for 8bit");
-    TFLITE_ABORT;
-  }
-
-  const float inverse_scale = 1 / output->params.scale;
-  int32_t maxval = std::numeric_limits<T>::max();
-  int32_t minval = std::numeric_limits<T>::min();
-  for (int32_t val = minval; val <= maxval; ++val) {
-    const float dequantized =
-        input->params.scale * (val - input->params.zero_point);
-    const float transformed = transform(dequantized);
-    const float rescaled = TfLiteRound(transformed * inverse_scale);
-    const int32_t quantized =
-        static_cast<int32_t>(rescaled + output->params.zero_point);
-    data->table[static_cast<uint8_t>(static_cast<T>(val))] =
-        static_cast<T>(std::max(std::min(maxval, quantized), minval));
-  }
-}
-
-// OLD-TODO(b/143696793): move this to optimized_ops.
-void EvalUsingLookupTable(const OpData* data, const TfLiteEvalTensor* input,
-                          TfLiteEvalTensor* output) {
-  const int size = MatchingFlatSize(tflite::micro::GetTensorShape(input),
-                                    tflite::micro::GetTensorShape(output));
-  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
-  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
-
-  for (int i = 0; i < size; ++i) {
-    output_data[i] = data->table[static_cast<uint8_t>(input_data[i])];
-  }
+float EluTransform(float value) {
+  return value < 0.0f ? std::exp(value) - 1.0f : value;
 }
 
 TfLiteStatus CalculateOpData(TfLiteContext* context, TfLiteNode* node) {
@@ -92,10 +58,9 @@ TfLiteStatus CalculateOpData(TfLiteContext* context, TfLiteNode* node) {
   // Use LUT to handle quantized elu path.
   if (input->type == kTfLiteInt8) {
     OpData* data = static_cast<OpData*>(node->user_data);
-    TransformFunc transform = [](float value) {
-      return value < 0.0f ? std::exp(value) - 1.0f : value;
-    };
-    PopulateLookupTable<int8_t>(input, output, transform, data);
+    data->lut =
+        CreateInt8UnaryLutFromFloat(context, input, output, EluTransform);
+    TF_LITE_ENSURE(context, data->lut != nullptr);
   }
 
   return kTfLiteOk;
@@ -128,7 +93,7 @@ TfLiteStatus EluEval(TfLiteContext* context, TfLiteNode* node) {
     }
     case kTfLiteInt8: {
       const OpData* data = static_cast<OpData*>(node->user_data);
-      EvalUsingLookupTable(data, input, output);
+      EvalInt8UnaryLut(data->lut, input, output);
       return kTfLiteOk;
     }
     default:
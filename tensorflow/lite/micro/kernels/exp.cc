@@ -15,10 +15,13 @@ limitations under the License.
 
 #include "tensorflow/lite/kernels/internal/reference/exp.h"
 
+#include <cmath>
+
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
 
 namespace tflite {
 namespace {
@@ -26,6 +29,18 @@ namespace {
 constexpr int kInputTensor = 0;
 constexpr int kOutputTensor = 0;
 
+struct OpData {
+  // Lookup table for the int8 path, built in Prepare.
+  int8_t* lut;
+};
+
+float ExpTransform(float value) { return std::exp(value); }
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 1);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -33,13 +48,21 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, input != nullptr);
   TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
   TF_LITE_ENSURE(context, output != nullptr);
-  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteFloat32);
+  TF_LITE_ENSURE(context,
+                 input->type == kTfLiteFloat32 || input->type == kTfLiteInt8);
   TF_LITE_ENSURE_TYPES_EQ(context, output->type, input->type);
   TF_LITE_ENSURE_EQ(context, output->bytes, input->bytes);
   TF_LITE_ENSURE_EQ(context, output->dims->size, input->dims->size);
   for (int i = 0; i < output->dims->size; ++i) {
     TF_LITE_ENSURE_EQ(context, output->dims->data[i], input->dims->data[i]);
   }
+
+  if (input->type == kTfLiteInt8) {
+    OpData* data = static_cast<OpData*>(node->user_data);
+    data->lut =
+        CreateInt8UnaryLutFromFloat(context, input, output, ExpTransform);
+    TF_LITE_ENSURE(context, data->lut != nullptr);
+  }
   return kTfLiteOk;
 }
 
@@ -55,6 +78,9 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     reference_ops::Exp(tflite::micro::GetTensorData<float>(input),
                        static_cast<size_t>(flat_size),
                        tflite::micro::GetTensorData<float>(output));
+  } else if (input->type == kTfLiteInt8) {
+    const OpData* data = static_cast<const OpData*>(node->user_data);
+    EvalInt8UnaryLut(data->lut, input, output);
   } else {
     TF_LITE_KERNEL_LOG(context, "Type %s (%d) currently not supported by Exp.",
                        TfLiteTypeGetName(input->type), input->type);
@@ -65,7 +91,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration Register_EXP() {
-  return {/*init=*/nullptr,
+  return {/*init=*/Init,
           /*free=*/nullptr,
           /*prepare=*/Prepare,
           /*invoke=*/Eval,
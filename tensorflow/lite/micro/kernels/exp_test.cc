@@ -54,6 +54,45 @@ void TestExp(int* input_dims_data, const float* input_data,
     TF_LITE_MICRO_EXPECT_NEAR(expected_output_data[i], output_data[i], 1e-5f);
   }
 }
+
+void TestExpQuantized(int* input_dims_data, const float* input_data,
+                      int8_t* input_quantized, float input_scale,
+                      int input_zero_point, const float* expected_output_data,
+                      int8_t* output_data, float output_scale,
+                      int output_zero_point) {
+  TfLiteIntArray* input_dims = IntArrayFromInts(input_dims_data);
+  TfLiteIntArray* output_dims = IntArrayFromInts(input_dims_data);
+  const int output_dims_count = ElementCount(*output_dims);
+  constexpr int inputs_size = 1;
+  constexpr int outputs_size = 1;
+  constexpr int tensors_size = inputs_size + outputs_size;
+  TfLiteTensor tensors[tensors_size] = {
+      CreateQuantizedTensor(input_data, input_quantized, input_dims,
+                            input_scale, input_zero_point),
+      CreateQuantizedTensor(output_data, output_dims, output_scale,
+                            output_zero_point),
+  };
+
+  int inputs_array_data[] = {1, 0};
+  TfLiteIntArray* inputs_array = IntArrayFromInts(inputs_array_data);
+  int outputs_array_data[] = {1, 1};
+  TfLiteIntArray* outputs_array = IntArrayFromInts(outputs_array_data);
+
+  const TfLiteRegistration registration = Register_EXP();
+  micro::KernelRunner runner(registration, tensors, tensors_size, inputs_array,
+                             outputs_array,
+                             /*builtin_data=*/nullptr);
+
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, runner.InitAndPrepare());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, runner.Invoke());
+  for (int i = 0; i < output_dims_count; ++i) {
+    const float dequantized =
+        output_scale * (output_data[i] - output_zero_point);
+    TF_LITE_MICRO_EXPECT_NEAR(expected_output_data[i], dequantized,
+                              output_scale);
+  }
+}
+
 }  // namespace
 }  // namespace testing
 }  // namespace tflite
@@ -74,4 +113,25 @@ TF_LITE_MICRO_TEST(SingleDim) {
   tflite::testing::TestExp(input_dims, input_values, golden, output_data);
 }
 
+TF_LITE_MICRO_TEST(SingleDimInt8) {
+  constexpr int kInputSize = 7;
+  int8_t input_quantized[kInputSize];
+  int8_t output_data[kInputSize];
+  int input_dims[] = {2, 1, kInputSize};
+  const float input_values[kInputSize] = {0.0f,  1.0f,   -1.0f, 2.0f,
+                                          -4.0f, 0.125f, -0.125f};
+  const float input_scale = 8.0f / 256.0f;
+  const int input_zero_point = 0;
+  const float output_scale = 8.0f / 256.0f;
+  const int output_zero_point = -128;
+  float golden[kInputSize];
+  for (int i = 0; i < kInputSize; ++i) {
+    golden[i] = std::exp(input_values[i]);
+  }
+
+  tflite::testing::TestExpQuantized(
+      input_dims, input_values, input_quantized, input_scale, input_zero_point,
+      golden, output_data, output_scale, output_zero_point);
+}
+
 TF_LITE_MICRO_TESTS_END
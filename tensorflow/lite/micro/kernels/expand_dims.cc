@@ -118,6 +118,11 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   }
   ExpandTensorDim(context, input, axis_value, output);
 
+  // Nothing to copy when the memory planner aliased the output to the input.
+  if (input->data.raw == output->data.raw) {
+    return kTfLiteOk;
+  }
+
   switch (input->type) {
     case kTfLiteFloat32: {
       memCopyN(tflite::micro::GetTensorData<float>(output),
@@ -28,6 +28,39 @@ limitations under the License.
 namespace tflite {
 namespace {
 
+// Splits the output channels of a fully connected layer across the thread pool
+// bound to `context`. `fn` is called with equivalent 2D shapes covering either
+// the whole layer, or a range of output channels of a single batch.
+template <typename Fn>
+void ParallelForOutputChannels(TfLiteContext* context, int batches,
+                               int output_depth, int accum_depth,
+                               const Fn& fn) {
+  tflite::micro::ParallelForRange(
+      context, output_depth, [&](int channel_start, int channel_end) {
+        const int channels = channel_end - channel_start;
+        const int32_t filter_dims[2] = {channels, accum_depth};
+        const RuntimeShape filter_slice_shape(2, filter_dims);
+        if (channels == output_depth) {
+          const int32_t input_dims[2] = {batches, accum_depth};
+          const int32_t output_dims[2] = {batches, output_depth};
+          fn(RuntimeShape(2, input_dims), 0, filter_slice_shape, 0,
+             RuntimeShape(2, output_dims), 0);
+          return;
+        }
+        // The output rows of a channel range are strided, so each batch is
+        // computed separately.
+        const int32_t input_dims[2] = {1, accum_depth};
+        const int32_t output_dims[2] = {1, channels};
+        const RuntimeShape input_slice_shape(2, input_dims);
+        const RuntimeShape output_slice_shape(2, output_dims);
+        for (int b = 0; b < batches; ++b) {
+          fn(input_slice_shape, b * accum_depth, filter_slice_shape,
+             channel_start, output_slice_shape,
+             b * output_depth + channel_start);
+        }
+      });
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
   return context->AllocatePersistentBuffer(context,
@@ -79,33 +112,59 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   const auto& data =
       *(static_cast<const OpDataFullyConnected*>(node->user_data));
 
+  const RuntimeShape& filter_shape =
+      tflite::micro::GetEvalInputShape(node, kFullyConnectedWeightsTensor);
+  const RuntimeShape& bias_shape =
+      tflite::micro::GetEvalInputShape(node, kFullyConnectedBiasTensor);
+  const RuntimeShape& output_shape =
+      tflite::micro::GetEvalOutputShape(node, kFullyConnectedOutputTensor);
+  const int output_depth = output_shape.Dims(output_shape.DimensionsCount() - 1);
+  const int batches = output_shape.FlatSize() / output_depth;
+  const int accum_depth = filter_shape.Dims(filter_shape.DimensionsCount() - 1);
+
   // Checks in Prepare ensure input, output and filter types are all the same.
   switch (input->type) {
     case kTfLiteFloat32: {
-      tflite::reference_ops::FullyConnected(
-          FullyConnectedParamsFloat(params->activation),
-          tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<float>(input),
-          tflite::micro::GetTensorShape(filter),
-          tflite::micro::GetTensorData<float>(filter),
-          tflite::micro::GetTensorShape(bias),
-          tflite::micro::GetTensorData<float>(bias),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<float>(output));
+      const FullyConnectedParams op_params =
+          FullyConnectedParamsFloat(params->activation);
+      const float* input_data = tflite::micro::GetTensorData<float>(input);
+      const float* filter_data = tflite::micro::GetTensorData<float>(filter);
+      const float* bias_data = tflite::micro::GetTensorData<float>(bias);
+      float* output_data = tflite::micro::GetTensorData<float>(output);
+      ParallelForOutputChannels(
+          context, batches, output_depth, accum_depth,
+          [&](const RuntimeShape& input_slice_shape, int input_offset,
+              const RuntimeShape& filter_slice_shape, int channel_start,
+              const RuntimeShape& output_slice_shape, int output_offset) {
+            tflite::reference_ops::FullyConnected(
+                op_params, input_slice_shape, input_data + input_offset,
+                filter_slice_shape, filter_data + channel_start * accum_depth,
+                bias_shape,
+                bias_data != nullptr ? bias_data + channel_start : nullptr,
+                output_slice_shape, output_data + output_offset);
+          });
       break;
     }
 
     case kTfLiteInt8: {
-      tflite::reference_integer_ops::FullyConnected(
-          FullyConnectedParamsQuantized(data),
-          tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int8_t>(input),
-          tflite::micro::GetTensorShape(filter),
-          tflite::micro::GetTensorData<int8_t>(filter),
-          tflite::micro::GetTensorShape(bias),
-          tflite::micro::GetTensorData<int32_t>(bias),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int8_t>(output));
+      const FullyConnectedParams op_params =
+          FullyConnectedParamsQuantized(data);
+      const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+      const int8_t* filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+      const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+      int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+      ParallelForOutputChannels(
+          context, batches, output_depth, accum_depth,
+          [&](const RuntimeShape& input_slice_shape, int input_offset,
+              const RuntimeShape& filter_slice_shape, int channel_start,
+              const RuntimeShape& output_slice_shape, int output_offset) {
+            tflite::reference_integer_ops::FullyConnected(
+                op_params, input_slice_shape, input_data + input_offset,
+                filter_slice_shape, filter_data + channel_start * accum_depth,
+                bias_shape,
+                bias_data != nullptr ? bias_data + channel_start : nullptr,
+                output_slice_shape, output_data + output_offset);
+          });
       break;
     }
 
@@ -13,11 +13,15 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
+#include <cstring>
+
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/copy_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_utils.h"
 
 namespace tflite {
@@ -27,69 +31,51 @@ constexpr int kInputTensor = 0;
 constexpr int kInputPositions = 1;
 constexpr int kOutputTensor = 0;
 
-template <typename InputT, typename CoordsT = int32_t>
-TfLiteStatus Gather(const TfLiteGatherParams* params,
-                    const TfLiteEvalTensor* input,
+struct OpData {
+  int batch_size;
+  int outer_size;
+  int axis_size;
+  int coord_size;
+  // Bytes in one slice of the input along the gather axis.
+  int inner_bytes;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+// Gather only moves slices of the input around, so it works on bytes
+// independently of the input type. Runs of consecutive coordinates are copied
+// with a single memcpy.
+template <typename CoordsT = int32_t>
+TfLiteStatus Gather(const OpData& data, const TfLiteEvalTensor* input,
                     const TfLiteEvalTensor* coords, TfLiteEvalTensor* output) {
-  const InputT* input_data = tflite::micro::GetTensorData<InputT>(input);
+  const uint8_t* input_data = tflite::micro::GetTensorData<uint8_t>(input);
   const CoordsT* coords_data = tflite::micro::GetTensorData<CoordsT>(coords);
-  InputT* output_data = tflite::micro::GetTensorData<InputT>(output);
-  const TfLiteIntArray* input_dims = input->dims;
-  const int input_dims_size = input_dims->size;
-  int axis = params->axis;
-  if (axis < 0) {
-    axis += input_dims_size;
-  }
-  TFLITE_DCHECK_GE(axis, 0);
-  TFLITE_DCHECK_LT(axis, input_dims_size);
-
-  int batch_dims = params->batch_dims;
-  // batch_dims should be in range: [-rank(coords), rank(coords)].
-  // Negative batch_dims is added with rank of coords.
-  const TfLiteIntArray* coords_dims = coords->dims;
-  const int coords_dims_size = coords_dims->size;
-  if (batch_dims < 0) {
-    batch_dims += coords_dims_size;
-  }
-  TFLITE_DCHECK_GE(batch_dims, 0);
-  TFLITE_DCHECK_LT(batch_dims, input_dims_size);
-  TFLITE_DCHECK_LE(batch_dims, coords_dims_size);
-  TFLITE_DCHECK_GE(axis, batch_dims);
-  for (int i = 0; i < batch_dims; ++i) {
-    TFLITE_DCHECK_EQ(input_dims->data[i], coords_dims->data[i]);
-  }
-
-  const int axis_size = input_dims->data[axis];
-
-  int batch_size = 1;
-  for (int i = 0; i < batch_dims; ++i) {
-    batch_size *= input_dims->data[i];
-  }
-  int outer_size = 1;
-  for (int i = batch_dims; i < axis; ++i) {
-    outer_size *= input_dims->data[i];
-  }
-  int inner_size = 1;
-  for (int i = axis + 1; i < input_dims_size; ++i) {
-    inner_size *= input_dims->data[i];
-  }
-  int coord_size = 1;
-  for (int i = batch_dims; i < coords_dims_size; ++i) {
-    coord_size *= coords_dims->data[i];
-  }
-
-  for (int batch = 0; batch < batch_size; ++batch) {
-    for (int outer = 0; outer < outer_size; ++outer) {
-      for (int coord = 0; coord < coord_size; ++coord) {
-        TFLITE_DCHECK_GE(coords_data[coord], 0);
-        TFLITE_DCHECK_LT(coords_data[coord], axis_size);
-        std::memcpy(output_data +
-                        (((batch * outer_size) + outer) * coord_size + coord) *
-                            inner_size,
-                    input_data + (((batch * outer_size) + outer) * axis_size +
-                                  coords_data[batch * coord_size + coord]) *
-                                     inner_size,
-                    sizeof(InputT) * inner_size);
+  uint8_t* output_data = tflite::micro::GetTensorData<uint8_t>(output);
+  const int inner_bytes = data.inner_bytes;
+
+  for (int batch = 0; batch < data.batch_size; ++batch) {
+    const CoordsT* batch_coords = coords_data + batch * data.coord_size;
+    for (int outer = 0; outer < data.outer_size; ++outer) {
+      const uint8_t* input_slices =
+          input_data +
+          (batch * data.outer_size + outer) * data.axis_size * inner_bytes;
+      int coord = 0;
+      while (coord < data.coord_size) {
+        const CoordsT first = batch_coords[coord];
+        TFLITE_DCHECK_GE(first, 0);
+        TFLITE_DCHECK_LT(first, data.axis_size);
+        int length = 1;
+        while (coord + length < data.coord_size &&
+               batch_coords[coord + length] == first + length) {
+          ++length;
+        }
+        std::memcpy(output_data, input_slices + first * inner_bytes,
+                    length * inner_bytes);
+        output_data += length * inner_bytes;
+        coord += length;
       }
     }
   }
@@ -176,12 +162,26 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   for (int i = axis + 1; i < input->dims->size; ++i) {
     output_shape->data[output_index++] = input->dims->data[i];
   }
+
+  size_t element_size;
+  TF_LITE_ENSURE_OK(context, TfLiteTypeSizeOf(input->type, &element_size));
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  data->batch_size = tflite::micro::FlatSizeOfDims(input->dims, 0, batch_dims);
+  data->outer_size =
+      tflite::micro::FlatSizeOfDims(input->dims, batch_dims, axis);
+  data->axis_size = input->dims->data[axis];
+  data->coord_size = tflite::micro::FlatSizeOfDims(coords->dims, batch_dims,
+                                                   coords->dims->size);
+  data->inner_bytes = static_cast<int>(element_size) *
+                      tflite::micro::FlatSizeOfDims(input->dims, axis + 1,
+                                                    input->dims->size);
   return kTfLiteOk;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
-  const auto* params =
-      reinterpret_cast<const TfLiteGatherParams*>(node->builtin_data);
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *static_cast<const OpData*>(node->user_data);
   const TfLiteEvalTensor* input =
       tflite::micro::GetEvalInput(context, node, kInputTensor);
   const TfLiteEvalTensor* coords =
@@ -192,10 +192,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   if (coords->type == kTfLiteInt32) {
     switch (input->type) {
       case kTfLiteFloat32:
-        return Gather<float, int32_t>(params, input, coords, output);
-        break;
       case kTfLiteInt8:
-        return Gather<int8_t, int32_t>(params, input, coords, output);
+        return Gather<int32_t>(data, input, coords, output);
         break;
       default:
         TF_LITE_KERNEL_LOG(context, "Type '%s' is not supported by gather.",
@@ -209,7 +207,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration Register_GATHER() {
-  return {/*init=*/nullptr,
+  return {/*init=*/Init,
           /*free=*/nullptr,
           /*prepare=*/Prepare,
           /*invoke=*/Eval,
@@ -462,4 +462,38 @@ TF_LITE_MICRO_TEST(GatherOp_BatchDimsEqualIndiceDims) {
       output_data, golden_dims, golden_data, axis, batch_dims);
 }
 
+TF_LITE_MICRO_TEST(GatherOp_ConsecutivePositions) {
+  // Consecutive positions select contiguous slices, which the kernel copies
+  // together.
+  int input_dims[] = {2, 4, 3};
+  int positions_dims[] = {1, 3};
+  const int32_t positions_data[] = {1, 2, 3};
+  const float input_data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  const float golden_data[] = {4, 5, 6, 7, 8, 9, 10, 11, 12};
+  float output_data[9];
+
+  const int golden_dims[] = {3, 3};
+  int output_dims[] = {2, 0, 0};
+  tflite::testing::TestGather<float, int32_t>(
+      input_dims, input_data, positions_dims, positions_data, output_dims,
+      output_data, golden_dims, golden_data);
+}
+
+TF_LITE_MICRO_TEST(GatherOp_MixedRunsLastAxisInt8) {
+  // Runs of consecutive positions broken by jumps, on the last axis where
+  // each slice is a single byte and the outer dimension is not contiguous.
+  int input_dims[] = {2, 2, 5};
+  int positions_dims[] = {1, 5};
+  const int32_t positions_data[] = {4, 0, 1, 2, 0};
+  const int8_t input_data[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+  const int8_t golden_data[] = {5, 1, 2, 3, 1, 10, 6, 7, 8, 6};
+  int8_t output_data[10];
+
+  const int golden_dims[] = {2, 5};
+  int output_dims[] = {2, 0, 0};
+  tflite::testing::TestGather<int8_t, int32_t>(
+      input_dims, input_data, positions_dims, positions_data, output_dims,
+      output_data, golden_dims, golden_data, /*axis=*/1);
+}
+
 TF_LITE_MICRO_TESTS_END
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/kernels/hard_swish.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
 #include "tensorflow/lite/micro/micro_utils.h"
 
 namespace tflite {
@@ -42,7 +43,8 @@ TfLiteStatus HardSwishPrepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE(context, output != nullptr);
 
   if (input->type == kTfLiteInt8) {
-    HardSwishParams* params = static_cast<HardSwishParams*>(node->user_data);
+    OpDataHardSwish* data = static_cast<OpDataHardSwish*>(node->user_data);
+    HardSwishParams* params = &data->params;
 
     params->input_zero_point = input->params.zero_point;
     params->output_zero_point = output->params.zero_point;
@@ -71,6 +73,15 @@ TfLiteStatus HardSwishPrepare(TfLiteContext* context, TfLiteNode* node) {
     DownScaleInt32ToInt16Multiplier(
         reluish_multiplier_fixedpoint_int32,
         &params->reluish_multiplier_fixedpoint_int16);
+
+    data->lut = CreateInt8UnaryLut(
+        context, [params](const int8_t* input_data, int8_t* output_data,
+                          int size) {
+          const RuntimeShape shape(1, &size);
+          reference_ops::HardSwish<int8_t>(*params, shape, input_data, shape,
+                                           output_data);
+        });
+    TF_LITE_ENSURE(context, data->lut != nullptr);
   }
 
   return kTfLiteOk;
@@ -87,8 +87,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   const OpData* op_data = reinterpret_cast<OpData*>(node->user_data);
 
-  const TfLiteTensor* cond;
-  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 0, &cond));
+  const TfLiteEvalTensor* cond = tflite::micro::GetEvalInput(context, node, 0);
   bool cond_value = cond->data.b[0];
 
   // Casting to TfliteIntArray is required since we are re-using
@@ -103,6 +102,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   // optimized yet.
   int active_branch_subgraph_index =
       cond_value ? op_data->then_subgraph_index : op_data->else_subgraph_index;
+  TF_LITE_ENSURE_OK(context, graph_info->PrepareSubgraphIfDeferred(
+                                 active_branch_subgraph_index));
 
   for (size_t i = 0;
        i < graph_info->NumSubgraphInputs(active_branch_subgraph_index); ++i) {
@@ -72,6 +72,58 @@ void TestIf(int* input1_dims_data, const bool* input1_data,
                           runner.GetMockGraph()->get_invoke_count(2));
 }
 
+int failing_mul_init_count = 0;
+int failing_mul_free_count = 0;
+
+void* FailingMulInit(TfLiteContext* context, const char* buffer,
+                     size_t length) {
+  ++failing_mul_init_count;
+  return ops::micro::Register_MUL().init(context, buffer, length);
+}
+
+void FailingMulFree(TfLiteContext* context, void* buffer) {
+  ++failing_mul_free_count;
+}
+
+TfLiteStatus FailingMulPrepare(TfLiteContext* context, TfLiteNode* node) {
+  return kTfLiteError;
+}
+
+// Resolves MUL to a registration whose Prepare always fails, and counts the
+// calls to its Init and Free.
+class FailingMulOpResolver : public MicroOpResolver {
+ public:
+  FailingMulOpResolver() {
+    resolver_.AddIf();
+    resolver_.AddAdd();
+    resolver_.AddMul();
+    failing_mul_ = ops::micro::Register_MUL();
+    failing_mul_.init = FailingMulInit;
+    failing_mul_.free = FailingMulFree;
+    failing_mul_.prepare = FailingMulPrepare;
+    failing_mul_.builtin_code = BuiltinOperator_MUL;
+  }
+
+  const TfLiteRegistration* FindOp(BuiltinOperator op) const override {
+    if (op == BuiltinOperator_MUL) {
+      return &failing_mul_;
+    }
+    return resolver_.FindOp(op);
+  }
+
+  const TfLiteRegistration* FindOp(const char* op) const override {
+    return resolver_.FindOp(op);
+  }
+
+  BuiltinParseFunction GetOpDataParser(BuiltinOperator op) const override {
+    return resolver_.GetOpDataParser(op);
+  }
+
+ private:
+  MicroMutableOpResolver<3> resolver_;
+  TfLiteRegistration failing_mul_;
+};
+
 }  // namespace
 }  // namespace testing
 }  // namespace tflite
@@ -160,4 +212,109 @@ TF_LITE_MICRO_TEST(IfShouldInvokeSubgraphConditionFalse) {
   TF_LITE_MICRO_EXPECT_EQ(output->data.f[1], 35.0f);
 }
 
+TF_LITE_MICRO_TEST(IfShouldPrepareLazySubgraphsOnFirstInvoke) {
+  constexpr int kArenaSize = 5000;
+  uint8_t arena[kArenaSize];
+  uint8_t lazy_arena[kArenaSize];
+
+  const tflite::Model* model =
+      tflite::testing::GetSimpleModelWithSubgraphsAndIf();
+  tflite::MicroMutableOpResolver<3> resolver;
+  tflite::MicroErrorReporter reporter;
+  resolver.AddIf();
+  resolver.AddAdd();
+  resolver.AddMul();
+  tflite::MicroInterpreter interpreter(model, resolver, arena, kArenaSize,
+                                       &reporter);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+  tflite::MicroInterpreter lazy_interpreter(model, resolver, lazy_arena,
+                                            kArenaSize, &reporter);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                          lazy_interpreter.EnableLazySubgraphPreparation());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, lazy_interpreter.AllocateTensors());
+  TF_LITE_MICRO_EXPECT_LT(lazy_interpreter.arena_used_bytes(),
+                          interpreter.arena_used_bytes());
+
+  TfLiteTensor* condition = lazy_interpreter.input(0);
+  TfLiteTensor* input1 = lazy_interpreter.input(1);
+  TfLiteTensor* input2 = lazy_interpreter.input(2);
+  TfLiteTensor* output = lazy_interpreter.output(0);
+  float input1_data[] = {2.0, 5.0};
+  float input2_data[] = {3.0, 7.0};
+  const bool conditions[] = {true, false, true};
+  const float goldens[][2] = {{5.0, 12.0}, {6.0, 35.0}, {5.0, 12.0}};
+  for (int i = 0; i < 3; ++i) {
+    memcpy(input1->data.f, input1_data, 2 * sizeof(float));
+    memcpy(input2->data.f, input2_data, 2 * sizeof(float));
+    condition->data.b[0] = conditions[i];
+
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, lazy_interpreter.Invoke());
+
+    TF_LITE_MICRO_EXPECT_EQ(output->data.f[0], goldens[i][0]);
+    TF_LITE_MICRO_EXPECT_EQ(output->data.f[1], goldens[i][1]);
+  }
+}
+
+TF_LITE_MICRO_TEST(IfShouldFailWhenLazySubgraphDoesNotFit) {
+  // Arena requirements assume an arena size that is a multiple of 16.
+  constexpr int kArenaSize = 4096;
+  alignas(16) uint8_t arena[kArenaSize];
+
+  const tflite::Model* model =
+      tflite::testing::GetSimpleModelWithSubgraphsAndIf();
+  tflite::MicroMutableOpResolver<3> resolver;
+  tflite::MicroErrorReporter reporter;
+  resolver.AddIf();
+  resolver.AddAdd();
+  resolver.AddMul();
+  size_t lazy_arena_size;
+  {
+    tflite::MicroInterpreter interpreter(model, resolver, arena, kArenaSize,
+                                         &reporter);
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                            interpreter.EnableLazySubgraphPreparation());
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+    lazy_arena_size = interpreter.arena_requirements().arena_bytes;
+  }
+
+  // Only leaves room for the first subgraph.
+  tflite::MicroInterpreter interpreter(model, resolver, arena, lazy_arena_size,
+                                       &reporter);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                          interpreter.EnableLazySubgraphPreparation());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+  interpreter.input(0)->data.b[0] = true;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError,
+                          interpreter.EnableLazySubgraphPreparation());
+}
+
+TF_LITE_MICRO_TEST(IfShouldNotPrepareFailedLazySubgraphAgain) {
+  constexpr int kArenaSize = 5000;
+  uint8_t arena[kArenaSize];
+
+  const tflite::Model* model =
+      tflite::testing::GetSimpleModelWithSubgraphsAndIf();
+  tflite::testing::FailingMulOpResolver resolver;
+  tflite::MicroErrorReporter reporter;
+  tflite::testing::failing_mul_init_count = 0;
+  tflite::testing::failing_mul_free_count = 0;
+  {
+    tflite::MicroInterpreter interpreter(model, resolver, arena, kArenaSize,
+                                         &reporter);
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                            interpreter.EnableLazySubgraphPreparation());
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+    TF_LITE_MICRO_EXPECT_EQ(0, tflite::testing::failing_mul_init_count);
+
+    // The else branch holds the MUL.
+    interpreter.input(0)->data.b[0] = false;
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Invoke());
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Invoke());
+    TF_LITE_MICRO_EXPECT_EQ(1, tflite::testing::failing_mul_init_count);
+    TF_LITE_MICRO_EXPECT_EQ(0, tflite::testing::failing_mul_free_count);
+  }
+  TF_LITE_MICRO_EXPECT_EQ(1, tflite::testing::failing_mul_free_count);
+}
+
 TF_LITE_MICRO_TESTS_END
@@ -15,6 +15,7 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/kernels/kernel_runner.h"
 
+#include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/simple_memory_allocator.h"
 #include "tensorflow/lite/micro/test_helpers.h"
@@ -40,6 +41,7 @@ KernelRunner::KernelRunner(const TfLiteRegistration& registration,
                                                kKernelRunnerBufferSize_)),
       registration_(registration),
       tensors_(tensors),
+      tensors_size_(tensors_size),
       mock_micro_graph_(allocator_) {
   // Prepare TfLiteContext:
   context_.impl_ = static_cast<void*>(this);
@@ -54,21 +56,48 @@ KernelRunner::KernelRunner(const TfLiteRegistration& registration,
   context_.recommended_num_threads = 0;
 
   // Prepare TfLiteNode:
-  node_.inputs = inputs;
-  node_.outputs = outputs;
-  node_.builtin_data = builtin_data;
-  node_.reverse = reverse;
+  node_.node.inputs = inputs;
+  node_.node.outputs = outputs;
+  node_.node.builtin_data = builtin_data;
+  node_.node.reverse = reverse;
+  node_.registration = &registration_;
 }
 
 TfLiteStatus KernelRunner::InitAndPrepare(const char* init_data,
                                           size_t length) {
   if (registration_.init) {
-    node_.user_data = registration_.init(&context_, init_data, length);
+    node_.node.user_data = registration_.init(&context_, init_data, length);
   }
   if (registration_.prepare) {
-    TF_LITE_ENSURE_STATUS(registration_.prepare(&context_, &node_));
+    TF_LITE_ENSURE_STATUS(registration_.prepare(&context_, &node_.node));
+  }
+
+  // Resolve the tensors of the node the way the interpreter does once the
+  // memory plan is committed.
+  eval_tensors_ = reinterpret_cast<TfLiteEvalTensor*>(
+      allocator_->AllocateFromTail(sizeof(TfLiteEvalTensor) * tensors_size_,
+                                   alignof(TfLiteEvalTensor)));
+  TF_LITE_ENSURE(&context_, eval_tensors_ != nullptr);
+  RefreshEvalTensors();
+  eval_shapes_ = internal::AllocateTensorShapes(allocator_, eval_tensors_,
+                                                tensors_size_);
+  TF_LITE_ENSURE(&context_, eval_shapes_ != nullptr);
+  return internal::ResolveNodeTensors(allocator_, node_.node.inputs,
+                                      node_.node.outputs, eval_tensors_,
+                                      eval_shapes_, tensors_size_, &node_);
+}
+
+void KernelRunner::RefreshEvalTensors() {
+  // In unit tests, the TfLiteTensor pointer contains the source of truth for
+  // buffers and values:
+  for (int i = 0; i < tensors_size_; ++i) {
+    eval_tensors_[i].data = tensors_[i].data;
+    eval_tensors_[i].dims = tensors_[i].dims;
+    eval_tensors_[i].type = tensors_[i].type;
+  }
+  if (eval_shapes_ != nullptr) {
+    internal::UpdateTensorShapes(eval_tensors_, tensors_size_, eval_shapes_);
   }
-  return kTfLiteOk;
 }
 
 TfLiteStatus KernelRunner::Invoke() {
@@ -76,7 +105,10 @@ TfLiteStatus KernelRunner::Invoke() {
     MicroPrintf("TfLiteRegistration missing invoke function pointer!");
     return kTfLiteError;
   }
-  return registration_.invoke(&context_, &node_);
+  if (eval_tensors_ != nullptr) {
+    RefreshEvalTensors();
+  }
+  return registration_.invoke(&context_, &node_.node);
 }
 
 TfLiteTensor* KernelRunner::GetTensor(const struct TfLiteContext* context,
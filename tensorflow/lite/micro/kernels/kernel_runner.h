@@ -18,6 +18,8 @@ limitations under the License.
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/micro_node.h"
 #include "tensorflow/lite/micro/mock_micro_graph.h"
 #include "tensorflow/lite/micro/simple_memory_allocator.h"
 
@@ -36,6 +38,12 @@ class KernelRunner {
                int tensors_size, TfLiteIntArray* inputs,
                TfLiteIntArray* outputs, void* builtin_data, bool reverse=false);
 
+  // Sets the intermediate tensors of the node, as indices into the tensors
+  // passed during construction. Must be called before InitAndPrepare().
+  void SetIntermediates(TfLiteIntArray* intermediates) {
+    node_.node.intermediates = intermediates;
+  }
+
   // Calls init and prepare on the kernel (i.e. TfLiteRegistration) struct. Any
   // exceptions will be DebugLog'd and returned as a status code.
   TfLiteStatus InitAndPrepare(const char* init_data = nullptr,
@@ -69,6 +77,10 @@ class KernelRunner {
                                TfLiteIntArray** args);
 
  private:
+  // Copies the buffers, dims and types of `tensors_` into `eval_tensors_` and
+  // updates their shapes.
+  void RefreshEvalTensors();
+
   static constexpr int kNumScratchBuffers_ = 12;
 
   static constexpr int kKernelRunnerBufferSize_ = 10000;
@@ -77,10 +89,18 @@ class KernelRunner {
   SimpleMemoryAllocator* allocator_ = nullptr;
   const TfLiteRegistration& registration_;
   TfLiteTensor* tensors_ = nullptr;
+  int tensors_size_ = 0;
   MockMicroGraph mock_micro_graph_;
 
+  // Eval tensors and shapes backing the resolved tensor tables of `node_`.
+  // They are refreshed from `tensors_` before every invocation.
+  TfLiteEvalTensor* eval_tensors_ = nullptr;
+  RuntimeShape* eval_shapes_ = nullptr;
+
   TfLiteContext context_ = {};
-  TfLiteNode node_ = {};
+  // Kernels reach the tensor tables through the TfLiteNode, so the node has to
+  // live in a NodeAndRegistration like it does in the interpreter.
+  NodeAndRegistration node_ = {};
 
   int scratch_buffer_count_ = 0;
   uint8_t* scratch_buffers_[kNumScratchBuffers_];
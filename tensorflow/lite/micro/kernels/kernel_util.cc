@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 
+#include <cstdint>
+
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 
 namespace tflite {
 namespace micro {
@@ -74,5 +77,42 @@ TfLiteStatus CreateWritableTensorDimsWithCopy(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+TfLiteStatus AllocatePerChannelQuantizationParams(
+    TfLiteContext* context, TfLiteType input_type, int num_channels,
+    int32_t** per_channel_output_multiplier,
+    int32_t** per_channel_output_shift) {
+  *per_channel_output_multiplier = nullptr;
+  *per_channel_output_shift = nullptr;
+  if (input_type == kTfLiteFloat32) {
+    return kTfLiteOk;
+  }
+  *per_channel_output_multiplier =
+      static_cast<int32_t*>(context->AllocatePersistentBuffer(
+          context, num_channels * sizeof(int32_t)));
+  *per_channel_output_shift =
+      static_cast<int32_t*>(context->AllocatePersistentBuffer(
+          context, num_channels * sizeof(int32_t)));
+  TF_LITE_ENSURE(context, *per_channel_output_multiplier != nullptr);
+  TF_LITE_ENSURE(context, *per_channel_output_shift != nullptr);
+  return kTfLiteOk;
+}
+
+bool IsComputedInPlace(const TfLiteNode* node, const TfLiteEvalTensor* input,
+                       const TfLiteEvalTensor* output) {
+  if (node->reverse) {
+    return true;
+  }
+  size_t input_bytes;
+  size_t output_bytes;
+  if (TfLiteEvalTensorByteLength(input, &input_bytes) != kTfLiteOk ||
+      TfLiteEvalTensorByteLength(output, &output_bytes) != kTfLiteOk) {
+    return true;
+  }
+  const uintptr_t input_start = reinterpret_cast<uintptr_t>(input->data.raw);
+  const uintptr_t output_start = reinterpret_cast<uintptr_t>(output->data.raw);
+  return input_start < output_start + output_bytes &&
+         output_start < input_start + input_bytes;
+}
+
 }  // namespace micro
 }  // namespace tflite
@@ -22,6 +22,8 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/micro_node.h"
+#include "tensorflow/lite/micro/micro_thread_pool.h"
 
 namespace tflite {
 namespace micro {
@@ -33,6 +35,11 @@ inline TfLiteEvalTensor* GetMutableEvalInput(const TfLiteContext* context,
                                              int index) {
   TFLITE_DCHECK(context != nullptr);
   TFLITE_DCHECK(node != nullptr);
+  TfLiteEvalTensor* const* eval_tensors =
+      GetNodeAndRegistration(node)->eval_tensors;
+  if (eval_tensors != nullptr) {
+    return eval_tensors[index];
+  }
   return context->GetEvalTensor(context, node->inputs->data[index]);
 }
 
@@ -47,9 +54,37 @@ inline TfLiteEvalTensor* GetEvalOutput(const TfLiteContext* context,
                                        const TfLiteNode* node, int index) {
   TFLITE_DCHECK(context != nullptr);
   TFLITE_DCHECK(node != nullptr);
+  TfLiteEvalTensor* const* eval_tensors =
+      GetNodeAndRegistration(node)->eval_tensors;
+  if (eval_tensors != nullptr) {
+    return eval_tensors[node->inputs->size + index];
+  }
   return context->GetEvalTensor(context, node->outputs->data[index]);
 }
 
+// Returns the shape of the input at `index` of a node, as cached when the
+// memory plan was committed. Missing optional inputs have an empty shape. Only
+// valid during Eval.
+inline const RuntimeShape& GetEvalInputShape(const TfLiteNode* node,
+                                             int index) {
+  TFLITE_DCHECK(node != nullptr);
+  const RuntimeShape* const* eval_shapes =
+      GetNodeAndRegistration(node)->eval_shapes;
+  TFLITE_DCHECK(eval_shapes != nullptr);
+  return *eval_shapes[index];
+}
+
+// Returns the shape of the output at `index` of a node, as cached when the
+// memory plan was committed. Only valid during Eval.
+inline const RuntimeShape& GetEvalOutputShape(const TfLiteNode* node,
+                                              int index) {
+  TFLITE_DCHECK(node != nullptr);
+  const RuntimeShape* const* eval_shapes =
+      GetNodeAndRegistration(node)->eval_shapes;
+  TFLITE_DCHECK(eval_shapes != nullptr);
+  return *eval_shapes[node->inputs->size + index];
+}
+
 // Returns data for a TfLiteEvalTensor struct.
 template <typename T>
 T* GetTensorData(TfLiteEvalTensor* tensor) {
@@ -80,6 +115,103 @@ TfLiteStatus CreateWritableTensorDimsWithCopy(TfLiteContext* context,
                                               TfLiteTensor* tensor,
                                               TfLiteEvalTensor* eval_tensor);
 
+// Allocates the per-channel output multiplier and shift arrays of a
+// convolution with `num_channels` output channels from the persistent arena.
+// Float kernels never read them, so both are set to nullptr instead when
+// `input_type` is kTfLiteFloat32. Only use during Prepare phase.
+TfLiteStatus AllocatePerChannelQuantizationParams(
+    TfLiteContext* context, TfLiteType input_type, int num_channels,
+    int32_t** per_channel_output_multiplier,
+    int32_t** per_channel_output_shift);
+
+// Returns true if the output of `node` may overwrite parts of its input that
+// are still to be read, either because the memory planner marked the node as
+// computed in reverse or because the buffers of `input` and `output` overlap.
+// Such a node must compute its output in order on a single thread.
+bool IsComputedInPlace(const TfLiteNode* node, const TfLiteEvalTensor* input,
+                       const TfLiteEvalTensor* output);
+
+// Calls `fn(start, end)` for disjoint ranges covering [0, count), in parallel
+// if a thread pool is bound to `context`. `fn` must be safe to call
+// concurrently for different ranges.
+template <typename Fn>
+void ParallelForRange(TfLiteContext* context, int count, const Fn& fn) {
+  struct Closure {
+    static void Run(void* data, int start, int end) {
+      (*static_cast<const Fn*>(data))(start, end);
+    }
+  };
+  ParallelFor(context, count, Closure::Run,
+              const_cast<void*>(static_cast<const void*>(&fn)));
+}
+
+// A band of output rows of one batch of an NHWC windowed operation (conv,
+// depthwise conv, pooling), expressed as an equivalent single-batch operation
+// on the full input image of that batch.
+struct OutputRowBand {
+  RuntimeShape input_shape;
+  int input_offset;
+  RuntimeShape output_shape;
+  int output_offset;
+  // Height padding of the band such that its first row reads the same input
+  // rows as the original output row. May be negative.
+  int padding_height;
+};
+
+// Splits the output rows of an NHWC windowed operation across the thread pool
+// bound to `context` and calls `fn(band)` for each OutputRowBand. Without a
+// thread pool, or if the operation is computed `in_place` (see
+// IsComputedInPlace), `fn` is called once per batch with the full output
+// height, in order, on the calling thread. Reference kernels only use the
+// height padding to locate the first input row of each output row, which is
+// what makes the bands exact.
+template <typename Fn>
+void ParallelForOutputRows(TfLiteContext* context, bool in_place,
+                           const RuntimeShape& input_shape,
+                           const RuntimeShape& output_shape, int stride_height,
+                           int padding_height, const Fn& fn) {
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int output_height = output_shape.Dims(1);
+  // Bands must start on a batch boundary if the adjusted padding would not fit
+  // in PaddingValues.
+  const int rows_per_unit =
+      output_height * stride_height - padding_height <= INT16_MAX
+          ? 1
+          : output_height;
+  const int num_units = output_shape.Dims(0) * output_height / rows_per_unit;
+  const auto run_units = [&](int start_unit, int end_unit) {
+    const int end = end_unit * rows_per_unit;
+    int row = start_unit * rows_per_unit;
+    while (row < end) {
+      const int batch = row / output_height;
+      const int row_start = row % output_height;
+      const int row_end = output_height < row_start + (end - row)
+                              ? output_height
+                              : row_start + (end - row);
+      const int32_t input_band_dims[4] = {1, input_shape.Dims(1),
+                                          input_shape.Dims(2),
+                                          input_shape.Dims(3)};
+      const int32_t output_band_dims[4] = {1, row_end - row_start,
+                                           output_shape.Dims(2),
+                                           output_shape.Dims(3)};
+      const OutputRowBand band = {
+          RuntimeShape(4, input_band_dims),
+          Offset(input_shape, batch, 0, 0, 0),
+          RuntimeShape(4, output_band_dims),
+          Offset(output_shape, batch, row_start, 0, 0),
+          padding_height - row_start * stride_height};
+      fn(band);
+      row += row_end - row_start;
+    }
+  };
+  if (in_place) {
+    run_units(0, num_units);
+  } else {
+    ParallelForRange(context, num_units, run_units);
+  }
+}
+
 }  // namespace micro
 }  // namespace tflite
 
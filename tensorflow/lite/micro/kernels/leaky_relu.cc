@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/leaky_relu.h"
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 
 namespace tflite {
@@ -71,7 +72,7 @@ TfLiteStatus LeakyReluEval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteOk;
     } break;
     case kTfLiteInt8: {
-      QuantizeLeakyRelu<int8_t>(data, input, output);
+      EvalInt8UnaryLut(data.lut, input, output);
       return kTfLiteOk;
     } break;
     case kTfLiteInt16: {
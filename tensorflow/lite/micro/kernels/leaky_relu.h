@@ -32,6 +32,8 @@ struct LeakyReluOpData {
   int32_t output_shift_identity;
   int32_t input_zero_point;
   int32_t output_zero_point;
+  // Lookup table for the int8 path, built in LeakyReluPrepare.
+  int8_t* lut;
 };
 
 TfLiteStatus CalculateOpDataLeakyRelu(TfLiteContext* context, TfLiteNode* node);
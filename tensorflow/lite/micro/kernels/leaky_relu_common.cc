@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/leaky_relu.h"
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
 
 namespace tflite {
 
@@ -62,6 +63,25 @@ TfLiteStatus CalculateOpDataLeakyRelu(TfLiteContext* context,
     data->output_shift_identity = static_cast<int32_t>(output_shift_identity);
   }
 
+  if (output->type == kTfLiteInt8) {
+    LeakyReluOpData* data = static_cast<LeakyReluOpData*>(node->user_data);
+    LeakyReluParams op_params = {};
+    op_params.input_offset = data->input_zero_point;
+    op_params.output_offset = data->output_zero_point;
+    op_params.output_multiplier_alpha = data->output_multiplier_alpha;
+    op_params.output_shift_alpha = data->output_shift_alpha;
+    op_params.output_multiplier_identity = data->output_multiplier_identity;
+    op_params.output_shift_identity = data->output_shift_identity;
+    data->lut = CreateInt8UnaryLut(
+        context, [&op_params](const int8_t* input_data, int8_t* output_data,
+                              int size) {
+          const RuntimeShape shape(1, &size);
+          reference_ops::QuantizeLeakyRelu(op_params, shape, input_data, shape,
+                                           output_data);
+        });
+    TF_LITE_ENSURE(context, data->lut != nullptr);
+  }
+
   return kTfLiteOk;
 }
 
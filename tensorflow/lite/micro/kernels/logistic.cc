@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/logistic.h"
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
 
 namespace tflite {
 namespace {
@@ -46,10 +47,11 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
   if (input->type == kTfLiteFloat32) {
     switch (output->type) {
       case kTfLiteFloat32: {
-        reference_ops::Logistic(tflite::micro::GetTensorShape(input),
-                                tflite::micro::GetTensorData<float>(input),
-                                tflite::micro::GetTensorShape(output),
-                                tflite::micro::GetTensorData<float>(output));
+        reference_ops::Logistic(
+            tflite::micro::GetEvalInputShape(node, kLogisticInputTensor),
+            tflite::micro::GetTensorData<float>(input),
+            tflite::micro::GetEvalOutputShape(node, kLogisticOutputTensor),
+            tflite::micro::GetTensorData<float>(output));
         return kTfLiteOk;
       }
       default:
@@ -61,12 +63,7 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
   } else if (input->type == kTfLiteInt8) {
     switch (output->type) {
       case kTfLiteInt8: {
-        reference_integer_ops::Logistic(
-            data->input_zero_point, data->input_range_radius,
-            data->input_multiplier, data->input_left_shift,
-            NumElements(input->dims),
-            tflite::micro::GetTensorData<int8_t>(input),
-            tflite::micro::GetTensorData<int8_t>(output));
+        EvalInt8UnaryLut(data->lut, input, output);
         return kTfLiteOk;
       }
       default:
@@ -30,6 +30,8 @@ struct OpDataLogistic {
   int32_t input_range_radius;
   int32_t input_multiplier;
   int input_left_shift;
+  // Lookup table for the int8 path, built in LogisticPrepare.
+  int8_t* lut;
 };
 
 TfLiteStatus CalculateArithmeticOpDataLogistic(TfLiteContext* context,
@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/kernels/logistic.h"
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
 
 namespace tflite {
 const int kLogisticInputTensor = 0;
@@ -62,7 +63,23 @@ TfLiteStatus LogisticPrepare(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   OpDataLogistic* data = static_cast<OpDataLogistic*>(node->user_data);
 
-  return CalculateArithmeticOpDataLogistic(context, node, data);
+  TF_LITE_ENSURE_OK(context,
+                    CalculateArithmeticOpDataLogistic(context, node, data));
+
+  const TfLiteTensor* input = GetInput(context, node, kLogisticInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  if (input->type == kTfLiteInt8) {
+    data->lut = CreateInt8UnaryLut(
+        context, [data](const int8_t* input_data, int8_t* output_data,
+                        int size) {
+          reference_integer_ops::Logistic(
+              data->input_zero_point, data->input_range_radius,
+              data->input_multiplier, data->input_left_shift, size,
+              input_data, output_data);
+        });
+    TF_LITE_ENSURE(context, data->lut != nullptr);
+  }
+  return kTfLiteOk;
 }
 
 }  // namespace tflite
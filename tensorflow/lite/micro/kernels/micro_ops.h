@@ -33,6 +33,7 @@ namespace tflite {
 
 TfLiteRegistration Register_ADD_N();
 TfLiteRegistration Register_AVERAGE_POOL_2D();
+TfLiteRegistration Register_BATCH_MATMUL();
 TfLiteRegistration Register_BATCH_TO_SPACE_ND();
 TfLiteRegistration Register_CAST();
 TfLiteRegistration* Register_CIRCULAR_BUFFER();
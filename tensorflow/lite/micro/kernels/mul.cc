@@ -90,6 +90,12 @@ TfLiteStatus CalculateOpData(TfLiteContext* context, TfLiteNode* node,
 void EvalQuantized(TfLiteContext* context, TfLiteNode* node, const OpData* data,
                    const TfLiteEvalTensor* input1,
                    const TfLiteEvalTensor* input2, TfLiteEvalTensor* output) {
+  const RuntimeShape& input1_shape =
+      tflite::micro::GetEvalInputShape(node, kInput1Tensor);
+  const RuntimeShape& input2_shape =
+      tflite::micro::GetEvalInputShape(node, kInput2Tensor);
+  const RuntimeShape& output_shape =
+      tflite::micro::GetEvalOutputShape(node, kOutputTensor);
   tflite::ArithmeticParams op_params = {};
   op_params.quantized_activation_min = data->output_activation_min;
   op_params.quantized_activation_max = data->output_activation_max;
@@ -101,23 +107,19 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node, const OpData* data,
   op_params.output_shift = data->output_shift;
 
   bool need_broadcast = reference_ops::ProcessBroadcastShapes(
-      tflite::micro::GetTensorShape(input1),
-      tflite::micro::GetTensorShape(input2), &op_params);
+      input1_shape, input2_shape, &op_params);
 
   if (need_broadcast) {
     reference_integer_ops::BroadcastMul4DSlow(
-        op_params, tflite::micro::GetTensorShape(input1),
-        tflite::micro::GetTensorData<int8_t>(input1),
-        tflite::micro::GetTensorShape(input2),
-        tflite::micro::GetTensorData<int8_t>(input2),
-        tflite::micro::GetTensorShape(output),
-        tflite::micro::GetTensorData<int8_t>(output));
+        op_params, input1_shape, tflite::micro::GetTensorData<int8_t>(input1),
+        input2_shape, tflite::micro::GetTensorData<int8_t>(input2),
+        output_shape, tflite::micro::GetTensorData<int8_t>(output));
   } else {
-    reference_integer_ops::Mul(op_params, tflite::micro::GetTensorShape(input1),
+    reference_integer_ops::Mul(op_params, input1_shape,
                                tflite::micro::GetTensorData<int8_t>(input1),
-                               tflite::micro::GetTensorShape(input2),
+                               input2_shape,
                                tflite::micro::GetTensorData<int8_t>(input2),
-                               tflite::micro::GetTensorShape(output),
+                               output_shape,
                                tflite::micro::GetTensorData<int8_t>(output));
   }
 }
@@ -126,28 +128,30 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
                TfLiteMulParams* params, const OpData* data,
                const TfLiteEvalTensor* input1, const TfLiteEvalTensor* input2,
                TfLiteEvalTensor* output) {
+  const RuntimeShape& input1_shape =
+      tflite::micro::GetEvalInputShape(node, kInput1Tensor);
+  const RuntimeShape& input2_shape =
+      tflite::micro::GetEvalInputShape(node, kInput2Tensor);
+  const RuntimeShape& output_shape =
+      tflite::micro::GetEvalOutputShape(node, kOutputTensor);
   tflite::ArithmeticParams op_params = {};
   op_params.float_activation_min = data->output_activation_min_f32;
   op_params.float_activation_max = data->output_activation_max_f32;
 
   bool need_broadcast = reference_ops::ProcessBroadcastShapes(
-      tflite::micro::GetTensorShape(input1),
-      tflite::micro::GetTensorShape(input2), &op_params);
+      input1_shape, input2_shape, &op_params);
 
   if (need_broadcast) {
     reference_ops::BroadcastMul4DSlow(
-        op_params, tflite::micro::GetTensorShape(input1),
-        tflite::micro::GetTensorData<float>(input1),
-        tflite::micro::GetTensorShape(input2),
-        tflite::micro::GetTensorData<float>(input2),
-        tflite::micro::GetTensorShape(output),
+        op_params, input1_shape, tflite::micro::GetTensorData<float>(input1),
+        input2_shape, tflite::micro::GetTensorData<float>(input2), output_shape,
         tflite::micro::GetTensorData<float>(output));
   } else {
-    reference_ops::Mul(op_params, tflite::micro::GetTensorShape(input1),
+    reference_ops::Mul(op_params, input1_shape,
                        tflite::micro::GetTensorData<float>(input1),
-                       tflite::micro::GetTensorShape(input2),
+                       input2_shape,
                        tflite::micro::GetTensorData<float>(input2),
-                       tflite::micro::GetTensorShape(output),
+                       output_shape,
                        tflite::micro::GetTensorData<float>(output));
   }
 }
@@ -14,7 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/kernels/internal/reference/pad.h"
 
-#include <string.h>
+#include <cstring>
 
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/c/common.h"
@@ -22,7 +22,9 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
+#include "tensorflow/lite/micro/kernels/copy_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 
 namespace tflite {
 namespace ops {
@@ -33,8 +35,50 @@ namespace {
 struct OpData {
   PadParams params;
   int32_t output_zero_point;
+  int dims_count;
+  int element_size;
+  int32_t input_dims[reference_ops::PadKernelMaxDimensionCount()];
+  // Number of output elements in one step of each dimension.
+  int32_t output_strides[reference_ops::PadKernelMaxDimensionCount()];
 };
 
+// Writes the part of the output that belongs to one index of dimension
+// `dim - 1`, consuming the matching input. The padding before and after
+// dimension `dim` is written as a single fill over whole rows or planes, and
+// the input rows are copied with memcpy.
+void PadDimension(const OpData& data, int dim, const uint8_t** input,
+                  uint8_t** output, const void* pad_value) {
+  const int element_size = data.element_size;
+  const int left = data.params.left_padding[dim] * data.output_strides[dim];
+  const int right = data.params.right_padding[dim] * data.output_strides[dim];
+
+  tflite::micro::FillElements(*output, pad_value, element_size, left);
+  *output += left * element_size;
+  if (dim == data.dims_count - 1) {
+    const int row_bytes = data.input_dims[dim] * element_size;
+    std::memcpy(*output, *input, row_bytes);
+    *input += row_bytes;
+    *output += row_bytes;
+  } else {
+    for (int i = 0; i < data.input_dims[dim]; ++i) {
+      PadDimension(data, dim + 1, input, output, pad_value);
+    }
+  }
+  tflite::micro::FillElements(*output, pad_value, element_size, right);
+  *output += right * element_size;
+}
+
+void EvalPad(const OpData& data, const TfLiteEvalTensor* input,
+             const void* pad_value, TfLiteEvalTensor* output) {
+  const uint8_t* input_ptr = tflite::micro::GetTensorData<uint8_t>(input);
+  uint8_t* output_ptr = tflite::micro::GetTensorData<uint8_t>(output);
+  if (data.dims_count == 0) {
+    std::memcpy(output_ptr, input_ptr, data.element_size);
+    return;
+  }
+  PadDimension(data, 0, &input_ptr, &output_ptr, pad_value);
+}
+
 }  // namespace
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
@@ -87,14 +131,8 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   }
 
   // Calculate OpData:
-  data->params.resizing_category = ResizingCategory::kGenericResize;
-  const int paddings_total = GetTensorShape(paddings).FlatSize();
-  if (paddings_total == 8 && (paddings_data[0] == 0 && paddings_data[1] == 0) &&
-      (paddings_data[6] == 0 && paddings_data[7] == 0)) {
-    data->params.resizing_category = ResizingCategory::kImageStyle;
-  }
-
   const int num_input_dimensions = NumDimensions(input);
+  data->params.resizing_category = ResizingCategory::kGenericResize;
   data->params.left_padding_count = num_input_dimensions;
   data->params.right_padding_count = num_input_dimensions;
 
@@ -103,6 +141,17 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
     data->params.right_padding[idx] = paddings_data[idx * 2 + 1];
   }
 
+  size_t element_size;
+  TF_LITE_ENSURE_OK(context, TfLiteTypeSizeOf(input->type, &element_size));
+  data->element_size = static_cast<int>(element_size);
+  data->dims_count = num_input_dimensions;
+  int output_stride = 1;
+  for (int idx = num_input_dimensions - 1; idx >= 0; --idx) {
+    data->input_dims[idx] = input->dims->data[idx];
+    data->output_strides[idx] = output_stride;
+    output_stride *= output->dims->data[idx];
+  }
+
   if (input->type == kTfLiteInt8) {
     if (constant_values == nullptr) {
       // Quantized Pad requires that 0 is represented in the quantized
@@ -144,18 +193,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
           constant_values == nullptr
               ? 0.f
               : *tflite::micro::GetTensorData<float>(constant_values);
-      if (data->params.resizing_category == ResizingCategory::kImageStyle) {
-        reference_ops::PadImageStyle(
-            data->params, tflite::micro::GetTensorShape(input),
-            tflite::micro::GetTensorData<float>(input), &pad_value,
-            tflite::micro::GetTensorShape(output),
-            tflite::micro::GetTensorData<float>(output));
-      } else {
-        reference_ops::Pad(data->params, tflite::micro::GetTensorShape(input),
-                           tflite::micro::GetTensorData<float>(input),
-                           &pad_value, tflite::micro::GetTensorShape(output),
-                           tflite::micro::GetTensorData<float>(output));
-      }
+      EvalPad(*data, input, &pad_value, output);
     } break;
     case kTfLiteInt8: {
       int8_t pad_value;
@@ -164,28 +202,14 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
       } else {
         pad_value = *tflite::micro::GetTensorData<int8_t>(constant_values);
       }
-      if (data->params.resizing_category == ResizingCategory::kImageStyle) {
-        reference_ops::PadImageStyle(
-            data->params, tflite::micro::GetTensorShape(input),
-            tflite::micro::GetTensorData<int8_t>(input), &pad_value,
-            tflite::micro::GetTensorShape(output),
-            tflite::micro::GetTensorData<int8_t>(output));
-      } else {
-        reference_ops::Pad(data->params, tflite::micro::GetTensorShape(input),
-                           tflite::micro::GetTensorData<int8_t>(input),
-                           &pad_value, tflite::micro::GetTensorShape(output),
-                           tflite::micro::GetTensorData<int8_t>(output));
-      }
+      EvalPad(*data, input, &pad_value, output);
     } break;
     case kTfLiteInt32: {
       int32_t pad_value =
           constant_values == nullptr
               ? 0
               : *tflite::micro::GetTensorData<int32_t>(constant_values);
-      reference_ops::Pad(data->params, tflite::micro::GetTensorShape(input),
-                         tflite::micro::GetTensorData<int32_t>(input),
-                         &pad_value, tflite::micro::GetTensorShape(output),
-                         tflite::micro::GetTensorData<int32_t>(output));
+      EvalPad(*data, input, &pad_value, output);
     } break;
     default:
 
@@ -269,6 +269,24 @@ TF_LITE_MICRO_TEST(Test2DFloatV2) {
                                   output_data);
 }
 
+TF_LITE_MICRO_TEST(Test3DFloatV2AsymmetricPadding) {
+  int input_dims[] = {3, 2, 2, 3};
+  const float input_values[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  int pad_dims[] = {2, 3, 2};
+  const int32_t pad_values[] = {0, 1, 1, 0, 2, 1};
+  const float pad_value = 7;
+  int output_dims[] = {3, 3, 3, 6};
+  const float golden[] = {
+      7, 7, 7, 7, 7, 7, 7, 7, 1, 2, 3, 7, 7, 7, 4, 5, 6, 7,
+      7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 9, 7, 7, 7, 10, 11, 12, 7,
+      7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7};
+  float output_data[54];
+
+  tflite::testing::TestPadV2Float(input_dims, input_values, pad_dims,
+                                  pad_values, pad_value, output_dims, golden,
+                                  output_data);
+}
+
 TF_LITE_MICRO_TEST(Test2DInt8) {
   int input_dims[] = {4, 1, 2, 2, 1};
   const float input_values[] = {1, 2, 3, 4};
@@ -42,8 +42,7 @@ TfLiteStatus CalculateOpDataPooling(const TfLiteContext* context,
 
 TfLiteStatus PoolingPrepare(TfLiteContext* context, TfLiteNode* node);
 
-void AveragePoolingEvalFloat(const TfLiteContext* context,
-                             const TfLiteNode* node,
+void AveragePoolingEvalFloat(TfLiteContext* context, const TfLiteNode* node,
                              const TfLitePoolParams* params,
                              const OpDataPooling* data,
                              const TfLiteEvalTensor* input,
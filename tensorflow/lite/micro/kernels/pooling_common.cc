@@ -74,8 +74,7 @@ TfLiteStatus PoolingPrepare(TfLiteContext* context, TfLiteNode* node) {
   return kTfLiteOk;
 }
 
-void AveragePoolingEvalFloat(const TfLiteContext* context,
-                             const TfLiteNode* node,
+void AveragePoolingEvalFloat(TfLiteContext* context, const TfLiteNode* node,
                              const TfLitePoolParams* params,
                              const OpDataPooling* data,
                              const TfLiteEvalTensor* input,
@@ -89,10 +88,21 @@ void AveragePoolingEvalFloat(const TfLiteContext* context,
   op_params.padding_values.width = data->padding.width;
   op_params.float_activation_min = data->activation_min_f32;
   op_params.float_activation_max = data->activation_max_f32;
-  reference_ops::AveragePool(op_params, tflite::micro::GetTensorShape(input),
-                             tflite::micro::GetTensorData<float>(input),
-                             tflite::micro::GetTensorShape(output),
-                             tflite::micro::GetTensorData<float>(output));
+  const float* input_data = tflite::micro::GetTensorData<float>(input);
+  float* output_data = tflite::micro::GetTensorData<float>(output);
+  tflite::micro::ParallelForOutputRows(
+      context, tflite::micro::IsComputedInPlace(node, input, output),
+      tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorShape(output), op_params.stride_height,
+      op_params.padding_values.height,
+      [&](const tflite::micro::OutputRowBand& band) {
+        PoolParams band_params = op_params;
+        band_params.padding_values.height = band.padding_height;
+        reference_ops::AveragePool(band_params, band.input_shape,
+                                   input_data + band.input_offset,
+                                   band.output_shape,
+                                   output_data + band.output_offset);
+      });
 }
 
 void AveragePoolingEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
@@ -112,11 +122,21 @@ void AveragePoolingEvalQuantized(TfLiteContext* context, const TfLiteNode* node,
   op_params.quantized_activation_min = data->activation_min;
   op_params.quantized_activation_max = data->activation_max;
 
-  reference_integer_ops::AveragePool(
-      op_params, tflite::micro::GetTensorShape(input),
-      tflite::micro::GetTensorData<int8_t>(input),
-      tflite::micro::GetTensorShape(output),
-      tflite::micro::GetTensorData<int8_t>(output));
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  tflite::micro::ParallelForOutputRows(
+      context, tflite::micro::IsComputedInPlace(node, input, output),
+      tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorShape(output), op_params.stride_height,
+      op_params.padding_values.height,
+      [&](const tflite::micro::OutputRowBand& band) {
+        PoolParams band_params = op_params;
+        band_params.padding_values.height = band.padding_height;
+        reference_integer_ops::AveragePool(band_params, band.input_shape,
+                                           input_data + band.input_offset,
+                                           band.output_shape,
+                                           output_data + band.output_offset);
+      });
 }
 
 void MaxPoolingEvalFloat(TfLiteContext* context, TfLiteNode* node,
@@ -132,10 +152,21 @@ void MaxPoolingEvalFloat(TfLiteContext* context, TfLiteNode* node,
   op_params.padding_values.width = data->padding.width;
   op_params.float_activation_min = data->activation_min_f32;
   op_params.float_activation_max = data->activation_max_f32;
-  reference_ops::MaxPool(op_params, tflite::micro::GetTensorShape(input),
-                         tflite::micro::GetTensorData<float>(input),
-                         tflite::micro::GetTensorShape(output),
-                         tflite::micro::GetTensorData<float>(output));
+  const float* input_data = tflite::micro::GetTensorData<float>(input);
+  float* output_data = tflite::micro::GetTensorData<float>(output);
+  tflite::micro::ParallelForOutputRows(
+      context, tflite::micro::IsComputedInPlace(node, input, output),
+      tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorShape(output), op_params.stride_height,
+      op_params.padding_values.height,
+      [&](const tflite::micro::OutputRowBand& band) {
+        tflite::PoolParams band_params = op_params;
+        band_params.padding_values.height = band.padding_height;
+        reference_ops::MaxPool(band_params, band.input_shape,
+                               input_data + band.input_offset,
+                               band.output_shape,
+                               output_data + band.output_offset);
+      });
 }
 
 void MaxPoolingEvalQuantized(TfLiteContext* context, TfLiteNode* node,
@@ -153,11 +184,21 @@ void MaxPoolingEvalQuantized(TfLiteContext* context, TfLiteNode* node,
   op_params.quantized_activation_min = data->activation_min;
   op_params.quantized_activation_max = data->activation_max;
 
-  reference_integer_ops::MaxPool(op_params,
-                                 tflite::micro::GetTensorShape(input),
-                                 tflite::micro::GetTensorData<int8_t>(input),
-                                 tflite::micro::GetTensorShape(output),
-                                 tflite::micro::GetTensorData<int8_t>(output));
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  tflite::micro::ParallelForOutputRows(
+      context, tflite::micro::IsComputedInPlace(node, input, output),
+      tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorShape(output), op_params.stride_height,
+      op_params.padding_values.height,
+      [&](const tflite::micro::OutputRowBand& band) {
+        tflite::PoolParams band_params = op_params;
+        band_params.padding_values.height = band.padding_height;
+        reference_integer_ops::MaxPool(band_params, band.input_shape,
+                                       input_data + band.input_offset,
+                                       band.output_shape,
+                                       output_data + band.output_offset);
+      });
 }
 
 }  // namespace tflite
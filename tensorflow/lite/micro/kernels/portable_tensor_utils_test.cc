@@ -0,0 +1,163 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "tensorflow/lite/kernels/internal/reference/portable_tensor_utils_impl.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace tflite {
+namespace {
+
+// Each matrix gets its own requantization and bias, picked to cover rounding,
+// left shifts and saturation at both ends of the output type.
+constexpr int kNumMatrices = 5;
+const int32_t kMultipliers[kNumMatrices] = {1073741824, 1518500250,
+                                            1073741824, 1073741824,
+                                            2147483647};
+const int32_t kShifts[kNumMatrices] = {-8, -5, 1, 0, -31};
+
+constexpr int kMaxBatches = 3;
+constexpr int kMaxInputs = 64;
+constexpr int kMaxOutputs = 30;
+constexpr int kMaxOutputSize = kMaxBatches * kMaxOutputs;
+
+int8_t input[kMaxBatches * kMaxInputs];
+int8_t matrix_weights[kNumMatrices][kMaxOutputs * kMaxInputs];
+int32_t matrix_biases[kNumMatrices][kMaxOutputs];
+
+// A linear congruential generator keeps the data identical on all targets.
+uint32_t seed = 1;
+uint32_t NextRandom() {
+  seed = seed * 1664525u + 1013904223u;
+  return seed >> 8;
+}
+
+void InitializeData(int n_batch, int n_input, int n_output) {
+  for (int i = 0; i < n_batch * n_input; ++i) {
+    input[i] = static_cast<int8_t>(NextRandom());
+  }
+  for (int k = 0; k < kNumMatrices; ++k) {
+    for (int i = 0; i < n_output * n_input; ++i) {
+      matrix_weights[k][i] = static_cast<int8_t>(NextRandom());
+    }
+    for (int row = 0; row < n_output; ++row) {
+      int32_t bias;
+      switch (k) {
+        case 0:
+          bias = 0;
+          break;
+        case 2:
+          // Saturates at the maximum of the output type.
+          bias = 1 << 20;
+          break;
+        case 3:
+          // Saturates at the minimum of the output type.
+          bias = -(1 << 22);
+          break;
+        default:
+          bias = static_cast<int32_t>(NextRandom() % 16384) - 8192;
+          break;
+      }
+      matrix_biases[k][row] = bias;
+    }
+  }
+}
+
+// Compares PortableMultiMatrixBatchVectorMultiplyAccumulate against one
+// PortableMatrixBatchVectorMultiplyAccumulate call per matrix, starting from
+// the same non-zero outputs.
+template <typename T>
+void TestMultiMatrixMatchesSingleMatrix(int n_batch, int n_input, int n_output,
+                                        int32_t output_zp) {
+  InitializeData(n_batch, n_input, n_output);
+  const int output_size = n_batch * n_output;
+
+  T initial_output[kNumMatrices][kMaxOutputSize];
+  for (int k = 0; k < kNumMatrices; ++k) {
+    for (int i = 0; i < output_size; ++i) {
+      initial_output[k][i] = static_cast<T>(NextRandom());
+    }
+  }
+
+  T expected[kNumMatrices][kMaxOutputSize];
+  memcpy(expected, initial_output, sizeof(expected));
+  for (int k = 0; k < kNumMatrices; ++k) {
+    tensor_utils::PortableMatrixBatchVectorMultiplyAccumulate(
+        input, matrix_biases[k], matrix_weights[k], kMultipliers[k],
+        kShifts[k], n_batch, n_input, n_output, output_zp,
+        /*scratch=*/nullptr, expected[k], /*context=*/nullptr);
+  }
+
+  const int8_t* weights[kNumMatrices];
+  const int32_t* biases[kNumMatrices];
+  T fused[kNumMatrices][kMaxOutputSize];
+  T* fused_outputs[kNumMatrices];
+  memcpy(fused, initial_output, sizeof(fused));
+  for (int k = 0; k < kNumMatrices; ++k) {
+    weights[k] = matrix_weights[k];
+    biases[k] = matrix_biases[k];
+    fused_outputs[k] = fused[k];
+  }
+  tensor_utils::PortableMultiMatrixBatchVectorMultiplyAccumulate(
+      input, kNumMatrices, weights, biases, kMultipliers, kShifts, n_batch,
+      n_input, n_output, output_zp, fused_outputs);
+
+  bool saturated_max = false;
+  bool saturated_min = false;
+  for (int k = 0; k < kNumMatrices; ++k) {
+    for (int i = 0; i < output_size; ++i) {
+      TF_LITE_MICRO_EXPECT_EQ(expected[k][i], fused[k][i]);
+      saturated_max |= expected[k][i] == std::numeric_limits<T>::max();
+      saturated_min |= expected[k][i] == std::numeric_limits<T>::min();
+    }
+  }
+  TF_LITE_MICRO_EXPECT(saturated_max);
+  TF_LITE_MICRO_EXPECT(saturated_min);
+}
+
+}  // namespace
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(MultiMatrixInt16SingleRowMatchesSingleMatrix) {
+  tflite::TestMultiMatrixMatchesSingleMatrix<int16_t>(
+      /*n_batch=*/1, /*n_input=*/1, /*n_output=*/1, /*output_zp=*/0);
+}
+
+TF_LITE_MICRO_TEST(MultiMatrixInt16BlockedRowsMatchSingleMatrix) {
+  tflite::TestMultiMatrixMatchesSingleMatrix<int16_t>(
+      /*n_batch=*/2, /*n_input=*/5, /*n_output=*/8, /*output_zp=*/0);
+}
+
+TF_LITE_MICRO_TEST(MultiMatrixInt16RowTailMatchesSingleMatrix) {
+  tflite::TestMultiMatrixMatchesSingleMatrix<int16_t>(
+      /*n_batch=*/3, /*n_input=*/64, /*n_output=*/30, /*output_zp=*/0);
+}
+
+TF_LITE_MICRO_TEST(MultiMatrixInt8MatchesSingleMatrix) {
+  tflite::TestMultiMatrixMatchesSingleMatrix<int8_t>(
+      /*n_batch=*/2, /*n_input=*/33, /*n_output=*/13, /*output_zp=*/-3);
+}
+
+TF_LITE_MICRO_TEST(MultiMatrixInt8FewRowsMatchSingleMatrix) {
+  tflite::TestMultiMatrixMatchesSingleMatrix<int8_t>(
+      /*n_batch=*/3, /*n_input=*/7, /*n_output=*/3, /*output_zp=*/5);
+}
+
+TF_LITE_MICRO_TESTS_END
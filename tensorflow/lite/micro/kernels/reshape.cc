@@ -90,7 +90,8 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_STATUS(TfLiteTypeSizeOf(input->type, &input_bytes));
   input_bytes *= ElementCount(*input->dims);
 
-  // Do nothing for in-place reshape.
+  // Do nothing for in-place reshape. The memory planner aliases the output to
+  // the input whenever it can, see AllocationInfoBuilder::AliasShapeOnlyOps().
   if (input->data.raw != output->data.raw) {
     // Otherwise perform reshape with copy.
     for (size_t i = 0; i < input_bytes; ++i) {
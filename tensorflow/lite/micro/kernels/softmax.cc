@@ -28,28 +28,24 @@ limitations under the License.
 namespace tflite {
 namespace {
 
-void SoftmaxQuantized(const TfLiteEvalTensor* input, TfLiteEvalTensor* output,
+void SoftmaxQuantized(const TfLiteEvalTensor* input,
+                      const RuntimeShape& input_shape, TfLiteEvalTensor* output,
+                      const RuntimeShape& output_shape,
                       const SoftmaxParams& op_data) {
   if (input->type == kTfLiteInt8) {
     if (output->type == kTfLiteInt16) {
       tflite::reference_ops::Softmax(
-          op_data, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int8_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int16_t>(output));
+          op_data, input_shape, tflite::micro::GetTensorData<int8_t>(input),
+          output_shape, tflite::micro::GetTensorData<int16_t>(output));
     } else {
       tflite::reference_ops::Softmax(
-          op_data, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int8_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int8_t>(output));
+          op_data, input_shape, tflite::micro::GetTensorData<int8_t>(input),
+          output_shape, tflite::micro::GetTensorData<int8_t>(output));
     }
   } else {
     tflite::reference_ops::SoftmaxInt16(
-        op_data, tflite::micro::GetTensorShape(input),
-        tflite::micro::GetTensorData<int16_t>(input),
-        tflite::micro::GetTensorShape(output),
-        tflite::micro::GetTensorData<int16_t>(output));
+        op_data, input_shape, tflite::micro::GetTensorData<int16_t>(input),
+        output_shape, tflite::micro::GetTensorData<int16_t>(output));
   }
 }
 
@@ -59,19 +55,19 @@ TfLiteStatus SoftmaxEval(TfLiteContext* context, TfLiteNode* node) {
 
   TFLITE_DCHECK(node->user_data != nullptr);
   SoftmaxParams op_data = *static_cast<SoftmaxParams*>(node->user_data);
+  const RuntimeShape& input_shape = tflite::micro::GetEvalInputShape(node, 0);
+  const RuntimeShape& output_shape = tflite::micro::GetEvalOutputShape(node, 0);
 
   switch (input->type) {
     case kTfLiteFloat32: {
       tflite::reference_ops::Softmax(
-          op_data, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<float>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<float>(output));
+          op_data, input_shape, tflite::micro::GetTensorData<float>(input),
+          output_shape, tflite::micro::GetTensorData<float>(output));
       return kTfLiteOk;
     }
     case kTfLiteInt8:
     case kTfLiteInt16: {
-      SoftmaxQuantized(input, output, op_data);
+      SoftmaxQuantized(input, input_shape, output, output_shape, op_data);
       return kTfLiteOk;
     }
     default:
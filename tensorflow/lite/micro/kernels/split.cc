@@ -17,99 +17,96 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/copy_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 
 namespace tflite {
 namespace ops {
 namespace micro {
 namespace split {
 
-template <typename T>
-TfLiteStatus SplitImpl(TfLiteContext* context, TfLiteNode* node,
-                       const TfLiteEvalTensor* input, int axis_value) {
-  const int output_count = NumOutputs(node);
-  const TfLiteIntArray* input_dims = input->dims;
-  const TfLiteEvalTensor* output0 =
-      tflite::micro::GetEvalOutput(context, node, 0);
-  const TfLiteIntArray* output_dims = output0->dims;
-
-  const int split_dimensions = input_dims->size;
-  int axis = axis_value < 0 ? axis_value + split_dimensions : axis_value;
-
-  TFLITE_DCHECK_LT(axis, split_dimensions);
-  TFLITE_DCHECK_EQ(output_dims->size, split_dimensions);
-
-  int64_t split_size = output_dims->data[axis] * output_count;
-
-  TFLITE_DCHECK_EQ(split_size, input_dims->data[axis]);
-  int64_t outer_size = 1;
-  for (int i = 0; i < axis; ++i) {
-    outer_size *= input_dims->data[i];
-  }
-
-  int64_t base_inner_size = 1;
-  for (int i = axis + 1; i < split_dimensions; ++i) {
-    base_inner_size *= input_dims->data[i];
-  }
-
-  const T* input_ptr = tflite::micro::GetTensorData<T>(input);
-  for (int k = 0; k < outer_size; ++k) {
-    for (int i = 0; i < output_count; ++i) {
-      TfLiteEvalTensor* t = tflite::micro::GetEvalOutput(context, node, i);
-      T* output_data = tflite::micro::GetTensorData<T>(t);
-      const int copy_size = output_dims->data[axis] * base_inner_size;
-      T* output_ptr = output_data + k * copy_size;
-      for (int j = 0; j < copy_size; ++j) output_ptr[j] = input_ptr[j];
-      input_ptr += copy_size;
-    }
-  }
-
-  return kTfLiteOk;
+struct OpData {
+  // Number of slices of the input before the split axis.
+  int outer_size;
+  // Bytes in one slice of each output, and in one slice of the input.
+  int output_run_bytes;
+  int input_run_bytes;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteTensor* axis = GetInput(context, node, 0);
   TF_LITE_ENSURE(context, axis != nullptr);
+  const TfLiteTensor* input = GetInput(context, node, 1);
+  TF_LITE_ENSURE(context, input != nullptr);
 
   // Dynamic output tensors are needed if axis tensor is not constant.
   // But Micro doesn't support dynamic memory allocation, so we only support
   // constant axis tensor for now.
   TF_LITE_ENSURE_MSG(context, IsConstantTensor(axis),
                      "Non constant axis tensor not supported");
+
+  switch (input->type) {
+    case kTfLiteFloat32:
+    case kTfLiteInt8:
+    case kTfLiteInt16:
+    case kTfLiteInt32:
+      break;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s currently not supported.",
+                         TfLiteTypeGetName(input->type));
+      return kTfLiteError;
+  }
+
+  const TfLiteIntArray* input_dims = input->dims;
+  int axis_value = GetTensorData<int32_t>(axis)[0];
+  if (axis_value < 0) {
+    axis_value += input_dims->size;
+  }
+  TF_LITE_ENSURE(context, axis_value >= 0);
+  TF_LITE_ENSURE(context, axis_value < input_dims->size);
+
+  const int output_count = NumOutputs(node);
+  TF_LITE_ENSURE_EQ(context, input_dims->data[axis_value] % output_count, 0);
+
+  size_t element_size;
+  TF_LITE_ENSURE_OK(context, TfLiteTypeSizeOf(input->type, &element_size));
+  const int inner_bytes = static_cast<int>(element_size) *
+                          tflite::micro::FlatSizeOfDims(
+                              input_dims, axis_value + 1, input_dims->size);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  data->outer_size =
+      tflite::micro::FlatSizeOfDims(input_dims, 0, axis_value);
+  data->input_run_bytes = input_dims->data[axis_value] * inner_bytes;
+  data->output_run_bytes = data->input_run_bytes / output_count;
   return kTfLiteOk;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
-  const TfLiteEvalTensor* axis = tflite::micro::GetEvalInput(context, node, 0);
   const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 1);
 
-  int axis_value = tflite::micro::GetTensorData<int32_t>(axis)[0];
-  if (axis_value < 0) {
-    axis_value += input->dims->size;
-  }
-
-  TF_LITE_ENSURE(context, axis_value >= 0);
-  TF_LITE_ENSURE(context, axis_value < input->dims->size);
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *static_cast<const OpData*>(node->user_data);
 
-  switch (input->type) {
-    case kTfLiteFloat32: {
-      return SplitImpl<float>(context, node, input, axis_value);
-    }
-    case kTfLiteInt8: {
-      return SplitImpl<int8_t>(context, node, input, axis_value);
-    }
-    case kTfLiteInt16: {
-      return SplitImpl<int16_t>(context, node, input, axis_value);
-    }
-    case kTfLiteInt32: {
-      return SplitImpl<int32_t>(context, node, input, axis_value);
-    }
-    default:
-      TF_LITE_KERNEL_LOG(context, "Type %s currently not supported.",
-                         TfLiteTypeGetName(input->type));
-      return kTfLiteError;
+  // Each output takes an equally sized slice of each of the outer_size runs
+  // of the input, which makes the copy independent of the tensor type.
+  const uint8_t* input_ptr = tflite::micro::GetTensorData<uint8_t>(input);
+  const int output_count = NumOutputs(node);
+  for (int i = 0; i < output_count; ++i) {
+    TfLiteEvalTensor* t = tflite::micro::GetEvalOutput(context, node, i);
+    tflite::micro::CopyRuns(input_ptr, data.input_run_bytes,
+                            tflite::micro::GetTensorData<uint8_t>(t),
+                            data.output_run_bytes, data.output_run_bytes,
+                            data.outer_size);
+    input_ptr += data.output_run_bytes;
   }
-#undef TF_LITE_SPLIT
 
   return kTfLiteOk;
 }
@@ -117,7 +114,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace split
 
 TfLiteRegistration Register_SPLIT() {
-  return {/*init=*/nullptr,
+  return {/*init=*/split::Init,
           /*free=*/nullptr,
           /*prepare=*/split::Prepare,
           /*invoke=*/split::Eval,
@@ -457,4 +457,48 @@ TF_LITE_MICRO_TEST(TwoSplitFourDimensionalQuantized32) {
       output2_shape, golden2, output1_data, output2_data);
 }
 
+TF_LITE_MICRO_TEST(TwoSplitThreeDimensionalQuantizedAxisZero) {
+  // Splitting the outermost axis gives each output one contiguous block.
+  int input_shape[] = {3, 2, 3, 4};
+  const int8_t input_data[] = {1,  2,  3,  4,  5,  6,  7,  8,
+                               9,  10, 11, 12, 13, 14, 15, 16,
+                               17, 18, 19, 20, 21, 22, 23, 24};
+  int axis_shape[] = {1, 1};
+  const int32_t axis_data[] = {0};
+  int output1_shape[] = {3, 1, 3, 4};
+  const int8_t golden1[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+  int output2_shape[] = {3, 1, 3, 4};
+  const int8_t golden2[] = {13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24};
+
+  constexpr int output1_dims_count = 12;
+  constexpr int output2_dims_count = 12;
+  int8_t output1_data[output1_dims_count];
+  int8_t output2_data[output2_dims_count];
+  tflite::testing::TestSplitTwoOutputsQuantized(
+      input_shape, input_data, axis_shape, axis_data, output1_shape, golden1,
+      output2_shape, golden2, output1_data, output2_data);
+}
+
+TF_LITE_MICRO_TEST(TwoSplitThreeDimensionalQuantizedLastAxis) {
+  // Splitting the innermost axis copies one short run per outer index.
+  int input_shape[] = {3, 2, 3, 4};
+  const int8_t input_data[] = {1,  2,  3,  4,  5,  6,  7,  8,
+                               9,  10, 11, 12, 13, 14, 15, 16,
+                               17, 18, 19, 20, 21, 22, 23, 24};
+  int axis_shape[] = {1, 1};
+  const int32_t axis_data[] = {2};
+  int output1_shape[] = {3, 2, 3, 2};
+  const int8_t golden1[] = {1, 2, 5, 6, 9, 10, 13, 14, 17, 18, 21, 22};
+  int output2_shape[] = {3, 2, 3, 2};
+  const int8_t golden2[] = {3, 4, 7, 8, 11, 12, 15, 16, 19, 20, 23, 24};
+
+  constexpr int output1_dims_count = 12;
+  constexpr int output2_dims_count = 12;
+  int8_t output1_data[output1_dims_count];
+  int8_t output2_data[output2_dims_count];
+  tflite::testing::TestSplitTwoOutputsQuantized(
+      input_shape, input_data, axis_shape, axis_data, output1_shape, golden1,
+      output2_shape, golden2, output1_data, output2_data);
+}
+
 TF_LITE_MICRO_TESTS_END
@@ -18,57 +18,27 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
+#include "tensorflow/lite/micro/kernels/copy_util.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 
 namespace tflite {
 namespace ops {
 namespace micro {
 namespace split_v {
 
-template <typename T>
-TfLiteStatus SplitImpl(TfLiteContext* context, TfLiteNode* node,
-                       const TfLiteEvalTensor* input, int axis_value) {
-  const TfLiteIntArray* input_dims = input->dims;
-  const TfLiteEvalTensor* output0 =
-      tflite::micro::GetEvalOutput(context, node, 0);
-
-  const int split_dimensions = input_dims->size;
-
-  TFLITE_DCHECK_LT(axis_value, split_dimensions);
-  TFLITE_DCHECK_EQ(output0->dims->size, split_dimensions);
-
-  int64_t split_size = 0;
-  const int output_count = NumOutputs(node);
-  for (int i = 0; i < output_count; i++) {
-    split_size +=
-        tflite::micro::GetEvalOutput(context, node, i)->dims->data[axis_value];
-  }
-  TFLITE_DCHECK_EQ(split_size, input_dims->data[axis_value]);
-  int64_t outer_size = 1;
-  for (int i = 0; i < axis_value; ++i) {
-    outer_size *= input_dims->data[i];
-  }
-
-  int64_t base_inner_size = 1;
-  for (int i = axis_value + 1; i < split_dimensions; ++i) {
-    base_inner_size *= input_dims->data[i];
-  }
-
-  const T* input_ptr = tflite::micro::GetTensorData<T>(input);
-  for (int k = 0; k < outer_size; ++k) {
-    for (int i = 0; i < output_count; ++i) {
-      TfLiteEvalTensor* output_tensor =
-          tflite::micro::GetEvalOutput(context, node, i);
-      T* output_data = tflite::micro::GetTensorData<T>(output_tensor);
-      const int copy_size =
-          output_tensor->dims->data[axis_value] * base_inner_size;
-      T* output_ptr = output_data + k * copy_size;
-      for (int j = 0; j < copy_size; ++j) output_ptr[j] = input_ptr[j];
-      input_ptr += copy_size;
-    }
-  }
-
-  return kTfLiteOk;
+struct OpData {
+  // Number of slices of the input before the split axis.
+  int outer_size;
+  // Bytes in one slice of the input, and in one unit of the split axis.
+  int input_run_bytes;
+  int inner_bytes;
+  int axis;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
@@ -81,46 +51,82 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_MSG(context, IsConstantTensor(axis),
                      "Non constant axis tensor not supported");
 
+  const TfLiteTensor* input = GetInput(context, node, 0);
+  TF_LITE_ENSURE(context, input != nullptr);
+  switch (input->type) {
+    case kTfLiteFloat32:
+    case kTfLiteInt8:
+    case kTfLiteInt16:
+    case kTfLiteInt32:
+      break;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s currently not supported.",
+                         TfLiteTypeGetName(input->type));
+      return kTfLiteError;
+  }
+
+  const TfLiteIntArray* input_dims = input->dims;
+  int axis_value = GetTensorData<int32_t>(axis)[0];
+  if (axis_value < 0) {
+    axis_value += input_dims->size;
+  }
+  TF_LITE_ENSURE(context, axis_value >= 0);
+  TF_LITE_ENSURE(context, axis_value < input_dims->size);
+
+  int split_size = 0;
+  const int output_count = NumOutputs(node);
+  for (int i = 0; i < output_count; i++) {
+    const TfLiteTensor* output = GetOutput(context, node, i);
+    TF_LITE_ENSURE(context, output != nullptr);
+    TF_LITE_ENSURE_EQ(context, output->dims->size, input_dims->size);
+    split_size += output->dims->data[axis_value];
+  }
+  TF_LITE_ENSURE_EQ(context, split_size, input_dims->data[axis_value]);
+
+  size_t element_size;
+  TF_LITE_ENSURE_OK(context, TfLiteTypeSizeOf(input->type, &element_size));
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  data->axis = axis_value;
+  data->outer_size =
+      tflite::micro::FlatSizeOfDims(input_dims, 0, axis_value);
+  data->inner_bytes = static_cast<int>(element_size) *
+                      tflite::micro::FlatSizeOfDims(
+                          input_dims, axis_value + 1, input_dims->size);
+  data->input_run_bytes = input_dims->data[axis_value] * data->inner_bytes;
   return kTfLiteOk;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
-  const TfLiteEvalTensor* axis = tflite::micro::GetEvalInput(context, node, 2);
-
-  int axis_value = tflite::micro::GetTensorData<int32_t>(axis)[0];
-  if (axis_value < 0) {
-    axis_value += input->dims->size;
-  }
 
-  TF_LITE_ENSURE(context, axis_value >= 0);
-  TF_LITE_ENSURE(context, axis_value < input->dims->size);
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *static_cast<const OpData*>(node->user_data);
 
-  switch (input->type) {
-    case kTfLiteFloat32: {
-      return SplitImpl<float>(context, node, input, axis_value);
-    }
-    case kTfLiteInt8: {
-      return SplitImpl<int8_t>(context, node, input, axis_value);
-    }
-    case kTfLiteInt16: {
-      return SplitImpl<int16_t>(context, node, input, axis_value);
-    }
-    case kTfLiteInt32: {
-      return SplitImpl<int32_t>(context, node, input, axis_value);
-    }
-    default:
-      TF_LITE_KERNEL_LOG(context, "Type %s currently not supported.",
-                         TfLiteTypeGetName(input->type));
-      return kTfLiteError;
+  // Each output takes a slice of each of the outer_size runs of the input,
+  // which makes the copy independent of the tensor type.
+  const uint8_t* input_ptr = tflite::micro::GetTensorData<uint8_t>(input);
+  const int output_count = NumOutputs(node);
+  for (int i = 0; i < output_count; ++i) {
+    TfLiteEvalTensor* output_tensor =
+        tflite::micro::GetEvalOutput(context, node, i);
+    const int run_bytes =
+        output_tensor->dims->data[data.axis] * data.inner_bytes;
+    tflite::micro::CopyRuns(
+        input_ptr, data.input_run_bytes,
+        tflite::micro::GetTensorData<uint8_t>(output_tensor), run_bytes,
+        run_bytes, data.outer_size);
+    input_ptr += run_bytes;
   }
+
   return kTfLiteOk;
 }
 
 }  // namespace split_v
 
 TfLiteRegistration Register_SPLIT_V() {
-  return {/*init=*/nullptr,
+  return {/*init=*/split_v::Init,
           /*free=*/nullptr,
           /*prepare=*/split_v::Prepare,
           /*invoke=*/split_v::Eval,
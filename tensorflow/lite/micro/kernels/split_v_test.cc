@@ -465,4 +465,47 @@ TF_LITE_MICRO_TEST(SPLIT_V_OneDimensionalFloatTest2) {
                                    output_tensors);
 }
 
+TF_LITE_MICRO_TEST(SPLIT_V_ThreeDimensionalFloatUnevenInnerAxis) {
+  // Splitting an inner axis into uneven parts copies runs of different
+  // lengths, including single elements, for each outer index.
+  constexpr int output1_dims_count = 6;
+  constexpr int output2_dims_count = 18;
+  constexpr int output3_dims_count = 6;
+  float output1_data[output1_dims_count];
+  float output2_data[output2_dims_count];
+  float output3_data[output3_dims_count];
+  int input_shape[] = {3, 2, 3, 5};
+  float input_values[] = {1,  2,  3,  4,  5,  6,  7,  8,  9,  10,
+                          11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+                          21, 22, 23, 24, 25, 26, 27, 28, 29, 30};
+  int axis_shape[] = {1, 1};
+  int32_t axis_values[] = {2};
+  int split_shape[] = {1, 3};
+  int32_t split_values[] = {1, 3, 1};
+  int output1_shape[] = {3, 2, 3, 1};
+  float output1_values[] = {1, 6, 11, 16, 21, 26};
+  int output2_shape[] = {3, 2, 3, 3};
+  float output2_values[] = {2,  3,  4,  7,  8,  9,  12, 13, 14,
+                            17, 18, 19, 22, 23, 24, 27, 28, 29};
+  int output3_shape[] = {3, 2, 3, 1};
+  float output3_values[] = {5, 10, 15, 20, 25, 30};
+
+  tflite::testing::OutputTensors<3> output_tensors;
+  output_tensors.data[0] = output1_data;
+  output_tensors.data[1] = output2_data;
+  output_tensors.data[2] = output3_data;
+
+  output_tensors.dims[0] = output1_shape;
+  output_tensors.dims[1] = output2_shape;
+  output_tensors.dims[2] = output3_shape;
+
+  output_tensors.expected_output_data[0] = output1_values;
+  output_tensors.expected_output_data[1] = output2_values;
+  output_tensors.expected_output_data[2] = output3_values;
+
+  tflite::testing::TestSplitVFloat(input_shape, input_values, axis_shape,
+                                   axis_values, split_shape, split_values,
+                                   output_tensors);
+}
+
 TF_LITE_MICRO_TESTS_END
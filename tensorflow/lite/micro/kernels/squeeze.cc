@@ -80,18 +80,24 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
-  SqueezeContext op_context(context, node);
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
 
-  if (op_context.input->type == kTfLiteString) {
+  if (input->type == kTfLiteString) {
     TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
-                       TfLiteTypeGetName(op_context.input->type),
-                       op_context.input->type);
+                       TfLiteTypeGetName(input->type), input->type);
     return kTfLiteError;
   }
 
-  TF_LITE_ENSURE_EQ(context, op_context.input->bytes, op_context.output->bytes);
-  memcpy(op_context.output->data.raw, op_context.input->data.raw,
-         op_context.input->bytes);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
+  size_t input_bytes;
+  size_t output_bytes;
+  TF_LITE_ENSURE_STATUS(TfLiteEvalTensorByteLength(input, &input_bytes));
+  TF_LITE_ENSURE_STATUS(TfLiteEvalTensorByteLength(output, &output_bytes));
+  TF_LITE_ENSURE_EQ(context, input_bytes, output_bytes);
+  // Nothing to do when the memory planner aliased the output to the input.
+  if (input->data.raw != output->data.raw) {
+    memcpy(output->data.raw, input->data.raw, input_bytes);
+  }
   return kTfLiteOk;
 }
 
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
 
 namespace tflite {
 namespace ops {
@@ -117,34 +118,138 @@ TfLiteStatus CheckOutputSize(TfLiteContext* context,
   return kTfLiteOk;
 }
 
+struct OpData {
+  StridedSliceParams params;
+  // Set when the innermost stride is 1. The slice is then copied as runs of
+  // run_bytes contiguous bytes, one for each index of the four outer
+  // dimensions of the 5D extended shape that are not part of the run.
+  bool use_runs;
+  int run_bytes;
+  int input_offset_bytes;
+  int loop_count[4];
+  int loop_step_bytes[4];
+};
+
+// Returns the number of indices visited from start towards stop, the same
+// way the reference kernel's loops do.
+int SliceCount(int start, int stop, int stride) {
+  const int distance = stride > 0 ? stop - start : start - stop;
+  const int step = stride > 0 ? stride : -stride;
+  return distance <= 0 ? 0 : (distance + step - 1) / step;
+}
+
+// Finds the largest run of the slice that is contiguous in both the input and
+// the output: the innermost dimension with a stride of 1, extended outwards
+// across dimensions that are copied whole.
+TfLiteStatus CalculateContiguousRuns(TfLiteContext* context,
+                                     StridedSliceContext* op_context,
+                                     OpData* data) {
+  using ::tflite::strided_slice::StartForAxis;
+  using ::tflite::strided_slice::StopForAxis;
+  constexpr int kDims = 5;
+
+  StridedSliceParams params = data->params;
+  ::tflite::strided_slice::StridedSlicePadIndices(&params, kDims);
+  const RuntimeShape input_shape =
+      RuntimeShape::ExtendedShape(kDims, GetTensorShape(op_context->input));
+
+  int start[kDims];
+  int count[kDims];
+  int input_stride[kDims];
+  for (int d = kDims - 1; d >= 0; --d) {
+    start[d] = StartForAxis(params, input_shape, d);
+    const int stop = StopForAxis(params, input_shape, d, start[d]);
+    count[d] = SliceCount(start[d], stop, params.strides[d]);
+    input_stride[d] =
+        d == kDims - 1 ? 1 : input_stride[d + 1] * input_shape.Dims(d + 1);
+  }
+
+  data->use_runs = params.strides[kDims - 1] == 1;
+  if (!data->use_runs) {
+    return kTfLiteOk;
+  }
+
+  int run_dim = kDims - 1;
+  while (run_dim > 0 && start[run_dim] == 0 && params.strides[run_dim] == 1 &&
+         count[run_dim] == input_shape.Dims(run_dim)) {
+    --run_dim;
+  }
+  if (params.strides[run_dim] != 1) {
+    ++run_dim;
+  }
+
+  size_t element_size;
+  TF_LITE_ENSURE_OK(context,
+                    TfLiteTypeSizeOf(op_context->input->type, &element_size));
+  const int element_bytes = static_cast<int>(element_size);
+
+  data->run_bytes = count[run_dim] * input_stride[run_dim] * element_bytes;
+  int input_offset = 0;
+  for (int d = 0; d < kDims; ++d) {
+    input_offset += start[d] * input_stride[d];
+  }
+  data->input_offset_bytes = input_offset * element_bytes;
+  for (int d = 0; d < kDims - 1; ++d) {
+    data->loop_count[d] = d < run_dim ? count[d] : 1;
+    data->loop_step_bytes[d] =
+        params.strides[d] * input_stride[d] * element_bytes;
+  }
+  return kTfLiteOk;
+}
+
+void EvalContiguousRuns(const OpData& data, const TfLiteEvalTensor* input,
+                        TfLiteEvalTensor* output) {
+  const uint8_t* input_ptr =
+      tflite::micro::GetTensorData<uint8_t>(input) + data.input_offset_bytes;
+  uint8_t* output_ptr = tflite::micro::GetTensorData<uint8_t>(output);
+  const int* count = data.loop_count;
+  const int* step = data.loop_step_bytes;
+  for (int i0 = 0; i0 < count[0]; ++i0) {
+    const uint8_t* ptr0 = input_ptr + i0 * step[0];
+    for (int i1 = 0; i1 < count[1]; ++i1) {
+      const uint8_t* ptr1 = ptr0 + i1 * step[1];
+      for (int i2 = 0; i2 < count[2]; ++i2) {
+        const uint8_t* ptr2 = ptr1 + i2 * step[2];
+        for (int i3 = 0; i3 < count[3]; ++i3) {
+          std::memcpy(output_ptr, ptr2 + i3 * step[3], data.run_bytes);
+          output_ptr += data.run_bytes;
+        }
+      }
+    }
+  }
+}
+
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context, sizeof(StridedSliceParams));
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
-  StridedSliceParams* op_params =
-      static_cast<StridedSliceParams*>(node->user_data);
+  OpData* data = static_cast<OpData*>(node->user_data);
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 4);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
   StridedSliceContext op_context(context, node);
   TF_LITE_ENSURE_MSG(context, op_context.dims <= kMaxDim,
                      "input dim should not exceed 4");
-  auto params = BuildStridedSliceParams(&op_context);
-  memcpy(op_params, &params, sizeof(StridedSliceParams));
-  return CheckOutputSize(context, &op_context);
+  data->params = BuildStridedSliceParams(&op_context);
+  TF_LITE_ENSURE_OK(context, CheckOutputSize(context, &op_context));
+  return CalculateContiguousRuns(context, &op_context, data);
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
-  const StridedSliceParams& op_params =
-      *(static_cast<const StridedSliceParams*>(node->user_data));
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+  const StridedSliceParams& op_params = data.params;
 
   const TfLiteEvalTensor* input =
       tflite::micro::GetEvalInput(context, node, kInputTensor);
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+  if (data.use_runs) {
+    EvalContiguousRuns(data, input, output);
+    return kTfLiteOk;
+  }
   switch (output->type) {
     case kTfLiteFloat32:
       reference_ops::StridedSlice(op_params,
@@ -1071,4 +1071,94 @@ TF_LITE_MICRO_TEST(In3D_IdentityShrinkAxis1int16) {
       golden, false);
 }
 
+// The tests below cover the contiguous run copy used when the innermost stride
+// is 1, with runs that do and do not extend across the inner dimensions.
+TF_LITE_MICRO_TEST(In3D_ContiguousRunAcrossInnerDims) {
+  int input_shape[] = {3, 3, 2, 3};
+  int begin_shape[] = {1, 3};
+  int end_shape[] = {1, 3};
+  int strides_shape[] = {1, 3};
+  int output_shape[] = {3, 2, 2, 3};
+  float input_data[] = {1,  2,  3,  4,  5,  6,  7,  8,  9,
+                        10, 11, 12, 13, 14, 15, 16, 17, 18};
+  int32_t begin_data[] = {1, 0, 0};
+  int32_t end_data[] = {3, 2, 3};
+  int32_t strides_data[] = {1, 1, 1};
+  float golden[] = {7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18};
+  float output_data[12];
+
+  TfLiteStridedSliceParams builtin_data = {0, 0, 0, 0, 0};
+
+  tflite::testing::TestStridedSliceFloat(
+      input_shape, begin_shape, end_shape, strides_shape, &builtin_data,
+      input_data, begin_data, end_data, strides_data, output_shape, output_data,
+      golden, false);
+}
+
+TF_LITE_MICRO_TEST(In3D_ContiguousRunsOfPartialInnerDimInt8) {
+  int input_shape[] = {3, 3, 2, 3};
+  int begin_shape[] = {1, 3};
+  int end_shape[] = {1, 3};
+  int strides_shape[] = {1, 3};
+  int output_shape[] = {3, 3, 2, 2};
+  int8_t input_data[] = {1,  2,  3,  4,  5,  6,  7,  8,  9,
+                         10, 11, 12, 13, 14, 15, 16, 17, 18};
+  int32_t begin_data[] = {0, 0, 1};
+  int32_t end_data[] = {3, 2, 3};
+  int32_t strides_data[] = {1, 1, 1};
+  int8_t golden[] = {2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18};
+  int8_t output_data[12];
+
+  TfLiteStridedSliceParams builtin_data = {0, 0, 0, 0, 0};
+
+  tflite::testing::TestStridedSliceQuantized(
+      input_shape, begin_shape, end_shape, strides_shape, &builtin_data,
+      input_data, begin_data, end_data, strides_data, output_shape, output_data,
+      golden, false);
+}
+
+TF_LITE_MICRO_TEST(In3D_ContiguousRunsOfPartialMiddleDim) {
+  int input_shape[] = {3, 3, 2, 3};
+  int begin_shape[] = {1, 3};
+  int end_shape[] = {1, 3};
+  int strides_shape[] = {1, 3};
+  int output_shape[] = {3, 3, 1, 3};
+  float input_data[] = {1,  2,  3,  4,  5,  6,  7,  8,  9,
+                        10, 11, 12, 13, 14, 15, 16, 17, 18};
+  int32_t begin_data[] = {0, 1, 0};
+  int32_t end_data[] = {3, 2, 3};
+  int32_t strides_data[] = {1, 1, 1};
+  float golden[] = {4, 5, 6, 10, 11, 12, 16, 17, 18};
+  float output_data[9];
+
+  TfLiteStridedSliceParams builtin_data = {0, 0, 0, 0, 0};
+
+  tflite::testing::TestStridedSliceFloat(
+      input_shape, begin_shape, end_shape, strides_shape, &builtin_data,
+      input_data, begin_data, end_data, strides_data, output_shape, output_data,
+      golden, false);
+}
+
+TF_LITE_MICRO_TEST(In3D_ContiguousRunsWithNegativeOuterStride) {
+  int input_shape[] = {3, 3, 2, 3};
+  int begin_shape[] = {1, 3};
+  int end_shape[] = {1, 3};
+  int strides_shape[] = {1, 3};
+  int output_shape[] = {3, 2, 2, 3};
+  float input_data[] = {1,  2,  3,  4,  5,  6,  7,  8,  9,
+                        10, 11, 12, 13, 14, 15, 16, 17, 18};
+  int32_t begin_data[] = {2, 0, 0};
+  int32_t end_data[] = {0, 2, 3};
+  int32_t strides_data[] = {-1, 1, 1};
+  float golden[] = {13, 14, 15, 16, 17, 18, 7, 8, 9, 10, 11, 12};
+  float output_data[12];
+
+  TfLiteStridedSliceParams builtin_data = {0, 0, 0, 0, 0};
+
+  tflite::testing::TestStridedSliceFloat(
+      input_shape, begin_shape, end_shape, strides_shape, &builtin_data,
+      input_data, begin_data, end_data, strides_data, output_shape, output_data,
+      golden, false);
+}
+
 TF_LITE_MICRO_TESTS_END
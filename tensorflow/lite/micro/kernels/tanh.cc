@@ -24,6 +24,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
 #include "tensorflow/lite/micro/micro_utils.h"
 
 namespace tflite {
@@ -39,6 +40,8 @@ struct OpData {
   int32_t input_range_radius;
   int32_t input_multiplier;
   int input_left_shift;
+  // Lookup table for the int8 path, built in TanhPrepare.
+  int8_t* lut;
 };
 
 void* TanhInit(TfLiteContext* context, const char* buffer, size_t length) {
@@ -80,7 +83,21 @@ TfLiteStatus TanhPrepare(TfLiteContext* context, TfLiteNode* node) {
   const TfLiteTensor* input = GetInput(context, node, kInputTensor);
   TF_LITE_ENSURE(context, input != nullptr);
   data->input_zero_point = input->params.zero_point;
-  return CalculateArithmeticOpData(context, node, data);
+  TF_LITE_ENSURE_OK(context, CalculateArithmeticOpData(context, node, data));
+
+  if (input->type == kTfLiteInt8) {
+    data->lut = CreateInt8UnaryLut(
+        context, [data](const int8_t* input_data, int8_t* output_data,
+                        int size) {
+          const RuntimeShape shape(1, &size);
+          reference_integer_ops::Tanh(
+              data->input_zero_point, data->input_range_radius,
+              data->input_multiplier, data->input_left_shift, shape,
+              input_data, shape, output_data);
+        });
+    TF_LITE_ENSURE(context, data->lut != nullptr);
+  }
+  return kTfLiteOk;
 }
 
 }  // namespace
@@ -112,12 +129,7 @@ TfLiteStatus TanhEval(TfLiteContext* context, TfLiteNode* node) {
       return kTfLiteOk;
     } break;
     case kTfLiteInt8: {
-      reference_integer_ops::Tanh(
-          data.input_zero_point, data.input_range_radius, data.input_multiplier,
-          data.input_left_shift, tflite::micro::GetTensorShape(input),
-          tflite::micro::GetTensorData<int8_t>(input),
-          tflite::micro::GetTensorShape(output),
-          tflite::micro::GetTensorData<int8_t>(output));
+      EvalInt8UnaryLut(data.lut, input, output);
       return kTfLiteOk;
     } break;
     default:
@@ -14,14 +14,23 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/lite/kernels/internal/reference/transpose.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_utils.h"
 
 namespace tflite {
 namespace {
 
+// Edge length of the square tiles used by the 2D transpose, chosen so that a
+// tile of float32 input and output rows stays resident in a small L1 cache.
+constexpr int kTransposeBlockSize = 8;
+
 struct TransposeContext {
   TransposeContext(TfLiteContext* context, TfLiteNode* node) {
     input = GetInput(context, node, 0);
@@ -33,6 +42,134 @@ struct TransposeContext {
   TfLiteTensor* output;
 };
 
+// Permutation computed in Prepare, after dropping dimensions of size 1 and
+// merging dimensions that stay adjacent in both the input and the output.
+struct OpData {
+  TransposeParams params;
+  int32_t input_dims[5];
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+// Rewrites the transpose of `input_dims` by `perm` into the equivalent
+// transpose with the fewest dimensions. A permutation that only moves
+// dimensions of size 1 around, or that moves nothing, ends up with at most
+// one dimension.
+void CoalesceDimensions(const TfLiteIntArray* input_dims, const int32_t* perm,
+                        OpData* data) {
+  const int dims_count = input_dims->size;
+
+  // Drop the dimensions of size 1, which don't affect the memory layout.
+  int new_index[5];
+  int32_t squeezed_dims[5];
+  int squeezed_count = 0;
+  for (int i = 0; i < dims_count; ++i) {
+    new_index[i] = squeezed_count;
+    if (input_dims->data[i] != 1) {
+      squeezed_dims[squeezed_count++] = input_dims->data[i];
+    }
+  }
+  int squeezed_perm[5];
+  int squeezed_perm_count = 0;
+  for (int i = 0; i < dims_count; ++i) {
+    if (input_dims->data[perm[i]] != 1) {
+      squeezed_perm[squeezed_perm_count++] = new_index[perm[i]];
+    }
+  }
+
+  // Output dimensions that read consecutive input dimensions are contiguous in
+  // both tensors and can be moved as one. Records the first input dimension
+  // of each merged group, in output order.
+  int group_start[5];
+  int group_end[5];
+  int group_count = 0;
+  for (int i = 0; i < squeezed_perm_count; ++i) {
+    if (group_count > 0 && squeezed_perm[i] == group_end[group_count - 1] + 1) {
+      group_end[group_count - 1] = squeezed_perm[i];
+    } else {
+      group_start[group_count] = squeezed_perm[i];
+      group_end[group_count] = squeezed_perm[i];
+      ++group_count;
+    }
+  }
+
+  // The groups appear in the input in the order of their first dimension.
+  data->params.perm_count = group_count;
+  for (int i = 0; i < group_count; ++i) {
+    int rank = 0;
+    for (int j = 0; j < group_count; ++j) {
+      if (group_start[j] < group_start[i]) {
+        ++rank;
+      }
+    }
+    int32_t size = 1;
+    for (int d = group_start[i]; d <= group_end[i]; ++d) {
+      size *= squeezed_dims[d];
+    }
+    data->params.perm[i] = rank;
+    data->input_dims[rank] = size;
+  }
+}
+
+// Transposes `batches` row-major matrices of `rows` x `cols` elements, walking
+// them in square tiles so that both the reads and the writes stay within a
+// few cache lines.
+template <typename T>
+void BlockedTranspose2D(int batches, int rows, int cols, const T* input_data,
+                        T* output_data) {
+  for (int b = 0; b < batches; ++b) {
+    for (int r0 = 0; r0 < rows; r0 += kTransposeBlockSize) {
+      const int r_end = std::min(r0 + kTransposeBlockSize, rows);
+      for (int c0 = 0; c0 < cols; c0 += kTransposeBlockSize) {
+        const int c_end = std::min(c0 + kTransposeBlockSize, cols);
+        for (int r = r0; r < r_end; ++r) {
+          const T* input_row = input_data + r * cols;
+          for (int c = c0; c < c_end; ++c) {
+            output_data[c * rows + r] = input_row[c];
+          }
+        }
+      }
+    }
+    input_data += rows * cols;
+    output_data += rows * cols;
+  }
+}
+
+template <typename T>
+void TransposeCoalesced(const OpData& data, const TfLiteEvalTensor* input,
+                        TfLiteEvalTensor* output) {
+  const T* input_data = tflite::micro::GetTensorData<T>(input);
+  T* output_data = tflite::micro::GetTensorData<T>(output);
+  const TransposeParams& params = data.params;
+  const int32_t* dims = data.input_dims;
+
+  if (params.perm_count <= 1) {
+    // Nothing moves, the output is a copy of the input.
+    if (input_data != output_data) {
+      const int flat_size = ElementCount(*input->dims);
+      std::memcpy(output_data, input_data, flat_size * sizeof(T));
+    }
+  } else if (params.perm_count == 2) {
+    // perm is {1, 0}, the identity was handled above.
+    BlockedTranspose2D(1, dims[0], dims[1], input_data, output_data);
+  } else if (params.perm_count == 3 && params.perm[0] == 0) {
+    // perm is {0, 2, 1}: a batch of 2D transposes.
+    BlockedTranspose2D(dims[0], dims[1], dims[2], input_data, output_data);
+  } else {
+    int32_t output_dims[5];
+    for (int i = 0; i < params.perm_count; ++i) {
+      output_dims[i] = dims[params.perm[i]];
+    }
+    reference_ops::Transpose(params, RuntimeShape(params.perm_count, dims),
+                             input_data,
+                             RuntimeShape(params.perm_count, output_dims),
+                             output_data);
+  }
+}
+
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TF_LITE_ENSURE_EQ(context, NumInputs(node), 2);
   TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
@@ -56,41 +193,35 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                        "Transpose op permutations array is out of bounds.");
   }
 
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  CoalesceDimensions(op_context.input->dims, perm_data, data);
+
   return kTfLiteOk;
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
-  TransposeContext op_context(context, node);
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
 
-  const int32_t* perm_data = GetTensorData<int32_t>(op_context.perm);
-  const int size = op_context.perm->dims->data[0];
-  TransposeParams params;
-  params.perm_count = size;
-  for (int i = 0; i < size; ++i) {
-    params.perm[i] = perm_data[i];
-  }
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *static_cast<const OpData*>(node->user_data);
 
   // Transpose kernel only does rearranging values not numeric evaluations
   // on each cell. It's safe to implement per size of scalar type and this
   // trick keeps the total code size in a reasonable range.
-  switch (op_context.input->type) {
+  switch (input->type) {
     case kTfLiteFloat32:
-      reference_ops::Transpose(params, GetTensorShape(op_context.input),
-                               GetTensorData<float>(op_context.input),
-                               GetTensorShape(op_context.output),
-                               GetTensorData<float>(op_context.output));
+      TransposeCoalesced<int32_t>(data, input, output);
       break;
     case kTfLiteInt8:
-      reference_ops::Transpose(params, GetTensorShape(op_context.input),
-                               GetTensorData<int8_t>(op_context.input),
-                               GetTensorShape(op_context.output),
-                               GetTensorData<int8_t>(op_context.output));
+      TransposeCoalesced<int8_t>(data, input, output);
       break;
     default:
       TF_LITE_KERNEL_LOG(context,
                          "Type %s is currently not supported by Transpose. "
                          "Only float32 and int8 is supported",
-                         TfLiteTypeGetName(op_context.input->type));
+                         TfLiteTypeGetName(input->type));
       return kTfLiteError;
   }
 
@@ -100,7 +231,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 }  // namespace
 
 TfLiteRegistration Register_TRANSPOSE() {
-  return {/*init=*/nullptr,
+  return {/*init=*/Init,
           /*free=*/nullptr,
           /*prepare=*/Prepare,
           /*invoke=*/Eval,
@@ -153,13 +153,9 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   int output_height = output->dims->data[1];
 
   // Dynamically allocate per-channel quantization parameters.
-  const int num_channels = filter->dims->data[kConvQuantizedDimension];
-  data->per_channel_output_multiplier =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
-  data->per_channel_output_shift =
-      static_cast<int32_t*>(context->AllocatePersistentBuffer(
-          context, num_channels * sizeof(int32_t)));
+  TF_LITE_ENSURE_STATUS(micro::AllocatePerChannelQuantizationParams(
+      context, input->type, filter->dims->data[kConvQuantizedDimension],
+      &data->per_channel_output_multiplier, &data->per_channel_output_shift));
 
   // Quantized kernels use an int32 scratch buffer.
   if (input->type == kTfLiteInt8) {
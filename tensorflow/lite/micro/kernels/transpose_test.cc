@@ -611,4 +611,76 @@ TF_LITE_MICRO_TEST(Complex5DTestWithReorder) {
                                  expected_output_data, output_data, &params);
 }
 
+TF_LITE_MICRO_TEST(2DBlockedWithLeftOvers) {
+  float input_data[19 * 37];
+  float expected_output_data[19 * 37];
+  int32_t shape[] = {19, 37};
+  int32_t perms[] = {1, 0};
+  tflite::testing::RunTestPermutation(2, shape, perms, input_data,
+                                      expected_output_data);
+  int input_dims_data[] = {2, 19, 37};
+  int output_dims_data[] = {2, 37, 19};
+
+  float output_data[19 * 37];
+
+  tflite::TransposeParams params = {2, {1, 0}};
+
+  tflite::testing::TestTranspose(input_dims_data, input_data, output_dims_data,
+                                 expected_output_data, output_data, &params);
+}
+
+TF_LITE_MICRO_TEST(Int8BatchedBlocked2D) {
+  int8_t input_data[3 * 9 * 13];
+  int8_t expected_output_data[3 * 9 * 13];
+  int32_t shape[] = {3, 9, 13};
+  int32_t perms[] = {0, 2, 1};
+  tflite::testing::RunTestPermutation(3, shape, perms, input_data,
+                                      expected_output_data);
+  int input_dims_data[] = {3, 3, 9, 13};
+  int output_dims_data[] = {3, 3, 13, 9};
+
+  int8_t output_data[3 * 9 * 13];
+
+  tflite::TransposeParams params = {3, {0, 2, 1}};
+
+  tflite::testing::TestTranspose(input_dims_data, input_data, output_dims_data,
+                                 expected_output_data, output_data, &params);
+}
+
+TF_LITE_MICRO_TEST(4DCoalescedInto2D) {
+  float input_data[120];
+  float expected_output_data[120];
+  int32_t shape[] = {2, 3, 4, 5};
+  int32_t perms[] = {2, 3, 0, 1};
+  tflite::testing::RunTestPermutation(4, shape, perms, input_data,
+                                      expected_output_data);
+  int input_dims_data[] = {4, 2, 3, 4, 5};
+  int output_dims_data[] = {4, 4, 5, 2, 3};
+
+  float output_data[120];
+
+  tflite::TransposeParams params = {4, {2, 3, 0, 1}};
+
+  tflite::testing::TestTranspose(input_dims_data, input_data, output_dims_data,
+                                 expected_output_data, output_data, &params);
+}
+
+TF_LITE_MICRO_TEST(IdentityAfterDroppingUnitDimensions) {
+  float input_data[12];
+  float expected_output_data[12];
+  int32_t shape[] = {1, 4, 1, 3};
+  int32_t perms[] = {2, 0, 1, 3};
+  tflite::testing::RunTestPermutation(4, shape, perms, input_data,
+                                      expected_output_data);
+  int input_dims_data[] = {4, 1, 4, 1, 3};
+  int output_dims_data[] = {4, 1, 1, 4, 3};
+
+  float output_data[12];
+
+  tflite::TransposeParams params = {4, {2, 0, 1, 3}};
+
+  tflite::testing::TestTranspose(input_dims_data, input_data, output_dims_data,
+                                 expected_output_data, output_data, &params);
+}
+
 TF_LITE_MICRO_TESTS_END
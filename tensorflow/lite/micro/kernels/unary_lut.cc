@@ -0,0 +1,64 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/unary_lut.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/cppmath.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+
+namespace tflite {
+
+int8_t* CreateInt8UnaryLutFromFloat(TfLiteContext* context,
+                                    const TfLiteTensor* input,
+                                    const TfLiteTensor* output,
+                                    float (*transform)(float)) {
+  const float input_scale = input->params.scale;
+  const int32_t input_zero_point = input->params.zero_point;
+  const float inverse_scale = 1 / output->params.scale;
+  const int32_t output_zero_point = output->params.zero_point;
+  return CreateInt8UnaryLut(
+      context, [&](const int8_t* input_data, int8_t* output_data, int size) {
+        const int32_t maxval = std::numeric_limits<int8_t>::max();
+        const int32_t minval = std::numeric_limits<int8_t>::min();
+        for (int i = 0; i < size; ++i) {
+          const float dequantized =
+              input_scale * (input_data[i] - input_zero_point);
+          const float transformed = transform(dequantized);
+          const float rescaled = TfLiteRound(transformed * inverse_scale);
+          const int32_t quantized =
+              static_cast<int32_t>(rescaled + output_zero_point);
+          output_data[i] = static_cast<int8_t>(
+              std::max(std::min(maxval, quantized), minval));
+        }
+      });
+}
+
+void EvalInt8UnaryLut(const int8_t* lut, const TfLiteEvalTensor* input,
+                      TfLiteEvalTensor* output) {
+  const int size = MatchingFlatSize(tflite::micro::GetTensorShape(input),
+                                    tflite::micro::GetTensorShape(output));
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  for (int i = 0; i < size; ++i) {
+    output_data[i] = lut[static_cast<uint8_t>(input_data[i])];
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,66 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_UNARY_LUT_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_UNARY_LUT_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+// Number of entries in a lookup table that covers every int8 value. Entries
+// are indexed by the input value reinterpreted as uint8.
+constexpr int kInt8UnaryLutSize = 256;
+
+// Allocates a lookup table from the persistent arena and fills it by calling
+// `eval(const int8_t* input, int8_t* output, int size)` once over all of the
+// int8 values. `eval` is expected to be the element-wise reference kernel of
+// the op, so that looking up values in the table is bit-exact with running
+// the kernel itself. Must be called from Init or Prepare. Returns nullptr if
+// the table could not be allocated.
+template <typename EvalFunc>
+int8_t* CreateInt8UnaryLut(TfLiteContext* context, EvalFunc eval) {
+  int8_t* lut = static_cast<int8_t*>(
+      context->AllocatePersistentBuffer(context, kInt8UnaryLutSize));
+  if (lut == nullptr) {
+    return nullptr;
+  }
+  int8_t values[kInt8UnaryLutSize];
+  for (int i = 0; i < kInt8UnaryLutSize; ++i) {
+    values[i] = static_cast<int8_t>(i);
+  }
+  eval(values, lut, kInt8UnaryLutSize);
+  return lut;
+}
+
+// Allocates a lookup table from the persistent arena and fills it by
+// dequantizing every int8 value with the params of `input`, applying
+// `transform` and quantizing the result with the params of `output`. Returns
+// nullptr if the table could not be allocated.
+int8_t* CreateInt8UnaryLutFromFloat(TfLiteContext* context,
+                                    const TfLiteTensor* input,
+                                    const TfLiteTensor* output,
+                                    float (*transform)(float));
+
+// Maps every element of `input` through `lut` into `output`. `input` and
+// `output` may share the same buffer.
+void EvalInt8UnaryLut(const int8_t* lut, const TfLiteEvalTensor* input,
+                      TfLiteEvalTensor* output);
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_UNARY_LUT_H_
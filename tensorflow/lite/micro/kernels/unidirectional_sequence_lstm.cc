@@ -0,0 +1,609 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/portable_tensor_utils_impl.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+
+namespace tflite {
+namespace ops {
+namespace micro {
+namespace unidirectional_sequence_lstm {
+namespace {
+
+// The gates in the order of their weights, biases and intermediates.
+enum Gate {
+  kInputGate = 0,
+  kForgetGate,
+  kCellGate,
+  kOutputGate,
+  kNumGates,
+};
+
+constexpr int kInputTensor = 0;
+// Weights of size {n_cell, n_input}. The input gate ones are optional (CIFG).
+constexpr int kInputWeightsTensors[kNumGates] = {1, 2, 3, 4};
+// Weights of size {n_cell, n_output}. The input gate ones are optional (CIFG).
+constexpr int kRecurrentWeightsTensors[kNumGates] = {5, 6, 7, 8};
+// Optional peephole weights of size {n_cell}. The cell gate has none.
+constexpr int kCellWeightsTensors[kNumGates] = {9, 10, -1, 11};
+// Biases of size {n_cell}. The input gate one is optional (CIFG).
+constexpr int kGateBiasTensors[kNumGates] = {12, 13, 14, 15};
+constexpr int kProjectionWeightsTensor = 16;  // Optional {n_output, n_cell}
+constexpr int kProjectionBiasTensor = 17;     // Optional {n_output}
+// Variable tensors updated by each invocation.
+constexpr int kOutputStateTensor = 18;
+constexpr int kCellStateTensor = 19;
+// Optional layer norm coefficients of size {n_cell}, only present in the 24
+// input variant.
+constexpr int kLayerNormTensors[kNumGates] = {20, 21, 22, 23};
+
+constexpr int kOutputTensor = 0;
+
+// The intermediates hold the quantization of each gate ahead of its
+// activation, followed by the quantization of the hidden state.
+constexpr int kHiddenIntermediate = kNumGates;
+constexpr int kNumIntermediates = kNumGates + 1;
+
+// Gates are kept in Q3.12 when there is no layer norm to rescale them.
+constexpr int kGateIntegerBits = 3;
+
+struct OpData {
+  // Requantize the input and recurrent products, the peephole products and
+  // the layer norm of each gate into the gate's int16 quantization.
+  int32_t input_multiplier[kNumGates];
+  int32_t input_shift[kNumGates];
+  int32_t recurrent_multiplier[kNumGates];
+  int32_t recurrent_shift[kNumGates];
+  int32_t cell_multiplier[kNumGates];
+  int cell_shift[kNumGates];
+  int32_t layer_norm_multiplier[kNumGates];
+  int layer_norm_shift[kNumGates];
+  int32_t layer_norm_variance_guard[kNumGates];
+
+  int32_t hidden_multiplier;
+  int hidden_shift;
+  int32_t hidden_zero_point;
+  int32_t projection_multiplier;
+  int projection_shift;
+  int32_t output_state_zero_point;
+  // The cell state scale is 2^cell_scale.
+  int cell_scale;
+  // Zero disables clipping.
+  int16_t quantized_cell_clip;
+  int8_t quantized_proj_clip;
+
+  bool use_cifg;
+  bool use_peephole;
+  bool use_layer_norm;
+  bool use_projection;
+
+  // n_cell biases per gate with the zero point of the input or the output
+  // state folded in, so the matmuls can run on the raw int8 values. The gate
+  // biases are folded into the input part unless layer norm applies them
+  // after normalizing.
+  int32_t* input_effective_bias;
+  int32_t* recurrent_effective_bias;
+  // n_output biases with the hidden zero point folded in.
+  int32_t* projection_effective_bias;
+
+  // Holds the int16 outputs of all gates, n_batch * n_cell values each.
+  int gate_scratch_index;
+  // Holds the int8 hidden state ahead of the projection, if any.
+  int hidden_scratch_index;
+};
+
+// The constant data the gates of a step read.
+struct GateWeights {
+  const int8_t* input[kNumGates];
+  const int8_t* recurrent[kNumGates];
+  const int16_t* cell[kNumGates];
+  const int16_t* layer_norm[kNumGates];
+  const int32_t* bias[kNumGates];
+  const int8_t* projection;
+};
+
+// Sets `output` to `bias`, or zero without one, plus `zero_point` times the
+// sum of each row of `weights`.
+void PrecomputeEffectiveBias(int32_t zero_point, const TfLiteTensor* weights,
+                             const TfLiteTensor* bias, int32_t* output) {
+  const int rows = weights->dims->data[0];
+  const int cols = weights->dims->data[1];
+  if (bias == nullptr) {
+    std::memset(output, 0, rows * sizeof(int32_t));
+  } else {
+    std::memcpy(output, GetTensorData<int32_t>(bias), rows * sizeof(int32_t));
+  }
+  if (zero_point != 0) {
+    tensor_utils::PortableMatrixScalarMultiplyAccumulate(
+        GetTensorData<int8_t>(weights), zero_point, rows, cols, output);
+  }
+}
+
+TfLiteStatus CheckTensor(TfLiteContext* context, const TfLiteTensor* tensor,
+                         TfLiteType type, int dim0, int dim1 = -1) {
+  TF_LITE_ENSURE(context, tensor != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, tensor->type, type);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(tensor), dim1 < 0 ? 1 : 2);
+  TF_LITE_ENSURE_EQ(context, tensor->dims->data[0], dim0);
+  if (dim1 >= 0) {
+    TF_LITE_ENSURE_EQ(context, tensor->dims->data[1], dim1);
+  }
+  return kTfLiteOk;
+}
+
+// Computes the input and recurrent products of all gates with one fused
+// matmul each, so the input and output state are streamed once for all gates
+// rather than once per gate.
+void CalculateGateProducts(const OpData& data, const GateWeights& weights,
+                           const int8_t* input, const int8_t* output_state,
+                           int n_batch, int n_cell, int n_input, int n_output,
+                           int16_t* gates) {
+  const int first_gate = data.use_cifg ? kForgetGate : kInputGate;
+  const int n_gates = kNumGates - first_gate;
+  const int gate_size = n_batch * n_cell;
+  const int32_t* input_biases[kNumGates];
+  const int32_t* recurrent_biases[kNumGates];
+  int16_t* gate_outputs[kNumGates];
+  for (int gate = first_gate; gate < kNumGates; ++gate) {
+    input_biases[gate] = data.input_effective_bias + gate * n_cell;
+    recurrent_biases[gate] = data.recurrent_effective_bias + gate * n_cell;
+    gate_outputs[gate] = gates + gate * gate_size;
+  }
+
+  std::memset(gate_outputs[first_gate], 0,
+              n_gates * gate_size * sizeof(int16_t));
+  tensor_utils::PortableMultiMatrixBatchVectorMultiplyAccumulate(
+      input, n_gates, weights.input + first_gate, input_biases + first_gate,
+      data.input_multiplier + first_gate, data.input_shift + first_gate,
+      n_batch, n_input, n_cell, /*output_zp=*/0, gate_outputs + first_gate);
+  tensor_utils::PortableMultiMatrixBatchVectorMultiplyAccumulate(
+      output_state, n_gates, weights.recurrent + first_gate,
+      recurrent_biases + first_gate, data.recurrent_multiplier + first_gate,
+      data.recurrent_shift + first_gate, n_batch, n_output, n_cell,
+      /*output_zp=*/0, gate_outputs + first_gate);
+}
+
+// Adds the peephole product, applies layer norm and the activation to the
+// products of a gate.
+void FinishGate(const OpData& data, const GateWeights& weights, int gate,
+                const int16_t* cell_state, int n_batch, int n_cell,
+                int16_t* gate_values) {
+  if (data.use_peephole && gate != kCellGate) {
+    tensor_utils::PortableVectorBatchVectorCwiseProductAccumulate(
+        weights.cell[gate], n_cell, cell_state, n_batch,
+        data.cell_multiplier[gate], data.cell_shift[gate], gate_values);
+  }
+  if (data.use_layer_norm) {
+    tensor_utils::PortableApplyLayerNorm(
+        gate_values, weights.layer_norm[gate], weights.bias[gate],
+        data.layer_norm_multiplier[gate], data.layer_norm_shift[gate],
+        data.layer_norm_variance_guard[gate], n_batch, n_cell, gate_values);
+  }
+  if (gate == kCellGate) {
+    tensor_utils::PortableApplyTanh(kGateIntegerBits, gate_values, n_batch,
+                                    n_cell, gate_values);
+  } else {
+    tensor_utils::PortableApplySigmoid(gate_values, n_batch, n_cell,
+                                       gate_values);
+  }
+}
+
+// Runs one time step for `n_batch` consecutive batches, updating the output
+// and cell state in place and copying the new output state to `output`.
+void EvalStep(const OpData& data, const GateWeights& weights,
+              const int8_t* input, int n_batch, int n_cell, int n_input,
+              int n_output, int8_t* output_state, int16_t* cell_state,
+              int8_t* output, int16_t* gates, int8_t* hidden) {
+  const int gate_size = n_batch * n_cell;
+  int16_t* input_gate = gates + kInputGate * gate_size;
+  int16_t* forget_gate = gates + kForgetGate * gate_size;
+  int16_t* cell_gate = gates + kCellGate * gate_size;
+  int16_t* output_gate = gates + kOutputGate * gate_size;
+
+  CalculateGateProducts(data, weights, input, output_state, n_batch, n_cell,
+                        n_input, n_output, gates);
+  if (!data.use_cifg) {
+    FinishGate(data, weights, kInputGate, cell_state, n_batch, n_cell,
+               input_gate);
+  }
+  FinishGate(data, weights, kForgetGate, cell_state, n_batch, n_cell,
+             forget_gate);
+  FinishGate(data, weights, kCellGate, cell_state, n_batch, n_cell, cell_gate);
+
+  // cell_state = forget_gate * cell_state + input_gate * cell_gate, where the
+  // forget gate is reused as scratch once it has been applied.
+  tensor_utils::PortableCwiseMul(forget_gate, cell_state, n_batch, n_cell, 15,
+                                 cell_state);
+  if (data.use_cifg) {
+    tensor_utils::PortableSub1Vector(forget_gate, gate_size, forget_gate);
+    tensor_utils::PortableCwiseMul(forget_gate, cell_gate, n_batch, n_cell,
+                                   30 + data.cell_scale, forget_gate);
+  } else {
+    tensor_utils::PortableCwiseMul(input_gate, cell_gate, n_batch, n_cell,
+                                   30 + data.cell_scale, forget_gate);
+  }
+  tensor_utils::PortableCwiseAdd(cell_state, forget_gate, n_batch, n_cell,
+                                 cell_state);
+  if (data.quantized_cell_clip > 0) {
+    tensor_utils::PortableCwiseClipping(cell_state, gate_size,
+                                        data.quantized_cell_clip);
+  }
+
+  // The output gate peeks at the updated cell state.
+  FinishGate(data, weights, kOutputGate, cell_state, n_batch, n_cell,
+             output_gate);
+
+  // hidden = output_gate * tanh(cell_state), reusing the input gate as
+  // scratch. Without projection the hidden state is the output state. The
+  // zero point is negated as PortableCwiseMul subtracts it.
+  tensor_utils::PortableApplyTanh(15 + data.cell_scale, cell_state, n_batch,
+                                  n_cell, input_gate);
+  int8_t* hidden_state = data.use_projection ? hidden : output_state;
+  tensor_utils::PortableCwiseMul(output_gate, input_gate,
+                                 data.hidden_multiplier, data.hidden_shift,
+                                 n_batch, n_cell, -data.hidden_zero_point,
+                                 hidden_state);
+  if (data.use_projection) {
+    std::memset(output_state, 0, n_batch * n_output);
+    tensor_utils::PortableMatrixBatchVectorMultiplyAccumulate(
+        hidden, data.projection_effective_bias, weights.projection,
+        data.projection_multiplier, data.projection_shift, n_batch, n_cell,
+        n_output, data.output_state_zero_point, /*scratch=*/nullptr,
+        output_state, /*context=*/nullptr);
+    if (data.quantized_proj_clip > 0) {
+      tensor_utils::PortableCwiseClipping(output_state, n_batch * n_output,
+                                          data.quantized_proj_clip);
+    }
+  }
+  std::memcpy(output, output_state, n_batch * n_output);
+}
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(OpData));
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+  const auto* params =
+      static_cast<const TfLiteUnidirectionalSequenceLSTMParams*>(
+          node->builtin_data);
+
+  // The deprecated 20 input variant has no layer norm coefficients.
+  TF_LITE_ENSURE(context, NumInputs(node) == 20 || NumInputs(node) == 24);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+
+  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  // Only the 8x8_16 quantization is supported. The 16x8 one, with int16
+  // activations, is not.
+  if (input->type != kTfLiteInt8) {
+    MicroPrintf(
+        "UNIDIRECTIONAL_SEQUENCE_LSTM only supports int8 activations with an "
+        "int16 cell state (8x8_16 quantization), got %s.",
+        TfLiteTypeGetName(input->type));
+    return kTfLiteError;
+  }
+  TF_LITE_ENSURE_EQ(context, NumDimensions(input), 3);
+  const int n_batch =
+      params->time_major ? input->dims->data[1] : input->dims->data[0];
+  const int n_input = input->dims->data[2];
+
+  const TfLiteTensor* output_gate_weights =
+      GetInput(context, node, kRecurrentWeightsTensors[kOutputGate]);
+  TF_LITE_ENSURE(context, output_gate_weights != nullptr);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(output_gate_weights), 2);
+  const int n_cell = output_gate_weights->dims->data[0];
+  const int n_output = output_gate_weights->dims->data[1];
+
+  const TfLiteTensor* output_state =
+      GetInput(context, node, kOutputStateTensor);
+  TF_LITE_ENSURE(context, output_state != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, output_state->type, kTfLiteInt8);
+  TF_LITE_ENSURE(context, output_state->is_variable);
+  TF_LITE_ENSURE_EQ(context, NumElements(output_state), n_batch * n_output);
+  const TfLiteTensor* cell_state = GetInput(context, node, kCellStateTensor);
+  TF_LITE_ENSURE(context, cell_state != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, cell_state->type, kTfLiteInt16);
+  TF_LITE_ENSURE(context, cell_state->is_variable);
+  TF_LITE_ENSURE_EQ(context, NumElements(cell_state), n_batch * n_cell);
+
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(output), 3);
+  TF_LITE_ENSURE_EQ(context, output->dims->data[0], input->dims->data[0]);
+  TF_LITE_ENSURE_EQ(context, output->dims->data[1], input->dims->data[1]);
+  TF_LITE_ENSURE_EQ(context, output->dims->data[2], n_output);
+
+  // Integer LSTMs carry the quantization of their gates and hidden state in
+  // intermediate tensors.
+  TF_LITE_ENSURE(context, node->intermediates != nullptr);
+  TF_LITE_ENSURE_EQ(context, node->intermediates->size, kNumIntermediates);
+
+  data->use_cifg =
+      GetOptionalInputTensor(context, node, kInputWeightsTensors[kInputGate]) ==
+      nullptr;
+  data->use_peephole = GetOptionalInputTensor(
+                           context, node, kCellWeightsTensors[kForgetGate]) !=
+                       nullptr;
+  data->use_layer_norm =
+      NumInputs(node) == 24 &&
+      GetOptionalInputTensor(context, node, kLayerNormTensors[kForgetGate]) !=
+          nullptr;
+  const TfLiteTensor* projection_weights =
+      GetOptionalInputTensor(context, node, kProjectionWeightsTensor);
+  data->use_projection = projection_weights != nullptr;
+  // Without projection the hidden state is written to the output state.
+  if (!data->use_projection) {
+    TF_LITE_ENSURE_EQ(context, n_output, n_cell);
+  }
+
+  TF_LITE_ENSURE(context, CheckedLog2(cell_state->params.scale,
+                                      &data->cell_scale));
+  // The tanh of the cell state supports at most 6 integer bits.
+  TF_LITE_ENSURE(context, data->cell_scale >= -15 && data->cell_scale <= -9);
+
+  TfLiteTensor* hidden =
+      context->GetTensor(context, node->intermediates->data[kHiddenIntermediate]);
+  TF_LITE_ENSURE(context, hidden != nullptr);
+  const float hidden_scale = hidden->params.scale;
+  data->hidden_zero_point = hidden->params.zero_point;
+  data->output_state_zero_point = output_state->params.zero_point;
+
+  data->input_effective_bias = static_cast<int32_t*>(
+      context->AllocatePersistentBuffer(
+          context, 2 * kNumGates * n_cell * sizeof(int32_t)));
+  TF_LITE_ENSURE(context, data->input_effective_bias != nullptr);
+  data->recurrent_effective_bias =
+      data->input_effective_bias + kNumGates * n_cell;
+
+  const float input_scale = input->params.scale;
+  const float output_state_scale = output_state->params.scale;
+  for (int gate = data->use_cifg ? kForgetGate : kInputGate; gate < kNumGates;
+       ++gate) {
+    const TfLiteTensor* input_weights =
+        GetInput(context, node, kInputWeightsTensors[gate]);
+    TF_LITE_ENSURE_OK(context, CheckTensor(context, input_weights, kTfLiteInt8,
+                                           n_cell, n_input));
+    const TfLiteTensor* recurrent_weights =
+        GetInput(context, node, kRecurrentWeightsTensors[gate]);
+    TF_LITE_ENSURE_OK(context, CheckTensor(context, recurrent_weights,
+                                           kTfLiteInt8, n_cell, n_output));
+    const TfLiteTensor* bias = GetInput(context, node, kGateBiasTensors[gate]);
+    TF_LITE_ENSURE_OK(context, CheckTensor(context, bias, kTfLiteInt32, n_cell));
+
+    float gate_scale = std::ldexp(1.0f, -15 + kGateIntegerBits);
+    if (data->use_layer_norm) {
+      const TfLiteTensor* layer_norm =
+          GetInput(context, node, kLayerNormTensors[gate]);
+      TF_LITE_ENSURE_OK(
+          context, CheckTensor(context, layer_norm, kTfLiteInt16, n_cell));
+      const float layer_norm_scale = layer_norm->params.scale;
+      QuantizeMultiplier(static_cast<double>(layer_norm_scale),
+                         &data->layer_norm_multiplier[gate],
+                         &data->layer_norm_shift[gate]);
+      // Keeps the variance computation of the layer norm from overflowing.
+      data->layer_norm_variance_guard[gate] = std::max(
+          static_cast<int32_t>(1),
+          static_cast<int32_t>(10000 * layer_norm_scale));
+      const TfLiteTensor* intermediate =
+          context->GetTensor(context, node->intermediates->data[gate]);
+      TF_LITE_ENSURE(context, intermediate != nullptr);
+      gate_scale = intermediate->params.scale;
+    }
+
+    int shift;
+    QuantizeMultiplier(static_cast<double>(input_weights->params.scale *
+                                           input_scale / gate_scale),
+                       &data->input_multiplier[gate], &shift);
+    data->input_shift[gate] = shift;
+    QuantizeMultiplier(static_cast<double>(recurrent_weights->params.scale *
+                                           output_state_scale / gate_scale),
+                       &data->recurrent_multiplier[gate], &shift);
+    data->recurrent_shift[gate] = shift;
+
+    if (data->use_peephole && gate != kCellGate) {
+      const TfLiteTensor* cell_weights =
+          GetInput(context, node, kCellWeightsTensors[gate]);
+      TF_LITE_ENSURE_OK(
+          context, CheckTensor(context, cell_weights, kTfLiteInt16, n_cell));
+      QuantizeMultiplier(
+          static_cast<double>(std::ldexp(1.0f, data->cell_scale) *
+                              cell_weights->params.scale / gate_scale),
+          &data->cell_multiplier[gate], &data->cell_shift[gate]);
+    }
+
+    PrecomputeEffectiveBias(-input->params.zero_point, input_weights,
+                            data->use_layer_norm ? nullptr : bias,
+                            data->input_effective_bias + gate * n_cell);
+    PrecomputeEffectiveBias(-data->output_state_zero_point, recurrent_weights,
+                            nullptr,
+                            data->recurrent_effective_bias + gate * n_cell);
+  }
+
+  // The hidden state is the product of two Q0.15 values.
+  QuantizeMultiplier(
+      static_cast<double>(std::ldexp(1.0f, -15) / hidden_scale *
+                          std::ldexp(1.0f, -15)),
+      &data->hidden_multiplier, &data->hidden_shift);
+
+  data->projection_effective_bias = nullptr;
+  if (data->use_projection) {
+    TF_LITE_ENSURE_OK(context, CheckTensor(context, projection_weights,
+                                           kTfLiteInt8, n_output, n_cell));
+    const TfLiteTensor* projection_bias =
+        GetOptionalInputTensor(context, node, kProjectionBiasTensor);
+    if (projection_bias != nullptr) {
+      TF_LITE_ENSURE_OK(context, CheckTensor(context, projection_bias,
+                                             kTfLiteInt32, n_output));
+    }
+    QuantizeMultiplier(static_cast<double>(projection_weights->params.scale *
+                                           hidden_scale / output_state_scale),
+                       &data->projection_multiplier, &data->projection_shift);
+    data->projection_effective_bias =
+        static_cast<int32_t*>(context->AllocatePersistentBuffer(
+            context, n_output * sizeof(int32_t)));
+    TF_LITE_ENSURE(context, data->projection_effective_bias != nullptr);
+    PrecomputeEffectiveBias(-data->hidden_zero_point, projection_weights,
+                            projection_bias, data->projection_effective_bias);
+  }
+
+  data->quantized_cell_clip = 0;
+  if (params->cell_clip > 0.0f) {
+    data->quantized_cell_clip = static_cast<int16_t>(
+        std::min(std::max(params->cell_clip / cell_state->params.scale,
+                          -32768.0f),
+                 32767.0f));
+  }
+  data->quantized_proj_clip = 0;
+  if (params->proj_clip > 0.0f) {
+    data->quantized_proj_clip = static_cast<int8_t>(std::min(
+        std::max(params->proj_clip / output_state_scale, -128.0f), 127.0f));
+  }
+
+  TFLITE_DCHECK(context->RequestScratchBufferInArena != nullptr);
+  TF_LITE_ENSURE_OK(context, context->RequestScratchBufferInArena(
+                                 context,
+                                 kNumGates * n_batch * n_cell * sizeof(int16_t),
+                                 &data->gate_scratch_index));
+  data->hidden_scratch_index = -1;
+  if (data->use_projection) {
+    TF_LITE_ENSURE_OK(context, context->RequestScratchBufferInArena(
+                                   context, n_batch * n_cell,
+                                   &data->hidden_scratch_index));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+  const OpData& data = *static_cast<const OpData*>(node->user_data);
+  const auto* params =
+      static_cast<const TfLiteUnidirectionalSequenceLSTMParams*>(
+          node->builtin_data);
+
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  TfLiteEvalTensor* output_state =
+      tflite::micro::GetMutableEvalInput(context, node, kOutputStateTensor);
+  TfLiteEvalTensor* cell_state =
+      tflite::micro::GetMutableEvalInput(context, node, kCellStateTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  GateWeights weights = {};
+  for (int gate = data.use_cifg ? kForgetGate : kInputGate; gate < kNumGates;
+       ++gate) {
+    weights.input[gate] = tflite::micro::GetTensorData<int8_t>(
+        tflite::micro::GetEvalInput(context, node, kInputWeightsTensors[gate]));
+    weights.recurrent[gate] =
+        tflite::micro::GetTensorData<int8_t>(tflite::micro::GetEvalInput(
+            context, node, kRecurrentWeightsTensors[gate]));
+    weights.bias[gate] = tflite::micro::GetTensorData<int32_t>(
+        tflite::micro::GetEvalInput(context, node, kGateBiasTensors[gate]));
+    if (data.use_peephole && gate != kCellGate) {
+      weights.cell[gate] =
+          tflite::micro::GetTensorData<int16_t>(tflite::micro::GetEvalInput(
+              context, node, kCellWeightsTensors[gate]));
+    }
+    if (data.use_layer_norm) {
+      weights.layer_norm[gate] = tflite::micro::GetTensorData<int16_t>(
+          tflite::micro::GetEvalInput(context, node, kLayerNormTensors[gate]));
+    }
+  }
+  if (data.use_projection) {
+    weights.projection = tflite::micro::GetTensorData<int8_t>(
+        tflite::micro::GetEvalInput(context, node, kProjectionWeightsTensor));
+  }
+
+  int16_t* gates = static_cast<int16_t*>(
+      context->GetScratchBuffer(context, data.gate_scratch_index));
+  TF_LITE_ENSURE(context, gates != nullptr);
+  int8_t* hidden = nullptr;
+  if (data.use_projection) {
+    hidden = static_cast<int8_t*>(
+        context->GetScratchBuffer(context, data.hidden_scratch_index));
+    TF_LITE_ENSURE(context, hidden != nullptr);
+  }
+
+  const int n_input = input->dims->data[2];
+  const int n_cell = cell_state->dims->data[cell_state->dims->size - 1];
+  const int n_output = output->dims->data[2];
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  int8_t* output_state_data = tflite::micro::GetTensorData<int8_t>(output_state);
+  int16_t* cell_state_data = tflite::micro::GetTensorData<int16_t>(cell_state);
+
+  if (params->time_major) {
+    // All batches advance together, one time step at a time.
+    const int max_time = input->dims->data[0];
+    const int n_batch = input->dims->data[1];
+    for (int t = 0; t < max_time; ++t) {
+      EvalStep(data, weights, input_data + t * n_batch * n_input, n_batch,
+               n_cell, n_input, n_output, output_state_data, cell_state_data,
+               output_data + t * n_batch * n_output, gates, hidden);
+    }
+  } else {
+    // Each batch runs its whole sequence on its own slice of the state.
+    const int n_batch = input->dims->data[0];
+    const int max_time = input->dims->data[1];
+    for (int b = 0; b < n_batch; ++b) {
+      for (int t = 0; t < max_time; ++t) {
+        const int time_offset = b * max_time + t;
+        EvalStep(data, weights, input_data + time_offset * n_input,
+                 /*n_batch=*/1, n_cell, n_input, n_output,
+                 output_state_data + b * n_output,
+                 cell_state_data + b * n_cell,
+                 output_data + time_offset * n_output, gates, hidden);
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+}  // namespace unidirectional_sequence_lstm
+
+TfLiteRegistration Register_UNIDIRECTIONAL_SEQUENCE_LSTM() {
+  return {/*init=*/unidirectional_sequence_lstm::Init,
+          /*free=*/nullptr,
+          /*prepare=*/unidirectional_sequence_lstm::Prepare,
+          /*invoke=*/unidirectional_sequence_lstm::Eval,
+          /*profiling_string=*/nullptr,
+          /*builtin_code=*/0,
+          /*custom_name=*/nullptr,
+          /*version=*/0};
+}
+
+}  // namespace micro
+}  // namespace ops
+}  // namespace tflite
@@ -0,0 +1,520 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/kernels/kernel_runner.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace tflite {
+namespace testing {
+namespace {
+
+constexpr int kNumGates = 4;
+constexpr int kInputGate = 0;
+constexpr int kForgetGate = 1;
+constexpr int kCellGate = 2;
+constexpr int kOutputGate = 3;
+
+constexpr int kNumInputs = 24;
+constexpr int kOutputIndex = kNumInputs;
+constexpr int kIntermediatesIndex = kNumInputs + 1;
+constexpr int kNumTensors = kIntermediatesIndex + kNumGates + 1;
+
+constexpr int kMaxBatch = 2;
+constexpr int kMaxTime = 3;
+constexpr int kMaxSize = 4;
+constexpr int kMaxSequence = kMaxBatch * kMaxTime * kMaxSize;
+constexpr int kMaxMatrix = kMaxSize * kMaxSize;
+
+constexpr float kInputScale = 1.0f / 64;
+constexpr int kInputZeroPoint = 3;
+constexpr float kWeightsScale = 1.0f / 128;
+constexpr float kOutputScale = 1.0f / 128;
+constexpr int kOutputZeroPoint = -2;
+constexpr float kHiddenScale = 1.0f / 128;
+constexpr float kCellScale = 1.0f / 2048;
+constexpr float kInt16WeightsScale = 1.0f / 4096;
+constexpr float kLayerNormIntermediateScale = 1.0f / 1024;
+
+struct LstmConfig {
+  int n_batch;
+  int max_time;
+  int n_input;
+  int n_cell;
+  int n_output;
+  bool time_major;
+  bool use_cifg;
+  bool use_peephole;
+  bool use_layer_norm;
+  bool use_projection;
+  float cell_clip;
+  float proj_clip;
+};
+
+// Quantized buffers and tensors of one LSTM node.
+struct LstmModel {
+  int8_t input[kMaxSequence];
+  int8_t input_weights[kNumGates][kMaxMatrix];
+  int8_t recurrent_weights[kNumGates][kMaxMatrix];
+  int16_t cell_weights[kNumGates][kMaxSize];
+  int32_t bias[kNumGates][kMaxSize];
+  int8_t projection_weights[kMaxMatrix];
+  int32_t projection_bias[kMaxSize];
+  int8_t output_state[kMaxBatch * kMaxSize];
+  int16_t cell_state[kMaxBatch * kMaxSize];
+  int16_t layer_norm_weights[kNumGates][kMaxSize];
+  int8_t output[kMaxSequence];
+  int16_t gate_intermediates[kNumGates];
+  int8_t hidden_intermediate;
+
+  int input_dims[4];
+  int output_dims[4];
+  int matrix_dims[2][3];
+  int projection_dims[3];
+  int cell_dims[2];
+  int output_vector_dims[2];
+  int output_state_dims[3];
+  int cell_state_dims[3];
+  int scalar_dims[1];
+
+  int inputs[kNumInputs + 1];
+  int outputs[2];
+  int intermediates[kNumGates + 2];
+  TfLiteTensor tensors[kNumTensors];
+};
+
+// Deterministic values in [-range, range].
+float Value(int i, int seed, float range) {
+  return range * static_cast<float>((i * 37 + seed * 11) % 41 - 20) / 20.0f;
+}
+
+void MakeWeights(int size, int seed, float* values) {
+  for (int i = 0; i < size; ++i) {
+    values[i] = Value(i, seed, 0.5f);
+  }
+}
+
+float Dequantize(const TfLiteTensor& tensor, int i) {
+  switch (tensor.type) {
+    case kTfLiteInt8:
+      return tensor.params.scale *
+             (tensor.data.int8[i] - tensor.params.zero_point);
+    case kTfLiteInt16:
+      return tensor.params.scale *
+             (tensor.data.i16[i] - tensor.params.zero_point);
+    case kTfLiteInt32:
+      return tensor.params.scale * tensor.data.i32[i];
+    default:
+      return 0.0f;
+  }
+}
+
+float Sigmoid(float x) { return 1.0f / (1.0f + std::exp(-x)); }
+
+void BuildModel(const LstmConfig& config, LstmModel* model) {
+  const int n_batch = config.n_batch;
+  const int max_time = config.max_time;
+  const int n_input = config.n_input;
+  const int n_cell = config.n_cell;
+  const int n_output = config.n_output;
+  TfLiteTensor* tensors = model->tensors;
+  float values[kMaxSequence];
+
+  // Each slot holds a dummy tensor unless its input is used.
+  model->scalar_dims[0] = 0;
+  for (int i = 0; i < kNumTensors; ++i) {
+    tensors[i] =
+        CreateTensor(model->output, IntArrayFromInts(model->scalar_dims));
+  }
+
+  model->input_dims[0] = 3;
+  model->input_dims[1] = config.time_major ? max_time : n_batch;
+  model->input_dims[2] = config.time_major ? n_batch : max_time;
+  model->input_dims[3] = n_input;
+  for (int i = 0; i < n_batch * max_time * n_input; ++i) {
+    values[i] = Value(i, 1, 1.0f);
+  }
+  tensors[0] = CreateQuantizedTensor(values, model->input,
+                                     IntArrayFromInts(model->input_dims),
+                                     kInputScale, kInputZeroPoint);
+
+  model->matrix_dims[0][0] = 2;
+  model->matrix_dims[0][1] = n_cell;
+  model->matrix_dims[0][2] = n_input;
+  model->matrix_dims[1][0] = 2;
+  model->matrix_dims[1][1] = n_cell;
+  model->matrix_dims[1][2] = n_output;
+  model->cell_dims[0] = 1;
+  model->cell_dims[1] = n_cell;
+  const float gate_bias_input_scale =
+      config.use_layer_norm ? kInt16WeightsScale : kInputScale;
+  const float gate_bias_weights_scale =
+      config.use_layer_norm ? 1.0f / 1024 : kWeightsScale;
+  for (int gate = 0; gate < kNumGates; ++gate) {
+    if (config.use_cifg && gate == kInputGate) {
+      continue;
+    }
+    MakeWeights(n_cell * n_input, 2 + gate, values);
+    tensors[1 + gate] = CreateQuantizedTensor(
+        values, model->input_weights[gate],
+        IntArrayFromInts(model->matrix_dims[0]), kWeightsScale, 0);
+    MakeWeights(n_cell * n_output, 6 + gate, values);
+    tensors[5 + gate] = CreateQuantizedTensor(
+        values, model->recurrent_weights[gate],
+        IntArrayFromInts(model->matrix_dims[1]), kWeightsScale, 0);
+    for (int i = 0; i < n_cell; ++i) {
+      values[i] = Value(i, 10 + gate, 0.25f);
+    }
+    tensors[12 + gate] = CreateQuantizedBiasTensor(
+        values, model->bias[gate], IntArrayFromInts(model->cell_dims),
+        gate_bias_input_scale, gate_bias_weights_scale);
+    if (config.use_peephole && gate != kCellGate) {
+      for (int i = 0; i < n_cell; ++i) {
+        values[i] = Value(i, 14 + gate, 0.5f);
+      }
+      tensors[gate == kOutputGate ? 11 : 9 + gate] = CreateQuantizedTensor(
+          values, model->cell_weights[gate], IntArrayFromInts(model->cell_dims),
+          kInt16WeightsScale, 0);
+    }
+    if (config.use_layer_norm) {
+      for (int i = 0; i < n_cell; ++i) {
+        values[i] = 1.0f + Value(i, 18 + gate, 0.5f);
+      }
+      tensors[20 + gate] = CreateQuantizedTensor(
+          values, model->layer_norm_weights[gate],
+          IntArrayFromInts(model->cell_dims), kInt16WeightsScale, 0);
+    }
+    tensors[kIntermediatesIndex + gate] = CreateQuantizedTensor(
+        &model->gate_intermediates[gate], IntArrayFromInts(model->scalar_dims),
+        config.use_layer_norm ? kLayerNormIntermediateScale : 1.0f / 4096, 0);
+  }
+
+  // Without projection the hidden state is the output state.
+  const float hidden_scale =
+      config.use_projection ? kHiddenScale : kOutputScale;
+  const int hidden_zero_point = config.use_projection ? 0 : kOutputZeroPoint;
+  tensors[kIntermediatesIndex + kNumGates] = CreateQuantizedTensor(
+      &model->hidden_intermediate, IntArrayFromInts(model->scalar_dims),
+      hidden_scale, hidden_zero_point);
+
+  if (config.use_projection) {
+    model->projection_dims[0] = 2;
+    model->projection_dims[1] = n_output;
+    model->projection_dims[2] = n_cell;
+    MakeWeights(n_output * n_cell, 22, values);
+    tensors[16] = CreateQuantizedTensor(
+        values, model->projection_weights,
+        IntArrayFromInts(model->projection_dims), kWeightsScale, 0);
+    model->output_vector_dims[0] = 1;
+    model->output_vector_dims[1] = n_output;
+    for (int i = 0; i < n_output; ++i) {
+      values[i] = Value(i, 23, 0.25f);
+    }
+    tensors[17] = CreateQuantizedBiasTensor(
+        values, model->projection_bias,
+        IntArrayFromInts(model->output_vector_dims), hidden_scale,
+        kWeightsScale);
+  }
+
+  model->output_state_dims[0] = 2;
+  model->output_state_dims[1] = n_batch;
+  model->output_state_dims[2] = n_output;
+  for (int i = 0; i < n_batch * n_output; ++i) {
+    model->output_state[i] = kOutputZeroPoint;
+  }
+  tensors[18] = CreateQuantizedTensor(
+      model->output_state, IntArrayFromInts(model->output_state_dims),
+      kOutputScale, kOutputZeroPoint, /*is_variable=*/true);
+  model->cell_state_dims[0] = 2;
+  model->cell_state_dims[1] = n_batch;
+  model->cell_state_dims[2] = n_cell;
+  for (int i = 0; i < n_batch * n_cell; ++i) {
+    model->cell_state[i] = 0;
+  }
+  tensors[19] = CreateQuantizedTensor(
+      model->cell_state, IntArrayFromInts(model->cell_state_dims), kCellScale,
+      0, /*is_variable=*/true);
+
+  model->output_dims[0] = 3;
+  model->output_dims[1] = model->input_dims[1];
+  model->output_dims[2] = model->input_dims[2];
+  model->output_dims[3] = n_output;
+  tensors[kOutputIndex] = CreateQuantizedTensor(
+      model->output, IntArrayFromInts(model->output_dims), kOutputScale,
+      kOutputZeroPoint);
+
+  model->inputs[0] = kNumInputs;
+  for (int i = 0; i < kNumInputs; ++i) {
+    model->inputs[1 + i] = i;
+  }
+  if (config.use_cifg) {
+    model->inputs[1 + 1] = kTfLiteOptionalTensor;
+    model->inputs[1 + 5] = kTfLiteOptionalTensor;
+    model->inputs[1 + 9] = kTfLiteOptionalTensor;
+    model->inputs[1 + 12] = kTfLiteOptionalTensor;
+  }
+  if (!config.use_peephole) {
+    for (int i = 9; i <= 11; ++i) {
+      model->inputs[1 + i] = kTfLiteOptionalTensor;
+    }
+  }
+  if (!config.use_projection) {
+    model->inputs[1 + 16] = kTfLiteOptionalTensor;
+    model->inputs[1 + 17] = kTfLiteOptionalTensor;
+  }
+  for (int i = 20; i < kNumInputs; ++i) {
+    if (!config.use_layer_norm || (config.use_cifg && i == 20)) {
+      model->inputs[1 + i] = kTfLiteOptionalTensor;
+    }
+  }
+  model->outputs[0] = 1;
+  model->outputs[1] = kOutputIndex;
+  model->intermediates[0] = kNumGates + 1;
+  for (int i = 0; i <= kNumGates; ++i) {
+    model->intermediates[1 + i] = kIntermediatesIndex + i;
+  }
+}
+
+// Runs the LSTM in float on the dequantized tensors of `model`, writing the
+// output sequence to `expected`.
+void EvalFloatReference(const LstmConfig& config, const LstmModel& model,
+                        float* expected) {
+  const int n_input = config.n_input;
+  const int n_cell = config.n_cell;
+  const int n_output = config.n_output;
+  const TfLiteTensor* tensors = model.tensors;
+
+  for (int b = 0; b < config.n_batch; ++b) {
+    float output_state[kMaxSize] = {};
+    float cell_state[kMaxSize] = {};
+    for (int t = 0; t < config.max_time; ++t) {
+      const int offset = config.time_major ? t * config.n_batch + b
+                                           : b * config.max_time + t;
+      float gates[kNumGates][kMaxSize] = {};
+      for (int gate = 0; gate < kNumGates; ++gate) {
+        if (config.use_cifg && gate == kInputGate) {
+          continue;
+        }
+        for (int c = 0; c < n_cell; ++c) {
+          float sum = 0.0f;
+          for (int i = 0; i < n_input; ++i) {
+            sum += Dequantize(tensors[0], offset * n_input + i) *
+                   Dequantize(tensors[1 + gate], c * n_input + i);
+          }
+          for (int i = 0; i < n_output; ++i) {
+            sum += output_state[i] *
+                   Dequantize(tensors[5 + gate], c * n_output + i);
+          }
+          // The output gate peeks at the updated cell state below.
+          if (config.use_peephole && gate != kCellGate &&
+              gate != kOutputGate) {
+            sum += cell_state[c] * Dequantize(tensors[9 + gate], c);
+          }
+          gates[gate][c] = sum;
+        }
+      }
+
+      auto finish_gate = [&](int gate) {
+        if (config.use_layer_norm) {
+          float mean = 0.0f;
+          for (int c = 0; c < n_cell; ++c) {
+            mean += gates[gate][c];
+          }
+          mean /= n_cell;
+          float variance = 0.0f;
+          for (int c = 0; c < n_cell; ++c) {
+            variance += (gates[gate][c] - mean) * (gates[gate][c] - mean);
+          }
+          const float stddev = std::sqrt(variance / n_cell);
+          for (int c = 0; c < n_cell; ++c) {
+            gates[gate][c] = (gates[gate][c] - mean) / stddev *
+                                 Dequantize(tensors[20 + gate], c) +
+                             Dequantize(tensors[12 + gate], c);
+          }
+        } else {
+          for (int c = 0; c < n_cell; ++c) {
+            gates[gate][c] += Dequantize(tensors[12 + gate], c);
+          }
+        }
+        for (int c = 0; c < n_cell; ++c) {
+          gates[gate][c] = gate == kCellGate ? std::tanh(gates[gate][c])
+                                             : Sigmoid(gates[gate][c]);
+        }
+      };
+      if (!config.use_cifg) {
+        finish_gate(kInputGate);
+      }
+      finish_gate(kForgetGate);
+      finish_gate(kCellGate);
+
+      for (int c = 0; c < n_cell; ++c) {
+        const float input_gate =
+            config.use_cifg ? 1.0f - gates[kForgetGate][c]
+                            : gates[kInputGate][c];
+        cell_state[c] = gates[kForgetGate][c] * cell_state[c] +
+                        input_gate * gates[kCellGate][c];
+        if (config.cell_clip > 0.0f) {
+          cell_state[c] = std::min(std::max(cell_state[c], -config.cell_clip),
+                                   config.cell_clip);
+        }
+        if (config.use_peephole) {
+          gates[kOutputGate][c] += cell_state[c] * Dequantize(tensors[11], c);
+        }
+      }
+      finish_gate(kOutputGate);
+
+      float hidden[kMaxSize];
+      for (int c = 0; c < n_cell; ++c) {
+        hidden[c] = gates[kOutputGate][c] * std::tanh(cell_state[c]);
+      }
+      for (int i = 0; i < n_output; ++i) {
+        if (config.use_projection) {
+          float sum = Dequantize(tensors[17], i);
+          for (int c = 0; c < n_cell; ++c) {
+            sum += hidden[c] * Dequantize(tensors[16], i * n_cell + c);
+          }
+          if (config.proj_clip > 0.0f) {
+            sum = std::min(std::max(sum, -config.proj_clip), config.proj_clip);
+          }
+          output_state[i] = sum;
+        } else {
+          output_state[i] = hidden[i];
+        }
+        expected[offset * n_output + i] = output_state[i];
+      }
+    }
+  }
+}
+
+void TestUnidirectionalSequenceLstm(const LstmConfig& config,
+                                    LstmModel* model) {
+  BuildModel(config, model);
+  float expected[kMaxSequence];
+  EvalFloatReference(config, *model, expected);
+
+  TfLiteUnidirectionalSequenceLSTMParams params = {
+      kTfLiteActTanh, config.cell_clip, config.proj_clip, config.time_major,
+      /*asymmetric_quantize_inputs=*/false};
+  const TfLiteRegistration registration =
+      tflite::ops::micro::Register_UNIDIRECTIONAL_SEQUENCE_LSTM();
+  micro::KernelRunner runner(registration, model->tensors, kNumTensors,
+                             IntArrayFromInts(model->inputs),
+                             IntArrayFromInts(model->outputs), &params);
+  runner.SetIntermediates(IntArrayFromInts(model->intermediates));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, runner.InitAndPrepare());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, runner.Invoke());
+
+  const int output_size = config.n_batch * config.max_time * config.n_output;
+  for (int i = 0; i < output_size; ++i) {
+    const float expected_quantized =
+        expected[i] / kOutputScale + kOutputZeroPoint;
+    TF_LITE_MICRO_EXPECT_NEAR(expected_quantized, model->output[i], 2.0f);
+  }
+}
+
+// Expects Prepare to reject int16 activations, i.e. the 16x8 quantization.
+void TestUnidirectionalSequenceLstmInt16InputFails(const LstmConfig& config,
+                                                   LstmModel* model) {
+  BuildModel(config, model);
+  model->tensors[0].type = kTfLiteInt16;
+
+  TfLiteUnidirectionalSequenceLSTMParams params = {
+      kTfLiteActTanh, config.cell_clip, config.proj_clip, config.time_major,
+      /*asymmetric_quantize_inputs=*/false};
+  const TfLiteRegistration registration =
+      tflite::ops::micro::Register_UNIDIRECTIONAL_SEQUENCE_LSTM();
+  micro::KernelRunner runner(registration, model->tensors, kNumTensors,
+                             IntArrayFromInts(model->inputs),
+                             IntArrayFromInts(model->outputs), &params);
+  runner.SetIntermediates(IntArrayFromInts(model->intermediates));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, runner.InitAndPrepare());
+}
+
+LstmModel model;
+
+}  // namespace
+}  // namespace testing
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(BatchMajorMatchesFloatReference) {
+  const tflite::testing::LstmConfig config = {
+      /*n_batch=*/2,          /*max_time=*/3,
+      /*n_input=*/3,          /*n_cell=*/4,
+      /*n_output=*/4,         /*time_major=*/false,
+      /*use_cifg=*/false,     /*use_peephole=*/false,
+      /*use_layer_norm=*/false, /*use_projection=*/false,
+      /*cell_clip=*/0.0f,     /*proj_clip=*/0.0f};
+  tflite::testing::TestUnidirectionalSequenceLstm(config,
+                                                  &tflite::testing::model);
+}
+
+TF_LITE_MICRO_TEST(TimeMajorMatchesFloatReference) {
+  const tflite::testing::LstmConfig config = {
+      /*n_batch=*/2,          /*max_time=*/3,
+      /*n_input=*/3,          /*n_cell=*/4,
+      /*n_output=*/4,         /*time_major=*/true,
+      /*use_cifg=*/false,     /*use_peephole=*/false,
+      /*use_layer_norm=*/false, /*use_projection=*/false,
+      /*cell_clip=*/0.0f,     /*proj_clip=*/0.0f};
+  tflite::testing::TestUnidirectionalSequenceLstm(config,
+                                                  &tflite::testing::model);
+}
+
+TF_LITE_MICRO_TEST(CifgPeepholeProjectionMatchesFloatReference) {
+  const tflite::testing::LstmConfig config = {
+      /*n_batch=*/2,          /*max_time=*/3,
+      /*n_input=*/3,          /*n_cell=*/4,
+      /*n_output=*/3,         /*time_major=*/false,
+      /*use_cifg=*/true,      /*use_peephole=*/true,
+      /*use_layer_norm=*/false, /*use_projection=*/true,
+      /*cell_clip=*/0.5f,     /*proj_clip=*/0.5f};
+  tflite::testing::TestUnidirectionalSequenceLstm(config,
+                                                  &tflite::testing::model);
+}
+
+TF_LITE_MICRO_TEST(LayerNormMatchesFloatReference) {
+  const tflite::testing::LstmConfig config = {
+      /*n_batch=*/2,          /*max_time=*/3,
+      /*n_input=*/3,          /*n_cell=*/4,
+      /*n_output=*/4,         /*time_major=*/true,
+      /*use_cifg=*/false,     /*use_peephole=*/true,
+      /*use_layer_norm=*/true, /*use_projection=*/false,
+      /*cell_clip=*/0.0f,     /*proj_clip=*/0.0f};
+  tflite::testing::TestUnidirectionalSequenceLstm(config,
+                                                  &tflite::testing::model);
+}
+
+TF_LITE_MICRO_TEST(Int16ActivationsAreNotSupported) {
+  const tflite::testing::LstmConfig config = {
+      /*n_batch=*/2,          /*max_time=*/3,
+      /*n_input=*/3,          /*n_cell=*/4,
+      /*n_output=*/4,         /*time_major=*/false,
+      /*use_cifg=*/false,     /*use_peephole=*/false,
+      /*use_layer_norm=*/false, /*use_projection=*/false,
+      /*cell_clip=*/0.0f,     /*proj_clip=*/0.0f};
+  tflite::testing::TestUnidirectionalSequenceLstmInt16InputFails(
+      config, &tflite::testing::model);
+}
+
+TF_LITE_MICRO_TESTS_END
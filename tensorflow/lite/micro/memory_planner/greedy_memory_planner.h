@@ -56,6 +56,11 @@ class GreedyMemoryPlanner : public MemoryPlanner {
   GreedyMemoryPlanner(unsigned char* scratch_buffer, int scratch_buffer_size);
   ~GreedyMemoryPlanner() override;
 
+  // Returns the number of scratch bytes needed to plan `buffer_count` buffers.
+  static size_t scratch_buffer_size(int buffer_count) {
+    return per_buffer_size() * buffer_count;
+  }
+
   // Record details of a buffer we want to place.
   TfLiteStatus AddBuffer(ErrorReporter* error_reporter, int size,
                          int first_time_used, int last_time_used);
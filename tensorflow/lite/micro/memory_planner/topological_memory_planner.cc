@@ -132,9 +132,16 @@ bool IsOverlapOrInplaceOperator( BuiltinOperator op_type) {
 TopologicalMemoryPlanner::TopologicalMemoryPlanner(unsigned char* scratch_buffer,
                                          int scratch_buffer_size, int operator_size)
     : buffer_count_(0), need_to_calculate_offsets_(true) {
-  // Allocate the arrays we need within the scratch buffer arena.
-  max_buffer_count_ = (scratch_buffer_size - sizeof(OperatorRequirements) * operator_size) / \
-      (per_buffer_size() + 2 *operator_size);
+  // Allocate the arrays we need within the scratch buffer arena. A scratch
+  // buffer too small for the operator requirements leaves room for no buffers
+  // rather than wrapping around.
+  const int ops_requirements_size =
+      static_cast<int>(sizeof(OperatorRequirements)) * operator_size;
+  max_buffer_count_ =
+      scratch_buffer_size > ops_requirements_size
+          ? (scratch_buffer_size - ops_requirements_size) /
+                static_cast<int>(per_buffer_size() + 2 * operator_size)
+          : 0;
   operators_size_ = operator_size;
 
   unsigned char* next_free = scratch_buffer;
@@ -60,6 +60,13 @@ class TopologicalMemoryPlanner : public MemoryPlanner {
                           int operator_size);
   ~TopologicalMemoryPlanner() override;
 
+  // Returns the number of scratch bytes needed to plan `buffer_count` buffers
+  // for a subgraph of `operator_size` operators.
+  static size_t scratch_buffer_size(int buffer_count, int operator_size) {
+    return sizeof(OperatorRequirements) * operator_size +
+           (per_buffer_size() + 2 * operator_size) * buffer_count;
+  }
+
   // Record operator info
   TfLiteStatus AddOperatorInfo(tflite::ErrorReporter* error_reporter, 
                               int operator_id, BuiltinOperator op_type, 
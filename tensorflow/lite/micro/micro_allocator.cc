@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstddef>
 #include <cstdint>
+#include <new>
 
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/c/common.h"
@@ -58,8 +59,16 @@ struct AllocationInfo {
   void** output_ptr;
   int first_created;
   int last_used;
+  // Number of reads of the buffer at time `last_used`.
+  int last_used_reads;
   int32_t offline_offset;
   bool needs_allocating;
+  // Index of the buffer whose memory this buffer shares, or -1. Set for the
+  // outputs of shape-only operators such as RESHAPE and for the inputs of
+  // CONCATENATION, which are not planned themselves.
+  int alias_root;
+  // Offset in bytes of this buffer inside the memory of `alias_root`.
+  size_t alias_offset;
 #ifdef TOPOLOGY_MEM_PLANNER 
   // boolean array of operators of which tensor is the input
   // 1 means the tensor is one of inputs of the corresponding index of operator
@@ -178,6 +187,115 @@ TfLiteStatus CheckOfflinePlannedOffsets(const Model* model,
 }
 #endif
 
+// Maximum number of subgraphs a single control flow operator invokes.
+constexpr int kMaxInvokedSubgraphs = 2;
+
+// Stores the distinct subgraphs that `op` invokes in `subgraph_indices` and
+// returns their number. Sets `exclusive` when at most one of them runs per
+// invocation of the operator, like the branches of IF. WHILE alternates
+// between its condition and body and copies from one into the other, so those
+// need buffers of their own.
+int GetInvokedSubgraphs(const Operator* op, int* subgraph_indices,
+                        bool* exclusive) {
+  *exclusive = false;
+  switch (op->builtin_options_type()) {
+    case BuiltinOptions_IfOptions: {
+      const IfOptions* options = op->builtin_options_as_IfOptions();
+      subgraph_indices[0] = options->then_subgraph_index();
+      subgraph_indices[1] = options->else_subgraph_index();
+      *exclusive = true;
+      break;
+    }
+    case BuiltinOptions_WhileOptions: {
+      const WhileOptions* options = op->builtin_options_as_WhileOptions();
+      subgraph_indices[0] = options->cond_subgraph_index();
+      subgraph_indices[1] = options->body_subgraph_index();
+      break;
+    }
+    default:
+      return 0;
+  }
+  return subgraph_indices[0] == subgraph_indices[1] ? 1 : 2;
+}
+
+// Returns the number of operators in `model` that invoke `subgraph_idx`.
+int CountSubgraphCallers(const Model* model, int subgraph_idx) {
+  int callers = 0;
+  for (size_t i = 0; i < model->subgraphs()->size(); ++i) {
+    const SubGraph* subgraph = model->subgraphs()->Get(i);
+    const uint32_t operators_size = NumSubgraphOperators(subgraph);
+    for (uint32_t j = 0; j < operators_size; ++j) {
+      int invoked[kMaxInvokedSubgraphs];
+      bool exclusive;
+      const int invoked_size =
+          GetInvokedSubgraphs(subgraph->operators()->Get(j), invoked, &exclusive);
+      for (int k = 0; k < invoked_size; ++k) {
+        if (invoked[k] == subgraph_idx) {
+          ++callers;
+        }
+      }
+    }
+  }
+  return callers;
+}
+
+// Returns true if the memory plan of `subgraph_idx` is part of the plan of the
+// only subgraph invoking it, see MicroAllocator::PlanSubgraphTree(). Deferred
+// subgraphs are planned on their own once they are prepared.
+bool IsPlannedIntoCaller(const Model* model,
+                         const SubgraphAllocations* subgraph_allocations,
+                         int subgraph_idx) {
+  return subgraph_idx > 0 &&
+         subgraph_idx < static_cast<int>(model->subgraphs()->size()) &&
+         !subgraph_allocations[subgraph_idx].deferred &&
+         CountSubgraphCallers(model, subgraph_idx) == 1;
+}
+
+// Returns the number of subgraphs whose plans are part of the plan of
+// `subgraph`.
+size_t CountSubgraphsPlannedInto(
+    const Model* model, const SubGraph* subgraph,
+    const SubgraphAllocations* subgraph_allocations) {
+  size_t count = 0;
+  const uint32_t operators_size = NumSubgraphOperators(subgraph);
+  for (uint32_t i = 0; i < operators_size; ++i) {
+    int invoked[kMaxInvokedSubgraphs];
+    bool exclusive;
+    const int invoked_size =
+        GetInvokedSubgraphs(subgraph->operators()->Get(i), invoked, &exclusive);
+    for (int j = 0; j < invoked_size; ++j) {
+      if (IsPlannedIntoCaller(model, subgraph_allocations, invoked[j])) {
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+// Returns the index of the planned buffer that holds the memory of the buffer
+// at `index`, and the offset of that memory inside the planned buffer.
+int ResolveAlias(const AllocationInfo* info, int index, size_t* offset) {
+  *offset = 0;
+  while (info[index].alias_root != -1) {
+    *offset += info[index].alias_offset;
+    index = info[index].alias_root;
+  }
+  return index;
+}
+
+// Extends the lifetime of `into` to cover the lifetime of `from`.
+void MergeLifetime(const AllocationInfo& from, AllocationInfo* into) {
+  if (from.first_created < into->first_created) {
+    into->first_created = from.first_created;
+  }
+  if (from.last_used > into->last_used) {
+    into->last_used = from.last_used;
+    into->last_used_reads = from.last_used_reads;
+  } else if (from.last_used == into->last_used) {
+    into->last_used_reads += from.last_used_reads;
+  }
+}
+
 // A helper class to construct AllocationInfo array. This array contains the
 // lifetime of tensors / scratch_buffer and will be used to calculate the memory
 // plan. Methods need to be called in order from `Init`, `Add*`, to `Finish`.
@@ -205,22 +323,67 @@ class AllocationInfoBuilder {
       const Model* model, const int32_t** offline_planner_offsets);
 
   // Add allocaiton information for the tensors.
-  TfLiteStatus AddTensors(const SubGraph* subgraph,
-#ifdef TOPOLOGY_MEM_PLANNER
-                          const Model* model,
-#endif
+  TfLiteStatus AddTensors(const SubGraph* subgraph, const Model* model,
                           const int32_t* offline_offsets,
                           TfLiteEvalTensor* eval_tensors);
 
-  // Add allocation information for the scratch buffers.
+  // Measures buffer lifetimes in levels of `schedule` instead of operator
+  // indices. Must be called before the Add* methods.
+  void SetSchedule(const NodeSchedule* schedule) { schedule_ = schedule; }
+
+  // Keeps the subgraph inputs and outputs alive for the whole invocation and
+  // beyond, so no other buffer is ever planned on top of them. Must be called
+  // before AddTensors().
+  void SetPinIoBuffers(bool pin_io_buffers) {
+    pin_io_buffers_ = pin_io_buffers;
+  }
+
+  // Add allocation information for the scratch buffers requested by the
+  // operators of `subgraph_idx`.
   TfLiteStatus AddScratchBuffers(
       internal::ScratchBufferRequest* scratch_buffer_requests,
-      ScratchBufferHandle* scratch_buffer_handles);
+      ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx);
+
+  // Adds a buffer for the plans of the subgraphs that each control flow
+  // operator invokes, if they are planned into this subgraph. The buffer only
+  // lives while the operator runs, and the subgraphs of which at most one runs
+  // share it. Must be called after the other Add* methods.
+  TfLiteStatus AddInvokedSubgraphs(const Model* model,
+                                   const SubGraph* subgraph,
+                                   SubgraphAllocations* subgraph_allocations);
 
   // Returns a pointer to the built AllocationInfo array.
   const AllocationInfo* Finish() const { return info_; }
 
  private:
+  // Lets the output of every RESHAPE, SQUEEZE and EXPAND_DIMS operator share
+  // the buffer of its input. The lifetime of the shared buffer covers both
+  // tensors and the output is not planned on its own, which saves the arena
+  // space of the output and turns the operator into a no-op.
+  void AliasShapeOnlyOps(const SubGraph* subgraph, const Model* model);
+
+  // Places the inputs of every CONCATENATION operator that concatenates along
+  // its outermost non-trivial dimension at their offsets inside the output
+  // buffer. Producers then write straight into the output and the
+  // concatenation does not copy anything.
+  void AliasConcatenationInputs(const SubGraph* subgraph, const Model* model,
+                                const TfLiteEvalTensor* eval_tensors);
+
+  // Returns true if `tensor_index` is an input or output of `subgraph`. These
+  // keep buffers of their own, since the application accesses them outside of
+  // the invocation.
+  bool IsSubgraphIo(const SubGraph* subgraph, int tensor_index) const;
+
+  // Returns the time at which the operator at `node_idx` runs.
+  int NodeTime(int node_idx) const {
+    if (schedule_ == nullptr || node_idx >= schedule_->nodes_size) {
+      return node_idx;
+    }
+    return schedule_->node_levels[node_idx];
+  }
+
+  const NodeSchedule* schedule_ = nullptr;
+  bool pin_io_buffers_ = false;
   AllocationInfo* info_ = nullptr;
 #ifdef TOPOLOGY_MEM_PLANNER
   OperatorInfo* operator_info_=nullptr;
@@ -231,9 +394,7 @@ class AllocationInfoBuilder {
 };
 
 TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
-#ifdef TOPOLOGY_MEM_PLANNER
                                                const Model* model,
-#endif
                                                const int32_t* offline_offsets,
                                                TfLiteEvalTensor* eval_tensors) {
   TFLITE_DCHECK(eval_tensors != nullptr);
@@ -252,8 +413,11 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
 
     current->first_created = -1;
     current->last_used = -1;
+    current->last_used_reads = 0;
     current->needs_allocating = (eval_tensors[i].data.data == nullptr) &&
                                 (!subgraph->tensors()->Get(i)->is_variable());
+    current->alias_root = -1;
+    current->alias_offset = 0;
     if (offline_offsets) {
       current->offline_offset = offline_offsets[i];
     } else {
@@ -273,12 +437,14 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
   for (size_t i = 0; i < subgraph->outputs()->size(); ++i) {
     const int tensor_index = subgraph->outputs()->Get(i);
     AllocationInfo* current = &info_[tensor_index];
-    current->last_used = operators_size - 1;
+    current->last_used =
+        schedule_ != nullptr ? schedule_->levels_size - 1 : operators_size - 1;
   }
 
   // Figure out when the first and last use of each tensor is.
   for (int i = (operators_size - 1); i >= 0; --i) {
     const auto* op = subgraph->operators()->Get(i);
+    const int time = NodeTime(i);
 #ifdef TOPOLOGY_MEM_PLANNER 
     //TfLiteNode* node = &(
     //      graph_.GetAllocations()[subgraph_idx].node_and_registrations[i].node);
@@ -317,8 +483,11 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
     for (size_t n = 0; n < op->inputs()->size(); ++n) {
       const int tensor_index = op->inputs()->Get(n);
       AllocationInfo* current = &info_[tensor_index];
-      if (((current->last_used == -1) || (current->last_used < i))) {
-        current->last_used = i;
+      if (((current->last_used == -1) || (current->last_used < time))) {
+        current->last_used = time;
+        current->last_used_reads = 1;
+      } else if (current->last_used == time) {
+        ++current->last_used_reads;
       }
 #ifdef TOPOLOGY_MEM_PLANNER 
     current->input_of_operators[i] = 1;
@@ -352,8 +521,8 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
     for (size_t n = 0; n < op->outputs()->size(); ++n) {
       const int tensor_index = op->outputs()->Get(n);
       AllocationInfo* current = &info_[tensor_index];
-      if ((current->first_created == -1) || (current->first_created > i)) {
-        current->first_created = i;
+      if ((current->first_created == -1) || (current->first_created > time)) {
+        current->first_created = time;
       }
 #ifdef TOPOLOGY_MEM_PLANNER 
     current->output_of_operators[i] = 1;
@@ -387,9 +556,180 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
 #endif
     }
   }
+
+  AliasShapeOnlyOps(subgraph, model);
+  AliasConcatenationInputs(subgraph, model, eval_tensors);
+
+  // Outputs are created before the first operator runs, and inputs are only
+  // released after the last one, so that no buffer can be placed in-place on
+  // top of them either.
+  if (pin_io_buffers_) {
+    const int end_time =
+        schedule_ != nullptr ? schedule_->levels_size : operators_size;
+    for (size_t i = 0; i < subgraph->inputs()->size(); ++i) {
+      info_[subgraph->inputs()->Get(i)].last_used = end_time;
+    }
+    for (size_t i = 0; i < subgraph->outputs()->size(); ++i) {
+      info_[subgraph->outputs()->Get(i)].first_created = -1;
+    }
+  }
+
+  // The planners let the output of an operator overlap an input that is last
+  // read by that operator. With a schedule, other operators of the same level
+  // may still be reading that input concurrently, so keep such buffers alive
+  // one level longer.
+  if (schedule_ != nullptr) {
+    for (size_t i = 0; i < tensor_count_; ++i) {
+      if (info_[i].last_used_reads > 1) {
+        ++info_[i].last_used;
+      }
+    }
+  }
   return kTfLiteOk;
 }
 
+bool AllocationInfoBuilder::IsSubgraphIo(const SubGraph* subgraph,
+                                         int tensor_index) const {
+  for (size_t i = 0; i < subgraph->inputs()->size(); ++i) {
+    if (subgraph->inputs()->Get(i) == tensor_index) return true;
+  }
+  for (size_t i = 0; i < subgraph->outputs()->size(); ++i) {
+    if (subgraph->outputs()->Get(i) == tensor_index) return true;
+  }
+  return false;
+}
+
+void AllocationInfoBuilder::AliasShapeOnlyOps(const SubGraph* subgraph,
+                                              const Model* model) {
+  auto* opcodes = model->operator_codes();
+  const uint32_t operators_size = NumSubgraphOperators(subgraph);
+
+  // Operators are visited in execution order, so the input of a chain of
+  // shape-only operators has already been resolved to its root buffer.
+  for (uint32_t i = 0; i < operators_size; ++i) {
+    const auto* op = subgraph->operators()->Get(i);
+    const BuiltinOperator op_type =
+        GetBuiltinCode(opcodes->Get(op->opcode_index()));
+    if (op_type != BuiltinOperator_RESHAPE &&
+        op_type != BuiltinOperator_SQUEEZE &&
+        op_type != BuiltinOperator_EXPAND_DIMS) {
+      continue;
+    }
+    if (op->inputs() == nullptr || op->inputs()->size() < 1 ||
+        op->outputs() == nullptr || op->outputs()->size() != 1) {
+      continue;
+    }
+    const int input_index = op->inputs()->Get(0);
+    const int output_index = op->outputs()->Get(0);
+    if (input_index < 0 || IsSubgraphIo(subgraph, output_index)) {
+      continue;
+    }
+
+    AllocationInfo* output = &info_[output_index];
+    size_t root_offset;
+    const int root_index = ResolveAlias(info_, input_index, &root_offset);
+    AllocationInfo* root = &info_[root_index];
+    if (IsSubgraphIo(subgraph, root_index) || !root->needs_allocating ||
+        !output->needs_allocating || root->bytes != output->bytes ||
+        root->offline_offset != kOnlinePlannedBuffer ||
+        output->offline_offset != kOnlinePlannedBuffer) {
+      continue;
+    }
+
+    output->needs_allocating = false;
+    output->alias_root = root_index;
+    MergeLifetime(*output, root);
+#ifdef TOPOLOGY_MEM_PLANNER
+    // The aliasing operator itself does not produce a new buffer.
+    for (uint32_t j = 0; j < operators_size; ++j) {
+      root->input_of_operators[j] |= output->input_of_operators[j];
+      if (j != i) {
+        root->output_of_operators[j] |= output->output_of_operators[j];
+      }
+    }
+#endif
+  }
+}
+
+void AllocationInfoBuilder::AliasConcatenationInputs(
+    const SubGraph* subgraph, const Model* model,
+    const TfLiteEvalTensor* eval_tensors) {
+  auto* opcodes = model->operator_codes();
+  const uint32_t operators_size = NumSubgraphOperators(subgraph);
+
+  // Operators are visited in execution order, so that the output of one
+  // concatenation can in turn be placed inside the output of the next one.
+  for (uint32_t i = 0; i < operators_size; ++i) {
+    const auto* op = subgraph->operators()->Get(i);
+    if (GetBuiltinCode(opcodes->Get(op->opcode_index())) !=
+        BuiltinOperator_CONCATENATION) {
+      continue;
+    }
+    const ConcatenationOptions* options =
+        op->builtin_options_as_ConcatenationOptions();
+    if (options == nullptr || op->inputs() == nullptr ||
+        op->outputs() == nullptr || op->outputs()->size() != 1) {
+      continue;
+    }
+    const int output_index = op->outputs()->Get(0);
+    AllocationInfo* output = &info_[output_index];
+    if (IsSubgraphIo(subgraph, output_index) || !output->needs_allocating ||
+        output->offline_offset != kOnlinePlannedBuffer) {
+      continue;
+    }
+
+    // The inputs are contiguous inside the output only if all dimensions in
+    // front of the concatenation axis are 1.
+    const TfLiteIntArray* dims = eval_tensors[output_index].dims;
+    const int axis =
+        options->axis() < 0 ? options->axis() + dims->size : options->axis();
+    bool outer_concatenation = axis >= 0 && axis < dims->size;
+    for (int d = 0; outer_concatenation && d < axis; ++d) {
+      outer_concatenation = dims->data[d] == 1;
+    }
+    if (!outer_concatenation) {
+      continue;
+    }
+
+    size_t offset = 0;
+    for (size_t n = 0; n < op->inputs()->size(); ++n) {
+      const int input_index = op->inputs()->Get(n);
+      const size_t input_offset = offset;
+      offset += info_[input_index].bytes;
+
+      size_t root_offset;
+      const int root_index = ResolveAlias(info_, input_index, &root_offset);
+      AllocationInfo* root = &info_[root_index];
+      if (root_index == output_index || root_offset != 0 ||
+          root->bytes != info_[input_index].bytes ||
+          IsSubgraphIo(subgraph, root_index) || !root->needs_allocating ||
+          root->offline_offset != kOnlinePlannedBuffer ||
+          input_offset % kBufferAlignment != 0) {
+        continue;
+      }
+      // The same buffer can only be placed once.
+      bool placed = false;
+      for (size_t m = 0; m < n; ++m) {
+        size_t unused_offset;
+        placed |= ResolveAlias(info_, op->inputs()->Get(m), &unused_offset) ==
+                  root_index;
+      }
+      if (placed) {
+        continue;
+      }
+
+      // The operator flags are not merged into the output buffer: the
+      // planners would otherwise treat the producers of the inputs as
+      // candidates for placing their output on top of their inputs, with
+      // the output starting at the beginning of the concatenation output.
+      root->needs_allocating = false;
+      root->alias_root = output_index;
+      root->alias_offset = input_offset;
+      MergeLifetime(*root, output);
+    }
+  }
+}
+
 // Get offline tensors allocation plan. See
 // micro/docs/memory_management.md for more info.
 TfLiteStatus AllocationInfoBuilder::GetOfflinePlannedOffsets(
@@ -424,7 +764,7 @@ TfLiteStatus AllocationInfoBuilder::GetOfflinePlannedOffsets(
 
 TfLiteStatus AllocationInfoBuilder::AddScratchBuffers(
     internal::ScratchBufferRequest* scratch_buffer_requests,
-    ScratchBufferHandle* scratch_buffer_handles) {
+    ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx) {
   // Set up allocation info for buffers.
   for (size_t i = tensor_count_; i < tensor_count_ + buffer_count_; ++i) {
     internal::ScratchBufferRequest* current_request =
@@ -435,10 +775,59 @@ TfLiteStatus AllocationInfoBuilder::AddScratchBuffers(
     AllocationInfo* current = &info_[i];
     current->output_ptr = reinterpret_cast<void**>(&current_handle->data);
     current->bytes = current_request->bytes;
-    current->first_created = current_request->node_idx;
-    current->last_used = current_request->node_idx;
+    current->first_created = NodeTime(current_request->node_idx);
+    current->last_used = NodeTime(current_request->node_idx);
+    current->last_used_reads = 0;
     current->offline_offset = kOnlinePlannedBuffer;
-    current->needs_allocating = true;
+    // The buffers of other subgraphs are planned with those.
+    current->needs_allocating = current_request->subgraph_idx == subgraph_idx;
+    current->alias_root = -1;
+    current->alias_offset = 0;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus AllocationInfoBuilder::AddInvokedSubgraphs(
+    const Model* model, const SubGraph* subgraph,
+    SubgraphAllocations* subgraph_allocations) {
+  size_t index = tensor_count_ + buffer_count_;
+  const uint32_t operators_size = NumSubgraphOperators(subgraph);
+  for (uint32_t i = 0; i < operators_size; ++i) {
+    int invoked[kMaxInvokedSubgraphs];
+    bool exclusive;
+    const int invoked_size =
+        GetInvokedSubgraphs(subgraph->operators()->Get(i), invoked, &exclusive);
+    // Buffer shared by the exclusive subgraphs of the operator, or -1.
+    int shared_root = -1;
+    for (int j = 0; j < invoked_size; ++j) {
+      if (!IsPlannedIntoCaller(model, subgraph_allocations, invoked[j])) {
+        continue;
+      }
+      SubgraphAllocations* invoked_allocations =
+          &subgraph_allocations[invoked[j]];
+      AllocationInfo* current = &info_[index];
+      current->output_ptr =
+          reinterpret_cast<void**>(&invoked_allocations->plan_buffer);
+      current->bytes = invoked_allocations->plan_bytes;
+      current->first_created = NodeTime(i);
+      current->last_used = NodeTime(i);
+      current->last_used_reads = 0;
+      current->offline_offset = kOnlinePlannedBuffer;
+      current->needs_allocating = true;
+      current->alias_root = -1;
+      current->alias_offset = 0;
+      if (exclusive && shared_root == -1) {
+        shared_root = index;
+      } else if (exclusive) {
+        // The shared buffer is as large as the largest of the subgraphs.
+        if (info_[shared_root].bytes < current->bytes) {
+          info_[shared_root].bytes = current->bytes;
+        }
+        current->needs_allocating = false;
+        current->alias_root = shared_root;
+      }
+      ++index;
+    }
   }
   return kTfLiteOk;
 }
@@ -525,6 +914,16 @@ TfLiteStatus CommitPlan(ErrorReporter* error_reporter, MemoryPlanner* planner,
       ++planner_index;
     }
   }
+  // Aliased buffers point into the memory of their root buffer.
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->alias_root != -1) {
+      size_t offset;
+      const int root = ResolveAlias(allocation_info, i, &offset);
+      *current->output_ptr =
+          static_cast<uint8_t*>(*allocation_info[root].output_ptr) + offset;
+    }
+  }
   return kTfLiteOk;
 }
 }  // namespace
@@ -744,6 +1143,75 @@ TfLiteStatus InitializeTfLiteEvalTensorFromFlatbuffer(
   return kTfLiteOk;
 }
 
+RuntimeShape* AllocateTensorShapes(SimpleMemoryAllocator* allocator,
+                                   const TfLiteEvalTensor* eval_tensors,
+                                   size_t tensors_size) {
+  RuntimeShape* shapes =
+      reinterpret_cast<RuntimeShape*>(allocator->AllocateFromTail(
+          sizeof(RuntimeShape) * (tensors_size + 1), alignof(RuntimeShape)));
+  if (shapes == nullptr) {
+    return nullptr;
+  }
+  for (size_t i = 0; i <= tensors_size; ++i) {
+    new (&shapes[i]) RuntimeShape();
+  }
+  UpdateTensorShapes(eval_tensors, tensors_size, shapes);
+  return shapes;
+}
+
+void UpdateTensorShapes(const TfLiteEvalTensor* eval_tensors,
+                        size_t tensors_size, RuntimeShape* shapes) {
+  for (size_t i = 0; i < tensors_size; ++i) {
+    const TfLiteIntArray* dims = eval_tensors[i].dims;
+    // Shapes RuntimeShape cannot hold are left empty, kernels working on such
+    // tensors do not use RuntimeShape either.
+    if (dims != nullptr && dims->size <= 5) {
+      shapes[i].ReplaceWith(dims->size, dims->data);
+    }
+  }
+}
+
+TfLiteStatus ResolveNodeTensors(SimpleMemoryAllocator* allocator,
+                                const TfLiteIntArray* inputs,
+                                const TfLiteIntArray* outputs,
+                                TfLiteEvalTensor* eval_tensors,
+                                const RuntimeShape* shapes,
+                                size_t tensors_size,
+                                NodeAndRegistration* node) {
+  const int inputs_size = inputs != nullptr ? inputs->size : 0;
+  const int outputs_size = outputs != nullptr ? outputs->size : 0;
+  const size_t count = inputs_size + outputs_size;
+  if (count == 0) {
+    return kTfLiteOk;
+  }
+
+  TfLiteEvalTensor** node_tensors =
+      reinterpret_cast<TfLiteEvalTensor**>(allocator->AllocateFromTail(
+          sizeof(TfLiteEvalTensor*) * count, alignof(TfLiteEvalTensor*)));
+  const RuntimeShape** node_shapes =
+      reinterpret_cast<const RuntimeShape**>(allocator->AllocateFromTail(
+          sizeof(const RuntimeShape*) * count, alignof(const RuntimeShape*)));
+  if (node_tensors == nullptr || node_shapes == nullptr) {
+    return kTfLiteError;
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    const int tensor_index =
+        static_cast<int>(i) < inputs_size ? inputs->data[i]
+                                          : outputs->data[i - inputs_size];
+    if (tensor_index < 0 || static_cast<size_t>(tensor_index) >= tensors_size) {
+      node_tensors[i] = nullptr;
+      node_shapes[i] = &shapes[tensors_size];
+    } else {
+      node_tensors[i] = &eval_tensors[tensor_index];
+      node_shapes[i] = &shapes[tensor_index];
+    }
+  }
+  node->eval_tensors = node_tensors;
+  node->eval_shapes = node_shapes;
+  return kTfLiteOk;
+}
+
 }  // namespace internal
 
 MicroAllocator::MicroAllocator(SimpleMemoryAllocator* memory_allocator,
@@ -770,11 +1238,43 @@ MicroAllocator* MicroAllocator::Create(SimpleMemoryAllocator* memory_allocator,
 
   uint8_t* allocator_buffer = memory_allocator->AllocateFromTail(
       sizeof(MicroAllocator), alignof(MicroAllocator));
+  if (allocator_buffer == nullptr) {
+    return nullptr;
+  }
   MicroAllocator* allocator =
       new (allocator_buffer) MicroAllocator(memory_allocator, error_reporter);
   return allocator;
 }
 
+MicroAllocator* MicroAllocator::Create(uint8_t* persistent_arena,
+                                       size_t persistent_arena_size,
+                                       SharedNonPersistentArena* shared_arena,
+                                       ErrorReporter* error_reporter) {
+  TFLITE_DCHECK(shared_arena != nullptr);
+  TFLITE_DCHECK(error_reporter != nullptr);
+
+  uint8_t* aligned_persistent_arena =
+      AlignPointerUp(persistent_arena, kBufferAlignment);
+  size_t aligned_persistent_arena_size =
+      persistent_arena + persistent_arena_size - aligned_persistent_arena;
+  uint8_t* aligned_shared_arena =
+      AlignPointerUp(shared_arena->buffer, kBufferAlignment);
+  size_t aligned_shared_arena_size =
+      shared_arena->buffer + shared_arena->size - aligned_shared_arena;
+
+  SimpleMemoryAllocator* memory_allocator = SimpleMemoryAllocator::Create(
+      error_reporter, aligned_persistent_arena, aligned_persistent_arena_size,
+      aligned_shared_arena, aligned_shared_arena_size);
+  if (memory_allocator == nullptr) {
+    return nullptr;
+  }
+  MicroAllocator* allocator = Create(memory_allocator, error_reporter);
+  if (allocator != nullptr) {
+    allocator->shared_arena_ = shared_arena;
+  }
+  return allocator;
+}
+
 SubgraphAllocations* MicroAllocator::StartModelAllocation(const Model* model) {
   TFLITE_DCHECK(model != nullptr);
 
@@ -823,22 +1323,237 @@ TfLiteStatus MicroAllocator::FinishModelAllocation(
     return kTfLiteError;
   }
 
-  // TODO(b/187993197): Track scratch buffers for each subgraph.
+  TF_LITE_ENSURE_STATUS(AllocateScratchBufferHandles(
+      scratch_buffer_handles, scratch_buffer_request_count_));
+
+  // Every subgraph that is not planned into the plan of its caller gets a
+  // block of the head. The subgraphs nothing invokes, usually only the first,
+  // never run at the same time and share the start of the head. Subgraphs
+  // with several callers may run while any of those run, so they come after.
+  const int subgraphs_size = model->subgraphs()->size();
+  size_t uncalled_bytes = 0;
+  size_t shared_bytes = 0;
+  for (int subgraph_idx = 0; subgraph_idx < subgraphs_size; ++subgraph_idx) {
+    SubgraphAllocations& allocations = subgraph_allocations[subgraph_idx];
+    if (allocations.deferred ||
+        IsPlannedIntoCaller(model, subgraph_allocations, subgraph_idx)) {
+      continue;
+    }
+    TF_LITE_ENSURE_STATUS(PlanSubgraphTree(model, subgraph_allocations,
+                                           *scratch_buffer_handles,
+                                           subgraph_idx,
+                                           /*size_only=*/true, /*depth=*/0));
+    if (subgraph_idx == 0 || CountSubgraphCallers(model, subgraph_idx) == 0) {
+      if (uncalled_bytes < allocations.plan_bytes) {
+        uncalled_bytes = allocations.plan_bytes;
+      }
+    } else {
+      shared_bytes += AlignSizeUp(allocations.plan_bytes, kBufferAlignment);
+    }
+  }
+  uncalled_bytes = AlignSizeUp(uncalled_bytes, kBufferAlignment);
+  const size_t head_usage = uncalled_bytes + shared_bytes;
+
+  // Make sure we have enough arena size.
+  const size_t actual_available_arena_size =
+      memory_allocator_->GetAvailableMemory(kBufferAlignment);
+  if (head_usage > actual_available_arena_size) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter_,
+        "Arena size is too small for all buffers. Needed %u but only "
+        "%u was available.",
+        head_usage, actual_available_arena_size);
+    return kTfLiteError;
+  }
+
+  uint8_t* shared_buffer = memory_allocator_->GetHeadBuffer() + uncalled_bytes;
+  for (int subgraph_idx = 0; subgraph_idx < subgraphs_size; ++subgraph_idx) {
+    SubgraphAllocations& allocations = subgraph_allocations[subgraph_idx];
+    if (allocations.deferred ||
+        IsPlannedIntoCaller(model, subgraph_allocations, subgraph_idx)) {
+      continue;
+    }
+    if (subgraph_idx == 0 || CountSubgraphCallers(model, subgraph_idx) == 0) {
+      allocations.plan_buffer = memory_allocator_->GetHeadBuffer();
+    } else {
+      allocations.plan_buffer = shared_buffer;
+      shared_buffer += AlignSizeUp(allocations.plan_bytes, kBufferAlignment);
+    }
+    TF_LITE_ENSURE_STATUS(PlanSubgraphTree(model, subgraph_allocations,
+                                           *scratch_buffer_handles,
+                                           subgraph_idx,
+                                           /*size_only=*/false, /*depth=*/0));
+  }
+
+  // The head is used to store memory plans for one model at a time during the
+  // model preparation stage, and is re-purposed to store scratch buffer handles
+  // during model invocation. The head must be as large as the greater of the
+  // largest model memory plan's size and the total space required for all
+  // scratch buffer handles.
+  if (max_head_buffer_usage_ < head_usage) {
+    max_head_buffer_usage_ = head_usage;
+  }
+  TF_LITE_ENSURE_STATUS(memory_allocator_->SetHeadBufferSize(
+      max_head_buffer_usage_, kBufferAlignment));
+
+  for (int subgraph_idx = 0; subgraph_idx < subgraphs_size; ++subgraph_idx) {
+    if (subgraph_allocations[subgraph_idx].deferred) {
+      continue;
+    }
+    TF_LITE_ENSURE_STATUS(
+        AllocateVariables(model->subgraphs()->Get(subgraph_idx),
+                          subgraph_allocations[subgraph_idx].tensors));
+  }
+  TF_LITE_ENSURE_STATUS(ResolveNodeTensors(model, subgraph_allocations));
+  model_is_allocating_ = false;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::ResolveNodeTensors(
+    const Model* model, SubgraphAllocations* subgraph_allocations) {
   for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
        subgraph_idx++) {
-    const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
-    TFLITE_DCHECK(subgraph != nullptr);
+    // The shapes of a deferred subgraph are only final once it is prepared.
+    if (subgraph_allocations[subgraph_idx].deferred) {
+      continue;
+    }
+    TF_LITE_ENSURE_STATUS(
+        ResolveSubgraphNodeTensors(model, subgraph_allocations, subgraph_idx));
+  }
+  return kTfLiteOk;
+}
 
-    TF_LITE_ENSURE_STATUS(AllocateScratchBufferHandles(
-        scratch_buffer_handles, scratch_buffer_request_count_));
-    TF_LITE_ENSURE_STATUS(CommitStaticMemoryPlan(
-        model, subgraph_allocations[subgraph_idx].tensors,
-        subgraph_allocations[subgraph_idx].node_and_registrations,
-        *scratch_buffer_handles, subgraph_idx));
-    TF_LITE_ENSURE_STATUS(AllocateVariables(
-        subgraph, subgraph_allocations[subgraph_idx].tensors));
+TfLiteStatus MicroAllocator::ResolveSubgraphNodeTensors(
+    const Model* model, SubgraphAllocations* subgraph_allocations,
+    int subgraph_idx) {
+  const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+  const size_t tensors_size = subgraph->tensors()->size();
+  TfLiteEvalTensor* eval_tensors = subgraph_allocations[subgraph_idx].tensors;
+
+  const RuntimeShape* shapes = internal::AllocateTensorShapes(
+      memory_allocator_, eval_tensors, tensors_size);
+  if (shapes == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate memory for the tensor shapes "
+                         "of subgraph %d.",
+                         subgraph_idx);
+    return kTfLiteError;
+  }
+
+  // The tables follow the operator inputs and outputs of the flatbuffer,
+  // which the node inputs and outputs are built from.
+  for (size_t i = 0; i < NumSubgraphOperators(subgraph); ++i) {
+    const auto* op = subgraph->operators()->Get(i);
+    TfLiteIntArray* inputs = nullptr;
+    TfLiteIntArray* outputs = nullptr;
+    if (op->inputs() != nullptr) {
+      TF_LITE_ENSURE_STATUS(
+          FlatBufferVectorToTfLiteTypeArray(op->inputs(), &inputs));
+    }
+    if (op->outputs() != nullptr) {
+      TF_LITE_ENSURE_STATUS(
+          FlatBufferVectorToTfLiteTypeArray(op->outputs(), &outputs));
+    }
+    NodeAndRegistration* node =
+        &subgraph_allocations[subgraph_idx].node_and_registrations[i];
+    if (internal::ResolveNodeTensors(memory_allocator_, inputs, outputs,
+                                     eval_tensors, shapes, tensors_size,
+                                     node) != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to allocate memory for the tensor tables "
+                           "of node %d in subgraph %d.",
+                           i, subgraph_idx);
+      return kTfLiteError;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::CommitDeferredSubgraph(
+    const Model* model, SubgraphAllocations* subgraph_allocations,
+    int subgraph_idx) {
+  SubgraphAllocations& allocations = subgraph_allocations[subgraph_idx];
+  TF_LITE_ENSURE(error_reporter_, allocations.deferred);
+  // The block has to be allocated while the temp section is empty, so the
+  // plan is sized first.
+  TF_LITE_ENSURE_STATUS(PlanSubgraphTree(
+      model, subgraph_allocations, /*scratch_buffer_handles=*/nullptr,
+      subgraph_idx, /*size_only=*/true, /*depth=*/0));
+  allocations.plan_buffer = memory_allocator_->AllocateFromTail(
+      allocations.plan_bytes, kBufferAlignment);
+  if (allocations.plan_buffer == nullptr) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter_,
+        "Arena size is too small for the buffers of deferred subgraph %d. "
+        "Needed %u but only %u was available.",
+        subgraph_idx, allocations.plan_bytes,
+        memory_allocator_->GetAvailableMemory(kBufferAlignment));
+    return kTfLiteError;
+  }
+  TF_LITE_ENSURE_STATUS(PlanSubgraphTree(
+      model, subgraph_allocations, /*scratch_buffer_handles=*/nullptr,
+      subgraph_idx, /*size_only=*/false, /*depth=*/0));
+  TF_LITE_ENSURE_STATUS(AllocateVariables(
+      model->subgraphs()->Get(subgraph_idx), allocations.tensors));
+  TF_LITE_ENSURE_STATUS(
+      ResolveSubgraphNodeTensors(model, subgraph_allocations, subgraph_idx));
+  allocations.deferred = false;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::AllocateDeferredScratchBuffer(
+    size_t bytes, ScratchBufferHandle** scratch_buffer_handles,
+    int* buffer_idx) {
+  const size_t handles_size = scratch_buffer_count();
+  ScratchBufferHandle* handles = reinterpret_cast<ScratchBufferHandle*>(
+      memory_allocator_->AllocateFromTail(
+          sizeof(ScratchBufferHandle) * (handles_size + 1),
+          alignof(ScratchBufferHandle)));
+  uint8_t* buffer =
+      memory_allocator_->AllocateFromTail(bytes, kBufferAlignment);
+  if (handles == nullptr || buffer == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate a %d byte scratch buffer for a "
+                         "deferred subgraph.",
+                         bytes);
+    return kTfLiteError;
+  }
+  for (size_t i = 0; i < handles_size; ++i) {
+    handles[i] = (*scratch_buffer_handles)[i];
+  }
+  handles[handles_size].data = buffer;
+  *scratch_buffer_handles = handles;
+  *buffer_idx = handles_size;
+  ++deferred_scratch_buffer_count_;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::AllocateDispatchTables(
+    const Model* model, SubgraphAllocations* subgraph_allocations) {
+  for (size_t subgraph_idx = 0; subgraph_idx < model->subgraphs()->size();
+       subgraph_idx++) {
+    const size_t operators_size = NumSubgraphOperators(model, subgraph_idx);
+    NodeDispatch* dispatch_table = reinterpret_cast<NodeDispatch*>(
+        memory_allocator_->AllocateFromTail(
+            sizeof(NodeDispatch) * operators_size,
+            alignof(NodeDispatch)));
+    if (dispatch_table == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to allocate memory for the dispatch table "
+                           "of subgraph %d.",
+                           subgraph_idx);
+      return kTfLiteError;
+    }
+    NodeAndRegistration* node_and_registrations =
+        subgraph_allocations[subgraph_idx].node_and_registrations;
+    for (size_t i = 0; i < operators_size; ++i) {
+      dispatch_table[i].invoke = node_and_registrations[i].registration->invoke;
+      dispatch_table[i].node = &node_and_registrations[i].node;
+    }
+    subgraph_allocations[subgraph_idx].dispatch_table = dispatch_table;
+    subgraph_allocations[subgraph_idx].dispatch_table_size =
+        static_cast<int>(operators_size);
   }
-  model_is_allocating_ = false;
   return kTfLiteOk;
 }
 
@@ -879,6 +1594,7 @@ TfLiteStatus MicroAllocator::RequestScratchBufferInArena(size_t bytes,
   // allocating:
   current_request->bytes = bytes;
   current_request->node_idx = kUnassignedScratchBufferRequestIndex;
+  current_request->subgraph_idx = subgraph_idx;
 
   // Assign the current request index to the out-param:
   *buffer_idx = scratch_buffer_request_count_;
@@ -917,10 +1633,56 @@ TfLiteStatus MicroAllocator::FinishPrepareNodeAllocations(int node_id) {
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroAllocator::AcquireNonPersistentArena() {
+  if (shared_arena_ == nullptr || shared_arena_->owner == this) {
+    return kTfLiteOk;
+  }
+  if (shared_arena_->owner != nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "MicroAllocator: Shared non-persistent arena is in "
+                         "use by another allocator");
+    return kTfLiteError;
+  }
+  shared_arena_->owner = this;
+  return kTfLiteOk;
+}
+
+void MicroAllocator::ReleaseNonPersistentArena() {
+  if (shared_arena_ != nullptr && shared_arena_->owner == this) {
+    shared_arena_->owner = nullptr;
+  }
+}
+
+bool MicroAllocator::HoldsNonPersistentArena() const {
+  return shared_arena_ == nullptr || shared_arena_->owner == this;
+}
+
 size_t MicroAllocator::used_bytes() const {
   return memory_allocator_->GetUsedBytes();
 }
 
+ArenaRequirements MicroAllocator::GetArenaRequirements() const {
+  ArenaRequirements requirements;
+  requirements.head_bytes = memory_allocator_->GetHeadUsedBytes();
+  requirements.tail_bytes = memory_allocator_->GetTailUsedBytes();
+  requirements.temp_peak_bytes = memory_allocator_->GetPeakTempBytes();
+  requirements.non_persistent_bytes =
+      memory_allocator_->GetPeakNonPersistentBytes();
+  // The tail is aligned down from the end of the arena, so an arena size that
+  // is not a multiple of the alignment could lose bytes to padding.
+  requirements.arena_bytes =
+      AlignSizeUp(memory_allocator_->GetPeakUsedBytes(), kBufferAlignment);
+  return requirements;
+}
+
+uint8_t* MicroAllocator::planned_head_buffer() const {
+  return memory_allocator_->GetHeadBuffer();
+}
+
+size_t MicroAllocator::planned_head_bytes() const {
+  return memory_allocator_->GetHeadUsedBytes();
+}
+
 TfLiteStatus MicroAllocator::AllocateNodeAndRegistrations(
     const Model* model, SubgraphAllocations* subgraph_allocations) {
   TFLITE_DCHECK(subgraph_allocations != nullptr);
@@ -944,6 +1706,13 @@ TfLiteStatus MicroAllocator::AllocateNodeAndRegistrations(
       return kTfLiteError;
     }
     subgraph_allocations[subgraph_idx].node_and_registrations = output;
+    subgraph_allocations[subgraph_idx].schedule = nullptr;
+    subgraph_allocations[subgraph_idx].dispatch_table = nullptr;
+    subgraph_allocations[subgraph_idx].dispatch_table_size = 0;
+    subgraph_allocations[subgraph_idx].deferred = false;
+    subgraph_allocations[subgraph_idx].deferred_failed = false;
+    subgraph_allocations[subgraph_idx].plan_buffer = nullptr;
+    subgraph_allocations[subgraph_idx].plan_bytes = 0;
   }
   return kTfLiteOk;
 }
@@ -996,6 +1765,11 @@ TfLiteTensor* MicroAllocator::AllocateTempTfLiteTensor(
   TfLiteTensor* tensor =
       reinterpret_cast<TfLiteTensor*>(memory_allocator_->AllocateTemp(
           sizeof(TfLiteTensor), alignof(TfLiteTensor)));
+  // Deferred subgraphs are prepared while the model is invoked, so running out
+  // of temp memory has to fail the kernel instead of the process.
+  if (tensor == nullptr) {
+    return nullptr;
+  }
 
   // Populate any fields from the flatbuffer, since this TfLiteTensor struct is
   // allocated in the temp section of the arena, ensure that additional
@@ -1109,10 +1883,11 @@ ErrorReporter* MicroAllocator::error_reporter() const {
 }
 
 TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
-    const Model* model, TfLiteEvalTensor* eval_tensors,
-    NodeAndRegistration* node_and_registrations,
-    ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx) {
-  size_t head_usage = 0;
+    const Model* model, SubgraphAllocations* subgraph_allocations,
+    ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx,
+    bool size_only) {
+  SubgraphAllocations& allocations = subgraph_allocations[subgraph_idx];
+  TfLiteEvalTensor* eval_tensors = allocations.tensors;
   // Create static memory plan
   // 1. Calculate AllocationInfo to know the lifetime of each tensor/buffer.
   // 2. Add them into the planner (such as the GreedyMemoryPlanner).
@@ -1124,8 +1899,14 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   // function.
 
   const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+  // The scratch buffer requests of the prepare phase are only available in
+  // the head before the first plan is committed. Deferred subgraphs allocate
+  // their scratch buffers separately.
+  const size_t scratch_buffer_count =
+      allocations.deferred ? 0 : scratch_buffer_request_count_;
   size_t allocation_info_count =
-      subgraph->tensors()->size() + scratch_buffer_request_count_;
+      subgraph->tensors()->size() + scratch_buffer_count +
+      CountSubgraphsPlannedInto(model, subgraph, subgraph_allocations);
   size_t bytes = sizeof(AllocationInfo) * allocation_info_count;
 
   // Allocate an array of AllocationInfo structs from the temp section. This
@@ -1180,60 +1961,80 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
   operator_info,
 #endif
   subgraph->tensors()->size(),
-                                scratch_buffer_request_count_, error_reporter_);
+                                scratch_buffer_count, error_reporter_);
+  builder.SetSchedule(allocations.schedule);
+  builder.SetPinIoBuffers(pin_model_io_buffers_ && subgraph_idx == 0);
 
+  // Offline planned offsets only describe the first subgraph.
   const int32_t* offline_planner_offsets = nullptr;
+  if (subgraph_idx == 0) {
+    TF_LITE_ENSURE_STATUS(
+        builder.GetOfflinePlannedOffsets(model, &offline_planner_offsets));
+  }
   TF_LITE_ENSURE_STATUS(
-      builder.GetOfflinePlannedOffsets(model, &offline_planner_offsets));
-  TF_LITE_ENSURE_STATUS(
-      builder.AddTensors(subgraph, 
-#ifdef TOPOLOGY_MEM_PLANNER
-      model,
-#endif // TOPOLOGY_MEM_PLANNER
-      offline_planner_offsets, eval_tensors));
-
-  internal::ScratchBufferRequest* scratch_buffer_requests =
-      GetScratchBufferRequests();
+      builder.AddTensors(subgraph, model, offline_planner_offsets,
+                         eval_tensors));
 
-  TF_LITE_ENSURE_STATUS(builder.AddScratchBuffers(scratch_buffer_requests,
-                                                  scratch_buffer_handles));
+  if (!allocations.deferred) {
+    internal::ScratchBufferRequest* scratch_buffer_requests =
+        GetScratchBufferRequests();
 
-  // Remaining arena size that memory planner can use for calculating offsets.
-  size_t remaining_arena_size =
-      memory_allocator_->GetAvailableMemory(kBufferAlignment);
+    TF_LITE_ENSURE_STATUS(builder.AddScratchBuffers(
+        scratch_buffer_requests, scratch_buffer_handles, subgraph_idx));
+  }
+  TF_LITE_ENSURE_STATUS(
+      builder.AddInvokedSubgraphs(model, subgraph, subgraph_allocations));
+
+  // Only hand the memory planner the scratch it needs for the buffers that are
+  // planned, so that the peak temp usage reported by GetArenaRequirements()
+  // does not depend on the size of the arena.
+  int planned_buffer_count = 0;
+  for (size_t i = 0; i < allocation_info_count; ++i) {
+    if (allocation_info[i].needs_allocating) {
+      ++planned_buffer_count;
+    }
+  }
+#ifndef TOPOLOGY_MEM_PLANNER
+  const size_t planner_arena_size =
+      GreedyMemoryPlanner::scratch_buffer_size(planned_buffer_count);
+#else
+  const size_t planner_arena_size =
+      TopologicalMemoryPlanner::scratch_buffer_size(planned_buffer_count,
+                                                    operator_info_count);
+#endif
   uint8_t* planner_arena =
-      memory_allocator_->AllocateTemp(remaining_arena_size, kBufferAlignment);
+      memory_allocator_->AllocateTemp(planner_arena_size, kBufferAlignment);
   TF_LITE_ENSURE(error_reporter_, planner_arena != nullptr);
 #ifndef TOPOLOGY_MEM_PLANNER
-  GreedyMemoryPlanner planner(planner_arena, remaining_arena_size);
+  GreedyMemoryPlanner planner(planner_arena, planner_arena_size);
   TF_LITE_ENSURE_STATUS(CreatePlan(error_reporter_, &planner, allocation_info,
                                    allocation_info_count));
 #else 
-  TopologicalMemoryPlanner planner(planner_arena, remaining_arena_size, operator_info_count);
+  TopologicalMemoryPlanner planner(planner_arena, planner_arena_size, operator_info_count);
   TF_LITE_ENSURE_STATUS(CreatePlanTopological(error_reporter_, &planner, allocation_info,
                                    allocation_info_count, operator_info, operator_info_count));
 #endif
   
-
-  // Reset all temp allocations used above:
-  memory_allocator_->ResetTempAllocations();
-
-  size_t actual_available_arena_size =
-      memory_allocator_->GetAvailableMemory(kBufferAlignment);
-
-  // Make sure we have enough arena size.
-  if (planner.GetMaximumMemorySize() > actual_available_arena_size) {
-    TF_LITE_REPORT_ERROR(
-        error_reporter_,
-        "Arena size is too small for all buffers. Needed %u but only "
-        "%u was available.",
-        planner.GetMaximumMemorySize(), actual_available_arena_size);
+  const size_t plan_bytes = planner.GetMaximumMemorySize();
+  if (size_only) {
+    memory_allocator_->ResetTempAllocations();
+    allocations.plan_bytes = plan_bytes;
+    return kTfLiteOk;
+  }
+  if (allocations.plan_buffer == nullptr ||
+      plan_bytes > allocations.plan_bytes) {
+    memory_allocator_->ResetTempAllocations();
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Subgraph %d needs %u bytes for its buffers but only "
+                         "%u were reserved.",
+                         subgraph_idx, plan_bytes, allocations.plan_bytes);
     return kTfLiteError;
   }
+
   // Commit the plan.
   TF_LITE_ENSURE_STATUS(CommitPlan(error_reporter_, &planner,
-                                   memory_allocator_->GetHeadBuffer(),
-                                   allocation_info, allocation_info_count));
+                                   allocations.plan_buffer, allocation_info,
+                                   allocation_info_count));
 #ifdef TF_LITE_SHOW_MEMORY_USE
   planner.PrintMemoryPlan();
 #endif
@@ -1241,26 +2042,54 @@ TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
 #ifdef TOPOLOGY_MEM_PLANNER
   // update node->reverse after Topological memory allocator
   for(size_t i=0; i < operator_info_count; i++) {
-    TfLiteNode* node = &(node_and_registrations[i].node);
+    TfLiteNode* node = &(allocations.node_and_registrations[i].node);
     node->reverse = planner.GetOperatorRequirementsReverse(error_reporter_, i);
   }
 #endif
-  head_usage = planner.GetMaximumMemorySize();
-  printf("planner memory usage: %zu\n", head_usage);
-  // The head is used to store memory plans for one model at a time during the
-  // model preparation stage, and is re-purposed to store scratch buffer handles
-  // during model invocation. The head must be as large as the greater of the
-  // largest model memory plan's size and the total space required for all
-  // scratch buffer handles.
-  if (max_head_buffer_usage_ < head_usage) {
-    max_head_buffer_usage_ = head_usage;
+  if (!allocations.deferred) {
+    printf("planner memory usage: %zu\n", plan_bytes);
   }
 
-  // The head is used for storing scratch buffer allocations before finalizing a
-  // memory plan in this function. Ensure that the head is set to the largest
-  // memory plan sent through the allocator:
-  TF_LITE_ENSURE_STATUS(memory_allocator_->SetHeadBufferSize(
-      max_head_buffer_usage_, kBufferAlignment));
+  // Reset all temp allocations used above:
+  memory_allocator_->ResetTempAllocations();
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::PlanSubgraphTree(
+    const Model* model, SubgraphAllocations* subgraph_allocations,
+    ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx,
+    bool size_only, int depth) {
+  // A subgraph that invokes itself would never end the recursion.
+  if (depth >= static_cast<int>(model->subgraphs()->size())) {
+    TF_LITE_REPORT_ERROR(error_reporter_, "Subgraph %d invokes itself.",
+                         subgraph_idx);
+    return kTfLiteError;
+  }
+  if (!size_only) {
+    TF_LITE_ENSURE_STATUS(CommitStaticMemoryPlan(
+        model, subgraph_allocations, scratch_buffer_handles, subgraph_idx,
+        /*size_only=*/false));
+  }
+  const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+  const uint32_t operators_size = NumSubgraphOperators(subgraph);
+  for (uint32_t i = 0; i < operators_size; ++i) {
+    int invoked[kMaxInvokedSubgraphs];
+    bool exclusive;
+    const int invoked_size =
+        GetInvokedSubgraphs(subgraph->operators()->Get(i), invoked, &exclusive);
+    for (int j = 0; j < invoked_size; ++j) {
+      if (IsPlannedIntoCaller(model, subgraph_allocations, invoked[j])) {
+        TF_LITE_ENSURE_STATUS(PlanSubgraphTree(
+            model, subgraph_allocations, scratch_buffer_handles, invoked[j],
+            size_only, depth + 1));
+      }
+    }
+  }
+  if (size_only) {
+    TF_LITE_ENSURE_STATUS(CommitStaticMemoryPlan(
+        model, subgraph_allocations, scratch_buffer_handles, subgraph_idx,
+        /*size_only=*/true));
+  }
   return kTfLiteOk;
 }
 
@@ -21,8 +21,10 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/micro/compatibility.h"
 #include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/micro_node.h"
 #include "tensorflow/lite/micro/simple_memory_allocator.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/schema/schema_utils.h"
@@ -42,6 +44,30 @@ TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
     const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
     ErrorReporter* error_reporter, TfLiteTensor* result);
 
+// Allocates a RuntimeShape for each of the `tensors_size` eval tensors from the
+// tail of `allocator`, followed by one empty shape that stands for missing
+// optional tensors. Returns nullptr if the allocation failed.
+RuntimeShape* AllocateTensorShapes(SimpleMemoryAllocator* allocator,
+                                   const TfLiteEvalTensor* eval_tensors,
+                                   size_t tensors_size);
+
+// Updates `shapes`, as returned by AllocateTensorShapes(), to the current dims
+// of `eval_tensors`.
+void UpdateTensorShapes(const TfLiteEvalTensor* eval_tensors,
+                        size_t tensors_size, RuntimeShape* shapes);
+
+// Sets up the `eval_tensors` and `eval_shapes` tables of `node` from the tail
+// of `allocator`, for the tensors listed in `inputs` and `outputs`.
+// `eval_tensors` and `shapes` are indexed by tensor index, with `shapes` as
+// returned by AllocateTensorShapes().
+TfLiteStatus ResolveNodeTensors(SimpleMemoryAllocator* allocator,
+                                const TfLiteIntArray* inputs,
+                                const TfLiteIntArray* outputs,
+                                TfLiteEvalTensor* eval_tensors,
+                                const RuntimeShape* shapes,
+                                size_t tensors_size,
+                                NodeAndRegistration* node);
+
 // Holds placeholder information for a scratch buffer request from a kernel.
 // This struct is only used during the model prepare stage. Each request from a
 // kernel is stored in the head section. During the prepare stage, the head
@@ -60,15 +86,12 @@ typedef struct {
   // determine the lifetime of the buffer. In AllocationInfo, this buffer will
   // have `before` = node_idx and `after` = node_idx.
   int node_idx;
+  // Subgraph of the node, whose memory plan the buffer is part of.
+  int subgraph_idx;
 } ScratchBufferRequest;
 
 }  // namespace internal
 
-typedef struct {
-  TfLiteNode node;
-  const TfLiteRegistration* registration;
-} NodeAndRegistration;
-
 // Holds a pointer to a buffer for a scratch buffer requested by a kernel during
 // the model prepare stage. This struct is allocated in-place and allows for
 // quick pointer-indexed lookup for speed during model inference.
@@ -77,13 +100,95 @@ typedef struct {
   uint8_t* data;
 } ScratchBufferHandle;
 
+class MicroAllocator;
+
+// Describes a non-persistent arena region that is shared by several
+// MicroAllocator instances. Each allocator keeps its persistent (tail) data in
+// a private buffer and plans its non-persistent (head) buffers into this
+// region, so models that never run at the same time (e.g. a cascade of models
+// invoked back to back) only need a region as large as their biggest plan.
+//
+// Activations are not preserved between allocators: the contents of input and
+// output tensors are only valid until another allocator sharing the region
+// allocates or invokes. `owner` tracks which allocator currently uses the
+// region and must be nullptr when the struct is handed to
+// MicroAllocator::Create().
+typedef struct {
+  uint8_t* buffer;
+  size_t size;
+  const MicroAllocator* owner;
+} SharedNonPersistentArena;
+
+// Execution order of the operators of a subgraph, grouped in levels. An
+// operator only depends on operators of earlier levels, so the operators of
+// one level can run concurrently. Built by MicroGraph::BuildNodeSchedules().
+// When present, the memory plan keeps the buffers of all operators of a level
+// apart, and operators must be invoked level by level.
+typedef struct {
+  // Number of operators in the subgraph.
+  int nodes_size;
+  // Level of each operator, indexed by operator index.
+  int* node_levels;
+  // Operator indices ordered by level. The operators of level `l` are stored in
+  // [level_starts[l], level_starts[l + 1]).
+  int* level_nodes;
+  int* level_starts;
+  int levels_size;
+  // Invoke status of each operator, written while a level runs concurrently.
+  TfLiteStatus* node_statuses;
+} NodeSchedule;
+
+// Entry of the dispatch table of a subgraph: the invoke function of an
+// operator's registration next to the operator's node, so that the invoke loop
+// only walks a single array.
+typedef struct {
+  TfLiteStatus (*invoke)(TfLiteContext* context, TfLiteNode* node);
+  TfLiteNode* node;
+} NodeDispatch;
+
 // Stores all per-subgraph allocations. This includes the node and registration
 // array, tensor list and scratch buffer handles for each subgraph.
 typedef struct {
   NodeAndRegistration* node_and_registrations;
   TfLiteEvalTensor* tensors;
+  // Only set when inter-op parallelism is enabled, nullptr otherwise.
+  NodeSchedule* schedule;
+  // One entry per operator in execution order. Set by
+  // AllocateDispatchTables(), nullptr before.
+  NodeDispatch* dispatch_table;
+  int dispatch_table_size;
+  // Set for subgraphs whose operators are initialized, prepared and planned
+  // the first time the subgraph is invoked. FinishModelAllocation() skips
+  // them, and their tensors have no buffers until CommitDeferredSubgraph().
+  bool deferred;
+  // Set once preparing a deferred subgraph failed. Its operators may already
+  // be initialized, so it is not prepared again and FreeSubgraphs() frees it.
+  bool deferred_failed;
+  // Block of the non-persistent arena that the memory plan of the subgraph is
+  // committed to, and its size. The block also holds the plans of the
+  // subgraphs planned into it, see MicroAllocator::PlanSubgraphTree().
+  uint8_t* plan_buffer;
+  size_t plan_bytes;
 } SubgraphAllocations;
 
+// Arena sizes needed by everything a MicroAllocator has allocated so far, see
+// MicroAllocator::GetArenaRequirements(). The sizes assume an arena whose start
+// and size are multiples of 16 bytes.
+typedef struct {
+  // Size of the head section holding the committed memory plan.
+  size_t head_bytes;
+  // Size of the tail section holding the persistent allocations.
+  size_t tail_bytes;
+  // Largest temp section used on top of the head, e.g. by the memory planner
+  // or by the TfLiteTensors handed to kernels during Prepare.
+  size_t temp_peak_bytes;
+  // Largest head and temp sections used together. This is the smallest
+  // non-persistent buffer that works when the arena is split.
+  size_t non_persistent_bytes;
+  // Smallest single arena that works for the same model and kernels.
+  size_t arena_bytes;
+} ArenaRequirements;
+
 // Allocator responsible for allocating memory for all intermediate tensors
 // necessary to invoke a model.
 //
@@ -123,6 +228,16 @@ class MicroAllocator {
   static MicroAllocator* Create(SimpleMemoryAllocator* memory_allocator,
                                 ErrorReporter* error_reporter);
 
+  // Creates a MicroAllocator instance that allocates persistent data from
+  // `persistent_arena` and plans all non-persistent buffers into the region
+  // described by `shared_arena`. The same `shared_arena` can be passed to any
+  // number of allocators; it must be at least as large as the largest memory
+  // plan among them. See SharedNonPersistentArena for the usage constraints.
+  static MicroAllocator* Create(uint8_t* persistent_arena,
+                                size_t persistent_arena_size,
+                                SharedNonPersistentArena* shared_arena,
+                                ErrorReporter* error_reporter);
+
   // Allocates internal resources required for model inference for each subgraph
   // from the arena.
   //
@@ -136,7 +251,9 @@ class MicroAllocator {
 
   // Finish allocating internal resources required for model inference.
   //
-  // -Plan the memory for activation tensors and scratch buffers.
+  // -Plan the memory for activation tensors and scratch buffers. Subgraphs
+  //  invoked by control flow operators are planned into the plan of their
+  //  caller, see PlanSubgraphTree().
   // -Update eval tensors for each subgraph based on planned offsets.
   // -Allocate scratch buffer handles array and update based on planned offsets.
   //
@@ -150,6 +267,43 @@ class MicroAllocator {
       const Model* model, SubgraphAllocations* subgraph_allocations,
       ScratchBufferHandle** scratch_buffer_handles);
 
+  // Plans the buffers of a deferred subgraph once its operators are prepared,
+  // which happens while the model is invoked. The head holds the activations
+  // of the invoking subgraph at that point, so the activations of the
+  // deferred subgraph get a block of the persistent section of their own.
+  // Also allocates its variable tensors and resolves its node tensors, and
+  // clears the deferred flag.
+  TfLiteStatus CommitDeferredSubgraph(const Model* model,
+                                      SubgraphAllocations* subgraph_allocations,
+                                      int subgraph_idx);
+
+  // Allocates a scratch buffer requested while a deferred subgraph is
+  // prepared. The buffer is taken from the persistent section instead of
+  // being planned, and its handle is appended to `scratch_buffer_handles`,
+  // which is moved to a larger array.
+  TfLiteStatus AllocateDeferredScratchBuffer(
+      size_t bytes, ScratchBufferHandle** scratch_buffer_handles,
+      int* buffer_idx);
+
+  // Resolves the eval tensors of every node of every subgraph and caches their
+  // shapes, see NodeAndRegistration::eval_tensors. Called by
+  // FinishModelAllocation(), and by execution contexts for their own copies of
+  // the nodes.
+  TfLiteStatus ResolveNodeTensors(const Model* model,
+                                  SubgraphAllocations* subgraph_allocations);
+
+  // Builds the dispatch table of every subgraph from its nodes and
+  // registrations, which must all be set. Called once the model allocation is
+  // finished, and by execution contexts for their own copies of the nodes.
+  TfLiteStatus AllocateDispatchTables(
+      const Model* model, SubgraphAllocations* subgraph_allocations);
+
+  // Plans the input and output tensors of the model (those of the first
+  // subgraph) so that they never share memory with any other non-persistent
+  // buffer, which lets them be filled and read while the model is running.
+  // Must be called before FinishModelAllocation().
+  void PinModelIoBuffers() { pin_model_io_buffers_ = true; }
+
   // Allocates a TfLiteTensor struct and populates the returned value with
   // properties from the model flatbuffer. This struct is allocated from
   // persistent arena memory is only guaranteed for the lifetime of the
@@ -176,6 +330,12 @@ class MicroAllocator {
   // AllocateTfLiteTensor()).
   virtual void ResetTempAllocations();
 
+  // Returns true if there are temporary allocations to reset. Kernels that
+  // only use TfLiteEvalTensor during Eval make none.
+  bool HasTempAllocations() const {
+    return memory_allocator_->HasTempAllocations();
+  }
+
   // Allocates persistent buffer which has the same life time as the allocator.
   // The memory is immediately available and is allocated from the tail of the
   // arena.
@@ -194,10 +354,46 @@ class MicroAllocator {
   // next node prepare block.
   TfLiteStatus FinishPrepareNodeAllocations(int node_id);
 
+  // Claims the shared non-persistent arena for this allocator. Allocation and
+  // invocation must hold the arena for their whole duration. Returns an error
+  // if another allocator currently holds it. Always succeeds for allocators
+  // that do not use a SharedNonPersistentArena.
+  TfLiteStatus AcquireNonPersistentArena();
+
+  // Releases the shared non-persistent arena if it is held by this allocator.
+  void ReleaseNonPersistentArena();
+
+  // Returns true if this allocator currently holds the shared non-persistent
+  // arena. Allocators without a shared arena always hold their own.
+  bool HoldsNonPersistentArena() const;
+
   // Returns the arena usage in bytes, only available after
   // `FinishModelAllocation`. Otherwise, it will return 0.
   size_t used_bytes() const;
 
+  // Returns the arena sizes the allocations made so far actually needed. The
+  // peak temp usage during model allocation is usually larger than the head
+  // and tail left afterwards, so `used_bytes()` can underestimate the arena.
+  // Callers can size the arena of a first run generously, read these
+  // requirements after `FinishModelAllocation` (or after the first invoke, for
+  // kernels that use temp memory in Eval) and then allocate exactly
+  // `arena_bytes` on the device.
+  ArenaRequirements GetArenaRequirements() const;
+
+  // Returns the start of the head section holding the committed memory plan.
+  // Only meaningful after `FinishModelAllocation`.
+  uint8_t* planned_head_buffer() const;
+
+  // Returns the length in bytes of the head section holding the committed
+  // memory plan. Only meaningful after `FinishModelAllocation`.
+  size_t planned_head_bytes() const;
+
+  // Returns the number of scratch buffer handles allocated by
+  // `FinishModelAllocation` and `AllocateDeferredScratchBuffer`.
+  size_t scratch_buffer_count() const {
+    return scratch_buffer_request_count_ + deferred_scratch_buffer_count_;
+  }
+
   // Converts a flatbuffer int32_t array to a TfLiteIntArray, accounting for
   // endiannes.
   TfLiteStatus FlatBufferVectorToTfLiteTypeArray(
@@ -243,17 +439,38 @@ class MicroAllocator {
   ErrorReporter* error_reporter() const;
 
  private:
-  // Commits a memory plan for all non-persistent buffer allocations in the
-  // 'head' section of the memory arena. The eval_tensors pointer is the list of
-  // pre-allocated TfLiteEvalTensor structs that will point to the buffers that
-  // will be allocated into the head section in this function call. The
-  // scratch_buffer_handles pointer is the array of pre-allocated
-  // ScratchBufferHandle structs that will point to allocated buffers also in
-  // the head section.
+  // Commits a memory plan for all non-persistent buffer allocations of a
+  // subgraph to its `plan_buffer`. The tensors of the subgraph in
+  // `subgraph_allocations` and the scratch_buffer_handles of the scratch
+  // buffers it requested will point into that buffer after this call. When
+  // the subgraph has a schedule, buffer lifetimes are measured in schedule
+  // levels instead of operator indices.
+  //
+  // Subgraphs planned into the subgraph only need their `plan_bytes` here, and
+  // are committed separately. With `size_only`, the plan is only created to set
+  // the `plan_bytes` of the subgraph.
   virtual TfLiteStatus CommitStaticMemoryPlan(
-      const Model* model, TfLiteEvalTensor* eval_tensors,
-      NodeAndRegistration* node_and_registrations,
-      ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx);
+      const Model* model, SubgraphAllocations* subgraph_allocations,
+      ScratchBufferHandle* scratch_buffer_handles, int subgraph_idx,
+      bool size_only);
+
+  // Sizes or commits the memory plans of `subgraph_idx` and of the subgraphs
+  // planned into it, i.e. the subgraphs that only one control flow operator
+  // of it invokes. Those only need their buffers while the operator runs, so
+  // each operator gets a block of the plan that lives for the time of the
+  // operator, and subgraphs of which only one runs, like the branches of IF,
+  // share that block. Sizing works bottom-up and committing top-down, as a
+  // block has to be sized before its caller is planned and placed before its
+  // subgraphs are committed.
+  TfLiteStatus PlanSubgraphTree(const Model* model,
+                                SubgraphAllocations* subgraph_allocations,
+                                ScratchBufferHandle* scratch_buffer_handles,
+                                int subgraph_idx, bool size_only, int depth);
+
+  // Resolves the node tensors of a single subgraph, see ResolveNodeTensors().
+  TfLiteStatus ResolveSubgraphNodeTensors(
+      const Model* model, SubgraphAllocations* subgraph_allocations,
+      int subgraph_idx);
 
   // Allocates an array of ScratchBufferHandle structs in the tail section for a
   // given number of handles.
@@ -282,10 +499,21 @@ class MicroAllocator {
   // section when a model is allocating.
   size_t scratch_buffer_request_count_ = 0;
 
+  // Number of scratch buffers allocated by AllocateDeferredScratchBuffer().
+  // Their handles follow the ones of the planned scratch buffers.
+  size_t deferred_scratch_buffer_count_ = 0;
+
   // Holds the byte length of the memory plan with the largest head usage. Used
   // to ensure that multi-tenant allocations can share the head for buffers.
   size_t max_head_buffer_usage_ = 0;
 
+  // Non-persistent region shared with other allocators, or nullptr if the head
+  // lives in this allocator's own arena.
+  SharedNonPersistentArena* shared_arena_ = nullptr;
+
+  // Set by PinModelIoBuffers().
+  bool pin_model_io_buffers_ = false;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
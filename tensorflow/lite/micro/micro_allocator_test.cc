@@ -18,6 +18,7 @@ limitations under the License.
 #include <cstdint>
 
 #include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/simple_memory_allocator.h"
@@ -38,6 +39,12 @@ constexpr int t4 = 4;
 constexpr int t5 = 5;
 
 void VerifyMockTfLiteTensor(TfLiteTensor* tensor, bool is_variable = false) {
+  // A persistent tensor may fail to fit in the arena, so bail out instead of
+  // dereferencing nullptr and aborting the remaining tests.
+  TF_LITE_MICRO_EXPECT(nullptr != tensor);
+  if (tensor == nullptr) {
+    return;
+  }
   TF_LITE_MICRO_EXPECT_EQ(kTfLiteInt32, tensor->type);
   TF_LITE_MICRO_EXPECT_EQ(1, tensor->dims->size);
   TF_LITE_MICRO_EXPECT_EQ(1, tensor->dims->data[0]);
@@ -50,6 +57,10 @@ void VerifyMockTfLiteTensor(TfLiteTensor* tensor, bool is_variable = false) {
 }
 
 void VerifyMockWeightTfLiteTensor(TfLiteTensor* tensor) {
+  TF_LITE_MICRO_EXPECT(nullptr != tensor);
+  if (tensor == nullptr) {
+    return;
+  }
   TF_LITE_MICRO_EXPECT_EQ(kTfLiteUInt8, tensor->type);
   TF_LITE_MICRO_EXPECT_EQ(1, tensor->dims->size);
   TF_LITE_MICRO_EXPECT_EQ(1, tensor->dims->data[0]);
@@ -109,6 +120,10 @@ void VerifyMockWeightTensor(const Model* model, MicroAllocator* allocator,
 }
 
 void VerifyMockConvTfLiteTensor(TfLiteTensor* tensor, bool is_variable = false) {
+  TF_LITE_MICRO_EXPECT(nullptr != tensor);
+  if (tensor == nullptr) {
+    return;
+  }
   TF_LITE_MICRO_EXPECT_EQ(kTfLiteInt32, tensor->type);
   TF_LITE_MICRO_EXPECT_EQ(4, tensor->dims->size);
   TF_LITE_MICRO_EXPECT_EQ(1, tensor->dims->data[0]);
@@ -121,6 +136,10 @@ void VerifyMockConvTfLiteTensor(TfLiteTensor* tensor, bool is_variable = false)
 }
 
 void VerifyMockConvWeightTfLiteTensor(TfLiteTensor* tensor) {
+  TF_LITE_MICRO_EXPECT(nullptr != tensor);
+  if (tensor == nullptr) {
+    return;
+  }
   TF_LITE_MICRO_EXPECT_EQ(kTfLiteUInt8, tensor->type);
   TF_LITE_MICRO_EXPECT_EQ(4, tensor->dims->size);
   TF_LITE_MICRO_EXPECT_EQ(5, tensor->dims->data[0]);
@@ -356,7 +375,11 @@ TF_LITE_MICRO_TEST(TestMockModelAllocation) {
   const tflite::Model* model = tflite::testing::GetSimpleMockModel();
   tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
   tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
-  constexpr size_t arena_size = 1024;
+  // FinishModelAllocation() needs room for the memory planner's temporary
+  // buffers on top of the persistent allocations, which include the per-node
+  // tensor tables and cached shapes. This model needs at least 1488 bytes on a
+  // 64-bit host.
+  constexpr size_t arena_size = 1536;
   uint8_t arena[arena_size];
   tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
       arena, arena_size, tflite::GetMicroErrorReporter());
@@ -384,7 +407,9 @@ TF_LITE_MICRO_TEST(TestMockModelAllocation) {
   TF_LITE_MICRO_EXPECT_NE(eval_tensors[3].data.raw, eval_tensors[0].data.raw);
   TF_LITE_MICRO_EXPECT_NE(eval_tensors[3].data.raw, eval_tensors[1].data.raw);
   TF_LITE_MICRO_EXPECT_NE(eval_tensors[3].data.raw, eval_tensors[2].data.raw);
-  TF_LITE_MICRO_EXPECT_LE(allocator->used_bytes(), 856 + 100);
+  // The additional 256 bytes hold the per-node tensor tables and the cached
+  // RuntimeShapes of the subgraph.
+  TF_LITE_MICRO_EXPECT_LE(allocator->used_bytes(), 856 + 100 + 256);
 
   // SimpleMockModel has 2 operators:
   tflite::testing::VerifyRegistrationAndNodeAllocation(subgraph_allocations,
@@ -474,11 +499,48 @@ TF_LITE_MICRO_TEST(TestAllocationForModelsWithBranches) {
                                                        /*num_subgraphs=*/1);
 }
 
+TF_LITE_MICRO_TEST(TestAllocationForModelsWithBranchesAndSchedule) {
+  const tflite::Model* model = tflite::testing::GetSimpleModelWithBranch();
+  tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
+  constexpr size_t arena_size = 4096;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      arena, arena_size, tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_NE(nullptr, allocator);
+  tflite::SubgraphAllocations* subgraph_allocations =
+      allocator->StartModelAllocation(model);
+  TF_LITE_MICRO_EXPECT(nullptr != subgraph_allocations);
+
+  // n0 and n1 only depend on t0 and may run at the same time.
+  int node_levels[] = {0, 0, 1};
+  int level_nodes[] = {0, 1, 2};
+  int level_starts[] = {0, 2, 3};
+  TfLiteStatus node_statuses[3];
+  tflite::NodeSchedule schedule = {3,           node_levels, level_nodes,
+                                   level_starts, 2,          node_statuses};
+  subgraph_allocations[0].schedule = &schedule;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model, subgraph_allocations,
+                                                  &scratch_buffer_handles));
+
+  // t0 is last read by two operators of the same level, so it is kept alive
+  // for one more level and, unlike with sequential execution, t3 does not
+  // reuse its memory. All four buffers of 48 bytes are alive in the second
+  // level and must not overlap.
+  for (int i = 0; i < 4; ++i) {
+    for (int j = i + 1; j < 4; ++j) {
+      const uint8_t* a = subgraph_allocations[0].tensors[i].data.uint8;
+      const uint8_t* b = subgraph_allocations[0].tensors[j].data.uint8;
+      TF_LITE_MICRO_EXPECT(a + 48 <= b || b + 48 <= a);
+    }
+  }
+}
+
 TF_LITE_MICRO_TEST(TestAllocationForComplexModelAllocation) {
   const tflite::Model* model = tflite::testing::GetComplexMockModel();
   tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
   tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
-  constexpr size_t arena_size = 2048;
+  constexpr size_t arena_size = 2560;
   uint8_t arena[arena_size];
   tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
       arena, arena_size, tflite::GetMicroErrorReporter());
@@ -971,4 +1033,178 @@ TF_LITE_MICRO_TEST(TestModelWithUnusedTensors) {
       0, subgraph_allocations[0].tensors[3].data.uint8 - start);
 }
 
+TF_LITE_MICRO_TEST(TestReshapeOutputAliasesInput) {
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+
+  const tflite::Model* model = tflite::testing::GetModelWithReshape();
+
+  tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
+  constexpr size_t arena_size = 4096;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      arena, arena_size, tflite::GetMicroErrorReporter());
+
+  tflite::SubgraphAllocations* subgraph_allocations =
+      allocator->StartModelAllocation(model);
+  TF_LITE_MICRO_EXPECT(nullptr != subgraph_allocations);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model, subgraph_allocations,
+                                                  &scratch_buffer_handles));
+
+  // The RESHAPE output shares the buffer of its input.
+  const TfLiteEvalTensor* tensors = subgraph_allocations[0].tensors;
+  TF_LITE_MICRO_EXPECT(nullptr != tensors[2].data.data);
+  TF_LITE_MICRO_EXPECT(tensors[2].data.data == tensors[3].data.data);
+  // The model input and output keep buffers of their own.
+  TF_LITE_MICRO_EXPECT(tensors[0].data.data != tensors[3].data.data);
+  TF_LITE_MICRO_EXPECT(tensors[4].data.data != tensors[3].data.data);
+}
+
+TF_LITE_MICRO_TEST(TestConcatenationInputsPlacedInOutput) {
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+
+  const tflite::Model* model = tflite::testing::GetModelWithConcatenation();
+
+  tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
+  constexpr size_t arena_size = 4096;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      arena, arena_size, tflite::GetMicroErrorReporter());
+
+  tflite::SubgraphAllocations* subgraph_allocations =
+      allocator->StartModelAllocation(model);
+  TF_LITE_MICRO_EXPECT(nullptr != subgraph_allocations);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model, subgraph_allocations,
+                                                  &scratch_buffer_handles));
+
+  // Both inputs of the concatenation are slices of its output.
+  const TfLiteEvalTensor* tensors = subgraph_allocations[0].tensors;
+  TF_LITE_MICRO_EXPECT(nullptr != tensors[4].data.data);
+  TF_LITE_MICRO_EXPECT(tensors[2].data.i32 == tensors[4].data.i32);
+  TF_LITE_MICRO_EXPECT(tensors[3].data.i32 == tensors[4].data.i32 + 4);
+  TF_LITE_MICRO_EXPECT(tensors[5].data.data != tensors[4].data.data);
+}
+
+TF_LITE_MICRO_TEST(TestNodeTensorsResolvedAfterPlanning) {
+  const tflite::Model* model = tflite::testing::GetSimpleMockModel();
+  tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
+  constexpr size_t arena_size = 2048;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      arena, arena_size, tflite::GetMicroErrorReporter());
+  tflite::SubgraphAllocations* subgraph_allocations =
+      allocator->StartModelAllocation(model);
+  TF_LITE_MICRO_EXPECT(nullptr != subgraph_allocations);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model, subgraph_allocations,
+                                                  &scratch_buffer_handles));
+
+  // Both operators read t0 and t1, and write t2 and t3 respectively.
+  TfLiteEvalTensor* tensors = subgraph_allocations[0].tensors;
+  const tflite::NodeAndRegistration& node0 =
+      subgraph_allocations[0].node_and_registrations[0];
+  const tflite::NodeAndRegistration& node1 =
+      subgraph_allocations[0].node_and_registrations[1];
+  TF_LITE_MICRO_EXPECT(nullptr != node0.eval_tensors);
+  TF_LITE_MICRO_EXPECT(node0.eval_tensors[0] == &tensors[0]);
+  TF_LITE_MICRO_EXPECT(node0.eval_tensors[1] == &tensors[1]);
+  TF_LITE_MICRO_EXPECT(node0.eval_tensors[2] == &tensors[2]);
+  TF_LITE_MICRO_EXPECT(node1.eval_tensors[2] == &tensors[3]);
+
+  const tflite::RuntimeShape& shape =
+      tflite::micro::GetEvalInputShape(&node0.node, 0);
+  TF_LITE_MICRO_EXPECT_EQ(tensors[0].dims->size, shape.DimensionsCount());
+  for (int i = 0; i < shape.DimensionsCount(); ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(tensors[0].dims->data[i], shape.Dims(i));
+  }
+}
+
+TF_LITE_MICRO_TEST(TestDispatchTableFollowsNodes) {
+  const tflite::Model* model = tflite::testing::GetSimpleMockModel();
+  tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
+  constexpr size_t arena_size = 2048;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      arena, arena_size, tflite::GetMicroErrorReporter());
+  tflite::SubgraphAllocations* subgraph_allocations =
+      allocator->StartModelAllocation(model);
+  TF_LITE_MICRO_EXPECT(nullptr != subgraph_allocations);
+  TF_LITE_MICRO_EXPECT(nullptr == subgraph_allocations[0].dispatch_table);
+  TF_LITE_MICRO_EXPECT_EQ(0, subgraph_allocations[0].dispatch_table_size);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model, subgraph_allocations,
+                                                  &scratch_buffer_handles));
+
+  tflite::NodeAndRegistration* node_and_registrations =
+      subgraph_allocations[0].node_and_registrations;
+  for (int i = 0; i < 2; ++i) {
+    node_and_registrations[i].registration =
+        tflite::testing::MockCustom::getRegistration();
+  }
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, allocator->AllocateDispatchTables(
+                                         model, subgraph_allocations));
+
+  const tflite::NodeDispatch* dispatch_table =
+      subgraph_allocations[0].dispatch_table;
+  TF_LITE_MICRO_EXPECT(nullptr != dispatch_table);
+  TF_LITE_MICRO_EXPECT_EQ(2, subgraph_allocations[0].dispatch_table_size);
+  for (int i = 0; i < 2; ++i) {
+    TF_LITE_MICRO_EXPECT(dispatch_table[i].invoke ==
+                         tflite::testing::MockCustom::Invoke);
+    TF_LITE_MICRO_EXPECT(dispatch_table[i].node ==
+                         &node_and_registrations[i].node);
+  }
+}
+
+TF_LITE_MICRO_TEST(TestIfBranchesArePlannedIntoCallerPlan) {
+  const tflite::Model* model =
+      tflite::testing::GetSimpleModelWithSubgraphsAndIf();
+  tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
+  constexpr size_t arena_size = 4096;
+  uint8_t arena[arena_size];
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      arena, arena_size, tflite::GetMicroErrorReporter());
+  tflite::SubgraphAllocations* subgraph_allocations =
+      allocator->StartModelAllocation(model);
+  TF_LITE_MICRO_EXPECT(nullptr != subgraph_allocations);
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, allocator->FinishModelAllocation(model, subgraph_allocations,
+                                                  &scratch_buffer_handles));
+
+  // Check test_helpers.cc BuildSimpleModelWithSubgraphsAndIf for the model
+  // structure. Only one branch runs, so both share one block.
+  const tflite::SubgraphAllocations& then_allocations =
+      subgraph_allocations[1];
+  const tflite::SubgraphAllocations& else_allocations =
+      subgraph_allocations[2];
+  TF_LITE_MICRO_EXPECT(then_allocations.plan_buffer ==
+                       else_allocations.plan_buffer);
+  // The three 8 byte tensors of a branch are all alive at once, each
+  // padded to 16 bytes.
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(48),
+                          then_allocations.plan_bytes);
+  for (int i = 0; i < 3; ++i) {
+    TF_LITE_MICRO_EXPECT_GE(then_allocations.tensors[i].data.uint8,
+                            then_allocations.plan_buffer);
+    TF_LITE_MICRO_EXPECT_LT(
+        then_allocations.tensors[i].data.uint8,
+        then_allocations.plan_buffer + then_allocations.plan_bytes);
+  }
+
+  // All four tensors of the first subgraph are alive while IF runs, so the
+  // block of the branches follows them.
+  const tflite::SubgraphAllocations& if_allocations = subgraph_allocations[0];
+  uint8_t* block_start = then_allocations.plan_buffer;
+  uint8_t* block_end = block_start + then_allocations.plan_bytes;
+  for (int i = 0; i < 4; ++i) {
+    uint8_t* data = if_allocations.tensors[i].data.uint8;
+    TF_LITE_MICRO_EXPECT(data + 8 <= block_start || data >= block_end);
+  }
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(64 + 48),
+                          if_allocations.plan_bytes);
+  TF_LITE_MICRO_EXPECT_EQ(if_allocations.plan_bytes,
+                          allocator->planned_head_bytes());
+}
+
 TF_LITE_MICRO_TESTS_END
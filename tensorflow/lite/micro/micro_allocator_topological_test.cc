@@ -385,7 +385,9 @@ TF_LITE_MICRO_TEST(TestMockModelAllocation) {
   TF_LITE_MICRO_EXPECT_NE(eval_tensors[3].data.raw, eval_tensors[0].data.raw);
   TF_LITE_MICRO_EXPECT_NE(eval_tensors[3].data.raw, eval_tensors[1].data.raw);
   TF_LITE_MICRO_EXPECT_NE(eval_tensors[3].data.raw, eval_tensors[2].data.raw);
-  TF_LITE_MICRO_EXPECT_LE(allocator->used_bytes(), 856 + 100);
+  // The additional 256 bytes hold the per-node tensor tables and the cached
+  // RuntimeShapes of the subgraph.
+  TF_LITE_MICRO_EXPECT_LE(allocator->used_bytes(), 856 + 100 + 256);
 
   // SimpleMockModel has 2 operators:
   tflite::testing::VerifyRegistrationAndNodeAllocation(subgraph_allocations,
@@ -977,7 +979,7 @@ TF_LITE_MICRO_TEST(TestMockConvModelAllocation) {
   const tflite::Model* model = tflite::testing::GetSimpleMockConvModel();
   tflite::ScratchBufferHandle* scratch_buffer_handles = nullptr;
   tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
-  constexpr size_t arena_size = 1024;
+  constexpr size_t arena_size = 1280;
   uint8_t arena[arena_size];
   tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
       arena, arena_size, tflite::GetMicroErrorReporter());
@@ -0,0 +1,305 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_execution_context.h"
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/simple_memory_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+// Must match the alignment used by MicroAllocator so that rebased buffers keep
+// the alignment they were planned with.
+constexpr int kBufferAlignment = 16;
+
+// Moves a pointer into the interpreter's planned head section to the same
+// offset inside this context's head section. Pointers outside of the planned
+// head (weights, persistent buffers) are shared and returned unchanged.
+void* RebasePlannedPointer(void* data, const uint8_t* planned_head_buffer,
+                           size_t planned_head_bytes, uint8_t* head_buffer) {
+  const uint8_t* address = static_cast<const uint8_t*>(data);
+  if (address >= planned_head_buffer &&
+      address < planned_head_buffer + planned_head_bytes) {
+    return head_buffer + (address - planned_head_buffer);
+  }
+  return data;
+}
+
+}  // namespace
+
+MicroExecutionContext::MicroExecutionContext(
+    const Model* model, MicroAllocator* allocator,
+    SubgraphAllocations* subgraph_allocations,
+    ScratchBufferHandle* scratch_buffer_handles, ErrorReporter* error_reporter,
+    MicroProfiler* profiler)
+    : model_(model),
+      error_reporter_(error_reporter),
+      allocator_(*allocator),
+      graph_(&context_, model, allocator),
+      scratch_buffer_handles_(scratch_buffer_handles) {
+  graph_.SetSubgraphAllocations(subgraph_allocations);
+
+  context_.impl_ = static_cast<void*>(this);
+  context_.ReportError = ReportOpError;
+  context_.GetTensor = GetTensor;
+  context_.GetEvalTensor = GetEvalTensor;
+  context_.GetScratchBuffer = GetScratchBuffer;
+  context_.GetExecutionPlan = GetGraph;
+  context_.profiler = profiler;
+  // Kernels are fully prepared, so no further arena allocations are allowed.
+  context_.AllocatePersistentBuffer = nullptr;
+  context_.RequestScratchBufferInArena = nullptr;
+}
+
+MicroExecutionContext* MicroExecutionContext::Create(
+    const Model* model, const SubgraphAllocations* subgraph_allocations,
+    const ScratchBufferHandle* scratch_buffer_handles,
+    size_t scratch_buffer_count, const uint8_t* planned_head_buffer,
+    size_t planned_head_bytes, uint8_t* buffer, size_t buffer_size,
+    ErrorReporter* error_reporter, MicroProfiler* profiler) {
+  TFLITE_DCHECK(model != nullptr);
+  TFLITE_DCHECK(buffer != nullptr);
+  TFLITE_DCHECK(error_reporter != nullptr);
+
+  if (subgraph_allocations == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Execution contexts can only be created after "
+                         "AllocateTensors() succeeded.");
+    return nullptr;
+  }
+
+  const size_t subgraphs_size = model->subgraphs()->size();
+  for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_size;
+       ++subgraph_idx) {
+    const SubGraph* subgraph = model->subgraphs()->Get(subgraph_idx);
+    for (size_t i = 0; i < subgraph->tensors()->size(); ++i) {
+      if (subgraph->tensors()->Get(i)->is_variable()) {
+        TF_LITE_REPORT_ERROR(error_reporter,
+                             "Execution contexts do not support models with "
+                             "variable tensors (subgraph %d, tensor %d).",
+                             subgraph_idx, i);
+        return nullptr;
+      }
+    }
+  }
+
+  uint8_t* aligned_buffer = AlignPointerUp(buffer, kBufferAlignment);
+  if (aligned_buffer >= buffer + buffer_size) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Execution context buffer is too small.");
+    return nullptr;
+  }
+  SimpleMemoryAllocator* memory_allocator = SimpleMemoryAllocator::Create(
+      error_reporter, aligned_buffer, buffer + buffer_size - aligned_buffer);
+  if (memory_allocator == nullptr) {
+    return nullptr;
+  }
+  MicroAllocator* allocator =
+      MicroAllocator::Create(memory_allocator, error_reporter);
+  if (allocator == nullptr) {
+    return nullptr;
+  }
+
+  // The context object, the eval tensor copies and the scratch buffer handles
+  // live in the tail so that the head can hold the activations.
+  uint8_t* context_buffer = memory_allocator->AllocateFromTail(
+      sizeof(MicroExecutionContext), alignof(MicroExecutionContext));
+  SubgraphAllocations* allocations = reinterpret_cast<SubgraphAllocations*>(
+      memory_allocator->AllocateFromTail(
+          sizeof(SubgraphAllocations) * subgraphs_size,
+          alignof(SubgraphAllocations)));
+  if (context_buffer == nullptr || allocations == nullptr) {
+    return nullptr;
+  }
+
+  ScratchBufferHandle* handles = nullptr;
+  if (scratch_buffer_count > 0) {
+    handles = reinterpret_cast<ScratchBufferHandle*>(
+        memory_allocator->AllocateFromTail(
+            sizeof(ScratchBufferHandle) * scratch_buffer_count,
+            alignof(ScratchBufferHandle)));
+    if (handles == nullptr) {
+      return nullptr;
+    }
+  }
+
+  for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_size;
+       ++subgraph_idx) {
+    const size_t tensors_size =
+        model->subgraphs()->Get(subgraph_idx)->tensors()->size();
+    TfLiteEvalTensor* tensors = reinterpret_cast<TfLiteEvalTensor*>(
+        memory_allocator->AllocateFromTail(
+            sizeof(TfLiteEvalTensor) * tensors_size,
+            alignof(TfLiteEvalTensor)));
+    // The nodes are copied since their resolved tensor tables point at the
+    // eval tensors. The kernel data they reference is shared.
+    const size_t nodes_size = NumSubgraphOperators(model, subgraph_idx);
+    NodeAndRegistration* nodes = nullptr;
+    if (nodes_size > 0) {
+      nodes = reinterpret_cast<NodeAndRegistration*>(
+          memory_allocator->AllocateFromTail(
+              sizeof(NodeAndRegistration) * nodes_size,
+              alignof(NodeAndRegistration)));
+    }
+    if (tensors == nullptr || (nodes_size > 0 && nodes == nullptr)) {
+      return nullptr;
+    }
+    for (size_t i = 0; i < nodes_size; ++i) {
+      nodes[i] = subgraph_allocations[subgraph_idx].node_and_registrations[i];
+    }
+    allocations[subgraph_idx].node_and_registrations = nodes;
+    allocations[subgraph_idx].tensors = tensors;
+    allocations[subgraph_idx].schedule =
+        subgraph_allocations[subgraph_idx].schedule;
+    allocations[subgraph_idx].dispatch_table = nullptr;
+    allocations[subgraph_idx].dispatch_table_size = 0;
+    allocations[subgraph_idx].deferred = false;
+    allocations[subgraph_idx].deferred_failed = false;
+  }
+
+  if (memory_allocator->SetHeadBufferSize(planned_head_bytes,
+                                          kBufferAlignment) != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Execution context buffer is too small for the "
+                         "memory plan of %d bytes.",
+                         planned_head_bytes);
+    return nullptr;
+  }
+  uint8_t* head_buffer = memory_allocator->GetHeadBuffer();
+
+  for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_size;
+       ++subgraph_idx) {
+    const size_t tensors_size =
+        model->subgraphs()->Get(subgraph_idx)->tensors()->size();
+    for (size_t i = 0; i < tensors_size; ++i) {
+      TfLiteEvalTensor* tensor = &allocations[subgraph_idx].tensors[i];
+      *tensor = subgraph_allocations[subgraph_idx].tensors[i];
+      tensor->data.data =
+          RebasePlannedPointer(tensor->data.data, planned_head_buffer,
+                               planned_head_bytes, head_buffer);
+    }
+    allocations[subgraph_idx].plan_buffer = static_cast<uint8_t*>(
+        RebasePlannedPointer(subgraph_allocations[subgraph_idx].plan_buffer,
+                             planned_head_buffer, planned_head_bytes,
+                             head_buffer));
+    allocations[subgraph_idx].plan_bytes =
+        subgraph_allocations[subgraph_idx].plan_bytes;
+  }
+  for (size_t i = 0; i < scratch_buffer_count; ++i) {
+    handles[i].data = static_cast<uint8_t*>(
+        RebasePlannedPointer(scratch_buffer_handles[i].data,
+                             planned_head_buffer, planned_head_bytes,
+                             head_buffer));
+  }
+  if (allocator->ResolveNodeTensors(model, allocations) != kTfLiteOk ||
+      allocator->AllocateDispatchTables(model, allocations) != kTfLiteOk) {
+    return nullptr;
+  }
+
+  return new (context_buffer) MicroExecutionContext(
+      model, allocator, allocations, handles, error_reporter, profiler);
+}
+
+TfLiteStatus MicroExecutionContext::Invoke() {
+  return graph_.InvokeSubgraph(0);
+}
+
+size_t MicroExecutionContext::inputs_size() const {
+  return model_->subgraphs()->Get(0)->inputs()->size();
+}
+
+size_t MicroExecutionContext::outputs_size() const {
+  return model_->subgraphs()->Get(0)->outputs()->size();
+}
+
+TfLiteEvalTensor* MicroExecutionContext::input(size_t index) {
+  if (index >= inputs_size()) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Input index %d out of range (length is %d)", index,
+                         inputs_size());
+    return nullptr;
+  }
+  return graph_.GetSubgraphInput(0, index);
+}
+
+TfLiteEvalTensor* MicroExecutionContext::output(size_t index) {
+  if (index >= outputs_size()) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Output index %d out of range (length is %d)", index,
+                         outputs_size());
+    return nullptr;
+  }
+  return graph_.GetSubgraphOutput(0, index);
+}
+
+void MicroExecutionContext::ReportOpError(struct TfLiteContext* context,
+                                          const char* format, ...) {
+#ifndef TF_LITE_STRIP_ERROR_STRINGS
+  MicroExecutionContext* execution_context =
+      static_cast<MicroExecutionContext*>(context->impl_);
+  va_list args;
+  va_start(args, format);
+  TF_LITE_REPORT_ERROR(execution_context->error_reporter_, format, args);
+  va_end(args);
+#endif
+}
+
+TfLiteTensor* MicroExecutionContext::GetTensor(
+    const struct TfLiteContext* context, int tensor_idx) {
+  MicroExecutionContext* execution_context =
+      static_cast<MicroExecutionContext*>(context->impl_);
+  // Temp TfLiteTensor structs are allocated from this context's own temp
+  // section, which is reset by the graph after every node.
+  return execution_context->allocator_.AllocateTempTfLiteTensor(
+      execution_context->model_, execution_context->graph_.GetAllocations(),
+      tensor_idx, execution_context->graph_.GetCurrentSubgraphIndex());
+}
+
+TfLiteEvalTensor* MicroExecutionContext::GetEvalTensor(
+    const struct TfLiteContext* context, int tensor_idx) {
+  MicroExecutionContext* execution_context =
+      static_cast<MicroExecutionContext*>(context->impl_);
+  return &execution_context->graph_
+              .GetAllocations()[execution_context->graph_
+                                    .GetCurrentSubgraphIndex()]
+              .tensors[tensor_idx];
+}
+
+void* MicroExecutionContext::GetScratchBuffer(TfLiteContext* ctx,
+                                              int buffer_idx) {
+  MicroExecutionContext* execution_context =
+      static_cast<MicroExecutionContext*>(ctx->impl_);
+  return execution_context->scratch_buffer_handles_[buffer_idx].data;
+}
+
+TfLiteStatus MicroExecutionContext::GetGraph(struct TfLiteContext* context,
+                                             TfLiteIntArray** args) {
+  MicroExecutionContext* execution_context =
+      static_cast<MicroExecutionContext*>(context->impl_);
+  *args = reinterpret_cast<TfLiteIntArray*>(&execution_context->graph_);
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
@@ -0,0 +1,101 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_EXECUTION_CONTEXT_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_EXECUTION_CONTEXT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// A lightweight context for invoking a model that has already been prepared by
+// a MicroInterpreter. The read-only model state owned by the interpreter (node
+// and registration arrays, parsed builtin data, kernel OpData such as
+// per-channel quantization parameters, and the memory plan) is shared, while
+// each execution context owns a private copy of the activation buffers, the
+// eval tensors pointing at them, the scratch buffers and the temp section used
+// by kernels during Eval.
+//
+// Several execution contexts created from the same interpreter can therefore
+// be invoked concurrently from different threads, each context being used by
+// one thread at a time. Models with variable tensors are rejected since their
+// state lives in the shared persistent section. Kernels must not modify their
+// OpData during Eval for concurrent use to be safe.
+//
+// Instances are created with MicroInterpreter::CreateExecutionContext() and are
+// placed in the buffer handed to that call. The interpreter must outlive all of
+// its execution contexts.
+class MicroExecutionContext {
+ public:
+  // Creates an execution context in `buffer`. The buffer must be large enough
+  // for the committed memory plan of the model (`planned_head_bytes`), a copy
+  // of the eval tensors, nodes and scratch buffer handles, and any temp
+  // allocations the kernels make during Eval. Returns nullptr on failure.
+  static MicroExecutionContext* Create(
+      const Model* model, const SubgraphAllocations* subgraph_allocations,
+      const ScratchBufferHandle* scratch_buffer_handles,
+      size_t scratch_buffer_count, const uint8_t* planned_head_buffer,
+      size_t planned_head_bytes, uint8_t* buffer, size_t buffer_size,
+      ErrorReporter* error_reporter, MicroProfiler* profiler = nullptr);
+
+  // Runs the model on this context's activation buffers.
+  TfLiteStatus Invoke();
+
+  size_t inputs_size() const;
+  size_t outputs_size() const;
+
+  // Returns the input and output tensors of the main subgraph, backed by this
+  // context's activation buffers.
+  TfLiteEvalTensor* input(size_t index);
+  TfLiteEvalTensor* output(size_t index);
+
+  // Returns the number of bytes of the context buffer in use.
+  size_t arena_used_bytes() const { return allocator_.used_bytes(); }
+
+ private:
+  MicroExecutionContext(const Model* model, MicroAllocator* allocator,
+                        SubgraphAllocations* subgraph_allocations,
+                        ScratchBufferHandle* scratch_buffer_handles,
+                        ErrorReporter* error_reporter, MicroProfiler* profiler);
+
+  // Static functions that are bound to the TfLiteContext instance:
+  static void ReportOpError(struct TfLiteContext* context, const char* format,
+                            ...);
+  static TfLiteTensor* GetTensor(const struct TfLiteContext* context,
+                                 int tensor_idx);
+  static TfLiteEvalTensor* GetEvalTensor(const struct TfLiteContext* context,
+                                         int tensor_idx);
+  static void* GetScratchBuffer(TfLiteContext* ctx, int buffer_idx);
+  static TfLiteStatus GetGraph(struct TfLiteContext* context,
+                               TfLiteIntArray** args);
+
+  const Model* model_;
+  ErrorReporter* error_reporter_;
+  MicroAllocator& allocator_;
+  TfLiteContext context_ = {};
+  MicroGraph graph_;
+  ScratchBufferHandle* scratch_buffer_handles_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_EXECUTION_CONTEXT_H_
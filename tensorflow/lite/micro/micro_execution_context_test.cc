@@ -0,0 +1,113 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_execution_context.h"
+
+#include <cstdint>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/test_helpers.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace {
+
+constexpr size_t kArenaSize = 2000;
+constexpr size_t kContextBufferSize = 1536;
+
+}  // namespace
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(TestExecutionContextsHaveIndependentActivations) {
+  const tflite::Model* model = tflite::testing::GetSimpleMockModel();
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+  uint8_t arena[kArenaSize];
+  uint8_t context_buffer0[kContextBufferSize];
+  uint8_t context_buffer1[kContextBufferSize];
+
+  tflite::MicroInterpreter interpreter(model, op_resolver, arena, kArenaSize,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT(interpreter.CreateExecutionContext(
+                           context_buffer0, kContextBufferSize) == nullptr);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  tflite::MicroExecutionContext* context0 =
+      interpreter.CreateExecutionContext(context_buffer0, kContextBufferSize);
+  tflite::MicroExecutionContext* context1 =
+      interpreter.CreateExecutionContext(context_buffer1, kContextBufferSize);
+  TF_LITE_MICRO_EXPECT_NE(nullptr, context0);
+  TF_LITE_MICRO_EXPECT_NE(nullptr, context1);
+  TF_LITE_MICRO_EXPECT_EQ(interpreter.inputs_size(), context0->inputs_size());
+  TF_LITE_MICRO_EXPECT_EQ(interpreter.outputs_size(),
+                          context0->outputs_size());
+  TF_LITE_MICRO_EXPECT_LE(context0->arena_used_bytes(), kContextBufferSize);
+
+  // Activations of each context live in its own buffer.
+  int32_t* input0 = context0->input(0)->data.i32;
+  int32_t* input1 = context1->input(0)->data.i32;
+  TF_LITE_MICRO_EXPECT_TRUE(
+      reinterpret_cast<uint8_t*>(input0) >= context_buffer0 &&
+      reinterpret_cast<uint8_t*>(input0) < context_buffer0 + kContextBufferSize);
+  TF_LITE_MICRO_EXPECT_TRUE(
+      reinterpret_cast<uint8_t*>(input1) >= context_buffer1 &&
+      reinterpret_cast<uint8_t*>(input1) < context_buffer1 + kContextBufferSize);
+
+  interpreter.input(0)->data.i32[0] = 1;
+  input0[0] = 21;
+  input1[0] = 10;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, context0->Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, context1->Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+
+  TF_LITE_MICRO_EXPECT_EQ(42, context0->output(0)->data.i32[0]);
+  TF_LITE_MICRO_EXPECT_EQ(42, context0->output(1)->data.i32[0]);
+  TF_LITE_MICRO_EXPECT_EQ(31, context1->output(0)->data.i32[0]);
+  TF_LITE_MICRO_EXPECT_EQ(31, context1->output(1)->data.i32[0]);
+  TF_LITE_MICRO_EXPECT_EQ(22, interpreter.output(0)->data.i32[0]);
+
+  TF_LITE_MICRO_EXPECT(context0->input(1) == nullptr);
+  TF_LITE_MICRO_EXPECT(context0->output(2) == nullptr);
+}
+
+TF_LITE_MICRO_TEST(TestExecutionContextBufferTooSmall) {
+  const tflite::Model* model = tflite::testing::GetSimpleMockModel();
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+  uint8_t arena[kArenaSize];
+  uint8_t context_buffer[64];
+
+  tflite::MicroInterpreter interpreter(model, op_resolver, arena, kArenaSize,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+  TF_LITE_MICRO_EXPECT(interpreter.CreateExecutionContext(
+                           context_buffer, sizeof(context_buffer)) == nullptr);
+}
+
+TF_LITE_MICRO_TEST(TestExecutionContextRejectsVariableTensors) {
+  const tflite::Model* model = tflite::testing::GetComplexMockModel();
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+  constexpr size_t arena_size = 4096;
+  uint8_t arena[arena_size];
+  uint8_t context_buffer[kContextBufferSize];
+
+  tflite::MicroInterpreter interpreter(model, op_resolver, arena, arena_size,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+  TF_LITE_MICRO_EXPECT(interpreter.CreateExecutionContext(
+                           context_buffer, kContextBufferSize) == nullptr);
+}
+
+TF_LITE_MICRO_TESTS_END
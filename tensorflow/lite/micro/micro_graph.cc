@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_thread_pool.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
 namespace tflite {
@@ -37,6 +38,63 @@ const char* OpNameFromRegistration(const TfLiteRegistration* registration) {
 }
 #endif  // !defined(TF_LITE_STRIP_ERROR_STRINGS)
 
+// Operators that invoke other subgraphs or access resource variables depend on
+// other operators in ways that are not expressed by their inputs and outputs.
+bool IsScheduleBarrier(const TfLiteRegistration* registration) {
+  switch (registration->builtin_code) {
+    case BuiltinOperator_IF:
+    case BuiltinOperator_WHILE:
+    case BuiltinOperator_CALL_ONCE:
+    case BuiltinOperator_VAR_HANDLE:
+    case BuiltinOperator_READ_VARIABLE:
+    case BuiltinOperator_ASSIGN_VARIABLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ContainsTensor(const TfLiteIntArray* tensors, int tensor_idx) {
+  for (int i = 0; i < tensors->size; ++i) {
+    if (tensors->data[i] == tensor_idx) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns true if `node` has to run after `previous_node`, i.e. if it uses a
+// tensor written by `previous_node` or if both access the same variable
+// tensor.
+bool DependsOn(const SubGraph* subgraph, const TfLiteNode& node,
+               const TfLiteNode& previous_node) {
+  const TfLiteIntArray* node_tensors[] = {node.inputs, node.outputs};
+  for (const TfLiteIntArray* tensors : node_tensors) {
+    for (int i = 0; i < tensors->size; ++i) {
+      const int tensor_idx = tensors->data[i];
+      if (tensor_idx == kTfLiteOptionalTensor) {
+        continue;
+      }
+      if (ContainsTensor(previous_node.outputs, tensor_idx)) {
+        return true;
+      }
+      if (subgraph->tensors()->Get(tensor_idx)->is_variable() &&
+          ContainsTensor(previous_node.inputs, tensor_idx)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Operators of one level handed to the thread pool by InvokeScheduledSubgraph.
+struct ConcurrentNodes {
+  MicroGraph* graph;
+  int subgraph_idx;
+  const int* nodes;
+  TfLiteStatus* node_statuses;
+};
+
 }  // namespace
 
 MicroGraph::MicroGraph(TfLiteContext* context, const Model* model,
@@ -53,32 +111,38 @@ MicroGraph::MicroGraph(TfLiteContext* context, const Model* model,
 MicroGraph::~MicroGraph() {}
 
 TfLiteStatus MicroGraph::InitSubgraphs() {
-  int previous_subgraph_idx = current_subgraph_index_;
-
   for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_->size();
        subgraph_idx++) {
-    current_subgraph_index_ = subgraph_idx;
-    uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
-    for (size_t i = 0; i < operators_size; ++i) {
-      TfLiteNode* node =
-          &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
-      const TfLiteRegistration* registration =
-          subgraph_allocations_[subgraph_idx]
-              .node_and_registrations[i]
-              .registration;
-      size_t init_data_size;
-      const char* init_data;
-      if (registration->builtin_code == BuiltinOperator_CUSTOM) {
-        init_data = reinterpret_cast<const char*>(node->custom_initial_data);
-        init_data_size = node->custom_initial_data_size;
-      } else {
-        init_data = reinterpret_cast<const char*>(node->builtin_data);
-        init_data_size = 0;
-      }
-      if (registration->init) {
-        node->user_data =
-            registration->init(context_, init_data, init_data_size);
-      }
+    if (!subgraph_allocations_[subgraph_idx].deferred) {
+      TF_LITE_ENSURE_STATUS(InitSubgraph(subgraph_idx));
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroGraph::InitSubgraph(int subgraph_idx) {
+  int previous_subgraph_idx = current_subgraph_index_;
+  current_subgraph_index_ = subgraph_idx;
+  uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
+  for (size_t i = 0; i < operators_size; ++i) {
+    TfLiteNode* node =
+        &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
+    const TfLiteRegistration* registration =
+        subgraph_allocations_[subgraph_idx]
+            .node_and_registrations[i]
+            .registration;
+    size_t init_data_size;
+    const char* init_data;
+    if (registration->builtin_code == BuiltinOperator_CUSTOM) {
+      init_data = reinterpret_cast<const char*>(node->custom_initial_data);
+      init_data_size = node->custom_initial_data_size;
+    } else {
+      init_data = reinterpret_cast<const char*>(node->builtin_data);
+      init_data_size = 0;
+    }
+    if (registration->init) {
+      node->user_data =
+          registration->init(context_, init_data, init_data_size);
     }
   }
   current_subgraph_index_ = previous_subgraph_idx;
@@ -87,27 +151,41 @@ TfLiteStatus MicroGraph::InitSubgraphs() {
 }
 
 TfLiteStatus MicroGraph::PrepareSubgraphs() {
-  int previous_subgraph_idx = current_subgraph_index_;
-
   for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_->size();
        subgraph_idx++) {
-    current_subgraph_index_ = subgraph_idx;
-    uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
-    for (size_t i = 0; i < operators_size; ++i) {
-      TfLiteNode* node =
-          &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
-      const TfLiteRegistration* registration =
-          subgraph_allocations_[subgraph_idx]
-              .node_and_registrations[i]
-              .registration;
-      if (registration->prepare != nullptr) {
-        TfLiteStatus prepare_status = registration->prepare(context_, node);
-        if (prepare_status != kTfLiteOk) {
-          MicroPrintf("Node %s (number %df) failed to prepare with status %d",
-                      OpNameFromRegistration(registration), i, prepare_status);
-          return kTfLiteError;
-        }
+    if (!subgraph_allocations_[subgraph_idx].deferred) {
+      TF_LITE_ENSURE_STATUS(PrepareSubgraph(subgraph_idx));
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroGraph::PrepareSubgraph(int subgraph_idx) {
+  int previous_subgraph_idx = current_subgraph_index_;
+  current_subgraph_index_ = subgraph_idx;
+  // The head holds the running memory plan while a deferred subgraph is
+  // prepared, so only the temp allocations of its operators are reset.
+  const bool deferred = subgraph_allocations_[subgraph_idx].deferred;
+  uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
+  for (size_t i = 0; i < operators_size; ++i) {
+    TfLiteNode* node =
+        &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
+    const TfLiteRegistration* registration =
+        subgraph_allocations_[subgraph_idx]
+            .node_and_registrations[i]
+            .registration;
+    if (registration->prepare != nullptr) {
+      TfLiteStatus prepare_status = registration->prepare(context_, node);
+      if (prepare_status != kTfLiteOk) {
+        MicroPrintf("Node %s (number %df) failed to prepare with status %d",
+                    OpNameFromRegistration(registration), i, prepare_status);
+        current_subgraph_index_ = previous_subgraph_idx;
+        return kTfLiteError;
       }
+    }
+    if (deferred) {
+      allocator_->ResetTempAllocations();
+    } else {
       allocator_->FinishPrepareNodeAllocations(/*node_id=*/i);
     }
   }
@@ -121,6 +199,12 @@ TfLiteStatus MicroGraph::FreeSubgraphs() {
 
   for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_->size();
        subgraph_idx++) {
+    // The operators of a subgraph that was never invoked were never
+    // initialized either.
+    if (subgraph_allocations_[subgraph_idx].deferred &&
+        !subgraph_allocations_[subgraph_idx].deferred_failed) {
+      continue;
+    }
     current_subgraph_index_ = subgraph_idx;
     uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
     for (size_t i = 0; i < operators_size; ++i) {
@@ -142,6 +226,93 @@ TfLiteStatus MicroGraph::FreeSubgraphs() {
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroGraph::BuildNodeSchedules() {
+  for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_->size();
+       subgraph_idx++) {
+    NodeSchedule* schedule =
+        reinterpret_cast<NodeSchedule*>(allocator_->AllocatePersistentBuffer(
+            sizeof(NodeSchedule)));
+    if (schedule == nullptr) {
+      MicroPrintf("Failed to allocate memory for the node schedule.");
+      return kTfLiteError;
+    }
+    TF_LITE_ENSURE_STATUS(BuildNodeSchedule(subgraph_idx, schedule));
+    subgraph_allocations_[subgraph_idx].schedule = schedule;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroGraph::BuildNodeSchedule(int subgraph_idx,
+                                           NodeSchedule* schedule) {
+  const SubGraph* subgraph = (*subgraphs_)[subgraph_idx];
+  const NodeAndRegistration* node_and_registrations =
+      subgraph_allocations_[subgraph_idx].node_and_registrations;
+  const int nodes_size = NumSubgraphOperators(model_, subgraph_idx);
+
+  int* node_levels = reinterpret_cast<int*>(
+      allocator_->AllocatePersistentBuffer(sizeof(int) * nodes_size));
+  int* level_nodes = reinterpret_cast<int*>(
+      allocator_->AllocatePersistentBuffer(sizeof(int) * nodes_size));
+  TfLiteStatus* node_statuses =
+      reinterpret_cast<TfLiteStatus*>(allocator_->AllocatePersistentBuffer(
+          sizeof(TfLiteStatus) * nodes_size));
+  if (node_levels == nullptr || level_nodes == nullptr ||
+      node_statuses == nullptr) {
+    MicroPrintf("Failed to allocate memory for the node schedule.");
+    return kTfLiteError;
+  }
+
+  // An operator runs one level after the last operator it depends on. Barrier
+  // operators run after all of the operators before them, and the operators
+  // after a barrier run after it.
+  int levels_size = 0;
+  int first_free_level = 0;
+  for (int i = 0; i < nodes_size; ++i) {
+    const NodeAndRegistration& current = node_and_registrations[i];
+    int level = first_free_level;
+    if (IsScheduleBarrier(current.registration)) {
+      level = levels_size;
+      first_free_level = level + 1;
+    } else {
+      for (int j = 0; j < i; ++j) {
+        if (node_levels[j] >= level &&
+            DependsOn(subgraph, current.node, node_and_registrations[j].node)) {
+          level = node_levels[j] + 1;
+        }
+      }
+    }
+    node_levels[i] = level;
+    if (level >= levels_size) {
+      levels_size = level + 1;
+    }
+  }
+
+  int* level_starts = reinterpret_cast<int*>(
+      allocator_->AllocatePersistentBuffer(sizeof(int) * (levels_size + 1)));
+  if (level_starts == nullptr) {
+    MicroPrintf("Failed to allocate memory for the node schedule.");
+    return kTfLiteError;
+  }
+  int level_nodes_size = 0;
+  for (int level = 0; level < levels_size; ++level) {
+    level_starts[level] = level_nodes_size;
+    for (int i = 0; i < nodes_size; ++i) {
+      if (node_levels[i] == level) {
+        level_nodes[level_nodes_size++] = i;
+      }
+    }
+  }
+  level_starts[levels_size] = level_nodes_size;
+
+  schedule->nodes_size = nodes_size;
+  schedule->node_levels = node_levels;
+  schedule->level_nodes = level_nodes;
+  schedule->level_starts = level_starts;
+  schedule->levels_size = levels_size;
+  schedule->node_statuses = node_statuses;
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
   int previous_subgraph_idx = current_subgraph_index_;
   current_subgraph_index_ = subgraph_idx;
@@ -151,68 +322,258 @@ TfLiteStatus MicroGraph::InvokeSubgraph(int subgraph_idx) {
                 subgraph_idx, subgraphs_->size());
     return kTfLiteError;
   }
+  TfLiteStatus prepare_status = PrepareSubgraphIfDeferred(subgraph_idx);
+  if (prepare_status != kTfLiteOk) {
+    current_subgraph_index_ = previous_subgraph_idx;
+    return prepare_status;
+  }
+  const NodeSchedule* schedule = subgraph_allocations_[subgraph_idx].schedule;
+  if (weight_streamer_ != nullptr && subgraph_idx == 0) {
+    TfLiteStatus invoke_status = InvokeStreamedSubgraph(
+        schedule, reinterpret_cast<MicroProfiler*>(context_->profiler));
+    current_subgraph_index_ = previous_subgraph_idx;
+    return invoke_status;
+  }
+  if (schedule != nullptr) {
+    TF_LITE_ENSURE_STATUS(InvokeScheduledSubgraph(subgraph_idx, *schedule));
+    current_subgraph_index_ = previous_subgraph_idx;
+    return kTfLiteOk;
+  }
+
+  MicroProfiler* profiler =
+      reinterpret_cast<MicroProfiler*>(context_->profiler);
+  const NodeDispatch* dispatch_table =
+      subgraph_allocations_[subgraph_idx].dispatch_table;
+  if (dispatch_table != nullptr && profiler == nullptr) {
+    TF_LITE_ENSURE_STATUS(InvokeDispatchTable(
+        dispatch_table,
+        subgraph_allocations_[subgraph_idx].dispatch_table_size,
+        subgraph_idx));
+    current_subgraph_index_ = previous_subgraph_idx;
+    return kTfLiteOk;
+  }
+
   uint32_t operators_size = NumSubgraphOperators(model_, subgraph_idx);
   for (size_t i = 0; i < operators_size; ++i) {
-    TfLiteNode* node =
-        &(subgraph_allocations_[subgraph_idx].node_and_registrations[i].node);
-    const TfLiteRegistration* registration = subgraph_allocations_[subgraph_idx]
-                                                 .node_and_registrations[i]
-                                                 .registration;
+    TfLiteStatus invoke_status = InvokeNode(subgraph_idx, i, profiler);
+
+    // All TfLiteTensor structs used in the kernel are allocated from temp
+    // memory in the allocator. This creates a chain of allocations in the
+    // temp section. The call below resets the chain of allocations to
+    // prepare for the next call. Kernels working on TfLiteEvalTensor leave
+    // the chain empty.
+    if (allocator_->HasTempAllocations()) {
+      allocator_->ResetTempAllocations();
+    }
+
+    if (invoke_status != kTfLiteOk) {
+      return invoke_status;
+    }
+  }
+  current_subgraph_index_ = previous_subgraph_idx;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroGraph::InvokeDispatchTable(
+    const NodeDispatch* dispatch_table, int dispatch_table_size,
+    int subgraph_idx) {
+  for (int node_idx = 0; node_idx < dispatch_table_size; ++node_idx) {
+    const NodeDispatch& entry = dispatch_table[node_idx];
+    TFLITE_DCHECK(entry.invoke);
+    TfLiteStatus invoke_status = entry.invoke(context_, entry.node);
+    if (allocator_->HasTempAllocations()) {
+      allocator_->ResetTempAllocations();
+    }
+    if (invoke_status != kTfLiteOk) {
+      if (invoke_status == kTfLiteError) {
+        MicroPrintf("Node %s (number %d) failed to invoke with status %d",
+                    OpNameFromRegistration(
+                        subgraph_allocations_[subgraph_idx]
+                            .node_and_registrations[node_idx]
+                            .registration),
+                    node_idx, invoke_status);
+      }
+      return invoke_status;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroGraph::InvokeNode(int subgraph_idx, int node_idx,
+                                    MicroProfiler* profiler) {
+  TfLiteNode* node =
+      &(subgraph_allocations_[subgraph_idx].node_and_registrations[node_idx]
+            .node);
+  const TfLiteRegistration* registration =
+      subgraph_allocations_[subgraph_idx]
+          .node_and_registrations[node_idx]
+          .registration;
 
 // This ifdef is needed (even though ScopedMicroProfiler itself is a no-op with
 // -DTF_LITE_STRIP_ERROR_STRINGS) because the function OpNameFromRegistration is
 // only defined for builds with the error strings.
 #if !defined(TF_LITE_STRIP_ERROR_STRINGS)
-    ScopedMicroProfiler scoped_profiler(
-        OpNameFromRegistration(registration),
-        reinterpret_cast<MicroProfiler*>(context_->profiler));
+  ScopedMicroProfiler scoped_profiler(OpNameFromRegistration(registration),
+                                      profiler);
 #endif
 
-    TFLITE_DCHECK(registration->invoke);
-    TfLiteStatus invoke_status = registration->invoke(context_, node);
+  TFLITE_DCHECK(registration->invoke);
+  TfLiteStatus invoke_status = registration->invoke(context_, node);
+  if (invoke_status == kTfLiteError) {
+    MicroPrintf("Node %s (number %d) failed to invoke with status %d",
+                OpNameFromRegistration(registration), node_idx,
+                invoke_status);
+  }
+  return invoke_status;
+}
 
-    // All TfLiteTensor structs used in the kernel are allocated from temp
-    // memory in the allocator. This creates a chain of allocations in the
-    // temp section. The call below resets the chain of allocations to
-    // prepare for the next call.
-    allocator_->ResetTempAllocations();
+TfLiteStatus MicroGraph::InvokeStreamedSubgraph(const NodeSchedule* schedule,
+                                                MicroProfiler* profiler) {
+  const int operators_size = NumSubgraphOperators(model_, 0);
+  if (operators_size == 0) {
+    return kTfLiteOk;
+  }
+  // The concatenated levels of a schedule are a valid sequential order.
+  const int* order = schedule != nullptr ? schedule->level_nodes : nullptr;
+  TfLiteStatus invoke_status = weight_streamer_->Begin(
+      model_, subgraph_allocations_, order != nullptr ? order[0] : 0);
+  for (int i = 0; invoke_status == kTfLiteOk && i < operators_size; ++i) {
+    const int node_idx = order != nullptr ? order[i] : i;
+    const int next_node_idx =
+        i + 1 == operators_size ? -1 : (order != nullptr ? order[i + 1] : i + 1);
+    invoke_status = weight_streamer_->AcquireNode(node_idx, next_node_idx);
+    if (invoke_status == kTfLiteOk) {
+      invoke_status = InvokeNode(0, node_idx, profiler);
+    }
+    if (allocator_->HasTempAllocations()) {
+      allocator_->ResetTempAllocations();
+    }
+  }
+  const TfLiteStatus end_status = weight_streamer_->End();
+  return invoke_status != kTfLiteOk ? invoke_status : end_status;
+}
 
-    if (invoke_status == kTfLiteError) {
-      MicroPrintf("Node %s (number %d) failed to invoke with status %d",
-                  OpNameFromRegistration(registration), i, invoke_status);
-      return kTfLiteError;
-    } else if (invoke_status != kTfLiteOk) {
-      return invoke_status;
+TfLiteStatus MicroGraph::InvokeScheduledSubgraph(int subgraph_idx,
+                                                 const NodeSchedule& schedule) {
+  MicroProfiler* profiler =
+      reinterpret_cast<MicroProfiler*>(context_->profiler);
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  MicroThreadPool* thread_pool = GetMicroThreadPool(context_);
+  const int num_threads =
+      thread_pool != nullptr ? thread_pool->num_threads() : 1;
+#endif
+
+  for (int level = 0; level < schedule.levels_size; ++level) {
+    const int* nodes = &schedule.level_nodes[schedule.level_starts[level]];
+    const int nodes_size =
+        schedule.level_starts[level + 1] - schedule.level_starts[level];
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+    if (nodes_size > 1 && num_threads > 1) {
+      ConcurrentNodes concurrent_nodes = {this, subgraph_idx, nodes,
+                                          schedule.node_statuses};
+      {
+        // MicroProfiler is not thread-safe, so the level is recorded as a
+        // single event.
+        ScopedMicroProfiler scoped_profiler("CONCURRENT_OPS", profiler);
+        // The kernels of the level see the pool running and split no work of
+        // their own, see ParallelFor().
+        thread_pool->Run(InvokeNodesTask, &concurrent_nodes, nodes_size,
+                         nodes_size);
+      }
+      // The temp allocations of all of the operators of the level are released
+      // together once the whole level is done.
+      if (allocator_->HasTempAllocations()) {
+        allocator_->ResetTempAllocations();
+      }
+      for (int i = 0; i < nodes_size; ++i) {
+        TF_LITE_ENSURE_STATUS(schedule.node_statuses[nodes[i]]);
+      }
+      continue;
+    }
+#endif  // defined(TF_LITE_MICRO_USE_THREADS)
+
+    for (int i = 0; i < nodes_size; ++i) {
+      TfLiteStatus invoke_status = InvokeNode(subgraph_idx, nodes[i], profiler);
+      if (allocator_->HasTempAllocations()) {
+        allocator_->ResetTempAllocations();
+      }
+      TF_LITE_ENSURE_STATUS(invoke_status);
     }
   }
-  current_subgraph_index_ = previous_subgraph_idx;
   return kTfLiteOk;
 }
 
+void MicroGraph::InvokeNodesTask(void* data, int start, int end) {
+  ConcurrentNodes* concurrent_nodes = static_cast<ConcurrentNodes*>(data);
+  for (int i = start; i < end; ++i) {
+    const int node_idx = concurrent_nodes->nodes[i];
+    concurrent_nodes->node_statuses[node_idx] =
+        concurrent_nodes->graph->InvokeNode(concurrent_nodes->subgraph_idx,
+                                            node_idx, /*profiler=*/nullptr);
+  }
+}
+
 TfLiteStatus MicroGraph::ResetVariableTensors() {
   for (size_t subgraph_idx = 0; subgraph_idx < subgraphs_->size();
        subgraph_idx++) {
-    const SubGraph* subgraph = (*subgraphs_)[subgraph_idx];
-    for (size_t i = 0; i < subgraph->tensors()->size(); ++i) {
-      auto* tensor = subgraph->tensors()->Get(i);
-      if (tensor->is_variable()) {
-        size_t buffer_size;
-        TF_LITE_ENSURE_STATUS(TfLiteEvalTensorByteLength(
-            &subgraph_allocations_[subgraph_idx].tensors[i], &buffer_size));
-
-        int value = 0;
-        if (tensor->type() == tflite::TensorType_INT8) {
-          value = tensor->quantization()->zero_point()->Get(0);
-        }
-        memset(subgraph_allocations_[subgraph_idx].tensors[i].data.raw, value,
-               buffer_size);
-      }
+    // Deferred subgraphs have no variable buffers yet, and get them reset
+    // when they are prepared.
+    if (!subgraph_allocations_[subgraph_idx].deferred) {
+      TF_LITE_ENSURE_STATUS(ResetSubgraphVariableTensors(subgraph_idx));
     }
   }
 
   return kTfLiteOk;
 }
 
+TfLiteStatus MicroGraph::ResetSubgraphVariableTensors(int subgraph_idx) {
+  const SubGraph* subgraph = (*subgraphs_)[subgraph_idx];
+  for (size_t i = 0; i < subgraph->tensors()->size(); ++i) {
+    auto* tensor = subgraph->tensors()->Get(i);
+    if (tensor->is_variable()) {
+      size_t buffer_size;
+      TF_LITE_ENSURE_STATUS(TfLiteEvalTensorByteLength(
+          &subgraph_allocations_[subgraph_idx].tensors[i], &buffer_size));
+
+      int value = 0;
+      if (tensor->type() == tflite::TensorType_INT8) {
+        value = tensor->quantization()->zero_point()->Get(0);
+      }
+      memset(subgraph_allocations_[subgraph_idx].tensors[i].data.raw, value,
+             buffer_size);
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroGraph::PrepareSubgraphIfDeferred(int subgraph_idx) {
+  if (!subgraph_allocations_[subgraph_idx].deferred) {
+    return kTfLiteOk;
+  }
+  if (subgraph_allocations_[subgraph_idx].deferred_failed) {
+    MicroPrintf("Subgraph %d failed to prepare on an earlier invocation.",
+                subgraph_idx);
+    return kTfLiteError;
+  }
+  if (deferred_subgraph_preparer_ == nullptr) {
+    MicroPrintf("Subgraph %d was deferred but can not be prepared.",
+                subgraph_idx);
+    return kTfLiteError;
+  }
+  if (deferred_subgraph_preparer_(deferred_subgraph_preparer_data_,
+                                  subgraph_idx) != kTfLiteOk) {
+    subgraph_allocations_[subgraph_idx].deferred_failed = true;
+    return kTfLiteError;
+  }
+  if (subgraph_allocations_[subgraph_idx].deferred) {
+    MicroPrintf("Subgraph %d is still deferred after preparing it.",
+                subgraph_idx);
+    return kTfLiteError;
+  }
+  return ResetSubgraphVariableTensors(subgraph_idx);
+}
+
 int MicroGraph::NumSubgraphs() { return model_->subgraphs()->size(); }
 
 void MicroGraph::SetSubgraphAllocations(
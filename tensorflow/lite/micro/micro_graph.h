@@ -18,10 +18,16 @@ limitations under the License.
 
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
 namespace tflite {
 
+// Initializes and prepares the operators of a deferred subgraph and commits
+// its memory plan, see MicroGraph::SetDeferredSubgraphPreparer().
+typedef TfLiteStatus (*DeferredSubgraphPreparer)(void* data, int subgraph_idx);
+
 // Abstracts the details of interacting with the tflite::Model.
 //
 // Provides methods to access, initialize, prepare, invoke and free any
@@ -36,21 +42,43 @@ class MicroGraph {
   virtual ~MicroGraph();
 
   // Sets up builtin data and calls TfLiteRegistration->Init for every operator
-  // in every subgraph in the model.
+  // in every subgraph in the model that is not deferred.
   virtual TfLiteStatus InitSubgraphs();
 
   // Calls TfLiteRegistration->Prepare for every operator in every subgraph in
-  // the model.
+  // the model that is not deferred.
   virtual TfLiteStatus PrepareSubgraphs();
 
+  // Calls TfLiteRegistration->Init or Prepare for every operator in a single
+  // subgraph.
+  TfLiteStatus InitSubgraph(int subgraph_idx);
+  TfLiteStatus PrepareSubgraph(int subgraph_idx);
+
   // Calls TfLiteRegistration->Free for every operator in every subgraph in the
-  // model.
+  // model that was initialized.
   virtual TfLiteStatus FreeSubgraphs();
 
+  // Groups the operators of every subgraph into levels of operators that do
+  // not depend on each other, using the operator inputs and outputs. Operators
+  // that invoke other subgraphs or access resource variables get a level of
+  // their own. Must be called after PrepareSubgraphs() and before the memory
+  // plan is committed, since the plan has to follow the schedule.
+  virtual TfLiteStatus BuildNodeSchedules();
+
   // Calls TfLiteRegistration->Invoke for every operator in a single subgraph in
-  // the model.
+  // the model. Subgraphs with a schedule are invoked level by level, and the
+  // operators of a level run concurrently when a MicroThreadPool is bound to
+  // the context. Otherwise the subgraph's dispatch table is walked directly,
+  // unless a profiler is attached and needs the per-operator events. With a
+  // weight streamer, the first subgraph is always invoked one operator at a
+  // time. A deferred subgraph is prepared before its first invocation.
   virtual TfLiteStatus InvokeSubgraph(int subgraph_idx);
 
+  // Prepares `subgraph_idx` if it is still deferred. Control flow operators
+  // call this before copying into the inputs of the subgraph, which have no
+  // buffers until then.
+  virtual TfLiteStatus PrepareSubgraphIfDeferred(int subgraph_idx);
+
   // Zeros out all variable tensors in all subgraphs in the model.
   virtual TfLiteStatus ResetVariableTensors();
 
@@ -81,11 +109,55 @@ class MicroGraph {
   // for all per-subgraph allocation data.
   SubgraphAllocations* GetAllocations() { return subgraph_allocations_; }
 
+  // Stages the weights of the first subgraph through `weight_streamer` during
+  // InvokeSubgraph(). Passing nullptr reads them in place again.
+  void SetWeightStreamer(MicroWeightStreamer* weight_streamer) {
+    weight_streamer_ = weight_streamer;
+  }
+
+  // Sets the function that prepares subgraphs marked as deferred in their
+  // SubgraphAllocations when they are first invoked. It has to clear the
+  // deferred flag, and the graph then resets the variable tensors of the
+  // subgraph.
+  void SetDeferredSubgraphPreparer(DeferredSubgraphPreparer preparer,
+                                   void* data) {
+    deferred_subgraph_preparer_ = preparer;
+    deferred_subgraph_preparer_data_ = data;
+  }
+
  private:
+  TfLiteStatus BuildNodeSchedule(int subgraph_idx, NodeSchedule* schedule);
+
+  // Invokes a single operator. Events are recorded in `profiler` unless it is
+  // nullptr. Temp allocations made by the operator are not reset.
+  TfLiteStatus InvokeNode(int subgraph_idx, int node_idx,
+                          MicroProfiler* profiler);
+
+  // Invokes the operators of a dispatch table in order, without profiling.
+  TfLiteStatus InvokeDispatchTable(const NodeDispatch* dispatch_table,
+                                   int dispatch_table_size, int subgraph_idx);
+
+  TfLiteStatus InvokeScheduledSubgraph(int subgraph_idx,
+                                       const NodeSchedule& schedule);
+
+  // Invokes the operators of the first subgraph one at a time while the
+  // weight streamer loads the weights of the next one. Follows the schedule if
+  // there is one, since the memory plan does.
+  TfLiteStatus InvokeStreamedSubgraph(const NodeSchedule* schedule,
+                                      MicroProfiler* profiler);
+
+  TfLiteStatus ResetSubgraphVariableTensors(int subgraph_idx);
+
+  // MicroParallelTask invoking a range of the operators of one level.
+  static void InvokeNodesTask(void* data, int start, int end);
+
   TfLiteContext* context_;
   const Model* model_;
   MicroAllocator* allocator_;
   SubgraphAllocations* subgraph_allocations_ = nullptr;
+  MicroWeightStreamer* weight_streamer_ = nullptr;
+  DeferredSubgraphPreparer deferred_subgraph_preparer_ = nullptr;
+  void* deferred_subgraph_preparer_data_ = nullptr;
   int current_subgraph_index_;
   const flatbuffers::Vector<flatbuffers::Offset<SubGraph>>* subgraphs_;
 
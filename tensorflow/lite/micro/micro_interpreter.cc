@@ -26,12 +26,75 @@ limitations under the License.
 #include "tensorflow/lite/micro/memory_helpers.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_execution_context.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_thread_pool.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/schema/schema_utils.h"
 
 namespace tflite {
+namespace {
+
+// Holds the allocator's non-persistent arena for the lifetime of the scope. An
+// arena that is already held when the scope is entered (e.g. Invoke() calling
+// into AllocateTensors()) stays held when the scope exits.
+class ScopedNonPersistentArena {
+ public:
+  explicit ScopedNonPersistentArena(MicroAllocator& allocator)
+      : allocator_(allocator),
+        already_held_(allocator.HoldsNonPersistentArena()),
+        status_(allocator.AcquireNonPersistentArena()) {}
+
+  ~ScopedNonPersistentArena() {
+    if (!already_held_) {
+      allocator_.ReleaseNonPersistentArena();
+    }
+  }
+
+  TfLiteStatus status() const { return status_; }
+
+ private:
+  MicroAllocator& allocator_;
+  const bool already_held_;
+  const TfLiteStatus status_;
+};
+
+// Allocates two buffer sets for the tensors listed in `tensor_indices`. Set 0
+// is the planned buffer of each tensor, set 1 a buffer of the same size from
+// the persistent section of the arena.
+TfLiteStatus AllocateBufferSets(
+    MicroAllocator& allocator, ErrorReporter* error_reporter,
+    const flatbuffers::Vector<int32_t>& tensor_indices,
+    TfLiteEvalTensor* eval_tensors, void*** buffers) {
+  const size_t tensors_size = tensor_indices.size();
+  *buffers = reinterpret_cast<void**>(
+      allocator.AllocatePersistentBuffer(sizeof(void*) * 2 * tensors_size));
+  if (*buffers == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Failed to allocate memory for pipeline buffers, %d "
+                         "bytes required",
+                         sizeof(void*) * 2 * tensors_size);
+    return kTfLiteError;
+  }
+  for (size_t i = 0; i < tensors_size; ++i) {
+    TfLiteEvalTensor* tensor = &eval_tensors[tensor_indices.Get(i)];
+    size_t bytes;
+    TF_LITE_ENSURE_STATUS(TfLiteEvalTensorByteLength(tensor, &bytes));
+    void* buffer = allocator.AllocatePersistentBuffer(bytes);
+    if (buffer == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Failed to allocate %d bytes for a pipeline buffer",
+                           bytes);
+      return kTfLiteError;
+    }
+    (*buffers)[i] = tensor->data.data;
+    (*buffers)[tensors_size + i] = buffer;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
 
 MicroInterpreter::MicroInterpreter(const Model* model,
                                    const MicroOpResolver& op_resolver,
@@ -71,6 +134,19 @@ MicroInterpreter::MicroInterpreter(const Model* model,
 }
 
 MicroInterpreter::~MicroInterpreter() {
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  if (async_invoke_pending_) {
+    Wait();
+  }
+  if (async_invoke_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(async_invoke_mutex_);
+      async_invoke_stop_ = true;
+    }
+    async_invoke_start_condition_.notify_one();
+    async_invoke_thread_.join();
+  }
+#endif
   if (graph_.GetAllocations() != nullptr) {
     graph_.FreeSubgraphs();
   }
@@ -83,6 +159,7 @@ void MicroInterpreter::Init(MicroProfiler* profiler) {
   context_.ReportError = ReportOpError;
   context_.GetTensor = GetTensor;
   context_.GetEvalTensor = GetEvalTensor;
+  context_.GetExternalContext = GetExternalContext;
   context_.profiler = profiler;
 
   initialization_status_ = kTfLiteOk;
@@ -167,8 +244,12 @@ TfLiteStatus MicroInterpreter::PrepareNodeAndRegistrationDataFromFlatbuffer() {
       TF_LITE_ENSURE_STATUS(allocator_.FlatBufferVectorToTfLiteTypeArray(
           op->outputs(), &outputs_array));
 
-      TfLiteNode* node = &(
-          graph_.GetAllocations()[subgraph_idx].node_and_registrations[i].node);
+      NodeAndRegistration* node_and_registration =
+          &graph_.GetAllocations()[subgraph_idx].node_and_registrations[i];
+      // The tensor tables are resolved once the memory plan is committed.
+      node_and_registration->eval_tensors = nullptr;
+      node_and_registration->eval_shapes = nullptr;
+      TfLiteNode* node = &node_and_registration->node;
       *node = {};
       node->inputs = inputs_array;
       node->outputs = outputs_array;
@@ -189,6 +270,19 @@ TfLiteStatus MicroInterpreter::PrepareNodeAndRegistrationDataFromFlatbuffer() {
 }
 
 TfLiteStatus MicroInterpreter::AllocateTensors() {
+  // Deferred subgraphs are prepared from within Invoke(), which resets the
+  // temp allocations and the head while concurrent operators may use them.
+  if (lazy_subgraph_preparation_ && inter_op_parallelism_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Lazy subgraph preparation can not be combined with "
+                         "inter-op parallelism.");
+    initialization_status_ = kTfLiteError;
+    return kTfLiteError;
+  }
+
+  ScopedNonPersistentArena arena_scope(allocator_);
+  TF_LITE_ENSURE_STATUS(arena_scope.status());
+
   SubgraphAllocations* allocations = allocator_.StartModelAllocation(model_);
 
   if (allocations == nullptr) {
@@ -199,6 +293,13 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
   }
 
   graph_.SetSubgraphAllocations(allocations);
+  if (lazy_subgraph_preparation_) {
+    for (int subgraph_idx = 1; subgraph_idx < graph_.NumSubgraphs();
+         ++subgraph_idx) {
+      allocations[subgraph_idx].deferred = true;
+    }
+    graph_.SetDeferredSubgraphPreparer(PrepareDeferredSubgraph, this);
+  }
 
   TF_LITE_ENSURE_STATUS(PrepareNodeAndRegistrationDataFromFlatbuffer());
 
@@ -214,15 +315,27 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
   context_.RequestScratchBufferInArena = RequestScratchBufferInArena;
   graph_.PrepareSubgraphs();
 
+  // The schedule has to exist before the memory plan is committed, since the
+  // buffer lifetimes follow it.
+  if (inter_op_parallelism_) {
+    TF_LITE_ENSURE_STATUS(graph_.BuildNodeSchedules());
+  }
+
   // Prepare is done, we're ready for Invoke. Memory allocation is no longer
   // allowed. Kernels can only fetch scratch buffers via GetScratchBuffer.
   context_.AllocatePersistentBuffer = nullptr;
   context_.RequestScratchBufferInArena = nullptr;
   context_.GetScratchBuffer = GetScratchBuffer;
 
+  if (pipelining_) {
+    allocator_.PinModelIoBuffers();
+  }
+
   TF_LITE_ENSURE_OK(&context_, allocator_.FinishModelAllocation(
                                    model_, graph_.GetAllocations(),
                                    &scratch_buffer_handles_));
+  TF_LITE_ENSURE_OK(&context_, allocator_.AllocateDispatchTables(
+                                   model_, graph_.GetAllocations()));
 
   // TODO(b/162311891): Drop these allocations when the interpreter supports
   // handling buffers from TfLiteEvalTensor.
@@ -272,6 +385,10 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
     }
   }
 
+  if (pipelining_) {
+    TF_LITE_ENSURE_STATUS(AllocatePipelineBuffers());
+  }
+
   TF_LITE_ENSURE_STATUS(ResetVariableTensors());
 
   tensors_allocated_ = true;
@@ -285,12 +402,239 @@ TfLiteStatus MicroInterpreter::Invoke() {
     return kTfLiteError;
   }
 
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  if (async_invoke_pending_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Wait() must be called before invoking again.");
+    return kTfLiteError;
+  }
+#endif
+
+  // Interpreters sharing a non-persistent arena must not invoke at the same
+  // time, since their activations overlap.
+  ScopedNonPersistentArena arena_scope(allocator_);
+  TF_LITE_ENSURE_STATUS(arena_scope.status());
+
   // Ensure tensors are allocated before the interpreter is invoked to avoid
   // difficult to debug segfaults.
   if (!tensors_allocated_) {
     TF_LITE_ENSURE_OK(&context_, AllocateTensors());
   }
-  return graph_.InvokeSubgraph(0);
+  if (!pipelining_) {
+    return graph_.InvokeSubgraph(0);
+  }
+
+  SwapInputBuffers();
+  const TfLiteStatus status = graph_.InvokeSubgraph(0);
+  // The results of a failed invocation are not handed out, output() keeps
+  // returning the previous ones.
+  if (status == kTfLiteOk) {
+    SwapOutputBuffers();
+  }
+  return status;
+}
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+TfLiteStatus MicroInterpreter::InvokeAsync() {
+  if (initialization_status_ != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "InvokeAsync() called after initialization failed\n");
+    return kTfLiteError;
+  }
+  if (!pipelining_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "InvokeAsync() requires EnablePipelining().");
+    return kTfLiteError;
+  }
+  if (async_invoke_pending_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Wait() must be called before invoking again.");
+    return kTfLiteError;
+  }
+
+  if (!tensors_allocated_) {
+    TF_LITE_ENSURE_OK(&context_, AllocateTensors());
+  }
+  // The arena stays claimed until Wait().
+  TF_LITE_ENSURE_STATUS(allocator_.AcquireNonPersistentArena());
+
+  SwapInputBuffers();
+  if (!async_invoke_thread_.joinable()) {
+    async_invoke_thread_ =
+        std::thread(&MicroInterpreter::AsyncInvokeLoop, this);
+  }
+  {
+    std::lock_guard<std::mutex> lock(async_invoke_mutex_);
+    async_invoke_requested_ = true;
+  }
+  async_invoke_start_condition_.notify_one();
+  async_invoke_pending_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::Wait() {
+  if (!async_invoke_pending_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Wait() called without a pending InvokeAsync().");
+    return kTfLiteError;
+  }
+  {
+    std::unique_lock<std::mutex> lock(async_invoke_mutex_);
+    async_invoke_done_condition_.wait(
+        lock, [this] { return !async_invoke_requested_; });
+  }
+  async_invoke_pending_ = false;
+  allocator_.ReleaseNonPersistentArena();
+
+  if (async_invoke_status_ == kTfLiteOk) {
+    SwapOutputBuffers();
+  }
+  return async_invoke_status_;
+}
+
+void MicroInterpreter::AsyncInvokeLoop() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(async_invoke_mutex_);
+      async_invoke_start_condition_.wait(lock, [this] {
+        return async_invoke_stop_ || async_invoke_requested_;
+      });
+      if (async_invoke_stop_) {
+        return;
+      }
+    }
+
+    const TfLiteStatus status = graph_.InvokeSubgraph(0);
+
+    {
+      std::lock_guard<std::mutex> lock(async_invoke_mutex_);
+      async_invoke_status_ = status;
+      async_invoke_requested_ = false;
+    }
+    async_invoke_done_condition_.notify_one();
+  }
+}
+#endif  // defined(TF_LITE_MICRO_USE_THREADS)
+
+MicroExecutionContext* MicroInterpreter::CreateExecutionContext(
+    uint8_t* buffer, size_t buffer_size, MicroProfiler* profiler) {
+  if (!tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "AllocateTensors() must be called before creating an "
+                         "execution context.");
+    return nullptr;
+  }
+  // The model inputs and outputs may currently point at the second buffer set,
+  // which an execution context would end up sharing with the interpreter.
+  if (pipelining_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Execution contexts can not be created from a "
+                         "pipelined interpreter.");
+    return nullptr;
+  }
+  // Subgraphs prepared later would get buffers that all execution contexts
+  // share.
+  if (lazy_subgraph_preparation_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Execution contexts can not be created from an "
+                         "interpreter with lazy subgraph preparation.");
+    return nullptr;
+  }
+  return MicroExecutionContext::Create(
+      model_, graph_.GetAllocations(), scratch_buffer_handles_,
+      allocator_.scratch_buffer_count(), allocator_.planned_head_buffer(),
+      allocator_.planned_head_bytes(), buffer, buffer_size, error_reporter_,
+      profiler);
+}
+
+void MicroInterpreter::SetThreadPool(MicroThreadPool* thread_pool) {
+  thread_pool_ = thread_pool;
+}
+
+TfLiteStatus MicroInterpreter::EnableInterOpParallelism() {
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "EnableInterOpParallelism() must be called before "
+                         "AllocateTensors().");
+    return kTfLiteError;
+  }
+  inter_op_parallelism_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::EnableLazySubgraphPreparation() {
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "EnableLazySubgraphPreparation() must be called "
+                         "before AllocateTensors().");
+    return kTfLiteError;
+  }
+  lazy_subgraph_preparation_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::EnablePipelining() {
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "EnablePipelining() must be called before "
+                         "AllocateTensors().");
+    return kTfLiteError;
+  }
+  pipelining_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::AllocatePipelineBuffers() {
+  // A tensor that is both an input and an output can not be in two buffer sets
+  // at the same time.
+  for (size_t i = 0; i < inputs_size(); ++i) {
+    for (size_t o = 0; o < outputs_size(); ++o) {
+      if (inputs().Get(i) == outputs().Get(o)) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Pipelining does not support input %d also being "
+                             "output %d.",
+                             i, o);
+        return kTfLiteError;
+      }
+    }
+  }
+
+  TfLiteEvalTensor* eval_tensors = graph_.GetAllocations()[0].tensors;
+  TF_LITE_ENSURE_STATUS(AllocateBufferSets(
+      allocator_, error_reporter_, inputs(), eval_tensors, &input_buffers_));
+  TF_LITE_ENSURE_STATUS(AllocateBufferSets(
+      allocator_, error_reporter_, outputs(), eval_tensors, &output_buffers_));
+  input_set_ = 0;
+  output_set_ = 0;
+  return kTfLiteOk;
+}
+
+void MicroInterpreter::SwapInputBuffers() {
+  TfLiteEvalTensor* eval_tensors = graph_.GetAllocations()[0].tensors;
+  const size_t inputs_count = inputs_size();
+  for (size_t i = 0; i < inputs_count; ++i) {
+    eval_tensors[inputs().Get(i)].data.data =
+        input_buffers_[input_set_ * inputs_count + i];
+  }
+  input_set_ ^= 1;
+  for (size_t i = 0; i < inputs_count; ++i) {
+    input_tensors_[i]->data.data = input_buffers_[input_set_ * inputs_count + i];
+  }
+
+  const size_t outputs_count = outputs_size();
+  for (size_t i = 0; i < outputs_count; ++i) {
+    eval_tensors[outputs().Get(i)].data.data =
+        output_buffers_[output_set_ * outputs_count + i];
+  }
+}
+
+void MicroInterpreter::SwapOutputBuffers() {
+  const size_t outputs_count = outputs_size();
+  for (size_t i = 0; i < outputs_count; ++i) {
+    output_tensors_[i]->data.data =
+        output_buffers_[output_set_ * outputs_count + i];
+  }
+  output_set_ ^= 1;
 }
 
 TfLiteTensor* MicroInterpreter::input(size_t index) {
@@ -330,6 +674,10 @@ TfLiteStatus MicroInterpreter::RequestScratchBufferInArena(TfLiteContext* ctx,
                                                            int* buffer_idx) {
   MicroInterpreter* interpreter =
       reinterpret_cast<MicroInterpreter*>(ctx->impl_);
+  if (interpreter->preparing_deferred_subgraph_) {
+    return interpreter->allocator_.AllocateDeferredScratchBuffer(
+        bytes, &interpreter->scratch_buffer_handles_, buffer_idx);
+  }
   return interpreter->allocator_.RequestScratchBufferInArena(
       bytes, interpreter->graph_.GetCurrentSubgraphIndex(), buffer_idx);
 }
@@ -358,6 +706,19 @@ TfLiteTensor* MicroInterpreter::GetTensor(const struct TfLiteContext* context,
                                           int tensor_idx) {
   MicroInterpreter* interpreter =
       static_cast<MicroInterpreter*>(context->impl_);
+  // Once the tensors are allocated, kernels are only prepared again for
+  // deferred subgraphs. Any other call comes from Eval.
+  if (interpreter->get_tensor_guard_ && interpreter->tensors_allocated_ &&
+      !interpreter->preparing_deferred_subgraph_) {
+    TF_LITE_REPORT_ERROR(interpreter->error_reporter_,
+                         "GetTensor(%d) called during Eval, kernels must use "
+                         "TfLiteEvalTensor instead.",
+                         tensor_idx);
+    return nullptr;
+  }
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  std::lock_guard<std::mutex> lock(interpreter->temp_allocation_mutex_);
+#endif
   return interpreter->allocator_.AllocateTempTfLiteTensor(
       interpreter->model_, interpreter->graph_.GetAllocations(), tensor_idx,
       interpreter->get_subgraph_index());
@@ -372,6 +733,50 @@ TfLiteEvalTensor* MicroInterpreter::GetEvalTensor(
               .tensors[tensor_idx];
 }
 
+TfLiteExternalContext* MicroInterpreter::GetExternalContext(
+    struct TfLiteContext* context, TfLiteExternalContextType type) {
+  MicroInterpreter* interpreter =
+      reinterpret_cast<MicroInterpreter*>(context->impl_);
+  if (type == kTfLiteCpuBackendContext) {
+    return interpreter->thread_pool_;
+  }
+  return nullptr;
+}
+
+TfLiteStatus MicroInterpreter::PrepareDeferredSubgraph(void* data,
+                                                       int subgraph_idx) {
+  MicroInterpreter* interpreter = static_cast<MicroInterpreter*>(data);
+  TfLiteContext& context = interpreter->context_;
+
+  // The kernels get the same context functions as during AllocateTensors().
+  interpreter->preparing_deferred_subgraph_ = true;
+  context.AllocatePersistentBuffer = AllocatePersistentBuffer;
+  context.RequestScratchBufferInArena = nullptr;
+  context.GetScratchBuffer = nullptr;
+  TfLiteStatus status = interpreter->graph_.InitSubgraph(subgraph_idx);
+  context.RequestScratchBufferInArena = RequestScratchBufferInArena;
+  if (status == kTfLiteOk) {
+    status = interpreter->graph_.PrepareSubgraph(subgraph_idx);
+  }
+  context.AllocatePersistentBuffer = nullptr;
+  context.RequestScratchBufferInArena = nullptr;
+  context.GetScratchBuffer = GetScratchBuffer;
+  interpreter->preparing_deferred_subgraph_ = false;
+
+  if (status == kTfLiteOk) {
+    status = interpreter->allocator_.CommitDeferredSubgraph(
+        interpreter->model_, interpreter->graph_.GetAllocations(),
+        subgraph_idx);
+  }
+  if (status != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(interpreter->error_reporter_,
+                         "Failed to prepare subgraph %d on its first "
+                         "invocation.",
+                         subgraph_idx);
+  }
+  return status;
+}
+
 TfLiteStatus MicroInterpreter::GetGraph(struct TfLiteContext* context,
                                         TfLiteIntArray** args) {
   MicroInterpreter* interpreter =
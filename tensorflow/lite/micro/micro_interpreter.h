@@ -18,6 +18,12 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 
+#if defined(TF_LITE_MICRO_USE_THREADS)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
@@ -26,6 +32,8 @@ limitations under the License.
 #include "tensorflow/lite/micro/micro_graph.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_thread_pool.h"
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
 #include "tensorflow/lite/portable_type_to_tflitetype.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -35,6 +43,8 @@ limitations under the License.
 
 namespace tflite {
 
+class MicroExecutionContext;
+
 class MicroInterpreter {
  public:
   // The lifetime of the model, op resolver, tensor arena, error reporter and
@@ -53,7 +63,10 @@ class MicroInterpreter {
   // This constructor should be used when creating an allocator that needs to
   // have allocation handled in more than one interpreter or for recording
   // allocations inside the interpreter. The lifetime of the allocator must be
-  // as long as that of the interpreter object.
+  // as long as that of the interpreter object. Allocators created with a
+  // SharedNonPersistentArena let several interpreters share one activation
+  // region; AllocateTensors() and Invoke() fail while another interpreter is
+  // using that region.
   MicroInterpreter(const Model* model, const MicroOpResolver& op_resolver,
                    MicroAllocator* allocator, ErrorReporter* error_reporter,
                    MicroProfiler* profiler = nullptr);
@@ -110,6 +123,78 @@ class MicroInterpreter {
 
   TfLiteStatus initialization_status() const { return initialization_status_; }
 
+  // Creates an execution context in `buffer` that can invoke this model
+  // independently of the interpreter and of other execution contexts, e.g. from
+  // another thread. The context shares the prepared kernels and memory plan of
+  // the interpreter but owns its activations. Must be called after
+  // AllocateTensors(). Returns nullptr on failure.
+  MicroExecutionContext* CreateExecutionContext(
+      uint8_t* buffer, size_t buffer_size, MicroProfiler* profiler = nullptr);
+
+  // Lets kernels that support it split their work across the threads of
+  // `thread_pool` during Invoke(). Passing nullptr restores single-threaded
+  // execution. The thread pool must outlive the interpreter or be unset first.
+  void SetThreadPool(MicroThreadPool* thread_pool);
+
+  // Lets operators that do not depend on each other, e.g. the branches of an
+  // Inception block, run concurrently on the thread pool set with
+  // SetThreadPool(). Operators are then invoked in the order of a dependency
+  // schedule built during AllocateTensors(), and the memory plan keeps the
+  // buffers of operators that may run at the same time apart, which usually
+  // requires a larger arena. Must be called before AllocateTensors().
+  // Operators only run concurrently in builds with TF_LITE_MICRO_USE_THREADS.
+  TfLiteStatus EnableInterOpParallelism();
+
+  // Defers initializing, preparing and planning the subgraphs invoked by
+  // control flow operators, e.g. the branches of IF, until they are first
+  // invoked. Branches that never run then cost no startup time and no arena.
+  // The activations of a deferred subgraph get a block of the persistent
+  // section of the arena when it is prepared, so the arena has to leave room
+  // for the subgraphs that may run; Invoke() reports an error otherwise.
+  // Scratch buffers of deferred subgraphs are not planned but allocated
+  // persistently as well. Must be called before AllocateTensors(), which
+  // fails if inter-op parallelism is enabled as well.
+  TfLiteStatus EnableLazySubgraphPreparation();
+
+  // Double-buffers the model inputs and outputs, so that the next input can be
+  // filled and the previous output consumed while the model runs. Each
+  // Invoke() consumes the tensors returned by input() and points input() at a
+  // second buffer set for the next call, while output() keeps returning the
+  // results of the last completed invocation. The second buffer set lives in
+  // the persistent section of the arena, and the memory plan keeps the first
+  // one apart from all other activations. Must be called before
+  // AllocateTensors().
+  TfLiteStatus EnablePipelining();
+
+  // Makes GetTensor() fail for kernels that call it during Invoke(): the call
+  // is reported and returns nullptr. Every such call allocates a TfLiteTensor
+  // from temp memory, which kernels avoid by only using TfLiteEvalTensor in
+  // Eval. Meant for finding the kernels of a model that still do.
+  void SetGetTensorGuard(bool enabled) { get_tensor_guard_ = enabled; }
+
+  // Copies the weights of each operator into RAM through `weight_streamer`
+  // before the operator runs, overlapped with the previous operator. Operators
+  // of the first subgraph then run one at a time. Passing nullptr reads the
+  // weights in place again. The streamer must outlive the interpreter or be
+  // unset first.
+  void SetWeightStreamer(MicroWeightStreamer* weight_streamer) {
+    graph_.SetWeightStreamer(weight_streamer);
+  }
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  // Starts an invocation on a worker thread of the interpreter and returns
+  // without waiting for it. The worker is created by the first call and
+  // reused by the later ones. Needs pipelining to be enabled. Until Wait() is
+  // called, only the tensors returned by input() and output() may be used:
+  // they hold the buffers of the next invocation and the results of the
+  // previous one.
+  TfLiteStatus InvokeAsync();
+
+  // Blocks until the invocation started by InvokeAsync() has finished, makes
+  // its results available through output() and returns its status.
+  TfLiteStatus Wait();
+#endif
+
   // Populates node and registration pointers representing the inference graph
   // of the model from values inside the flatbuffer (loaded from the TfLiteModel
   // instance). Persistent data (e.g. operator data) is allocated from the
@@ -117,13 +202,20 @@ class MicroInterpreter {
   TfLiteStatus PrepareNodeAndRegistrationDataFromFlatbuffer();
 
   // For debugging only.
-  // Returns the actual used arena in bytes. This method gives the optimal arena
-  // size. It's only available after `AllocateTensors` has been called.
-  // Note that normally `tensor_arena` requires 16 bytes alignment to fully
-  // utilize the space. If it's not the case, the optimial arena size would be
-  // arena_used_bytes() + 16.
+  // Returns the actual used arena in bytes. It's only available after
+  // `AllocateTensors` has been called. This does not include the temp memory
+  // needed while allocating tensors, use `arena_requirements()` to size the
+  // arena.
   size_t arena_used_bytes() const { return allocator_.used_bytes(); }
 
+  // Returns the smallest arena sizes the model needs, including the temp
+  // memory used while allocating tensors that `arena_used_bytes()` leaves out.
+  // Only available after `AllocateTensors` has been called, see
+  // MicroAllocator::GetArenaRequirements().
+  ArenaRequirements arena_requirements() const {
+    return allocator_.GetArenaRequirements();
+  }
+
  protected:
   const MicroAllocator& allocator() const { return allocator_; }
   const TfLiteContext& context() const { return context_; }
@@ -148,9 +240,31 @@ class MicroInterpreter {
                                  int tensor_idx);
   static TfLiteEvalTensor* GetEvalTensor(const struct TfLiteContext* context,
                                          int tensor_idx);
+  static TfLiteExternalContext* GetExternalContext(
+      struct TfLiteContext* context, TfLiteExternalContextType type);
   static TfLiteStatus GetGraph(struct TfLiteContext* context,
                                TfLiteIntArray** args);
 
+  // DeferredSubgraphPreparer bound to the graph with lazy subgraph
+  // preparation.
+  static TfLiteStatus PrepareDeferredSubgraph(void* data, int subgraph_idx);
+
+  // Allocates the second input and output buffer set used by pipelining.
+  TfLiteStatus AllocatePipelineBuffers();
+
+  // Points the model at the input set filled by the caller and at the output
+  // set to write, and hands the other input set out through input().
+  void SwapInputBuffers();
+
+  // Hands the output set that was just written out through output().
+  void SwapOutputBuffers();
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  // Body of `async_invoke_thread_`: runs an invocation of the first subgraph
+  // each time InvokeAsync() requests one, until the interpreter is destroyed.
+  void AsyncInvokeLoop();
+#endif
+
   const Model* model_;
   const MicroOpResolver& op_resolver_;
   ErrorReporter* error_reporter_;
@@ -163,6 +277,40 @@ class MicroInterpreter {
 
   ScratchBufferHandle* scratch_buffer_handles_ = nullptr;
 
+  MicroThreadPool* thread_pool_ = nullptr;
+  bool inter_op_parallelism_ = false;
+  bool get_tensor_guard_ = false;
+  bool lazy_subgraph_preparation_ = false;
+  bool preparing_deferred_subgraph_ = false;
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  // Serializes the temp allocations of concurrently running operators.
+  std::mutex temp_allocation_mutex_;
+#endif
+
+  bool pipelining_ = false;
+  // Buffer set `s` of model input `i` is input_buffers_[s * inputs_size() + i],
+  // and likewise for outputs. Set 0 is planned in the head of the arena.
+  void** input_buffers_ = nullptr;
+  void** output_buffers_ = nullptr;
+  // Input set handed out through input(), and output set written by the next
+  // invocation.
+  int input_set_ = 0;
+  int output_set_ = 0;
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  // Set by InvokeAsync() and cleared by Wait().
+  bool async_invoke_pending_ = false;
+  std::thread async_invoke_thread_;
+  // Guard the fields below, which are shared with `async_invoke_thread_`.
+  std::mutex async_invoke_mutex_;
+  std::condition_variable async_invoke_start_condition_;
+  std::condition_variable async_invoke_done_condition_;
+  // Set by InvokeAsync() and cleared by the worker once the invocation has
+  // finished.
+  bool async_invoke_requested_ = false;
+  bool async_invoke_stop_ = false;
+  TfLiteStatus async_invoke_status_ = kTfLiteOk;
+#endif
+
   // TODO(b/162311891): Clean these pointers up when this class supports buffers
   // from TfLiteEvalTensor.
   TfLiteTensor** input_tensors_;
@@ -18,10 +18,14 @@ limitations under the License.
 #include <cstdint>
 
 #include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/all_ops_resolver.h"
 #include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_utils.h"
 #include "tensorflow/lite/micro/recording_micro_allocator.h"
 #include "tensorflow/lite/micro/recording_simple_memory_allocator.h"
 #include "tensorflow/lite/micro/test_helpers.h"
@@ -51,6 +55,88 @@ class MockProfiler : public MicroProfiler {
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
+// Computes the same as MockCustom, but reads its inputs through TfLiteTensor
+// during Eval.
+TfLiteStatus GetTensorInEval(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteTensor* input = GetInput(context, node, 0);
+  TF_LITE_ENSURE(context, input != nullptr);
+  const TfLiteTensor* weight = GetInput(context, node, 1);
+  TF_LITE_ENSURE(context, weight != nullptr);
+  TfLiteEvalTensor* output = micro::GetEvalOutput(context, node, 0);
+  output->data.i32[0] = input->data.i32[0] + weight->data.uint8[0];
+  return kTfLiteOk;
+}
+
+// Buffers read and written by each AddWeightToAllElements() call, in order.
+constexpr int kMaxRecordedNodes = 4;
+const int32_t* recorded_inputs[kMaxRecordedNodes];
+const int32_t* recorded_outputs[kMaxRecordedNodes];
+int recorded_nodes = 0;
+
+// Like MockCustom, but writes every element of its output: the input, repeated
+// to the output size, plus the weight.
+TfLiteStatus AddWeightToAllElements(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteEvalTensor* input = micro::GetEvalInput(context, node, 0);
+  const TfLiteEvalTensor* weight = micro::GetEvalInput(context, node, 1);
+  TfLiteEvalTensor* output = micro::GetEvalOutput(context, node, 0);
+  const int input_size = ElementCount(*input->dims);
+  const int output_size = ElementCount(*output->dims);
+  for (int i = 0; i < output_size; ++i) {
+    output->data.i32[i] =
+        input->data.i32[i % input_size] + weight->data.uint8[0];
+  }
+  TF_LITE_ENSURE(context, recorded_nodes < kMaxRecordedNodes);
+  recorded_inputs[recorded_nodes] = input->data.i32;
+  recorded_outputs[recorded_nodes] = output->data.i32;
+  ++recorded_nodes;
+  return kTfLiteOk;
+}
+
+// Number of output elements of the model returned by GetModelWithConv().
+constexpr int kConvOutputSize = 64 * 8 * 16;
+
+// Invokes the model returned by GetModelWithConv() on a fixed input with
+// `thread_pool` bound, if not nullptr, and copies its output to
+// `output_data`. Sets `in_place` if the memory plan places the output over
+// the input.
+void InvokeConvModel(MicroThreadPool* thread_pool, float* output_data,
+                     bool* in_place) {
+  const Model* model = testing::GetModelWithConv();
+  AllOpsResolver op_resolver = testing::GetOpResolver();
+
+  constexpr size_t allocator_buffer_size = 96 * 1024;
+  static uint8_t allocator_buffer[allocator_buffer_size];
+  MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                               allocator_buffer_size,
+                               GetMicroErrorReporter());
+  if (thread_pool != nullptr) {
+    interpreter.SetThreadPool(thread_pool);
+  }
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  TfLiteTensor* input = interpreter.input(0);
+  TfLiteTensor* filter = interpreter.input(1);
+  TfLiteTensor* bias = interpreter.input(2);
+  TfLiteTensor* output = interpreter.output(0);
+  for (size_t i = 0; i < input->bytes / sizeof(float); ++i) {
+    input->data.f[i] = static_cast<float>(static_cast<int>(i % 7) - 3);
+  }
+  for (size_t i = 0; i < filter->bytes / sizeof(float); ++i) {
+    filter->data.f[i] = 0.25f * static_cast<float>(static_cast<int>(i % 5) - 2);
+  }
+  for (size_t i = 0; i < bias->bytes / sizeof(float); ++i) {
+    bias->data.f[i] = 0.5f * static_cast<float>(i);
+  }
+  *in_place = input->data.raw < output->data.raw + output->bytes &&
+              output->data.raw < input->data.raw + input->bytes;
+
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(kConvOutputSize * sizeof(float), output->bytes);
+  for (int i = 0; i < kConvOutputSize; ++i) {
+    output_data[i] = output->data.f[i];
+  }
+}
+
 }  // namespace
 }  // namespace tflite
 
@@ -71,7 +157,9 @@ TF_LITE_MICRO_TEST(TestInterpreter) {
                                          allocator_buffer_size,
                                          tflite::GetMicroErrorReporter());
     TF_LITE_MICRO_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
-    TF_LITE_MICRO_EXPECT_LE(interpreter.arena_used_bytes(), 928 + 100);
+    // The additional 16 bytes are the plan_buffer and plan_bytes fields of the
+    // SubgraphAllocations of the only subgraph, kept in the tail.
+    TF_LITE_MICRO_EXPECT_LE(interpreter.arena_used_bytes(), 928 + 100 + 16);
     TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(1), interpreter.inputs_size());
     TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(2), interpreter.outputs_size());
 
@@ -201,6 +289,59 @@ TF_LITE_MICRO_TEST(TestMultiTenantInterpreter) {
       allocator->GetSimpleMemoryAllocator()->GetHeadUsedBytes());
 }
 
+TF_LITE_MICRO_TEST(TestSharedNonPersistentArenaInterpreters) {
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+  constexpr size_t persistent_arena_size = 4096;
+  constexpr size_t shared_arena_size = 2048;
+  uint8_t persistent_arena0[persistent_arena_size];
+  uint8_t persistent_arena1[persistent_arena_size];
+  uint8_t shared_buffer[shared_arena_size];
+  tflite::SharedNonPersistentArena shared_arena = {shared_buffer,
+                                                   shared_arena_size, nullptr};
+
+  tflite::MicroAllocator* allocator0 = tflite::MicroAllocator::Create(
+      persistent_arena0, persistent_arena_size, &shared_arena,
+      tflite::GetMicroErrorReporter());
+  tflite::MicroAllocator* allocator1 = tflite::MicroAllocator::Create(
+      persistent_arena1, persistent_arena_size, &shared_arena,
+      tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_NE(nullptr, allocator0);
+  TF_LITE_MICRO_EXPECT_NE(nullptr, allocator1);
+
+  tflite::MicroInterpreter interpreter0(tflite::testing::GetComplexMockModel(),
+                                        op_resolver, allocator0,
+                                        tflite::GetMicroErrorReporter());
+  tflite::MicroInterpreter interpreter1(tflite::testing::GetSimpleMockModel(),
+                                        op_resolver, allocator1,
+                                        tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter0.AllocateTensors());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter1.AllocateTensors());
+  TF_LITE_MICRO_EXPECT(nullptr == shared_arena.owner);
+
+  // Both plans start at the beginning of the shared region.
+  TF_LITE_MICRO_EXPECT_LE(interpreter0.input(0)->data.uint8,
+                          shared_buffer + shared_arena_size);
+  TF_LITE_MICRO_EXPECT_GE(interpreter0.input(0)->data.uint8, shared_buffer);
+  TF_LITE_MICRO_EXPECT_LE(interpreter1.input(0)->data.uint8,
+                          shared_buffer + shared_arena_size);
+  TF_LITE_MICRO_EXPECT_GE(interpreter1.input(0)->data.uint8, shared_buffer);
+
+  interpreter0.input(0)->data.i32[0] = 10;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter0.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(10, interpreter0.output(0)->data.i32[0]);
+
+  interpreter1.input(0)->data.i32[0] = 21;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter1.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(42, interpreter1.output(0)->data.i32[0]);
+
+  // Only one interpreter can use the shared region at a time.
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, allocator0->AcquireNonPersistentArena());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter1.Invoke());
+  allocator0->ReleaseNonPersistentArena();
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter1.Invoke());
+  TF_LITE_MICRO_EXPECT(nullptr == shared_arena.owner);
+}
+
 TF_LITE_MICRO_TEST(TestKernelMemoryPlanning) {
   const tflite::Model* model = tflite::testing::GetSimpleStatefulModel();
   TF_LITE_MICRO_EXPECT_NE(nullptr, model);
@@ -254,6 +395,50 @@ TF_LITE_MICRO_TEST(TestKernelMemoryPlanning) {
 // ensures that simply creating and destructing an interpreter object is ok.
 // b/147830765 has one example of a change that caused trouble for this simple
 // case.
+TF_LITE_MICRO_TEST(TestInterpreterArenaRequirementsAreExact) {
+  const tflite::Model* model = tflite::testing::GetComplexMockModel();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+
+  constexpr size_t allocator_buffer_size = 4096;
+  alignas(16) uint8_t allocator_buffer[allocator_buffer_size];
+
+  // Size the arena with a generous buffer first.
+  tflite::ArenaRequirements requirements;
+  {
+    tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                         allocator_buffer_size,
+                                         tflite::GetMicroErrorReporter());
+    TF_LITE_MICRO_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+    TF_LITE_MICRO_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+    requirements = interpreter.arena_requirements();
+    TF_LITE_MICRO_EXPECT_GE(requirements.arena_bytes,
+                            interpreter.arena_used_bytes());
+  }
+  TF_LITE_MICRO_EXPECT_LE(requirements.arena_bytes,
+                          requirements.non_persistent_bytes +
+                              requirements.tail_bytes);
+  TF_LITE_MICRO_EXPECT_GE(requirements.non_persistent_bytes,
+                          requirements.head_bytes +
+                              requirements.temp_peak_bytes);
+
+  // An arena of exactly that size works, one alignment step less does not.
+  {
+    tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                         requirements.arena_bytes,
+                                         tflite::GetMicroErrorReporter());
+    TF_LITE_MICRO_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteOk);
+    TF_LITE_MICRO_EXPECT_EQ(interpreter.Invoke(), kTfLiteOk);
+  }
+  {
+    tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                         requirements.arena_bytes - 16,
+                                         tflite::GetMicroErrorReporter());
+    TF_LITE_MICRO_EXPECT_EQ(interpreter.AllocateTensors(), kTfLiteError);
+  }
+}
+
 TF_LITE_MICRO_TEST(TestIncompleteInitialization) {
   const tflite::Model* model = tflite::testing::GetComplexMockModel();
   TF_LITE_MICRO_EXPECT_NE(nullptr, model);
@@ -493,4 +678,241 @@ TF_LITE_MICRO_TEST(TestInterpreterMultipleInputs) {
   TF_LITE_MICRO_EXPECT_EQ(tflite::testing::MultipleInputs::freed_, true);
 }
 
+TF_LITE_MICRO_TEST(TestInterpreterInterOpParallelism) {
+  const tflite::Model* model = tflite::testing::GetModelWithParallelBranches();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+
+  constexpr size_t allocator_buffer_size = 4096;
+  uint8_t allocator_buffer[allocator_buffer_size];
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  tflite::MicroWorkerPool thread_pool(2);
+#endif
+  tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                       allocator_buffer_size,
+                                       tflite::GetMicroErrorReporter());
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  interpreter.SetThreadPool(&thread_pool);
+#endif
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.EnableInterOpParallelism());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+  // The memory plan has already been committed.
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError,
+                          interpreter.EnableInterOpParallelism());
+
+  for (int i = 0; i < 3; ++i) {
+    interpreter.input(0)->data.i32[0] = 10 + i;
+    interpreter.input(1)->data.uint8[0] = 3;
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+
+    // n0 and n1 both compute t0 + w, n2 sums their outputs and t0.
+    TfLiteTensor* output = interpreter.output(0);
+    TF_LITE_MICRO_EXPECT_NE(nullptr, output);
+    TF_LITE_MICRO_EXPECT_EQ(3 * (10 + i) + 6, output->data.i32[0]);
+  }
+}
+
+TF_LITE_MICRO_TEST(TestInterpreterLazyPreparationWithInterOpParallelism) {
+  const tflite::Model* model =
+      tflite::testing::GetSimpleModelWithSubgraphsAndIf();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+
+  constexpr size_t allocator_buffer_size = 5000;
+  uint8_t allocator_buffer[allocator_buffer_size];
+
+  tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                       allocator_buffer_size,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                          interpreter.EnableLazySubgraphPreparation());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.EnableInterOpParallelism());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.AllocateTensors());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Invoke());
+}
+
+TF_LITE_MICRO_TEST(TestInterpreterInPlaceConvWithThreadPool) {
+  static float serial_output[tflite::kConvOutputSize];
+  bool in_place = false;
+  tflite::InvokeConvModel(nullptr, serial_output, &in_place);
+  // The topological memory planner places the output of the convolution over
+  // its input.
+  TF_LITE_MICRO_EXPECT(in_place);
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  // The output rows must still be computed in order with a thread pool bound,
+  // since later rows overwrite input rows that earlier rows read.
+  tflite::MicroWorkerPool thread_pool(4);
+  static float parallel_output[tflite::kConvOutputSize];
+  for (int i = 0; i < 10; ++i) {
+    tflite::InvokeConvModel(&thread_pool, parallel_output, &in_place);
+    TF_LITE_MICRO_EXPECT(in_place);
+    for (int j = 0; j < tflite::kConvOutputSize; ++j) {
+      TF_LITE_MICRO_EXPECT_NEAR(serial_output[j], parallel_output[j], 0.0f);
+    }
+  }
+#endif
+}
+
+TF_LITE_MICRO_TEST(TestInterpreterReshapeAliasing) {
+  const tflite::Model* model = tflite::testing::GetModelWithReshape();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+
+  constexpr size_t allocator_buffer_size = 2000;
+  uint8_t allocator_buffer[allocator_buffer_size];
+  tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                       allocator_buffer_size,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  interpreter.input(0)->data.i32[0] = 21;
+  interpreter.input(1)->data.uint8[0] = 2;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+
+  // n0 and n2 both add w, the RESHAPE in between reads and writes the same
+  // buffer.
+  TfLiteTensor* output = interpreter.output(0);
+  TF_LITE_MICRO_EXPECT_NE(nullptr, output);
+  TF_LITE_MICRO_EXPECT_EQ(25, output->data.i32[0]);
+}
+
+TF_LITE_MICRO_TEST(TestInterpreterConcatenationInPlace) {
+  const tflite::Model* model = tflite::testing::GetModelWithConcatenation();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+
+  TfLiteRegistration registration = {};
+  registration.invoke = tflite::AddWeightToAllElements;
+  tflite::MicroMutableOpResolver<2> op_resolver;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                          op_resolver.AddCustom("mock_custom", &registration));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, op_resolver.AddConcatenation());
+
+  constexpr size_t allocator_buffer_size = 4096;
+  uint8_t allocator_buffer[allocator_buffer_size];
+  tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                       allocator_buffer_size,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  int32_t* input = interpreter.input(0)->data.i32;
+  for (int i = 0; i < 4; ++i) {
+    input[i] = 21 + i;
+  }
+  interpreter.input(1)->data.uint8[0] = 2;
+  tflite::recorded_nodes = 0;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+
+  // n0 and n1 write their outputs straight into the two halves of the
+  // concatenation output, which n3 reads.
+  TF_LITE_MICRO_EXPECT_EQ(3, tflite::recorded_nodes);
+  const int32_t* concatenation_output = tflite::recorded_inputs[2];
+  TF_LITE_MICRO_EXPECT(tflite::recorded_outputs[0] == concatenation_output);
+  TF_LITE_MICRO_EXPECT(tflite::recorded_outputs[1] ==
+                       concatenation_output + 4);
+
+  // Both halves hold t0 + w, and n3 adds w once more.
+  TfLiteTensor* output = interpreter.output(0);
+  TF_LITE_MICRO_EXPECT_NE(nullptr, output);
+  TF_LITE_MICRO_EXPECT_EQ(8, tflite::ElementCount(*output->dims));
+  for (int i = 0; i < 8; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(25 + i % 4, output->data.i32[i]);
+  }
+}
+
+TF_LITE_MICRO_TEST(TestInterpreterPipelining) {
+  const tflite::Model* model = tflite::testing::GetSimpleMockModel();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+
+  tflite::AllOpsResolver op_resolver = tflite::testing::GetOpResolver();
+
+  constexpr size_t allocator_buffer_size = 2000;
+  uint8_t allocator_buffer[allocator_buffer_size];
+  tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                       allocator_buffer_size,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.EnablePipelining());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.EnablePipelining());
+
+  int32_t* first_input = interpreter.input(0)->data.i32;
+  first_input[0] = 1;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(22, interpreter.output(0)->data.i32[0]);
+  int32_t* first_output = interpreter.output(0)->data.i32;
+
+  // The next input goes to the other buffer set, and filling it leaves the
+  // previous results alone.
+  int32_t* second_input = interpreter.input(0)->data.i32;
+  TF_LITE_MICRO_EXPECT(second_input != first_input);
+  second_input[0] = 2;
+  TF_LITE_MICRO_EXPECT_EQ(22, interpreter.output(0)->data.i32[0]);
+
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(23, interpreter.output(0)->data.i32[0]);
+  TF_LITE_MICRO_EXPECT_EQ(23, interpreter.output(1)->data.i32[0]);
+  TF_LITE_MICRO_EXPECT(interpreter.output(0)->data.i32 != first_output);
+  TF_LITE_MICRO_EXPECT(interpreter.input(0)->data.i32 == first_input);
+  // The results of the first invocation are still in their buffer.
+  TF_LITE_MICRO_EXPECT_EQ(22, first_output[0]);
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+  for (int i = 0; i < 4; ++i) {
+    interpreter.input(0)->data.i32[0] = 3 + i;
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.InvokeAsync());
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Invoke());
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.InvokeAsync());
+
+    // Prepare the next input and consume the previous output while the model
+    // runs.
+    interpreter.input(0)->data.i32[0] = -1;
+    TF_LITE_MICRO_EXPECT_EQ(22 + i + 1, interpreter.output(0)->data.i32[0]);
+
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Wait());
+    TF_LITE_MICRO_EXPECT_EQ(24 + i, interpreter.output(0)->data.i32[0]);
+  }
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Wait());
+
+  // The worker of InvokeAsync() stays idle in between, synchronous
+  // invocations still run on the calling thread.
+  interpreter.input(0)->data.i32[0] = 10;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(31, interpreter.output(0)->data.i32[0]);
+
+  // A pending invocation is finished before the interpreter is destroyed.
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.InvokeAsync());
+#endif
+}
+
+TF_LITE_MICRO_TEST(TestInterpreterGetTensorGuard) {
+  const tflite::Model* model = tflite::testing::GetSimpleMockModel();
+  TF_LITE_MICRO_EXPECT_NE(nullptr, model);
+
+  TfLiteRegistration registration = {};
+  registration.invoke = tflite::GetTensorInEval;
+  tflite::MicroMutableOpResolver<1> op_resolver;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                          op_resolver.AddCustom("mock_custom", &registration));
+
+  constexpr size_t allocator_buffer_size = 2000;
+  uint8_t allocator_buffer[allocator_buffer_size];
+  tflite::MicroInterpreter interpreter(model, op_resolver, allocator_buffer,
+                                       allocator_buffer_size,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+  interpreter.input(0)->data.i32[0] = 21;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(42, interpreter.output(0)->data.i32[0]);
+
+  interpreter.SetGetTensorGuard(true);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Invoke());
+
+  interpreter.SetGetTensorGuard(false);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+}
+
 TF_LITE_MICRO_TESTS_END
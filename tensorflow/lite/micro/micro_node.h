@@ -0,0 +1,46 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_NODE_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_NODE_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+
+// A node of a subgraph with its registration and the tables TFLM resolves for
+// it once the memory plan is committed. Every TfLiteNode that TFLM hands to a
+// kernel is the `node` member of a NodeAndRegistration, so the kernel helpers
+// can reach the tables from the TfLiteNode pointer, see GetNodeAndRegistration.
+typedef struct {
+  TfLiteNode node;
+  const TfLiteRegistration* registration;
+  // Eval tensors of the node inputs followed by those of its outputs. Missing
+  // optional inputs map to nullptr. nullptr if the node was not resolved yet.
+  TfLiteEvalTensor** eval_tensors;
+  // Shapes of `eval_tensors`, in the same order. Missing optional inputs map
+  // to an empty shape. Set along with `eval_tensors`.
+  const RuntimeShape* const* eval_shapes;
+} NodeAndRegistration;
+
+// Returns the NodeAndRegistration whose `node` member is `node`.
+inline const NodeAndRegistration* GetNodeAndRegistration(
+    const TfLiteNode* node) {
+  return reinterpret_cast<const NodeAndRegistration*>(node);
+}
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_NODE_H_
@@ -0,0 +1,147 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_thread_pool.h"
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+
+MicroThreadPool* GetMicroThreadPool(TfLiteContext* context) {
+  if (context == nullptr || context->GetExternalContext == nullptr) {
+    return nullptr;
+  }
+  TfLiteExternalContext* external_context =
+      context->GetExternalContext(context, kTfLiteCpuBackendContext);
+  if (external_context == nullptr) {
+    return nullptr;
+  }
+  return static_cast<MicroThreadPool*>(external_context);
+}
+
+void ParallelFor(TfLiteContext* context, int count, MicroParallelTask task,
+                 void* data) {
+  if (count <= 0) {
+    return;
+  }
+  MicroThreadPool* thread_pool = GetMicroThreadPool(context);
+  const int num_threads =
+      thread_pool != nullptr ? thread_pool->num_threads() : 1;
+  if (num_threads <= 1 || count == 1 || thread_pool->IsRunning()) {
+    task(data, 0, count);
+    return;
+  }
+  thread_pool->Run(task, data, count,
+                   count < num_threads ? count : num_threads);
+}
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+
+MicroWorkerPool::MicroWorkerPool(int num_threads)
+    : next_task_(0), running_(false) {
+  if (num_threads < 1) {
+    num_threads = 1;
+  } else if (num_threads > kMaxThreads) {
+    num_threads = kMaxThreads;
+  }
+  num_workers_ = num_threads - 1;
+  for (int i = 0; i < num_workers_; ++i) {
+    workers_[i] = std::thread(&MicroWorkerPool::WorkerLoop, this);
+  }
+}
+
+MicroWorkerPool::~MicroWorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_condition_.notify_all();
+  for (int i = 0; i < num_workers_; ++i) {
+    workers_[i].join();
+  }
+}
+
+void MicroWorkerPool::Run(MicroParallelTask task, void* data, int count,
+                          int num_tasks) {
+  if (num_workers_ == 0 || num_tasks <= 1) {
+    task(data, 0, count);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = task;
+    data_ = data;
+    count_ = count;
+    num_tasks_ = num_tasks;
+    next_task_.store(0, std::memory_order_relaxed);
+    busy_workers_ = num_workers_;
+    // Set before the workers can see the new generation, so that none of the
+    // tasks misses it.
+    running_.store(true, std::memory_order_release);
+    ++generation_;
+  }
+  start_condition_.notify_all();
+
+  RunTasks();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_condition_.wait(lock, [this] { return busy_workers_ == 0; });
+  running_.store(false, std::memory_order_release);
+}
+
+void MicroWorkerPool::WorkerLoop() {
+  unsigned int seen_generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_condition_.wait(lock, [this, seen_generation] {
+        return stop_ || generation_ != seen_generation;
+      });
+      if (stop_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+
+    RunTasks();
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --busy_workers_;
+    }
+    done_condition_.notify_one();
+  }
+}
+
+void MicroWorkerPool::RunTasks() {
+  // Ranges are handed out through a single atomic counter so that threads that
+  // finish early pick up the remaining work without taking the lock.
+  int task_index = next_task_.fetch_add(1, std::memory_order_relaxed);
+  while (task_index < num_tasks_) {
+    const int start = static_cast<int>(
+        static_cast<int64_t>(count_) * task_index / num_tasks_);
+    const int end = static_cast<int>(
+        static_cast<int64_t>(count_) * (task_index + 1) / num_tasks_);
+    task_(data_, start, end);
+    task_index = next_task_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+#endif  // defined(TF_LITE_MICRO_USE_THREADS)
+
+}  // namespace tflite
@@ -0,0 +1,130 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_THREAD_POOL_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_THREAD_POOL_H_
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/compatibility.h"
+
+namespace tflite {
+
+// Work item run by a MicroThreadPool. Processes the elements [start, end) of
+// the range that was handed to MicroThreadPool::Run().
+typedef void (*MicroParallelTask)(void* data, int start, int end);
+
+// Interface used by kernels to split the work of a single operator across
+// several cores. An implementation is made available to kernels through
+// TfLiteContext::GetExternalContext() with the kTfLiteCpuBackendContext type,
+// see MicroInterpreter::SetThreadPool(). When no thread pool is set, which is
+// the default on microcontrollers, kernels run single-threaded.
+class MicroThreadPool : public TfLiteExternalContext {
+ public:
+  MicroThreadPool() {
+    type = kTfLiteCpuBackendContext;
+    Refresh = nullptr;
+  }
+  virtual ~MicroThreadPool() = default;
+
+  // Number of threads that work is split across, including the thread calling
+  // Run().
+  virtual int num_threads() const = 0;
+
+  // Splits [0, count) into `num_tasks` contiguous ranges and calls `task` once
+  // for each of them. Blocks until all of the ranges have been processed. The
+  // calling thread takes part in the work. Only one thread may call Run() at a
+  // time.
+  virtual void Run(MicroParallelTask task, void* data, int count,
+                   int num_tasks) = 0;
+
+  // Returns true while Run() spreads tasks across several threads. Since only
+  // one thread may call Run() at a time, a caller that sees the pool running
+  // is one of its tasks and must not nest another Run().
+  virtual bool IsRunning() const { return false; }
+
+ private:
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+// Returns the thread pool bound to `context`, or nullptr if there is none.
+MicroThreadPool* GetMicroThreadPool(TfLiteContext* context);
+
+// Runs `task` over [0, count), split across the thread pool bound to
+// `context`. Runs `task` once over the whole range on the calling thread if no
+// thread pool is available, or if it is already running, e.g. because the
+// caller is an operator run concurrently with others of its level.
+void ParallelFor(TfLiteContext* context, int count, MicroParallelTask task,
+                 void* data);
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+// MicroThreadPool backed by a fixed set of worker threads that are spawned on
+// construction and joined on destruction. Run() does not allocate: the
+// workers are woken up and pull ranges off a shared atomic counter until the
+// work is exhausted.
+class MicroWorkerPool : public MicroThreadPool {
+ public:
+  static constexpr int kMaxThreads = 16;
+
+  // Creates a pool that splits work across `num_threads` threads, the caller
+  // of Run() included. `num_threads` is clamped to [1, kMaxThreads].
+  explicit MicroWorkerPool(int num_threads);
+  ~MicroWorkerPool() override;
+
+  int num_threads() const override { return num_workers_ + 1; }
+
+  void Run(MicroParallelTask task, void* data, int count,
+           int num_tasks) override;
+
+  bool IsRunning() const override {
+    return running_.load(std::memory_order_acquire);
+  }
+
+ private:
+  void WorkerLoop();
+  void RunTasks();
+
+  std::thread workers_[kMaxThreads - 1];
+  int num_workers_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable start_condition_;
+  std::condition_variable done_condition_;
+  // Incremented by Run() to signal the workers that new work is available.
+  unsigned int generation_ = 0;
+  int busy_workers_ = 0;
+  bool stop_ = false;
+
+  MicroParallelTask task_ = nullptr;
+  void* data_ = nullptr;
+  int count_ = 0;
+  int num_tasks_ = 0;
+  std::atomic<int> next_task_;
+  // Set by Run() for as long as the workers take part in the work.
+  std::atomic<bool> running_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+#endif  // defined(TF_LITE_MICRO_USE_THREADS)
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_THREAD_POOL_H_
@@ -0,0 +1,152 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_thread_pool.h"
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace {
+
+constexpr int kCount = 1000;
+
+struct Counts {
+  int hits[kCount];
+  int calls;
+};
+
+void CountRange(void* data, int start, int end) {
+  Counts* counts = static_cast<Counts*>(data);
+  for (int i = start; i < end; ++i) {
+    counts->hits[i]++;
+  }
+}
+
+void CountCalls(void* data, int start, int end) {
+  static_cast<Counts*>(data)->calls++;
+}
+
+tflite::MicroThreadPool* thread_pool = nullptr;
+
+TfLiteExternalContext* GetExternalContext(TfLiteContext* context,
+                                          TfLiteExternalContextType type) {
+  return type == kTfLiteCpuBackendContext ? thread_pool : nullptr;
+}
+
+struct NestedCounts {
+  TfLiteContext* context;
+  bool saw_pool_idle;
+  Counts inner[4];
+};
+
+void RunNestedParallelFor(void* data, int start, int end) {
+  NestedCounts* nested = static_cast<NestedCounts*>(data);
+  for (int i = start; i < end; ++i) {
+    if (!thread_pool->IsRunning()) {
+      nested->saw_pool_idle = true;
+    }
+    tflite::ParallelFor(nested->context, kCount, CountCalls,
+                        &nested->inner[i]);
+  }
+}
+
+}  // namespace
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(TestParallelForWithoutThreadPoolRunsOnce) {
+  TfLiteContext context = {};
+  static Counts counts = {};
+  TF_LITE_MICRO_EXPECT(tflite::GetMicroThreadPool(&context) == nullptr);
+
+  tflite::ParallelFor(&context, kCount, CountCalls, &counts);
+  TF_LITE_MICRO_EXPECT_EQ(1, counts.calls);
+
+  context.GetExternalContext = GetExternalContext;
+  thread_pool = nullptr;
+  tflite::ParallelFor(&context, kCount, CountCalls, &counts);
+  TF_LITE_MICRO_EXPECT_EQ(2, counts.calls);
+
+  tflite::ParallelFor(&context, 0, CountCalls, &counts);
+  TF_LITE_MICRO_EXPECT_EQ(2, counts.calls);
+
+  tflite::ParallelFor(&context, kCount, CountRange, &counts);
+  for (int i = 0; i < kCount; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(1, counts.hits[i]);
+  }
+}
+
+#if defined(TF_LITE_MICRO_USE_THREADS)
+TF_LITE_MICRO_TEST(TestWorkerPoolCoversRangeExactlyOnce) {
+  tflite::MicroWorkerPool pool(4);
+  TF_LITE_MICRO_EXPECT_EQ(4, pool.num_threads());
+  thread_pool = &pool;
+
+  TfLiteContext context = {};
+  context.GetExternalContext = GetExternalContext;
+  TF_LITE_MICRO_EXPECT(tflite::GetMicroThreadPool(&context) == &pool);
+
+  static Counts counts = {};
+  constexpr int kIterations = 100;
+  for (int i = 0; i < kIterations; ++i) {
+    tflite::ParallelFor(&context, kCount, CountRange, &counts);
+  }
+  for (int i = 0; i < kCount; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(kIterations, counts.hits[i]);
+  }
+
+  // Ranges shorter than the number of threads are split into single elements.
+  static Counts short_counts = {};
+  tflite::ParallelFor(&context, 3, CountRange, &short_counts);
+  TF_LITE_MICRO_EXPECT_EQ(1, short_counts.hits[0]);
+  TF_LITE_MICRO_EXPECT_EQ(1, short_counts.hits[1]);
+  TF_LITE_MICRO_EXPECT_EQ(1, short_counts.hits[2]);
+  TF_LITE_MICRO_EXPECT_EQ(0, short_counts.hits[3]);
+
+  thread_pool = nullptr;
+}
+
+TF_LITE_MICRO_TEST(TestNestedParallelForRunsSerially) {
+  tflite::MicroWorkerPool pool(4);
+  thread_pool = &pool;
+
+  TfLiteContext context = {};
+  context.GetExternalContext = GetExternalContext;
+
+  static NestedCounts nested = {};
+  nested.context = &context;
+  TF_LITE_MICRO_EXPECT(!pool.IsRunning());
+  tflite::ParallelFor(&context, 4, RunNestedParallelFor, &nested);
+  TF_LITE_MICRO_EXPECT(!pool.IsRunning());
+  TF_LITE_MICRO_EXPECT(!nested.saw_pool_idle);
+  // The pool is busy with the outer loop, so each inner loop runs as a single
+  // call on the calling worker.
+  for (int i = 0; i < 4; ++i) {
+    TF_LITE_MICRO_EXPECT_EQ(1, nested.inner[i].calls);
+  }
+
+  thread_pool = nullptr;
+}
+
+TF_LITE_MICRO_TEST(TestWorkerPoolClampsThreadCount) {
+  tflite::MicroWorkerPool single(0);
+  TF_LITE_MICRO_EXPECT_EQ(1, single.num_threads());
+  tflite::MicroWorkerPool many(1000);
+  TF_LITE_MICRO_EXPECT_EQ(tflite::MicroWorkerPool::kMaxThreads,
+                          many.num_threads());
+}
+#endif  // defined(TF_LITE_MICRO_USE_THREADS)
+
+TF_LITE_MICRO_TESTS_END
@@ -0,0 +1,172 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+// Staged tensors get the same alignment as tensors planned in the arena.
+constexpr size_t kBufferAlignment = 16;
+
+}  // namespace
+
+MicroWeightStreamer::MicroWeightStreamer(const uint8_t* model_data,
+                                         MicroWeightReader* reader,
+                                         uint8_t* staging_buffer,
+                                         size_t staging_buffer_size)
+    : model_data_(model_data), reader_(reader) {
+  uint8_t* aligned_buffer = AlignPointerUp(staging_buffer, kBufferAlignment);
+  const size_t alignment_loss = aligned_buffer - staging_buffer;
+  if (staging_buffer != nullptr && staging_buffer_size > alignment_loss) {
+    slot_size_ = (staging_buffer_size - alignment_loss) / 2;
+    slot_size_ -= slot_size_ % kBufferAlignment;
+  }
+  for (int i = 0; i < 2; ++i) {
+    slots_[i].data = aligned_buffer + i * slot_size_;
+    slots_[i].node_idx = -1;
+    slots_[i].tensors_size = 0;
+  }
+}
+
+TfLiteStatus MicroWeightStreamer::Begin(const Model* model,
+                                        SubgraphAllocations* allocations,
+                                        int first_node_idx) {
+  if (model != GetModel(model_data_)) {
+    MicroPrintf("The weight streamer was created for a different model.");
+    return kTfLiteError;
+  }
+  model_ = model;
+  allocations_ = allocations;
+  bound_slot_ = nullptr;
+  return StartLoad(first_node_idx, &slots_[0]);
+}
+
+TfLiteStatus MicroWeightStreamer::AcquireNode(int node_idx,
+                                              int next_node_idx) {
+  Slot* slot = loading_slot_;
+  if (slot == nullptr || slot->node_idx != node_idx) {
+    // The operators ran in a different order than announced.
+    TF_LITE_ENSURE_STATUS(End());
+    slot = bound_slot_ == &slots_[0] ? &slots_[1] : &slots_[0];
+    TF_LITE_ENSURE_STATUS(StartLoad(node_idx, slot));
+  }
+  if (reads_pending_) {
+    reads_pending_ = false;
+    TF_LITE_ENSURE_STATUS(reader_->WaitForReads());
+  }
+  ReleaseNode();
+
+  TfLiteEvalTensor* tensors = allocations_[0].tensors;
+  for (int i = 0; i < slot->tensors_size; ++i) {
+    tensors[slot->tensor_indices[i]].data.data = slot->staged_data[i];
+  }
+  bound_slot_ = slot;
+
+  if (next_node_idx >= 0) {
+    return StartLoad(next_node_idx, slot == &slots_[0] ? &slots_[1]
+                                                       : &slots_[0]);
+  }
+  loading_slot_ = nullptr;
+  return kTfLiteOk;
+}
+
+void MicroWeightStreamer::ReleaseNode() {
+  if (bound_slot_ == nullptr) {
+    return;
+  }
+  TfLiteEvalTensor* tensors = allocations_[0].tensors;
+  for (int i = 0; i < bound_slot_->tensors_size; ++i) {
+    const int tensor_idx = bound_slot_->tensor_indices[i];
+    tensors[tensor_idx].data.data = const_cast<uint8_t*>(
+        model_->buffers()
+            ->Get(model_->subgraphs()->Get(0)->tensors()->Get(tensor_idx)
+                      ->buffer())
+            ->data()
+            ->data());
+  }
+  bound_slot_ = nullptr;
+}
+
+TfLiteStatus MicroWeightStreamer::End() {
+  TfLiteStatus status = kTfLiteOk;
+  if (reads_pending_) {
+    reads_pending_ = false;
+    status = reader_->WaitForReads();
+  }
+  loading_slot_ = nullptr;
+  ReleaseNode();
+  return status;
+}
+
+TfLiteStatus MicroWeightStreamer::StartLoad(int node_idx, Slot* slot) {
+  slot->node_idx = node_idx;
+  slot->tensors_size = 0;
+  loading_slot_ = slot;
+
+  const TfLiteIntArray* inputs =
+      allocations_[0].node_and_registrations[node_idx].node.inputs;
+  size_t used_bytes = 0;
+  for (int i = 0; i < inputs->size; ++i) {
+    if (slot->tensors_size == kMaxStagedTensors) {
+      break;
+    }
+    const int tensor_idx = inputs->data[i];
+    const flatbuffers::Vector<uint8_t>* data = ConstantData(tensor_idx);
+    if (data == nullptr) {
+      continue;
+    }
+    bool already_staged = false;
+    for (int j = 0; j < slot->tensors_size; ++j) {
+      already_staged |= slot->tensor_indices[j] == tensor_idx;
+    }
+    const size_t staged_offset = AlignSizeUp(used_bytes, kBufferAlignment);
+    if (already_staged || staged_offset + data->size() > slot_size_) {
+      continue;
+    }
+
+    uint8_t* dest = slot->data + staged_offset;
+    TF_LITE_ENSURE_STATUS(reader_->StartRead(data->data() - model_data_,
+                                             data->size(), dest));
+    reads_pending_ = true;
+    slot->tensor_indices[slot->tensors_size] = tensor_idx;
+    slot->staged_data[slot->tensors_size] = dest;
+    ++slot->tensors_size;
+    used_bytes = staged_offset + data->size();
+    streamed_bytes_ += data->size();
+  }
+  return kTfLiteOk;
+}
+
+const flatbuffers::Vector<uint8_t>* MicroWeightStreamer::ConstantData(
+    int tensor_idx) const {
+  if (tensor_idx < 0) {
+    return nullptr;
+  }
+  const Tensor* tensor = model_->subgraphs()->Get(0)->tensors()->Get(tensor_idx);
+  const flatbuffers::Vector<uint8_t>* data =
+      model_->buffers()->Get(tensor->buffer())->data();
+  if (data == nullptr || data->size() == 0 ||
+      allocations_[0].tensors[tensor_idx].data.data != data->data()) {
+    return nullptr;
+  }
+  return data;
+}
+
+}  // namespace tflite
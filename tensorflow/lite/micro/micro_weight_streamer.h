@@ -0,0 +1,126 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_STREAMER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_STREAMER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Copies constant tensor data of a model from the storage it is kept in, e.g.
+// QSPI flash or a file, into RAM. Offsets are relative to the start of the
+// model flatbuffer.
+class MicroWeightReader {
+ public:
+  virtual ~MicroWeightReader() = default;
+
+  // Queues a copy of `size` bytes at `offset` into `dest`. The copy may run in
+  // the background, e.g. on a DMA engine, and `dest` must not be read before
+  // WaitForReads() returns. Queued copies are not reordered.
+  virtual TfLiteStatus StartRead(size_t offset, size_t size, uint8_t* dest) = 0;
+
+  // Blocks until all queued copies have finished. Returns an error if any of
+  // them failed.
+  virtual TfLiteStatus WaitForReads() = 0;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+// Stages the constant inputs of each operator in RAM before the operator is
+// invoked, and loads those of the next operator while the current one runs.
+// The staging buffer is split into two slots that take turns. The constant
+// inputs of an operator are packed into its slot in input order, and the
+// ones that do not fit any more are read in place.
+//
+// Kernels see the staged copies through their TfLiteEvalTensor data pointers,
+// which are pointed back at the model after each operator. The flatbuffer
+// itself still has to be addressable, since kernels read their weights in
+// place during Prepare and the tensors are found through it. This pays off
+// when that memory is much slower than RAM, e.g. memory-mapped flash.
+//
+// Only the operators of the first subgraph stream their weights; subgraphs
+// invoked by control flow operators read theirs in place.
+class MicroWeightStreamer {
+ public:
+  // `model_data` is the flatbuffer the model was loaded from, and offsets
+  // passed to `reader` are relative to it. Neither the reader nor the
+  // staging buffer are owned, and both must outlive the streamer.
+  MicroWeightStreamer(const uint8_t* model_data, MicroWeightReader* reader,
+                      uint8_t* staging_buffer, size_t staging_buffer_size);
+
+  // Starts loading the inputs of `first_node_idx`, the first operator of the
+  // invocation. Fails if `model` was not loaded from the model data.
+  TfLiteStatus Begin(const Model* model, SubgraphAllocations* allocations,
+                     int first_node_idx);
+
+  // Waits for the inputs of `node_idx` and points its constant inputs at the
+  // staged copies, then starts loading the inputs of `next_node_idx` into the
+  // other slot. `next_node_idx` is -1 for the last operator.
+  TfLiteStatus AcquireNode(int node_idx, int next_node_idx);
+
+  // Waits for any load still in flight and releases the last operator. Must
+  // be called after Begin(), also when the invocation fails.
+  TfLiteStatus End();
+
+  // Bytes copied by the reader since the streamer was created.
+  size_t streamed_bytes() const { return streamed_bytes_; }
+
+ private:
+  // Inputs beyond this count are read in place.
+  static constexpr int kMaxStagedTensors = 8;
+
+  struct Slot {
+    uint8_t* data;
+    int node_idx;
+    int tensors_size;
+    int tensor_indices[kMaxStagedTensors];
+    uint8_t* staged_data[kMaxStagedTensors];
+  };
+
+  // Points the constant inputs of the last acquired operator back at the
+  // model.
+  void ReleaseNode();
+
+  // Queues reads for the constant inputs of `node_idx` into `slot`.
+  TfLiteStatus StartLoad(int node_idx, Slot* slot);
+
+  // Returns the model buffer of the tensor, or nullptr if the tensor is not
+  // constant or its eval tensor does not point at the model.
+  const flatbuffers::Vector<uint8_t>* ConstantData(int tensor_idx) const;
+
+  const uint8_t* model_data_;
+  MicroWeightReader* reader_;
+  size_t slot_size_ = 0;
+  Slot slots_[2];
+  // Slot of the last acquired operator, or nullptr.
+  Slot* bound_slot_ = nullptr;
+  // Slot that reads were queued for last.
+  Slot* loading_slot_ = nullptr;
+  bool reads_pending_ = false;
+
+  const Model* model_ = nullptr;
+  SubgraphAllocations* allocations_ = nullptr;
+  size_t streamed_bytes_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_WEIGHT_STREAMER_H_
@@ -0,0 +1,205 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+#include "tensorflow/lite/micro/testing/test_conv_model.h"
+
+namespace tflite {
+namespace {
+
+constexpr size_t kTensorArenaSize = 1024 * 16;
+alignas(16) uint8_t tensor_arena[kTensorArenaSize];
+
+constexpr size_t kStagingBufferSize = 1024 * 4;
+uint8_t staging_buffer[kStagingBufferSize];
+
+constexpr int kMaxOutputBytes = 1024;
+
+// Defers the copies until WaitForReads(), like a DMA engine would finish them
+// in the background, so reading a slot too early shows up as wrong results.
+class DeferredWeightReader : public MicroWeightReader {
+ public:
+  explicit DeferredWeightReader(const uint8_t* model_data)
+      : model_data_(model_data) {}
+
+  TfLiteStatus StartRead(size_t offset, size_t size, uint8_t* dest) override {
+    if (pending_size_ == kMaxPendingReads) {
+      return kTfLiteError;
+    }
+    pending_[pending_size_++] = {offset, size, dest};
+    ++reads_;
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus WaitForReads() override {
+    for (int i = 0; i < pending_size_; ++i) {
+      std::memcpy(pending_[i].dest, model_data_ + pending_[i].offset,
+                  pending_[i].size);
+    }
+    pending_size_ = 0;
+    return fail_ ? kTfLiteError : kTfLiteOk;
+  }
+
+  int reads() const { return reads_; }
+  void set_fail(bool fail) { fail_ = fail; }
+
+ private:
+  static constexpr int kMaxPendingReads = 16;
+
+  struct PendingRead {
+    size_t offset;
+    size_t size;
+    uint8_t* dest;
+  };
+
+  const uint8_t* model_data_;
+  PendingRead pending_[kMaxPendingReads];
+  int pending_size_ = 0;
+  int reads_ = 0;
+  bool fail_ = false;
+};
+
+void FillInput(TfLiteTensor* input) {
+  for (size_t i = 0; i < input->bytes; ++i) {
+    input->data.raw[i] = static_cast<char>(i * 7 % 251);
+  }
+}
+
+}  // namespace
+}  // namespace tflite
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(TestStreamedInvokeMatchesInPlaceInvoke) {
+  const tflite::Model* model = tflite::GetModel(kTestConvModelData);
+  tflite::AllOpsResolver op_resolver;
+  tflite::MicroInterpreter interpreter(model, op_resolver, tflite::tensor_arena,
+                                       tflite::kTensorArenaSize,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  tflite::FillInput(interpreter.input(0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  const size_t output_bytes = interpreter.output(0)->bytes;
+  TF_LITE_MICRO_EXPECT_LE(output_bytes,
+                          static_cast<size_t>(tflite::kMaxOutputBytes));
+  char expected[tflite::kMaxOutputBytes];
+  std::memcpy(expected, interpreter.output(0)->data.raw, output_bytes);
+
+  tflite::DeferredWeightReader reader(kTestConvModelData);
+  tflite::MicroWeightStreamer streamer(kTestConvModelData, &reader,
+                                       tflite::staging_buffer,
+                                       tflite::kStagingBufferSize);
+  interpreter.SetWeightStreamer(&streamer);
+  std::memset(interpreter.output(0)->data.raw, 0, output_bytes);
+  tflite::FillInput(interpreter.input(0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_GT(reader.reads(), 0);
+  TF_LITE_MICRO_EXPECT_GT(streamer.streamed_bytes(), static_cast<size_t>(0));
+  TF_LITE_MICRO_EXPECT_EQ(
+      0, std::memcmp(expected, interpreter.output(0)->data.raw, output_bytes));
+
+  // The weights are read in place again once the streamer is unset, so
+  // clobbering the staging buffer must not change the results.
+  interpreter.SetWeightStreamer(nullptr);
+  std::memset(tflite::staging_buffer, 0x5a, tflite::kStagingBufferSize);
+  tflite::FillInput(interpreter.input(0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(
+      0, std::memcmp(expected, interpreter.output(0)->data.raw, output_bytes));
+}
+
+TF_LITE_MICRO_TEST(TestSmallStagingBufferReadsWeightsInPlace) {
+  const tflite::Model* model = tflite::GetModel(kTestConvModelData);
+  tflite::AllOpsResolver op_resolver;
+  tflite::MicroInterpreter interpreter(model, op_resolver, tflite::tensor_arena,
+                                       tflite::kTensorArenaSize,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  tflite::FillInput(interpreter.input(0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  const size_t output_bytes = interpreter.output(0)->bytes;
+  char expected[tflite::kMaxOutputBytes];
+  std::memcpy(expected, interpreter.output(0)->data.raw, output_bytes);
+
+  // Too small for any weights of the model, only biases fit.
+  tflite::DeferredWeightReader reader(kTestConvModelData);
+  tflite::MicroWeightStreamer streamer(kTestConvModelData, &reader,
+                                       tflite::staging_buffer, 64);
+  interpreter.SetWeightStreamer(&streamer);
+  tflite::FillInput(interpreter.input(0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_LE(streamer.streamed_bytes(), static_cast<size_t>(64));
+  TF_LITE_MICRO_EXPECT_EQ(
+      0, std::memcmp(expected, interpreter.output(0)->data.raw, output_bytes));
+}
+
+TF_LITE_MICRO_TEST(TestFailedReadFailsInvokeAndRestoresWeights) {
+  const tflite::Model* model = tflite::GetModel(kTestConvModelData);
+  tflite::AllOpsResolver op_resolver;
+  tflite::MicroInterpreter interpreter(model, op_resolver, tflite::tensor_arena,
+                                       tflite::kTensorArenaSize,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  tflite::FillInput(interpreter.input(0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  const size_t output_bytes = interpreter.output(0)->bytes;
+  char expected[tflite::kMaxOutputBytes];
+  std::memcpy(expected, interpreter.output(0)->data.raw, output_bytes);
+
+  tflite::DeferredWeightReader reader(kTestConvModelData);
+  reader.set_fail(true);
+  tflite::MicroWeightStreamer streamer(kTestConvModelData, &reader,
+                                       tflite::staging_buffer,
+                                       tflite::kStagingBufferSize);
+  interpreter.SetWeightStreamer(&streamer);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Invoke());
+
+  interpreter.SetWeightStreamer(nullptr);
+  std::memset(tflite::staging_buffer, 0x5a, tflite::kStagingBufferSize);
+  tflite::FillInput(interpreter.input(0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(
+      0, std::memcmp(expected, interpreter.output(0)->data.raw, output_bytes));
+}
+
+TF_LITE_MICRO_TEST(TestStreamerForOtherModelFailsInvoke) {
+  const tflite::Model* model = tflite::GetModel(kTestConvModelData);
+  tflite::AllOpsResolver op_resolver;
+  tflite::MicroInterpreter interpreter(model, op_resolver, tflite::tensor_arena,
+                                       tflite::kTensorArenaSize,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  const uint8_t other_model_data[16] = {};
+  tflite::DeferredWeightReader reader(other_model_data);
+  tflite::MicroWeightStreamer streamer(other_model_data, &reader,
+                                       tflite::staging_buffer,
+                                       tflite::kStagingBufferSize);
+  interpreter.SetWeightStreamer(&streamer);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, interpreter.Invoke());
+  TF_LITE_MICRO_EXPECT_EQ(0, reader.reads());
+}
+
+TF_LITE_MICRO_TESTS_END
@@ -45,6 +45,10 @@ TfLiteStatus MockMicroGraph::InvokeSubgraph(int subgraph_idx) {
   return kTfLiteOk;
 }
 
+TfLiteStatus MockMicroGraph::PrepareSubgraphIfDeferred(int subgraph_idx) {
+  return kTfLiteOk;
+}
+
 TfLiteStatus MockMicroGraph::ResetVariableTensors() { return kTfLiteOk; }
 
 size_t MockMicroGraph::NumSubgraphInputs(int subgraph_idx) { return 1; }
@@ -30,6 +30,7 @@ class MockMicroGraph : public MicroGraph {
  public:
   explicit MockMicroGraph(SimpleMemoryAllocator* allocator);
   TfLiteStatus InvokeSubgraph(int subgraph_idx) override;
+  TfLiteStatus PrepareSubgraphIfDeferred(int subgraph_idx) override;
   TfLiteStatus ResetVariableTensors() override;
   size_t NumSubgraphInputs(int subgraph_idx) override;
   TfLiteEvalTensor* GetSubgraphInput(int subgraph_idx, int tensor_idx) override;
@@ -41,6 +41,21 @@ SimpleMemoryAllocator::SimpleMemoryAllocator(ErrorReporter* error_reporter,
                                              size_t buffer_size)
     : SimpleMemoryAllocator(error_reporter, buffer, buffer + buffer_size) {}
 
+SimpleMemoryAllocator::SimpleMemoryAllocator(ErrorReporter* error_reporter,
+                                             uint8_t* persistent_buffer,
+                                             size_t persistent_buffer_size,
+                                             uint8_t* non_persistent_buffer,
+                                             size_t non_persistent_buffer_size)
+    : error_reporter_(error_reporter),
+      buffer_head_(non_persistent_buffer),
+      buffer_tail_(persistent_buffer + persistent_buffer_size),
+      head_(non_persistent_buffer),
+      tail_(persistent_buffer + persistent_buffer_size),
+      temp_(non_persistent_buffer),
+      non_persistent_buffer_end_(non_persistent_buffer +
+                                 non_persistent_buffer_size),
+      persistent_buffer_start_(persistent_buffer) {}
+
 /* static */
 SimpleMemoryAllocator* SimpleMemoryAllocator::Create(
     ErrorReporter* error_reporter, uint8_t* buffer_head, size_t buffer_size) {
@@ -54,6 +69,30 @@ SimpleMemoryAllocator* SimpleMemoryAllocator::Create(
   // allocator instance.
   uint8_t* allocator_buffer = tmp.AllocateFromTail(
       sizeof(SimpleMemoryAllocator), alignof(SimpleMemoryAllocator));
+  if (allocator_buffer == nullptr) {
+    return nullptr;
+  }
+  // Use the default copy constructor to populate internal states.
+  return new (allocator_buffer) SimpleMemoryAllocator(tmp);
+}
+
+/* static */
+SimpleMemoryAllocator* SimpleMemoryAllocator::Create(
+    ErrorReporter* error_reporter, uint8_t* persistent_buffer,
+    size_t persistent_buffer_size, uint8_t* non_persistent_buffer,
+    size_t non_persistent_buffer_size) {
+  TFLITE_DCHECK(error_reporter != nullptr);
+  TFLITE_DCHECK(persistent_buffer != nullptr);
+  TFLITE_DCHECK(non_persistent_buffer != nullptr);
+  SimpleMemoryAllocator tmp = SimpleMemoryAllocator(
+      error_reporter, persistent_buffer, persistent_buffer_size,
+      non_persistent_buffer, non_persistent_buffer_size);
+
+  uint8_t* allocator_buffer = tmp.AllocateFromTail(
+      sizeof(SimpleMemoryAllocator), alignof(SimpleMemoryAllocator));
+  if (allocator_buffer == nullptr) {
+    return nullptr;
+  }
   // Use the default copy constructor to populate internal states.
   return new (allocator_buffer) SimpleMemoryAllocator(tmp);
 }
@@ -71,7 +110,8 @@ TfLiteStatus SimpleMemoryAllocator::SetHeadBufferSize(size_t size,
   }
 
   uint8_t* const aligned_result = AlignPointerUp(buffer_head_, alignment);
-  const size_t available_memory = tail_ - aligned_result;
+  const size_t available_memory =
+      aligned_result < GetHeadLimit() ? GetHeadLimit() - aligned_result : 0;
   if (available_memory < size) {
     TF_LITE_REPORT_ERROR(
         error_reporter_,
@@ -81,6 +121,7 @@ TfLiteStatus SimpleMemoryAllocator::SetHeadBufferSize(size_t size,
   }
   head_ = aligned_result + size;
   temp_ = head_;
+  UpdatePeakUsage();
 
   return kTfLiteOk;
 }
@@ -88,9 +129,9 @@ TfLiteStatus SimpleMemoryAllocator::SetHeadBufferSize(size_t size,
 uint8_t* SimpleMemoryAllocator::AllocateFromTail(size_t size,
                                                  size_t alignment) {
   uint8_t* const aligned_result = AlignPointerDown(tail_ - size, alignment);
-  if (aligned_result < head_) {
+  if (aligned_result < GetTailLimit()) {
 #ifndef TF_LITE_STRIP_ERROR_STRINGS
-    const size_t missing_memory = head_ - aligned_result;
+    const size_t missing_memory = GetTailLimit() - aligned_result;
     TF_LITE_REPORT_ERROR(error_reporter_,
                          "Failed to allocate tail memory. Requested: %u, "
                          "available %u, missing: %u",
@@ -99,12 +140,14 @@ uint8_t* SimpleMemoryAllocator::AllocateFromTail(size_t size,
     return nullptr;
   }
   tail_ = aligned_result;
+  UpdatePeakUsage();
   return aligned_result;
 }
 
 uint8_t* SimpleMemoryAllocator::AllocateTemp(size_t size, size_t alignment) {
   uint8_t* const aligned_result = AlignPointerUp(temp_, alignment);
-  const size_t available_memory = tail_ - aligned_result;
+  const size_t available_memory =
+      aligned_result < GetHeadLimit() ? GetHeadLimit() - aligned_result : 0;
   if (available_memory < size) {
     TF_LITE_REPORT_ERROR(error_reporter_,
                          "Failed to allocate temp memory. Requested: %u, "
@@ -113,6 +156,7 @@ uint8_t* SimpleMemoryAllocator::AllocateTemp(size_t size, size_t alignment) {
     return nullptr;
   }
   temp_ = aligned_result + size;
+  UpdatePeakUsage();
   return aligned_result;
 }
 
@@ -130,16 +174,37 @@ size_t SimpleMemoryAllocator::GetTailUsedBytes() const {
 
 size_t SimpleMemoryAllocator::GetAvailableMemory(size_t alignment) const {
   uint8_t* const aligned_temp = AlignPointerUp(temp_, alignment);
-  uint8_t* const aligned_tail = AlignPointerDown(tail_, alignment);
-  return aligned_tail - aligned_temp;
+  uint8_t* const aligned_limit = AlignPointerDown(GetHeadLimit(), alignment);
+  return aligned_limit > aligned_temp ? aligned_limit - aligned_temp : 0;
 }
 
 size_t SimpleMemoryAllocator::GetUsedBytes() const {
-  return GetBufferSize() - (tail_ - temp_);
+  return (temp_ - buffer_head_) + GetTailUsedBytes();
+}
+
+uint8_t* SimpleMemoryAllocator::GetHeadLimit() const {
+  return non_persistent_buffer_end_ != nullptr ? non_persistent_buffer_end_
+                                               : tail_;
+}
+
+uint8_t* SimpleMemoryAllocator::GetTailLimit() const {
+  return persistent_buffer_start_ != nullptr ? persistent_buffer_start_
+                                             : temp_;
 }
 
-size_t SimpleMemoryAllocator::GetBufferSize() const {
-  return buffer_tail_ - buffer_head_;
+void SimpleMemoryAllocator::UpdatePeakUsage() {
+  const size_t non_persistent_bytes = temp_ - buffer_head_;
+  const size_t temp_bytes = temp_ - head_;
+  const size_t used_bytes = non_persistent_bytes + GetTailUsedBytes();
+  if (peak_non_persistent_bytes_ < non_persistent_bytes) {
+    peak_non_persistent_bytes_ = non_persistent_bytes;
+  }
+  if (peak_temp_bytes_ < temp_bytes) {
+    peak_temp_bytes_ = temp_bytes;
+  }
+  if (peak_used_bytes_ < used_bytes) {
+    peak_used_bytes_ = used_bytes;
+  }
 }
 
 uint8_t* SimpleMemoryAllocator::head() const { return head_; }
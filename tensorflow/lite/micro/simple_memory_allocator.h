@@ -36,6 +36,16 @@ class SimpleMemoryAllocator {
                         uint8_t* buffer_tail);
   SimpleMemoryAllocator(ErrorReporter* error_reporter, uint8_t* buffer,
                         size_t buffer_size);
+  // Creates an allocator whose tail (persistent) section lives in
+  // `persistent_buffer` and whose head and temp (non-persistent) sections live
+  // in the separate `non_persistent_buffer`. The non-persistent buffer can be
+  // shared between several allocators as long as only one of them uses it at a
+  // time.
+  SimpleMemoryAllocator(ErrorReporter* error_reporter,
+                        uint8_t* persistent_buffer,
+                        size_t persistent_buffer_size,
+                        uint8_t* non_persistent_buffer,
+                        size_t non_persistent_buffer_size);
   virtual ~SimpleMemoryAllocator();
 
   // Creates a new SimpleMemoryAllocator from a given buffer head and size.
@@ -43,6 +53,15 @@ class SimpleMemoryAllocator {
                                        uint8_t* buffer_head,
                                        size_t buffer_size);
 
+  // Creates a new SimpleMemoryAllocator with separate persistent and
+  // non-persistent buffers. The allocator instance itself is placed in the
+  // persistent buffer.
+  static SimpleMemoryAllocator* Create(ErrorReporter* error_reporter,
+                                       uint8_t* persistent_buffer,
+                                       size_t persistent_buffer_size,
+                                       uint8_t* non_persistent_buffer,
+                                       size_t non_persistent_buffer_size);
+
   // Adjusts the head (lowest address and moving upwards) memory allocation to a
   // given size. Calls to this method will also invalidate all temporary
   // allocation values (it sets the location of temp space at the end of the
@@ -69,6 +88,10 @@ class SimpleMemoryAllocator {
   // arena (lowest address).
   virtual void ResetTempAllocations();
 
+  // Returns true if a chain of temporary allocations is pending a call to
+  // ResetTempAllocations(). Inlined, since it is checked after every operator.
+  bool HasTempAllocations() const { return temp_ != head_; }
+
   // Returns a pointer to the buffer currently assigned to the head section.
   // This buffer is set by calling SetHeadSize().
   uint8_t* GetHeadBuffer() const;
@@ -87,6 +110,21 @@ class SimpleMemoryAllocator {
   // account any temporary allocations.
   size_t GetUsedBytes() const;
 
+  // Returns the largest value GetUsedBytes() has reached since the allocator
+  // was created. This is the smallest arena the same sequence of allocations
+  // fits in.
+  size_t GetPeakUsedBytes() const { return peak_used_bytes_; }
+
+  // Returns the largest number of bytes the head and temp sections have used
+  // together since the allocator was created.
+  size_t GetPeakNonPersistentBytes() const {
+    return peak_non_persistent_bytes_;
+  }
+
+  // Returns the largest number of bytes the temp section has used on top of
+  // the head since the allocator was created.
+  size_t GetPeakTempBytes() const { return peak_temp_bytes_; }
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 
  protected:
@@ -97,7 +135,16 @@ class SimpleMemoryAllocator {
   uint8_t* tail() const;
 
  private:
-  size_t GetBufferSize() const;
+  // Returns the highest address the head and temp sections can grow up to.
+  uint8_t* GetHeadLimit() const;
+
+  // Returns the lowest address the tail section can grow down to. The tail
+  // stops at the end of the temp section, which may be live while kernels of
+  // a deferred subgraph are prepared.
+  uint8_t* GetTailLimit() const;
+
+  // Folds the current head, temp and tail usage into the peak counters.
+  void UpdatePeakUsage();
 
   ErrorReporter* error_reporter_;
   uint8_t* buffer_head_;
@@ -105,6 +152,15 @@ class SimpleMemoryAllocator {
   uint8_t* head_;
   uint8_t* tail_;
   uint8_t* temp_;
+
+  // Bounds of the head and tail buffers when they are split into two separate
+  // regions. Both are nullptr when head and tail share a single buffer.
+  uint8_t* non_persistent_buffer_end_ = nullptr;
+  uint8_t* persistent_buffer_start_ = nullptr;
+
+  size_t peak_used_bytes_ = 0;
+  size_t peak_non_persistent_bytes_ = 0;
+  size_t peak_temp_bytes_ = 0;
 };
 
 }  // namespace tflite
@@ -269,4 +269,59 @@ TF_LITE_MICRO_TEST(TestEnsureHeadSizeWithoutResettingTemp) {
   TF_LITE_MICRO_EXPECT(temp == allocator.GetHeadBuffer());
 }
 
+TF_LITE_MICRO_TEST(TestSeparatePersistentAndNonPersistentBuffers) {
+  constexpr size_t persistent_size = 256;
+  constexpr size_t non_persistent_size = 512;
+  uint8_t persistent[persistent_size];
+  uint8_t non_persistent[non_persistent_size];
+  tflite::SimpleMemoryAllocator allocator(
+      tflite::GetMicroErrorReporter(), persistent, persistent_size,
+      non_persistent, non_persistent_size);
+
+  // Head and temp allocations come from the non-persistent buffer only.
+  TF_LITE_MICRO_EXPECT_EQ(allocator.GetAvailableMemory(/*alignment=*/1),
+                          non_persistent_size);
+  uint8_t* temp = allocator.AllocateTemp(100, 1);
+  TF_LITE_MICRO_EXPECT(temp == non_persistent);
+  allocator.ResetTempAllocations();
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                          allocator.SetHeadBufferSize(non_persistent_size, 1));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError,
+                          allocator.SetHeadBufferSize(non_persistent_size + 1,
+                                                      /*alignment=*/1));
+
+  // Tail allocations come from the persistent buffer and do not compete with
+  // the head.
+  uint8_t* tail = allocator.AllocateFromTail(persistent_size, 1);
+  TF_LITE_MICRO_EXPECT(tail == persistent);
+  TF_LITE_MICRO_EXPECT(nullptr == allocator.AllocateFromTail(1, 1));
+
+  TF_LITE_MICRO_EXPECT_EQ(allocator.GetUsedBytes(),
+                          persistent_size + non_persistent_size);
+}
+
+TF_LITE_MICRO_TEST(TestPeakUsageCoversResetTempAllocations) {
+  constexpr size_t arena_size = 1024;
+  uint8_t arena[arena_size];
+  tflite::SimpleMemoryAllocator allocator(tflite::GetMicroErrorReporter(),
+                                          arena, arena_size);
+
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, allocator.SetHeadBufferSize(100, 1));
+  TF_LITE_MICRO_EXPECT(nullptr != allocator.AllocateTemp(300, 1));
+  TF_LITE_MICRO_EXPECT(nullptr != allocator.AllocateFromTail(50, 1));
+  allocator.ResetTempAllocations();
+  TF_LITE_MICRO_EXPECT(nullptr != allocator.AllocateFromTail(200, 1));
+
+  // The temp allocation is gone, but the arena had to hold it together with
+  // the head and the first tail allocation.
+  TF_LITE_MICRO_EXPECT_EQ(allocator.GetUsedBytes(),
+                          static_cast<size_t>(100 + 250));
+  TF_LITE_MICRO_EXPECT_EQ(allocator.GetPeakUsedBytes(),
+                          static_cast<size_t>(100 + 300 + 50));
+  TF_LITE_MICRO_EXPECT_EQ(allocator.GetPeakNonPersistentBytes(),
+                          static_cast<size_t>(100 + 300));
+  TF_LITE_MICRO_EXPECT_EQ(allocator.GetPeakTempBytes(),
+                          static_cast<size_t>(300));
+}
+
 TF_LITE_MICRO_TESTS_END
@@ -28,6 +28,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
 #include "tensorflow/lite/micro/micro_utils.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -103,7 +104,9 @@ class ModelBuilder {
 
   // Adds a node to the model with given input and output Tensors.
   Node AddNode(Operator op, std::initializer_list<Tensor> inputs,
-               std::initializer_list<Tensor> outputs);
+               std::initializer_list<Tensor> outputs,
+               BuiltinOptions builtin_options_type = BuiltinOptions_NONE,
+               flatbuffers::Offset<void> builtin_options = 0);
 
   void AddMetadata(const char* description_string,
                    const int32_t* metadata_buffer_data, size_t num_elements);
@@ -158,12 +161,14 @@ ModelBuilder::Operator ModelBuilder::RegisterOp(BuiltinOperator op,
 ModelBuilder::Node ModelBuilder::AddNode(
     ModelBuilder::Operator op,
     std::initializer_list<ModelBuilder::Tensor> inputs,
-    std::initializer_list<ModelBuilder::Tensor> outputs) {
+    std::initializer_list<ModelBuilder::Tensor> outputs,
+    BuiltinOptions builtin_options_type,
+    flatbuffers::Offset<void> builtin_options) {
   TFLITE_DCHECK(next_operator_id_ <= kMaxOperators);
   operators_[next_operator_id_] = tflite::CreateOperator(
       *builder_, op, builder_->CreateVector(inputs.begin(), inputs.size()),
       builder_->CreateVector(outputs.begin(), outputs.size()),
-      BuiltinOptions_NONE);
+      builtin_options_type, builtin_options);
   next_operator_id_++;
   return next_operator_id_ - 1;
 }
@@ -314,6 +319,154 @@ const Model* BuildSimpleModelWithBranch() {
   return model_builder.BuildModel({t0}, {t3});
 }
 
+const Model* BuildModelWithParallelBranches() {
+  using flatbuffers::Offset;
+  flatbuffers::FlatBufferBuilder* fb_builder = BuilderInstance();
+
+  ModelBuilder model_builder(fb_builder);
+  /* Model structure
+         | t0, w
+    +----+----+
+    |         |
+    v         v
+  +----+    +----+
+  | n0 |    | n1 |
+  +----+    +----+
+    | t1      | t2
+    v         v
+  +--------------+
+  |      n2      |<-- t0
+  +--------------+
+         | t3
+         v
+  */
+  const int mock_op_id =
+      model_builder.RegisterOp(BuiltinOperator_CUSTOM, "mock_custom");
+  const int sum_op_id =
+      model_builder.RegisterOp(BuiltinOperator_CUSTOM, "multiple_inputs_op");
+  const int t0 = model_builder.AddTensor(TensorType_INT32, {1});
+  const int w = model_builder.AddTensor(TensorType_UINT8, {1});
+  const int t1 = model_builder.AddTensor(TensorType_INT32, {1});
+  const int t2 = model_builder.AddTensor(TensorType_INT32, {1});
+  const int t3 = model_builder.AddTensor(TensorType_INT32, {1});
+  model_builder.AddNode(mock_op_id, {t0, w}, {t1});      // n0
+  model_builder.AddNode(mock_op_id, {t0, w}, {t2});      // n1
+  model_builder.AddNode(sum_op_id, {t1, t2, t0}, {t3});  // n2
+  return model_builder.BuildModel({t0, w}, {t3});
+}
+
+const Model* BuildModelWithReshape() {
+  using flatbuffers::Offset;
+  flatbuffers::FlatBufferBuilder* fb_builder = BuilderInstance();
+
+  ModelBuilder model_builder(fb_builder);
+  /* Model structure
+         | t0, w
+         v
+      +------+
+      |  n0  |
+      +------+
+         | t1
+         v
+      +------+
+      |  n1  | RESHAPE
+      +------+
+         | t2
+         v
+      +------+
+      |  n2  |<-- w
+      +------+
+         | t3
+         v
+  */
+  const int mock_op_id =
+      model_builder.RegisterOp(BuiltinOperator_CUSTOM, "mock_custom");
+  const int reshape_op_id =
+      model_builder.RegisterOp(BuiltinOperator_RESHAPE, nullptr);
+  const int t0 = model_builder.AddTensor(TensorType_INT32, {2});
+  const int w = model_builder.AddTensor(TensorType_UINT8, {1});
+  const int t1 = model_builder.AddTensor(TensorType_INT32, {1, 2});
+  const int t2 = model_builder.AddTensor(TensorType_INT32, {2});
+  const int t3 = model_builder.AddTensor(TensorType_INT32, {2});
+  model_builder.AddNode(mock_op_id, {t0, w}, {t1});  // n0
+  model_builder.AddNode(reshape_op_id, {t1}, {t2});  // n1
+  model_builder.AddNode(mock_op_id, {t2, w}, {t3});  // n2
+  return model_builder.BuildModel({t0, w}, {t3});
+}
+
+const Model* BuildModelWithConcatenation() {
+  using flatbuffers::Offset;
+  flatbuffers::FlatBufferBuilder* fb_builder = BuilderInstance();
+
+  ModelBuilder model_builder(fb_builder);
+  /* Model structure
+         | t0, w
+    +----+----+
+    |         |
+    v         v
+  +----+    +----+
+  | n0 |    | n1 |
+  +----+    +----+
+    | t1      | t2
+    v         v
+  +--------------+
+  |      n2      | CONCATENATION
+  +--------------+
+         | t3
+         v
+      +------+
+      |  n3  |<-- w
+      +------+
+         | t4
+         v
+  */
+  const int mock_op_id =
+      model_builder.RegisterOp(BuiltinOperator_CUSTOM, "mock_custom");
+  const int concat_op_id =
+      model_builder.RegisterOp(BuiltinOperator_CONCATENATION, nullptr);
+  const int t0 = model_builder.AddTensor(TensorType_INT32, {4});
+  const int w = model_builder.AddTensor(TensorType_UINT8, {1});
+  const int t1 = model_builder.AddTensor(TensorType_INT32, {1, 4});
+  const int t2 = model_builder.AddTensor(TensorType_INT32, {1, 4});
+  const int t3 = model_builder.AddTensor(TensorType_INT32, {2, 4});
+  const int t4 = model_builder.AddTensor(TensorType_INT32, {2, 4});
+  model_builder.AddNode(mock_op_id, {t0, w}, {t1});  // n0
+  model_builder.AddNode(mock_op_id, {t0, w}, {t2});  // n1
+  model_builder.AddNode(
+      concat_op_id, {t1, t2}, {t3}, BuiltinOptions_ConcatenationOptions,
+      CreateConcatenationOptions(*fb_builder, /*axis=*/0).Union());  // n2
+  model_builder.AddNode(mock_op_id, {t3, w}, {t4});                  // n3
+  return model_builder.BuildModel({t0, w}, {t4});
+}
+
+const Model* BuildModelWithConv() {
+  using flatbuffers::Offset;
+  flatbuffers::FlatBufferBuilder* fb_builder = BuilderInstance();
+
+  ModelBuilder model_builder(fb_builder);
+  /* Model structure
+         | t0
+         v
+      +------+
+      |  n0  |<-- w, b   CONV_2D
+      +------+
+         | t1
+         v
+  */
+  const int conv_op_id =
+      model_builder.RegisterOp(BuiltinOperator_CONV_2D, nullptr);
+  const int t0 = model_builder.AddTensor(TensorType_FLOAT32, {1, 64, 8, 16});
+  const int w = model_builder.AddTensor(TensorType_FLOAT32, {16, 3, 3, 16});
+  const int b = model_builder.AddTensor(TensorType_FLOAT32, {16});
+  const int t1 = model_builder.AddTensor(TensorType_FLOAT32, {1, 64, 8, 16});
+  model_builder.AddNode(
+      conv_op_id, {t0, w, b}, {t1}, BuiltinOptions_Conv2DOptions,
+      CreateConv2DOptions(*fb_builder, Padding_SAME, /*stride_w=*/1,
+                          /*stride_h=*/1)
+          .Union());  // n0
+  return model_builder.BuildModel({t0, w, b}, {t1});
+}
+
 const Model* BuildModelWithOfflinePlanning(int number_of_tensors,
                                            const int32_t* metadata_buffer,
                                            NodeConnection* node_conn,
@@ -959,9 +1112,9 @@ TfLiteStatus SimpleStatefulOp::Invoke(TfLiteContext* context,
   OpData* data = reinterpret_cast<OpData*>(node->user_data);
   *data->invoke_count += 1;
 
-  const TfLiteTensor* input;
-  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, kInputTensor, &input));
-  const uint8_t* input_data = GetTensorData<uint8_t>(input);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const uint8_t* input_data = tflite::micro::GetTensorData<uint8_t>(input);
   int size = NumElements(input->dims);
 
   uint8_t* sorting_buffer = reinterpret_cast<uint8_t*>(
@@ -979,14 +1132,13 @@ TfLiteStatus SimpleStatefulOp::Invoke(TfLiteContext* context,
     }
   }
 
-  TfLiteTensor* median;
-  TF_LITE_ENSURE_OK(context,
-                    GetOutputSafe(context, node, kMedianTensor, &median));
-  uint8_t* median_data = GetTensorData<uint8_t>(median);
-  TfLiteTensor* invoke_count;
-  TF_LITE_ENSURE_OK(context,
-                    GetOutputSafe(context, node, kInvokeCount, &invoke_count));
-  int32_t* invoke_count_data = GetTensorData<int32_t>(invoke_count);
+  TfLiteEvalTensor* median =
+      tflite::micro::GetEvalOutput(context, node, kMedianTensor);
+  uint8_t* median_data = tflite::micro::GetTensorData<uint8_t>(median);
+  TfLiteEvalTensor* invoke_count =
+      tflite::micro::GetEvalOutput(context, node, kInvokeCount);
+  int32_t* invoke_count_data =
+      tflite::micro::GetTensorData<int32_t>(invoke_count);
 
   median_data[0] = sorting_buffer[size / 2];
   invoke_count_data[0] = *data->invoke_count;
@@ -1023,14 +1175,12 @@ TfLiteStatus MockCustom::Prepare(TfLiteContext* context, TfLiteNode* node) {
 }
 
 TfLiteStatus MockCustom::Invoke(TfLiteContext* context, TfLiteNode* node) {
-  const TfLiteTensor* input;
-  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 0, &input));
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
   const int32_t* input_data = input->data.i32;
-  const TfLiteTensor* weight;
-  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 1, &weight));
+  const TfLiteEvalTensor* weight =
+      tflite::micro::GetEvalInput(context, node, 1);
   const uint8_t* weight_data = weight->data.uint8;
-  TfLiteTensor* output;
-  TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
   int32_t* output_data = output->data.i32;
   output_data[0] =
       0;  // Catch output tensor sharing memory with an input tensor
@@ -1072,18 +1222,16 @@ TfLiteStatus MultipleInputs::Prepare(TfLiteContext* context, TfLiteNode* node) {
 }
 
 TfLiteStatus MultipleInputs::Invoke(TfLiteContext* context, TfLiteNode* node) {
-  const TfLiteTensor* input;
-  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 0, &input));
+  const TfLiteEvalTensor* input = tflite::micro::GetEvalInput(context, node, 0);
   const int32_t* input_data = input->data.i32;
-  const TfLiteTensor* input1;
-  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 1, &input1));
+  const TfLiteEvalTensor* input1 =
+      tflite::micro::GetEvalInput(context, node, 1);
   const int32_t* input_data1 = input1->data.i32;
-  const TfLiteTensor* input2;
-  TF_LITE_ENSURE_OK(context, GetInputSafe(context, node, 2, &input2));
+  const TfLiteEvalTensor* input2 =
+      tflite::micro::GetEvalInput(context, node, 2);
   const int32_t* input_data2 = input2->data.i32;
 
-  TfLiteTensor* output;
-  TF_LITE_ENSURE_OK(context, GetOutputSafe(context, node, 0, &output));
+  TfLiteEvalTensor* output = tflite::micro::GetEvalOutput(context, node, 0);
   int32_t* output_data = output->data.i32;
   output_data[0] =
       0;  // Catch output tensor sharing memory with an input tensor
@@ -1150,6 +1298,38 @@ const Model* GetSimpleModelWithBranch() {
   return model;
 }
 
+const Model* GetModelWithParallelBranches() {
+  static Model* model = nullptr;
+  if (!model) {
+    model = const_cast<Model*>(BuildModelWithParallelBranches());
+  }
+  return model;
+}
+
+const Model* GetModelWithReshape() {
+  static Model* model = nullptr;
+  if (!model) {
+    model = const_cast<Model*>(BuildModelWithReshape());
+  }
+  return model;
+}
+
+const Model* GetModelWithConcatenation() {
+  static Model* model = nullptr;
+  if (!model) {
+    model = const_cast<Model*>(BuildModelWithConcatenation());
+  }
+  return model;
+}
+
+const Model* GetModelWithConv() {
+  static Model* model = nullptr;
+  if (!model) {
+    model = const_cast<Model*>(BuildModelWithConv());
+  }
+  return model;
+}
+
 const Model* GetSimpleMockConvModel() {
   static Model* model = nullptr;
   if (!model) {
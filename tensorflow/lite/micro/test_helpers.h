@@ -106,6 +106,22 @@ const Model* GetComplexMockModel();
 // Returns a simple flatbuffer model with two branches.
 const Model* GetSimpleModelWithBranch();
 
+// Returns a flatbuffer model with two independent `mock_custom` operators whose
+// outputs are summed with the first input by `multiple_inputs_op`.
+const Model* GetModelWithParallelBranches();
+
+// Returns a flatbuffer model whose `mock_custom` operators are connected
+// through a RESHAPE operator.
+const Model* GetModelWithReshape();
+
+// Returns a flatbuffer model that concatenates the outputs of two
+// `mock_custom` operators along the outermost dimension.
+const Model* GetModelWithConcatenation();
+
+// Returns a flatbuffer model with a single float CONV_2D operator whose input,
+// filter and bias are all inputs of the model.
+const Model* GetModelWithConv();
+
 // Returns a simple example flatbuffer TensorFlow Lite model. Contains 3 inputs,
 // 1 output Tensor, and 1 operator.
 const Model* GetSimpleMultipleInputsModel();
@@ -0,0 +1,221 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/tools/aot/aot_runtime.h"
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/simple_memory_allocator.h"
+
+namespace tflite {
+namespace aot {
+namespace {
+
+// Must match the alignment used by MicroAllocator so that the planned offsets
+// keep the alignment they were planned with.
+constexpr int kBufferAlignment = 16;
+
+}  // namespace
+
+TfLiteStatus Runtime::Init(const uint8_t* model_data,
+                           const TensorSpec* tensor_specs,
+                           TfLiteEvalTensor* tensors, size_t tensors_size,
+                           const int32_t* scratch_buffer_offsets,
+                           size_t scratch_buffers_size,
+                           size_t planned_head_bytes, uint8_t* arena,
+                           size_t arena_size, ErrorReporter* error_reporter) {
+  TFLITE_DCHECK(model_data != nullptr);
+  TFLITE_DCHECK(arena != nullptr);
+  TFLITE_DCHECK(error_reporter != nullptr);
+
+  error_reporter_ = error_reporter;
+  memory_allocator_ =
+      SimpleMemoryAllocator::Create(error_reporter, arena, arena_size);
+  if (memory_allocator_ == nullptr ||
+      memory_allocator_->SetHeadBufferSize(planned_head_bytes,
+                                           kBufferAlignment) != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Arena of %d bytes is too small for the memory plan "
+                         "of %d bytes.",
+                         arena_size, planned_head_bytes);
+    return kTfLiteError;
+  }
+  head_buffer_ = memory_allocator_->GetHeadBuffer();
+
+  tensor_specs_ = tensor_specs;
+  tensors_ = tensors;
+  tensors_size_ = tensors_size;
+  for (size_t i = 0; i < tensors_size; ++i) {
+    const TensorSpec& spec = tensor_specs[i];
+    tensors[i].type = spec.type;
+    tensors[i].dims = spec.dims;
+    if (spec.arena_offset >= 0) {
+      tensors[i].data.data = head_buffer_ + spec.arena_offset;
+    } else if (spec.model_offset >= 0) {
+      tensors[i].data.data =
+          const_cast<uint8_t*>(model_data + spec.model_offset);
+    } else {
+      tensors[i].data.data = nullptr;
+    }
+  }
+  scratch_buffer_offsets_ = scratch_buffer_offsets;
+  scratch_buffers_size_ = scratch_buffers_size;
+  scratch_buffer_requests_ = 0;
+
+  context_ = {};
+  context_.impl_ = static_cast<void*>(this);
+  context_.ReportError = ReportOpError;
+  context_.GetTensor = GetTensor;
+  context_.GetEvalTensor = GetEvalTensor;
+  context_.AllocatePersistentBuffer = AllocatePersistentBuffer;
+  context_.RequestScratchBufferInArena = RequestScratchBufferInArena;
+  context_.GetScratchBuffer = GetScratchBuffer;
+  return kTfLiteOk;
+}
+
+void Runtime::InitNode(const TfLiteRegistration& registration,
+                       TfLiteNode* node) {
+  if (registration.init != nullptr) {
+    node->user_data = registration.init(
+        &context_, reinterpret_cast<const char*>(node->builtin_data), 0);
+  }
+}
+
+TfLiteStatus Runtime::PrepareNode(const TfLiteRegistration& registration,
+                                  TfLiteNode* node) {
+  TfLiteStatus status = kTfLiteOk;
+  if (registration.prepare != nullptr) {
+    status = registration.prepare(&context_, node);
+  }
+  ResetTempAllocations();
+  return status;
+}
+
+TfLiteStatus Runtime::FinishPrepare(NodeAndRegistration* nodes,
+                                    size_t nodes_size) {
+  if (scratch_buffer_requests_ != scratch_buffers_size_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Kernels requested %d scratch buffers, but %d were "
+                         "planned.",
+                         scratch_buffer_requests_, scratch_buffers_size_);
+    return kTfLiteError;
+  }
+
+  const RuntimeShape* shapes = internal::AllocateTensorShapes(
+      memory_allocator_, tensors_, tensors_size_);
+  if (shapes == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate memory for the tensor shapes.");
+    return kTfLiteError;
+  }
+  for (size_t i = 0; i < nodes_size; ++i) {
+    if (internal::ResolveNodeTensors(memory_allocator_, nodes[i].node.inputs,
+                                     nodes[i].node.outputs, tensors_, shapes,
+                                     tensors_size_, &nodes[i]) != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to allocate memory for the tensor tables "
+                           "of node %d.",
+                           i);
+      return kTfLiteError;
+    }
+  }
+
+  // Prepare is done, kernels can only fetch scratch buffers from now on.
+  context_.AllocatePersistentBuffer = nullptr;
+  context_.RequestScratchBufferInArena = nullptr;
+  return kTfLiteOk;
+}
+
+void* Runtime::AllocatePersistentBuffer(TfLiteContext* ctx, size_t bytes) {
+  Runtime* runtime = static_cast<Runtime*>(ctx->impl_);
+  return runtime->memory_allocator_->AllocateFromTail(bytes, kBufferAlignment);
+}
+
+TfLiteStatus Runtime::RequestScratchBufferInArena(TfLiteContext* ctx,
+                                                  size_t bytes,
+                                                  int* buffer_idx) {
+  Runtime* runtime = static_cast<Runtime*>(ctx->impl_);
+  if (runtime->scratch_buffer_requests_ >= runtime->scratch_buffers_size_) {
+    TF_LITE_REPORT_ERROR(runtime->error_reporter_,
+                         "Scratch buffer request %d of %d bytes was not "
+                         "planned.",
+                         runtime->scratch_buffer_requests_, bytes);
+    return kTfLiteError;
+  }
+  *buffer_idx = static_cast<int>(runtime->scratch_buffer_requests_++);
+  return kTfLiteOk;
+}
+
+void* Runtime::GetScratchBuffer(TfLiteContext* ctx, int buffer_idx) {
+  Runtime* runtime = static_cast<Runtime*>(ctx->impl_);
+  return runtime->head_buffer_ + runtime->scratch_buffer_offsets_[buffer_idx];
+}
+
+void Runtime::ReportOpError(struct TfLiteContext* context, const char* format,
+                            ...) {
+#ifndef TF_LITE_STRIP_ERROR_STRINGS
+  Runtime* runtime = static_cast<Runtime*>(context->impl_);
+  va_list args;
+  va_start(args, format);
+  TF_LITE_REPORT_ERROR(runtime->error_reporter_, format, args);
+  va_end(args);
+#endif
+}
+
+TfLiteTensor* Runtime::GetTensor(const struct TfLiteContext* context,
+                                 int tensor_idx) {
+  Runtime* runtime = static_cast<Runtime*>(context->impl_);
+  TfLiteTensor* tensor = reinterpret_cast<TfLiteTensor*>(
+      runtime->memory_allocator_->AllocateTemp(sizeof(TfLiteTensor),
+                                               alignof(TfLiteTensor)));
+  if (tensor == nullptr) {
+    TF_LITE_REPORT_ERROR(runtime->error_reporter_,
+                         "Failed to allocate memory for tensor %d.",
+                         tensor_idx);
+    return nullptr;
+  }
+
+  const TensorSpec& spec = runtime->tensor_specs_[tensor_idx];
+  const TfLiteEvalTensor& eval_tensor = runtime->tensors_[tensor_idx];
+  memset(tensor, 0, sizeof(TfLiteTensor));
+  tensor->type = eval_tensor.type;
+  tensor->data = eval_tensor.data;
+  tensor->dims = eval_tensor.dims;
+  tensor->bytes = spec.bytes;
+  tensor->allocation_type =
+      spec.arena_offset >= 0 ? kTfLiteArenaRw : kTfLiteMmapRo;
+  if (spec.quantization != nullptr) {
+    tensor->params.scale = spec.quantization->scale->data[0];
+    tensor->params.zero_point = spec.quantization->zero_point->data[0];
+    tensor->quantization.type = kTfLiteAffineQuantization;
+    tensor->quantization.params = spec.quantization;
+  }
+  return tensor;
+}
+
+TfLiteEvalTensor* Runtime::GetEvalTensor(const struct TfLiteContext* context,
+                                         int tensor_idx) {
+  Runtime* runtime = static_cast<Runtime*>(context->impl_);
+  return &runtime->tensors_[tensor_idx];
+}
+
+}  // namespace aot
+}  // namespace tflite
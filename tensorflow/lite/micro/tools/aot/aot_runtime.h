@@ -0,0 +1,134 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_TOOLS_AOT_AOT_RUNTIME_H_
+#define TENSORFLOW_LITE_MICRO_TOOLS_AOT_AOT_RUNTIME_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/micro/micro_node.h"
+#include "tensorflow/lite/micro/simple_memory_allocator.h"
+
+namespace tflite {
+namespace aot {
+
+// Arrays laid out like TfLiteIntArray and TfLiteFloatArray, so that generated
+// sources can define them statically.
+template <int N>
+struct IntArray {
+  int size;
+  int data[N];
+};
+
+template <int N>
+struct FloatArray {
+  int size;
+  float data[N];
+};
+
+// A tensor of a generated model. Activations live in the planned head of the
+// arena at `arena_offset`, constant tensors in the model flatbuffer at
+// `model_offset`. Tensors without data (e.g. missing optional inputs) have
+// both offsets set to -1.
+struct TensorSpec {
+  TfLiteType type;
+  TfLiteIntArray* dims;
+  int32_t arena_offset;
+  int32_t model_offset;
+  size_t bytes;
+  // nullptr for tensors that are not quantized.
+  TfLiteAffineQuantization* quantization;
+};
+
+// Replaces MicroInterpreter, MicroAllocator and MicroGraph for the sources
+// emitted by generate_aot_source. The memory plan, the tensor metadata and the
+// order of the operators are computed on the host, so the runtime only binds
+// the eval tensors to the arena and serves the TfLiteContext callbacks that
+// kernels use during Init, Prepare and Eval.
+//
+// The generated code calls Init(), then InitNode() and PrepareNode() for every
+// operator in execution order, then FinishPrepare(). Kernels must request
+// their scratch buffers in the same order as on the host, which holds since
+// Prepare only depends on the model.
+class Runtime {
+ public:
+  // Binds `tensors` to `arena` and `model_data` following `tensor_specs`.
+  // `scratch_buffer_offsets` are the planned offsets of the scratch buffers in
+  // the head of the arena, in request order.
+  TfLiteStatus Init(const uint8_t* model_data, const TensorSpec* tensor_specs,
+                    TfLiteEvalTensor* tensors, size_t tensors_size,
+                    const int32_t* scratch_buffer_offsets,
+                    size_t scratch_buffers_size, size_t planned_head_bytes,
+                    uint8_t* arena, size_t arena_size,
+                    ErrorReporter* error_reporter);
+
+  // Calls TfLiteRegistration->Init for `node`.
+  void InitNode(const TfLiteRegistration& registration, TfLiteNode* node);
+
+  // Calls TfLiteRegistration->Prepare for `node`.
+  TfLiteStatus PrepareNode(const TfLiteRegistration& registration,
+                           TfLiteNode* node);
+
+  // Resolves the eval tensor tables of all `nodes`, see
+  // NodeAndRegistration::eval_tensors. Kernels can no longer allocate
+  // afterwards.
+  TfLiteStatus FinishPrepare(NodeAndRegistration* nodes, size_t nodes_size);
+
+  // Releases the temp TfLiteTensor structs handed out by GetTensor().
+  void ResetTempAllocations() {
+    if (memory_allocator_->HasTempAllocations()) {
+      memory_allocator_->ResetTempAllocations();
+    }
+  }
+
+  TfLiteContext* context() { return &context_; }
+
+  // Returns the number of bytes of the arena in use.
+  size_t arena_used_bytes() const {
+    return memory_allocator_->GetUsedBytes();
+  }
+
+ private:
+  // Static functions that are bound to the TfLiteContext instance:
+  static void* AllocatePersistentBuffer(TfLiteContext* ctx, size_t bytes);
+  static TfLiteStatus RequestScratchBufferInArena(TfLiteContext* ctx,
+                                                  size_t bytes,
+                                                  int* buffer_idx);
+  static void* GetScratchBuffer(TfLiteContext* ctx, int buffer_idx);
+  static void ReportOpError(struct TfLiteContext* context, const char* format,
+                            ...);
+  static TfLiteTensor* GetTensor(const struct TfLiteContext* context,
+                                 int tensor_idx);
+  static TfLiteEvalTensor* GetEvalTensor(const struct TfLiteContext* context,
+                                         int tensor_idx);
+
+  const TensorSpec* tensor_specs_ = nullptr;
+  TfLiteEvalTensor* tensors_ = nullptr;
+  size_t tensors_size_ = 0;
+  const int32_t* scratch_buffer_offsets_ = nullptr;
+  size_t scratch_buffers_size_ = 0;
+  size_t scratch_buffer_requests_ = 0;
+  uint8_t* head_buffer_ = nullptr;
+  SimpleMemoryAllocator* memory_allocator_ = nullptr;
+  ErrorReporter* error_reporter_ = nullptr;
+  TfLiteContext context_ = {};
+};
+
+}  // namespace aot
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_TOOLS_AOT_AOT_RUNTIME_H_
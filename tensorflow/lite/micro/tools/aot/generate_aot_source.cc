@@ -0,0 +1,747 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Generates a C++ class that runs a .tflite model without MicroInterpreter,
+// MicroAllocator, MicroGraph or an op resolver. See README.md for the usage.
+//
+// The model is prepared on the host with a RecordingMicroInterpreter, which
+// runs the memory planner. The generated source then holds the planned arena
+// offsets of every tensor and scratch buffer, the tensor shapes and
+// quantization parameters, the builtin data of every operator and a
+// straight-line sequence of calls into the kernels of the model.
+
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/flatbuffer_utils.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_graph.h"
+#include "tensorflow/lite/micro/recording_micro_interpreter.h"
+#include "tensorflow/lite/micro/simple_memory_allocator.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+namespace tflite {
+namespace {
+
+// Large enough for any model that fits on a microcontroller.
+constexpr size_t kPlanningArenaSize = 64 * 1024 * 1024;
+uint8_t planning_arena[kPlanningArenaSize];
+
+// Must match the alignment used by MicroAllocator and aot::Runtime.
+constexpr size_t kBufferAlignment = 16;
+
+// An operator the generated code can call, with the struct its builtin data
+// is parsed into. Operators without builtin data have no struct.
+struct OpInfo {
+  BuiltinOperator op;
+  const char* registration;
+  const char* params_type;
+  size_t params_size;
+};
+
+#define TF_LITE_AOT_OP(op, ns, params) \
+  { BuiltinOperator_##op, #ns "::Register_" #op "()", #params, sizeof(params) }
+#define TF_LITE_AOT_OP_NO_PARAMS(op, ns) \
+  { BuiltinOperator_##op, #ns "::Register_" #op "()", nullptr, 0 }
+
+// Follows MicroMutableOpResolver. Operators that invoke other subgraphs are
+// not supported since the generated code only runs a single subgraph.
+const OpInfo kOps[] = {
+    TF_LITE_AOT_OP_NO_PARAMS(ABS, tflite::ops::micro),
+    TF_LITE_AOT_OP(ADD, tflite::ops::micro, TfLiteAddParams),
+    TF_LITE_AOT_OP_NO_PARAMS(ADD_N, tflite),
+    TF_LITE_AOT_OP(ARG_MAX, tflite::ops::micro, TfLiteArgMaxParams),
+    TF_LITE_AOT_OP(ARG_MIN, tflite::ops::micro, TfLiteArgMinParams),
+    TF_LITE_AOT_OP(AVERAGE_POOL_2D, tflite, TfLitePoolParams),
+    TF_LITE_AOT_OP(BATCH_MATMUL, tflite, TfLiteBatchMatMulParams),
+    TF_LITE_AOT_OP_NO_PARAMS(BATCH_TO_SPACE_ND, tflite),
+    TF_LITE_AOT_OP(CAST, tflite, TfLiteCastParams),
+    TF_LITE_AOT_OP_NO_PARAMS(CEIL, tflite::ops::micro),
+    TF_LITE_AOT_OP(CONCATENATION, tflite::ops::micro,
+                   TfLiteConcatenationParams),
+    TF_LITE_AOT_OP(CONV_2D, tflite, TfLiteConvParams),
+    TF_LITE_AOT_OP_NO_PARAMS(COS, tflite::ops::micro),
+    TF_LITE_AOT_OP(CUMSUM, tflite, TfLiteCumsumParams),
+    TF_LITE_AOT_OP(DEPTH_TO_SPACE, tflite, TfLiteDepthToSpaceParams),
+    TF_LITE_AOT_OP(DEPTHWISE_CONV_2D, tflite, TfLiteDepthwiseConvParams),
+    TF_LITE_AOT_OP_NO_PARAMS(DEQUANTIZE, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(ELU, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(EQUAL, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(EXP, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(EXPAND_DIMS, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(FILL, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(FLOOR, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(FLOOR_DIV, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(FLOOR_MOD, tflite),
+    TF_LITE_AOT_OP(FULLY_CONNECTED, tflite, TfLiteFullyConnectedParams),
+    TF_LITE_AOT_OP(GATHER, tflite, TfLiteGatherParams),
+    TF_LITE_AOT_OP_NO_PARAMS(GATHER_ND, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(GREATER, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(GREATER_EQUAL, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(HARD_SWISH, tflite),
+    TF_LITE_AOT_OP(L2_NORMALIZATION, tflite::ops::micro, TfLiteL2NormParams),
+    TF_LITE_AOT_OP(L2_POOL_2D, tflite, TfLitePoolParams),
+    TF_LITE_AOT_OP(LEAKY_RELU, tflite, TfLiteLeakyReluParams),
+    TF_LITE_AOT_OP_NO_PARAMS(LESS, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(LESS_EQUAL, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(LOG, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(LOGICAL_AND, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(LOGICAL_NOT, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(LOGICAL_OR, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(LOGISTIC, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(MAXIMUM, tflite::ops::micro),
+    TF_LITE_AOT_OP(MAX_POOL_2D, tflite, TfLitePoolParams),
+    TF_LITE_AOT_OP(MEAN, tflite::ops::micro, TfLiteReducerParams),
+    TF_LITE_AOT_OP_NO_PARAMS(MINIMUM, tflite::ops::micro),
+    TF_LITE_AOT_OP(MUL, tflite::ops::micro, TfLiteMulParams),
+    TF_LITE_AOT_OP_NO_PARAMS(NEG, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(NOT_EQUAL, tflite::ops::micro),
+    TF_LITE_AOT_OP(PACK, tflite::ops::micro, TfLitePackParams),
+    TF_LITE_AOT_OP_NO_PARAMS(PAD, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(PADV2, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(PRELU, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(QUANTIZE, tflite),
+    TF_LITE_AOT_OP(REDUCE_MAX, tflite::ops::micro, TfLiteReducerParams),
+    TF_LITE_AOT_OP_NO_PARAMS(RELU, tflite),
+    TF_LITE_AOT_OP_NO_PARAMS(RELU6, tflite),
+    TF_LITE_AOT_OP(RESHAPE, tflite::ops::micro, TfLiteReshapeParams),
+    TF_LITE_AOT_OP(RESIZE_BILINEAR, tflite, TfLiteResizeBilinearParams),
+    TF_LITE_AOT_OP(RESIZE_NEAREST_NEIGHBOR, tflite::ops::micro,
+                   TfLiteResizeNearestNeighborParams),
+    TF_LITE_AOT_OP_NO_PARAMS(ROUND, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(RSQRT, tflite::ops::micro),
+    TF_LITE_AOT_OP(SHAPE, tflite, TfLiteShapeParams),
+    TF_LITE_AOT_OP_NO_PARAMS(SIN, tflite::ops::micro),
+    TF_LITE_AOT_OP(SOFTMAX, tflite, TfLiteSoftmaxParams),
+    TF_LITE_AOT_OP_NO_PARAMS(SPACE_TO_BATCH_ND, tflite),
+    TF_LITE_AOT_OP(SPACE_TO_DEPTH, tflite, TfLiteSpaceToDepthParams),
+    TF_LITE_AOT_OP(SPLIT, tflite::ops::micro, TfLiteSplitParams),
+    TF_LITE_AOT_OP(SPLIT_V, tflite::ops::micro, TfLiteSplitVParams),
+    TF_LITE_AOT_OP(SQUEEZE, tflite, TfLiteSqueezeParams),
+    TF_LITE_AOT_OP_NO_PARAMS(SQRT, tflite::ops::micro),
+    TF_LITE_AOT_OP_NO_PARAMS(SQUARE, tflite::ops::micro),
+    TF_LITE_AOT_OP(STRIDED_SLICE, tflite::ops::micro, TfLiteStridedSliceParams),
+    TF_LITE_AOT_OP(SUB, tflite::ops::micro, TfLiteSubParams),
+    TF_LITE_AOT_OP(SVDF, tflite, TfLiteSVDFParams),
+    TF_LITE_AOT_OP_NO_PARAMS(TANH, tflite::ops::micro),
+    TF_LITE_AOT_OP(TRANSPOSE_CONV, tflite, TfLiteTransposeConvParams),
+    TF_LITE_AOT_OP_NO_PARAMS(TRANSPOSE, tflite),
+    TF_LITE_AOT_OP(UNPACK, tflite::ops::micro, TfLiteUnpackParams),
+    TF_LITE_AOT_OP(UNIDIRECTIONAL_SEQUENCE_LSTM, tflite::ops::micro,
+                   TfLiteUnidirectionalSequenceLSTMParams),
+    TF_LITE_AOT_OP_NO_PARAMS(ZEROS_LIKE, tflite),
+};
+
+#undef TF_LITE_AOT_OP
+#undef TF_LITE_AOT_OP_NO_PARAMS
+
+const OpInfo* FindOp(BuiltinOperator op) {
+  for (const OpInfo& info : kOps) {
+    if (info.op == op) {
+      return &info;
+    }
+  }
+  return nullptr;
+}
+
+// Gives access to the state of the prepared model.
+class PlanningInterpreter : public RecordingMicroInterpreter {
+ public:
+  PlanningInterpreter(const Model* model, const MicroOpResolver& op_resolver,
+                      uint8_t* tensor_arena, size_t tensor_arena_size,
+                      ErrorReporter* error_reporter)
+      : RecordingMicroInterpreter(model, op_resolver, tensor_arena,
+                                  tensor_arena_size, error_reporter) {}
+
+  const MicroAllocator& planner() const { return allocator(); }
+
+  TfLiteContext* mutable_context() {
+    return const_cast<TfLiteContext*>(&context());
+  }
+};
+
+const char* TypeName(TfLiteType type) {
+  switch (type) {
+    case kTfLiteFloat32:
+      return "kTfLiteFloat32";
+    case kTfLiteInt32:
+      return "kTfLiteInt32";
+    case kTfLiteUInt8:
+      return "kTfLiteUInt8";
+    case kTfLiteInt64:
+      return "kTfLiteInt64";
+    case kTfLiteBool:
+      return "kTfLiteBool";
+    case kTfLiteInt16:
+      return "kTfLiteInt16";
+    case kTfLiteInt8:
+      return "kTfLiteInt8";
+    case kTfLiteFloat16:
+      return "kTfLiteFloat16";
+    case kTfLiteFloat64:
+      return "kTfLiteFloat64";
+    case kTfLiteUInt64:
+      return "kTfLiteUInt64";
+    case kTfLiteUInt32:
+      return "kTfLiteUInt32";
+    default:
+      return "kTfLiteNoType";
+  }
+}
+
+// Lower case name of an operator, used for identifiers.
+void OpIdentifier(BuiltinOperator op, char* identifier, size_t size) {
+  const char* name = EnumNameBuiltinOperator(op);
+  size_t i = 0;
+  for (; name[i] != '\0' && i + 1 < size; ++i) {
+    identifier[i] = static_cast<char>(tolower(name[i]));
+  }
+  identifier[i] = '\0';
+}
+
+void WriteIntArray(FILE* file, const char* name, int index,
+                   const TfLiteIntArray* array) {
+  // Arrays keep at least one element, zero sized arrays are not standard C++.
+  const int capacity = array->size > 0 ? array->size : 1;
+  fprintf(file, "tflite::aot::IntArray<%d> %s%d = {%d, {", capacity, name,
+          index, array->size);
+  for (int i = 0; i < array->size; ++i) {
+    fprintf(file, i == 0 ? "%d" : ", %d", array->data[i]);
+  }
+  fprintf(file, array->size > 0 ? "}};\n" : "0}};\n");
+}
+
+void WriteFloat(FILE* file, float value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.9g", static_cast<double>(value));
+  fprintf(file, "%s%sf", buffer, strpbrk(buffer, ".en") ? "" : ".0");
+}
+
+// Writes the quantization parameters of tensor `index` and returns true, or
+// returns false if the tensor is not quantized.
+bool WriteQuantization(FILE* file, const Tensor* tensor, int index) {
+  const QuantizationParameters* quantization = tensor->quantization();
+  if (quantization == nullptr || quantization->scale() == nullptr ||
+      quantization->scale()->size() == 0 ||
+      quantization->zero_point() == nullptr ||
+      quantization->zero_point()->size() == 0) {
+    return false;
+  }
+  const int scales_size = quantization->scale()->size();
+  fprintf(file, "tflite::aot::FloatArray<%d> tensor_scale%d = {%d, {",
+          scales_size, index, scales_size);
+  for (int i = 0; i < scales_size; ++i) {
+    fprintf(file, i == 0 ? "" : ", ");
+    WriteFloat(file, quantization->scale()->Get(i));
+  }
+  fprintf(file, "}};\n");
+  // Like MicroAllocator, a single zero point is repeated for every scale.
+  fprintf(file, "tflite::aot::IntArray<%d> tensor_zero_point%d = {%d, {",
+          scales_size, index, scales_size);
+  for (int i = 0; i < scales_size; ++i) {
+    const int zero_point_idx =
+        quantization->zero_point()->size() == 1 ? 0 : i;
+    fprintf(file, i == 0 ? "%d" : ", %d",
+            static_cast<int>(quantization->zero_point()->Get(zero_point_idx)));
+  }
+  fprintf(file, "}};\n");
+  fprintf(file,
+          "TfLiteAffineQuantization tensor_quantization%d = {\n"
+          "    reinterpret_cast<TfLiteFloatArray*>(&tensor_scale%d),\n"
+          "    reinterpret_cast<TfLiteIntArray*>(&tensor_zero_point%d), %d};\n",
+          index, index, index, quantization->quantized_dimension());
+  return true;
+}
+
+void WriteHeader(FILE* file, const char* model_path, const char* class_name,
+                 const char* header_path, size_t arena_size,
+                 size_t tensors_size, size_t nodes_size, size_t inputs_size,
+                 size_t outputs_size) {
+  char guard[256];
+  size_t i = 0;
+  for (; header_path[i] != '\0' && i + 2 < sizeof(guard); ++i) {
+    guard[i] = isalnum(header_path[i])
+                   ? static_cast<char>(toupper(header_path[i]))
+                   : '_';
+  }
+  guard[i++] = '_';
+  guard[i] = '\0';
+
+  fprintf(file,
+          "// Generated by tensorflow/lite/micro/tools/aot/generate_aot_source "
+          "from\n// %s. Do not edit.\n\n",
+          model_path);
+  fprintf(file, "#ifndef %s\n#define %s\n\n", guard, guard);
+  fprintf(file,
+          "#include <cstddef>\n#include <cstdint>\n\n"
+          "#include \"tensorflow/lite/c/common.h\"\n"
+          "#include \"tensorflow/lite/core/api/error_reporter.h\"\n"
+          "#include \"tensorflow/lite/micro/tools/aot/aot_runtime.h\"\n\n");
+  fprintf(file,
+          "class %s {\n"
+          " public:\n"
+          "  // Arena size computed on the host, an upper bound for 32-bit "
+          "targets.\n"
+          "  static constexpr size_t kArenaSize = %zu;\n\n"
+          "  // Binds the tensors to `arena` and prepares the kernels. "
+          "`model_data` is the\n"
+          "  // .tflite flatbuffer the code was generated from, the weights "
+          "are read from\n"
+          "  // it.\n"
+          "  TfLiteStatus Init(const uint8_t* model_data, uint8_t* arena,\n"
+          "                    size_t arena_size, tflite::ErrorReporter* "
+          "error_reporter);\n\n"
+          "  TfLiteStatus Invoke();\n\n"
+          "  size_t inputs_size() const { return %zu; }\n"
+          "  size_t outputs_size() const { return %zu; }\n"
+          "  TfLiteEvalTensor* input(size_t index);\n"
+          "  TfLiteEvalTensor* output(size_t index);\n\n"
+          "  size_t arena_used_bytes() const { return "
+          "runtime_.arena_used_bytes(); }\n\n"
+          " private:\n"
+          "  tflite::aot::Runtime runtime_;\n"
+          "  TfLiteEvalTensor tensors_[%zu];\n"
+          "  tflite::NodeAndRegistration nodes_[%zu];\n"
+          "};\n\n",
+          class_name, arena_size, inputs_size, outputs_size, tensors_size,
+          nodes_size);
+  fprintf(file, "#endif  // %s\n", guard);
+}
+
+TfLiteStatus WriteSource(FILE* file, const char* model_path,
+                         const char* class_name, const char* header_path,
+                         const Model* model, const uint8_t* model_data,
+                         size_t model_size, PlanningInterpreter* interpreter) {
+  const SubGraph* subgraph = model->subgraphs()->Get(0);
+  const size_t tensors_size = subgraph->tensors()->size();
+  const size_t nodes_size = NumSubgraphOperators(subgraph);
+  TfLiteContext* context = interpreter->mutable_context();
+  const MicroAllocator& planner = interpreter->planner();
+  const uint8_t* head_buffer = planner.planned_head_buffer();
+  const size_t head_bytes = planner.planned_head_bytes();
+
+  TfLiteIntArray* graph_ptr;
+  TF_LITE_ENSURE_STATUS(context->GetExecutionPlan(context, &graph_ptr));
+  const NodeAndRegistration* node_and_registrations =
+      reinterpret_cast<MicroGraph*>(graph_ptr)
+          ->GetAllocations()[0]
+          .node_and_registrations;
+
+  fprintf(file,
+          "// Generated by tensorflow/lite/micro/tools/aot/generate_aot_source "
+          "from\n// %s. Do not edit.\n\n",
+          model_path);
+  fprintf(file,
+          "#include \"%s\"\n\n"
+          "#include \"tensorflow/lite/c/builtin_op_data.h\"\n"
+          "#include \"tensorflow/lite/c/common.h\"\n"
+          "#include \"tensorflow/lite/micro/kernels/conv.h\"\n"
+          "#include \"tensorflow/lite/micro/kernels/fully_connected.h\"\n"
+          "#include \"tensorflow/lite/micro/kernels/micro_ops.h\"\n"
+          "#include \"tensorflow/lite/micro/kernels/softmax.h\"\n"
+          "#include \"tensorflow/lite/micro/tools/aot/aot_runtime.h\"\n\n"
+          "namespace {\n\n"
+          "constexpr size_t kPlannedHeadBytes = %zu;\n",
+          header_path, head_bytes);
+
+  // Tensors.
+  for (size_t i = 0; i < tensors_size; ++i) {
+    const TfLiteEvalTensor* eval_tensor = context->GetEvalTensor(context, i);
+    fprintf(file, "\n");
+    WriteIntArray(file, "tensor_dims", i, eval_tensor->dims);
+    WriteQuantization(file, subgraph->tensors()->Get(i), i);
+  }
+  fprintf(file, "\nconst tflite::aot::TensorSpec kTensorSpecs[] = {\n");
+  for (size_t i = 0; i < tensors_size; ++i) {
+    const TfLiteEvalTensor* eval_tensor = context->GetEvalTensor(context, i);
+    const uint8_t* data = eval_tensor->data.uint8;
+    long arena_offset = -1;
+    long model_offset = -1;
+    size_t bytes = 0;
+    if (data != nullptr) {
+      TF_LITE_ENSURE_STATUS(TfLiteEvalTensorByteLength(eval_tensor, &bytes));
+      if (data >= head_buffer && data < head_buffer + head_bytes) {
+        arena_offset = data - head_buffer;
+      } else if (data >= model_data && data < model_data + model_size) {
+        model_offset = data - model_data;
+      } else {
+        MicroPrintf("Tensor %d is neither planned nor stored in the model.",
+                    i);
+        return kTfLiteError;
+      }
+    }
+    const Tensor* tensor = subgraph->tensors()->Get(i);
+    const bool quantized =
+        tensor->quantization() != nullptr &&
+        tensor->quantization()->scale() != nullptr &&
+        tensor->quantization()->scale()->size() > 0 &&
+        tensor->quantization()->zero_point() != nullptr &&
+        tensor->quantization()->zero_point()->size() > 0;
+    fprintf(file,
+            "    {%s, reinterpret_cast<TfLiteIntArray*>(&tensor_dims%zu), %ld, "
+            "%ld, %zu,\n     ",
+            TypeName(eval_tensor->type), i, arena_offset, model_offset,
+            bytes);
+    if (quantized) {
+      fprintf(file, "&tensor_quantization%zu},\n", i);
+    } else {
+      fprintf(file, "nullptr},\n");
+    }
+  }
+  fprintf(file, "};\n");
+
+  // Scratch buffers.
+  const size_t scratch_buffers_size = planner.scratch_buffer_count();
+  if (scratch_buffers_size > 0) {
+    fprintf(file, "\nconst int32_t kScratchBufferOffsets[] = {");
+    for (size_t i = 0; i < scratch_buffers_size; ++i) {
+      const uint8_t* data = static_cast<const uint8_t*>(
+          context->GetScratchBuffer(context, i));
+      fprintf(file, i == 0 ? "%ld" : ", %ld",
+              static_cast<long>(data - head_buffer));
+    }
+    fprintf(file, "};\n");
+  } else {
+    fprintf(file, "\nconst int32_t* kScratchBufferOffsets = nullptr;\n");
+  }
+
+  // Nodes.
+  for (size_t i = 0; i < nodes_size; ++i) {
+    const TfLiteNode& node = node_and_registrations[i].node;
+    const OpInfo* info = FindOp(static_cast<BuiltinOperator>(
+        node_and_registrations[i].registration->builtin_code));
+    fprintf(file, "\n");
+    WriteIntArray(file, "node_inputs", i, node.inputs);
+    WriteIntArray(file, "node_outputs", i, node.outputs);
+    if (node.intermediates != nullptr) {
+      WriteIntArray(file, "node_intermediates", i, node.intermediates);
+    }
+    if (info->params_type != nullptr && node.builtin_data != nullptr) {
+      // The builtin data structs only hold enums, ints, floats and bools, so
+      // their bytes carry over to little-endian targets with the same layout.
+      const uint8_t* bytes = static_cast<const uint8_t*>(node.builtin_data);
+      fprintf(file, "alignas(8) uint8_t node_builtin_data%zu[] = {", i);
+      for (size_t j = 0; j < info->params_size; ++j) {
+        const char* separator = j % 16 == 0 ? (j == 0 ? "\n    " : ",\n    ")
+                                            : ", ";
+        fprintf(file, "%s%u", separator, bytes[j]);
+      }
+      fprintf(file,
+              "};\nstatic_assert(sizeof(%s) == sizeof(node_builtin_data%zu),\n"
+              "              \"%s differs from the host.\");\n",
+              info->params_type, i, info->params_type);
+    }
+  }
+
+  // Registrations, one per operator type.
+  fprintf(file, "\n");
+  bool written[BuiltinOperator_MAX + 1] = {};
+  for (size_t i = 0; i < nodes_size; ++i) {
+    const BuiltinOperator op = static_cast<BuiltinOperator>(
+        node_and_registrations[i].registration->builtin_code);
+    if (!written[op]) {
+      char identifier[64];
+      OpIdentifier(op, identifier, sizeof(identifier));
+      fprintf(file, "TfLiteRegistration %s_registration;\n", identifier);
+      written[op] = true;
+    }
+  }
+
+  fprintf(file, "\nconst int kInputs[] = {");
+  for (size_t i = 0; i < subgraph->inputs()->size(); ++i) {
+    fprintf(file, i == 0 ? "%d" : ", %d", subgraph->inputs()->Get(i));
+  }
+  fprintf(file, "};\nconst int kOutputs[] = {");
+  for (size_t i = 0; i < subgraph->outputs()->size(); ++i) {
+    fprintf(file, i == 0 ? "%d" : ", %d", subgraph->outputs()->Get(i));
+  }
+  fprintf(file, "};\n\n}  // namespace\n\n");
+
+  // Init().
+  const int indent = strlen("TfLiteStatus ::Init(") + strlen(class_name);
+  fprintf(file,
+          "TfLiteStatus %s::Init(const uint8_t* model_data, uint8_t* arena,\n"
+          "%*ssize_t arena_size,\n"
+          "%*stflite::ErrorReporter* error_reporter) {\n"
+          "  TF_LITE_ENSURE_STATUS(runtime_.Init(\n"
+          "      model_data, kTensorSpecs, tensors_, %zu, "
+          "kScratchBufferOffsets, %zu,\n"
+          "      kPlannedHeadBytes, arena, arena_size, error_reporter));\n\n",
+          class_name, indent, "", indent, "", tensors_size,
+          scratch_buffers_size);
+  memset(written, 0, sizeof(written));
+  for (size_t i = 0; i < nodes_size; ++i) {
+    const BuiltinOperator op = static_cast<BuiltinOperator>(
+        node_and_registrations[i].registration->builtin_code);
+    if (!written[op]) {
+      char identifier[64];
+      OpIdentifier(op, identifier, sizeof(identifier));
+      fprintf(file, "  %s_registration = %s;\n", identifier,
+              FindOp(op)->registration);
+      written[op] = true;
+    }
+  }
+  for (size_t i = 0; i < nodes_size; ++i) {
+    const TfLiteNode& node = node_and_registrations[i].node;
+    const OpInfo* info = FindOp(static_cast<BuiltinOperator>(
+        node_and_registrations[i].registration->builtin_code));
+    fprintf(file,
+            "\n  nodes_[%zu] = {};\n"
+            "  nodes_[%zu].node.inputs = "
+            "reinterpret_cast<TfLiteIntArray*>(&node_inputs%zu);\n"
+            "  nodes_[%zu].node.outputs = "
+            "reinterpret_cast<TfLiteIntArray*>(&node_outputs%zu);\n",
+            i, i, i, i, i);
+    if (node.intermediates != nullptr) {
+      fprintf(file,
+              "  nodes_[%zu].node.intermediates =\n"
+              "      reinterpret_cast<TfLiteIntArray*>(&node_intermediates%zu);"
+              "\n",
+              i, i);
+    }
+    if (info->params_type != nullptr && node.builtin_data != nullptr) {
+      fprintf(file,
+              "  nodes_[%zu].node.builtin_data = node_builtin_data%zu;\n", i,
+              i);
+    }
+    // The memory plan may overlap the output of the node with its input, in
+    // which case the kernel has to compute in reverse order.
+    if (node.reverse) {
+      fprintf(file, "  nodes_[%zu].node.reverse = true;\n", i);
+    }
+  }
+  fprintf(file, "\n");
+  for (size_t i = 0; i < nodes_size; ++i) {
+    char identifier[64];
+    OpIdentifier(static_cast<BuiltinOperator>(
+                     node_and_registrations[i].registration->builtin_code),
+                 identifier, sizeof(identifier));
+    fprintf(file,
+            "  runtime_.InitNode(%s_registration, &nodes_[%zu].node);\n",
+            identifier, i);
+  }
+  for (size_t i = 0; i < nodes_size; ++i) {
+    char identifier[64];
+    OpIdentifier(static_cast<BuiltinOperator>(
+                     node_and_registrations[i].registration->builtin_code),
+                 identifier, sizeof(identifier));
+    fprintf(file,
+            "  TF_LITE_ENSURE_STATUS(\n"
+            "      runtime_.PrepareNode(%s_registration, "
+            "&nodes_[%zu].node));\n",
+            identifier, i);
+  }
+  fprintf(file, "  return runtime_.FinishPrepare(nodes_, %zu);\n}\n\n",
+          nodes_size);
+
+  // Invoke().
+  fprintf(file,
+          "TfLiteStatus %s::Invoke() {\n"
+          "  TfLiteContext* context = runtime_.context();\n",
+          class_name);
+  for (size_t i = 0; i < nodes_size; ++i) {
+    char identifier[64];
+    OpIdentifier(static_cast<BuiltinOperator>(
+                     node_and_registrations[i].registration->builtin_code),
+                 identifier, sizeof(identifier));
+    fprintf(file,
+            "  TF_LITE_ENSURE_STATUS(\n"
+            "      %s_registration.invoke(context, &nodes_[%zu].node));\n",
+            identifier, i);
+  }
+  fprintf(file,
+          "  runtime_.ResetTempAllocations();\n"
+          "  return kTfLiteOk;\n}\n\n");
+
+  fprintf(file,
+          "TfLiteEvalTensor* %s::input(size_t index) {\n"
+          "  return index < inputs_size() ? &tensors_[kInputs[index]] : "
+          "nullptr;\n}\n\n"
+          "TfLiteEvalTensor* %s::output(size_t index) {\n"
+          "  return index < outputs_size() ? &tensors_[kOutputs[index]] : "
+          "nullptr;\n}\n",
+          class_name, class_name);
+  return kTfLiteOk;
+}
+
+// Returns an upper bound of the arena used by aot::Runtime: the memory plan,
+// the persistent buffers of the kernels, the tensor tables and the temp
+// TfLiteTensor structs of the operator with the most tensors. Sizes are taken
+// on the host, which overestimates them for 32-bit targets.
+size_t ArenaSize(const SubGraph* subgraph, PlanningInterpreter* interpreter,
+                 const NodeAndRegistration* node_and_registrations) {
+  const RecordedAllocation kernel_buffers =
+      interpreter->GetMicroAllocator().GetRecordedAllocation(
+          RecordedAllocationType::kPersistentBufferData);
+  const size_t tensors_size = subgraph->tensors()->size();
+  size_t size = interpreter->planner().planned_head_bytes() +
+                kBufferAlignment + sizeof(SimpleMemoryAllocator) +
+                kBufferAlignment + kernel_buffers.used_bytes +
+                kernel_buffers.count * kBufferAlignment +
+                sizeof(RuntimeShape) * (tensors_size + 1) + kBufferAlignment;
+  size_t max_node_tensors = 0;
+  for (size_t i = 0; i < NumSubgraphOperators(subgraph); ++i) {
+    const TfLiteNode& node = node_and_registrations[i].node;
+    size_t node_tensors = node.inputs->size + node.outputs->size;
+    size += 2 * (sizeof(void*) * node_tensors + kBufferAlignment);
+    if (node.intermediates != nullptr) {
+      node_tensors += node.intermediates->size;
+    }
+    if (node_tensors > max_node_tensors) {
+      max_node_tensors = node_tensors;
+    }
+  }
+  size += max_node_tensors * (sizeof(TfLiteTensor) + kBufferAlignment);
+  return size;
+}
+
+TfLiteStatus CheckModel(const Model* model) {
+  if (model->subgraphs()->size() != 1) {
+    MicroPrintf("Only models with a single subgraph are supported, found %d.",
+                model->subgraphs()->size());
+    return kTfLiteError;
+  }
+  const SubGraph* subgraph = model->subgraphs()->Get(0);
+  for (size_t i = 0; i < subgraph->tensors()->size(); ++i) {
+    if (subgraph->tensors()->Get(i)->is_variable()) {
+      MicroPrintf("Variable tensors are not supported (tensor %d).", i);
+      return kTfLiteError;
+    }
+  }
+  for (size_t i = 0; i < NumSubgraphOperators(subgraph); ++i) {
+    const auto* op = subgraph->operators()->Get(i);
+    const BuiltinOperator builtin_code =
+        GetBuiltinCode(model->operator_codes()->Get(op->opcode_index()));
+    if (FindOp(builtin_code) == nullptr) {
+      MicroPrintf("Operator %s (number %d) is not supported.",
+                  EnumNameBuiltinOperator(builtin_code), i);
+      return kTfLiteError;
+    }
+  }
+  return kTfLiteOk;
+}
+
+bool IsIdentifier(const char* name) {
+  if (name[0] == '\0' || isdigit(name[0])) {
+    return false;
+  }
+  for (const char* c = name; *c != '\0'; ++c) {
+    if (!isalnum(*c) && *c != '_') {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint8_t* ReadFile(const char* path, size_t* size) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+  fseek(file, 0, SEEK_END);
+  *size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  // malloc() aligns well enough for the flatbuffer.
+  uint8_t* data = static_cast<uint8_t*>(malloc(*size));
+  if (data != nullptr && fread(data, 1, *size, file) != *size) {
+    free(data);
+    data = nullptr;
+  }
+  fclose(file);
+  return data;
+}
+
+int Run(int argc, char** argv) {
+  if (argc != 5 && argc != 6) {
+    MicroPrintf(
+        "Usage: %s <model.tflite> <class name> <output header> "
+        "<output source> [<header include path>]",
+        argv[0]);
+    return 1;
+  }
+  const char* model_path = argv[1];
+  const char* class_name = argv[2];
+  const char* header_path = argv[3];
+  const char* source_path = argv[4];
+  // The path the generated source includes the header with, which differs
+  // from `header_path` when the header is written to a build output tree.
+  const char* header_include_path = argc == 6 ? argv[5] : header_path;
+  if (!IsIdentifier(class_name)) {
+    MicroPrintf("%s is not a valid class name.", class_name);
+    return 1;
+  }
+
+  size_t model_size = 0;
+  uint8_t* model_data = ReadFile(model_path, &model_size);
+  if (model_data == nullptr) {
+    MicroPrintf("Failed to read %s.", model_path);
+    return 1;
+  }
+  const Model* model = GetModel(model_data);
+  if (CheckModel(model) != kTfLiteOk) {
+    return 1;
+  }
+
+  AllOpsResolver op_resolver;
+  PlanningInterpreter interpreter(model, op_resolver, planning_arena,
+                                  kPlanningArenaSize, GetMicroErrorReporter());
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    MicroPrintf("Failed to prepare %s.", model_path);
+    return 1;
+  }
+
+  TfLiteContext* context = interpreter.mutable_context();
+  TfLiteIntArray* graph_ptr;
+  context->GetExecutionPlan(context, &graph_ptr);
+  const NodeAndRegistration* node_and_registrations =
+      reinterpret_cast<MicroGraph*>(graph_ptr)
+          ->GetAllocations()[0]
+          .node_and_registrations;
+  const SubGraph* subgraph = model->subgraphs()->Get(0);
+
+  FILE* header = fopen(header_path, "w");
+  FILE* source = fopen(source_path, "w");
+  if (header == nullptr || source == nullptr) {
+    MicroPrintf("Failed to open the output files.");
+    return 1;
+  }
+  WriteHeader(header, model_path, class_name, header_include_path,
+              ArenaSize(subgraph, &interpreter, node_and_registrations),
+              subgraph->tensors()->size(), NumSubgraphOperators(subgraph),
+              subgraph->inputs()->size(), subgraph->outputs()->size());
+  const TfLiteStatus status =
+      WriteSource(source, model_path, class_name, header_include_path, model,
+                  model_data, model_size, &interpreter);
+  fclose(header);
+  fclose(source);
+  // The model data is left to the process exit, the interpreter still uses it
+  // when it is destroyed.
+  return status == kTfLiteOk ? 0 : 1;
+}
+
+}  // namespace
+}  // namespace tflite
+
+int main(int argc, char** argv) { return tflite::Run(argc, argv); }
@@ -0,0 +1,114 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks that the sources generate_aot_source writes for a model compute
+// bit-identical outputs to MicroInterpreter running the same model.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/examples/hello_world/hello_world_model_data.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/models/person_detect_model_data.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+#include "tensorflow/lite/micro/tools/aot/hello_world_aot.h"
+#include "tensorflow/lite/micro/tools/aot/person_detect_aot.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+constexpr size_t kInterpreterArenaSize = 136 * 1024;
+alignas(16) uint8_t interpreter_arena[kInterpreterArenaSize];
+
+// Number of different inputs each model is run on.
+constexpr int kNumRuns = 3;
+
+// Fills `data` with a pattern that depends on `seed` and covers all byte
+// values.
+void FillInput(uint8_t* data, size_t bytes, int seed) {
+  uint32_t state = 12345u + static_cast<uint32_t>(seed);
+  for (size_t i = 0; i < bytes; ++i) {
+    state = state * 1103515245u + 12345u;
+    data[i] = static_cast<uint8_t>(state >> 16);
+  }
+}
+
+// Runs `model_data` with MicroInterpreter and with `AotModel`, the class
+// generated from it, on the same inputs and expects the same output bytes.
+template <typename AotModel>
+void ExpectSameOutputs(const uint8_t* model_data) {
+  alignas(16) static uint8_t aot_arena[AotModel::kArenaSize];
+  static AotModel aot_model;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, aot_model.Init(model_data, aot_arena, AotModel::kArenaSize,
+                                tflite::GetMicroErrorReporter()));
+
+  tflite::AllOpsResolver op_resolver;
+  tflite::MicroInterpreter interpreter(
+      tflite::GetModel(model_data), op_resolver, interpreter_arena,
+      kInterpreterArenaSize, tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+  TF_LITE_MICRO_EXPECT_EQ(interpreter.inputs_size(), aot_model.inputs_size());
+  TF_LITE_MICRO_EXPECT_EQ(interpreter.outputs_size(),
+                          aot_model.outputs_size());
+
+  for (int run = 0; run < kNumRuns; ++run) {
+    for (size_t i = 0; i < aot_model.inputs_size(); ++i) {
+      TfLiteTensor* input = interpreter.input(i);
+      TfLiteEvalTensor* aot_input = aot_model.input(i);
+      size_t aot_bytes = 0;
+      TF_LITE_MICRO_EXPECT_EQ(
+          kTfLiteOk, tflite::TfLiteEvalTensorByteLength(aot_input, &aot_bytes));
+      TF_LITE_MICRO_EXPECT_EQ(input->bytes, aot_bytes);
+      FillInput(input->data.uint8, input->bytes, run);
+      FillInput(aot_input->data.uint8, aot_bytes, run);
+    }
+
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aot_model.Invoke());
+
+    for (size_t i = 0; i < aot_model.outputs_size(); ++i) {
+      const TfLiteTensor* output = interpreter.output(i);
+      const TfLiteEvalTensor* aot_output = aot_model.output(i);
+      size_t aot_bytes = 0;
+      TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, tflite::TfLiteEvalTensorByteLength(
+                                             aot_output, &aot_bytes));
+      TF_LITE_MICRO_EXPECT_EQ(output->bytes, aot_bytes);
+      TF_LITE_MICRO_EXPECT_EQ(
+          0, memcmp(output->data.uint8, aot_output->data.uint8, aot_bytes));
+    }
+  }
+
+  TF_LITE_MICRO_EXPECT_LE(aot_model.arena_used_bytes(), AotModel::kArenaSize);
+}
+
+}  // namespace
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(HelloWorldMatchesInterpreter) {
+  ExpectSameOutputs<HelloWorldAot>(g_hello_world_model_data);
+}
+
+TF_LITE_MICRO_TEST(PersonDetectMatchesInterpreter) {
+  ExpectSameOutputs<PersonDetectAot>(g_person_detect_model_data);
+}
+
+TF_LITE_MICRO_TESTS_END
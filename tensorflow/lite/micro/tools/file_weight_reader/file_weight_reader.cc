@@ -0,0 +1,140 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/tools/file_weight_reader/file_weight_reader.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+namespace tflite {
+
+FileWeightReader::~FileWeightReader() { Close(); }
+
+TfLiteStatus FileWeightReader::Open(const char* path,
+                                    ErrorReporter* error_reporter,
+                                    int latency_us, size_t bytes_per_second) {
+  Close();
+  fd_ = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd_ < 0) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Failed to open %s: %s", path,
+                         strerror(errno));
+    return kTfLiteError;
+  }
+  error_reporter_ = error_reporter;
+  latency_us_ = latency_us;
+  bytes_per_second_ = bytes_per_second;
+  status_ = kTfLiteOk;
+  finished_reads_ = 0;
+  stopping_ = false;
+  thread_ = std::thread(&FileWeightReader::ReaderThread, this);
+  return kTfLiteOk;
+}
+
+TfLiteStatus FileWeightReader::StartRead(size_t offset, size_t size,
+                                         uint8_t* dest) {
+  if (fd_ < 0) {
+    return kTfLiteError;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  reads_.push_back({offset, size, dest});
+  ++pending_reads_;
+  queued_.notify_one();
+  return kTfLiteOk;
+}
+
+TfLiteStatus FileWeightReader::WaitForReads() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  finished_.wait(lock, [this] { return pending_reads_ == 0; });
+  const TfLiteStatus status = status_;
+  status_ = kTfLiteOk;
+  return status;
+}
+
+int FileWeightReader::reads() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return finished_reads_;
+}
+
+void FileWeightReader::ReaderThread() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    queued_.wait(lock, [this] { return stopping_ || !reads_.empty(); });
+    if (reads_.empty()) {
+      return;
+    }
+    const Read read = reads_.front();
+    reads_.pop_front();
+
+    lock.unlock();
+    const TfLiteStatus status = PerformRead(read);
+    lock.lock();
+
+    if (status != kTfLiteOk) {
+      status_ = kTfLiteError;
+    }
+    ++finished_reads_;
+    if (--pending_reads_ == 0) {
+      finished_.notify_all();
+    }
+  }
+}
+
+TfLiteStatus FileWeightReader::PerformRead(const Read& read) {
+  const auto start = std::chrono::steady_clock::now();
+  size_t done = 0;
+  while (done < read.size) {
+    const ssize_t result =
+        pread(fd_, read.dest + done, read.size - done, read.offset + done);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to read %d bytes at offset %d: %s",
+                           read.size, read.offset,
+                           result == 0 ? "end of file" : strerror(errno));
+      return kTfLiteError;
+    }
+    done += result;
+  }
+
+  int64_t duration_us = latency_us_;
+  if (bytes_per_second_ > 0) {
+    duration_us += static_cast<int64_t>(read.size) * 1000000 /
+                   static_cast<int64_t>(bytes_per_second_);
+  }
+  std::this_thread::sleep_until(start + std::chrono::microseconds(duration_us));
+  return kTfLiteOk;
+}
+
+void FileWeightReader::Close() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+      queued_.notify_one();
+    }
+    thread_.join();
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,86 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_TOOLS_FILE_WEIGHT_READER_FILE_WEIGHT_READER_H_
+#define TENSORFLOW_LITE_MICRO_TOOLS_FILE_WEIGHT_READER_FILE_WEIGHT_READER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
+
+namespace tflite {
+
+// MicroWeightReader that reads the weights from the .tflite file on a Linux
+// host, for trying out weight streaming before there is a flash driver. The
+// reads run on a background thread, so they overlap with the operators like
+// DMA transfers would. Each read can be slowed down to the latency and
+// bandwidth of the storage the model will be kept in on the device.
+class FileWeightReader : public MicroWeightReader {
+ public:
+  FileWeightReader() = default;
+  ~FileWeightReader() override;
+
+  FileWeightReader(const FileWeightReader&) = delete;
+  FileWeightReader& operator=(const FileWeightReader&) = delete;
+
+  // Opens the model file at `path` and starts the reader thread. Every read
+  // then takes at least `latency_us` plus the time to transfer its bytes at
+  // `bytes_per_second`, where 0 means no limit.
+  TfLiteStatus Open(const char* path, ErrorReporter* error_reporter,
+                    int latency_us = 0, size_t bytes_per_second = 0);
+
+  TfLiteStatus StartRead(size_t offset, size_t size, uint8_t* dest) override;
+  TfLiteStatus WaitForReads() override;
+
+  // Number of reads finished since the file was opened.
+  int reads() const;
+
+ private:
+  struct Read {
+    size_t offset;
+    size_t size;
+    uint8_t* dest;
+  };
+
+  void ReaderThread();
+  TfLiteStatus PerformRead(const Read& read);
+  void Close();
+
+  ErrorReporter* error_reporter_ = nullptr;
+  int fd_ = -1;
+  int latency_us_ = 0;
+  size_t bytes_per_second_ = 0;
+
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable finished_;
+  std::deque<Read> reads_;
+  // Reads queued or in progress on the reader thread.
+  int pending_reads_ = 0;
+  int finished_reads_ = 0;
+  TfLiteStatus status_ = kTfLiteOk;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_TOOLS_FILE_WEIGHT_READER_FILE_WEIGHT_READER_H_
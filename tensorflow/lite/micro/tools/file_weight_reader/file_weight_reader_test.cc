@@ -0,0 +1,129 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/tools/file_weight_reader/file_weight_reader.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_weight_streamer.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+#include "tensorflow/lite/micro/testing/test_conv_model.h"
+
+namespace {
+
+constexpr size_t kTensorArenaSize = 1024 * 16;
+alignas(16) uint8_t tensor_arena[kTensorArenaSize];
+
+constexpr size_t kStagingBufferSize = 1024 * 4;
+uint8_t staging_buffer[kStagingBufferSize];
+
+constexpr int kMaxOutputBytes = 1024;
+
+// Writes `size` bytes of `data` to a new temporary file whose path is stored
+// in `path`.
+bool WriteTempFile(const void* data, size_t size, char* path) {
+  strcpy(path, "/tmp/file_weight_reader_test_XXXXXX");
+  FILE* file = fdopen(mkstemp(path), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool written = fwrite(data, 1, size, file) == size;
+  fclose(file);
+  return written;
+}
+
+void FillInput(TfLiteTensor* input) {
+  for (size_t i = 0; i < input->bytes; ++i) {
+    input->data.raw[i] = static_cast<char>(i * 7 % 251);
+  }
+}
+
+}  // namespace
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(TestStreamingFromFileMatchesInPlaceInvoke) {
+  char path[64];
+  TF_LITE_MICRO_EXPECT(
+      WriteTempFile(kTestConvModelData, kTestConvModelDataSize, path));
+
+  const tflite::Model* model = tflite::GetModel(kTestConvModelData);
+  tflite::AllOpsResolver op_resolver;
+  tflite::MicroInterpreter interpreter(model, op_resolver, tensor_arena,
+                                       kTensorArenaSize,
+                                       tflite::GetMicroErrorReporter());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.AllocateTensors());
+
+  FillInput(interpreter.input(0));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+  const size_t output_bytes = interpreter.output(0)->bytes;
+  TF_LITE_MICRO_EXPECT_LE(output_bytes, static_cast<size_t>(kMaxOutputBytes));
+  char expected[kMaxOutputBytes];
+  std::memcpy(expected, interpreter.output(0)->data.raw, output_bytes);
+
+  tflite::FileWeightReader reader;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, reader.Open(path, tflite::GetMicroErrorReporter(),
+                             /*latency_us=*/200,
+                             /*bytes_per_second=*/10 * 1024 * 1024));
+  tflite::MicroWeightStreamer streamer(kTestConvModelData, &reader,
+                                       staging_buffer, kStagingBufferSize);
+  interpreter.SetWeightStreamer(&streamer);
+  for (int i = 0; i < 2; ++i) {
+    std::memset(interpreter.output(0)->data.raw, 0, output_bytes);
+    FillInput(interpreter.input(0));
+    TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, interpreter.Invoke());
+    TF_LITE_MICRO_EXPECT_EQ(0, std::memcmp(expected,
+                                           interpreter.output(0)->data.raw,
+                                           output_bytes));
+  }
+  TF_LITE_MICRO_EXPECT_GT(reader.reads(), 0);
+  remove(path);
+}
+
+TF_LITE_MICRO_TEST(TestReadPastEndOfFileFails) {
+  const uint8_t data[16] = {};
+  char path[64];
+  TF_LITE_MICRO_EXPECT(WriteTempFile(data, sizeof(data), path));
+
+  tflite::FileWeightReader reader;
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk,
+                          reader.Open(path, tflite::GetMicroErrorReporter()));
+  uint8_t dest[32];
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, reader.StartRead(0, 16, dest));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, reader.WaitForReads());
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, reader.StartRead(8, 32, dest));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, reader.WaitForReads());
+
+  // A failed read does not affect the reads after it.
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, reader.StartRead(0, 8, dest));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, reader.WaitForReads());
+  remove(path);
+}
+
+TF_LITE_MICRO_TEST(TestMissingFileFails) {
+  tflite::FileWeightReader reader;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteError, reader.Open("/tmp/file_weight_reader_test_does_not_exist",
+                                tflite::GetMicroErrorReporter()));
+  uint8_t dest[8];
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, reader.StartRead(0, 8, dest));
+}
+
+TF_LITE_MICRO_TESTS_END
@@ -0,0 +1,139 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/tools/mmap_model/mmap_model.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+// Kernels read constant tensors in place, so each buffer has to be aligned to
+// the element type of the tensors that use it. The mapping is page aligned, so
+// the buffers keep the alignment they have in the file. The verifier does not
+// check the buffer indices of the tensors, so they are checked here as well.
+TfLiteStatus CheckConstantTensors(const Model* model, const char* path,
+                                  ErrorReporter* error_reporter) {
+  const auto* buffers = model->buffers();
+  const size_t buffers_size = buffers != nullptr ? buffers->size() : 0;
+  const auto* subgraphs = model->subgraphs();
+  for (size_t i = 0; subgraphs != nullptr && i < subgraphs->size(); ++i) {
+    const auto* tensors = subgraphs->Get(i)->tensors();
+    for (size_t j = 0; tensors != nullptr && j < tensors->size(); ++j) {
+      const Tensor& tensor = *tensors->Get(j);
+      if (tensor.buffer() >= buffers_size) {
+        TF_LITE_REPORT_ERROR(error_reporter,
+                             "Tensor %d of subgraph %d of %s refers to "
+                             "missing buffer %d.",
+                             j, i, path, tensor.buffer());
+        return kTfLiteError;
+      }
+      const auto* data = buffers->Get(tensor.buffer())->data();
+      if (data == nullptr || data->size() == 0) {
+        continue;
+      }
+      size_t bytes;
+      size_t type_size;
+      TF_LITE_ENSURE_STATUS(BytesRequiredForTensor(tensor, &bytes, &type_size,
+                                                   error_reporter));
+      if (reinterpret_cast<uintptr_t>(data->data()) % type_size != 0) {
+        TF_LITE_REPORT_ERROR(error_reporter,
+                             "Buffer %d of %s is not aligned to the %d-byte "
+                             "elements of tensor %d.",
+                             tensor.buffer(), path, type_size, j);
+        return kTfLiteError;
+      }
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+MmapModel::~MmapModel() { Unmap(); }
+
+TfLiteStatus MmapModel::Map(const char* path, ErrorReporter* error_reporter) {
+  Unmap();
+
+  const int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Failed to open %s: %s", path,
+                         strerror(errno));
+    return kTfLiteError;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Failed to stat %s: %s", path,
+                         strerror(errno));
+    close(fd);
+    return kTfLiteError;
+  }
+  const size_t size = static_cast<size_t>(file_stat.st_size);
+  if (size == 0) {
+    TF_LITE_REPORT_ERROR(error_reporter, "%s is empty.", path);
+    close(fd);
+    return kTfLiteError;
+  }
+
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  // The mapping keeps its own reference to the file.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Failed to map %s: %s", path,
+                         strerror(errno));
+    return kTfLiteError;
+  }
+  data_ = static_cast<const uint8_t*>(mapping);
+  size_ = size;
+
+  // A model read from disk is untrusted, unlike one compiled into the binary,
+  // so check every offset before the interpreter follows it.
+  flatbuffers::Verifier verifier(data_, size_);
+  if (!VerifyModelBuffer(verifier)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "%s is not a valid TfLite model.",
+                         path);
+    Unmap();
+    return kTfLiteError;
+  }
+
+  if (CheckConstantTensors(model(), path, error_reporter) != kTfLiteOk) {
+    Unmap();
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+void MmapModel::Unmap() {
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace tflite
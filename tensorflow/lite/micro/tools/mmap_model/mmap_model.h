@@ -0,0 +1,68 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_TOOLS_MMAP_MODEL_MMAP_MODEL_H_
+#define TENSORFLOW_LITE_MICRO_TOOLS_MMAP_MODEL_MMAP_MODEL_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// Maps a .tflite file read-only into memory on Linux hosts, so that a model can
+// be handed to MicroInterpreter without compiling it into the binary or
+// copying it to the heap. The weights are paged in on first use and are shared
+// through the page cache between all processes that map the same file.
+//
+// Kernels read constant tensors in place, so the mapping must stay alive for
+// as long as any interpreter uses model(). To hot-swap a model, write the new
+// file next to the old one and rename() it over the old path, then Map() it
+// again. Truncating or rewriting a mapped file in place makes later reads of
+// the old mapping fault.
+class MmapModel {
+ public:
+  MmapModel() = default;
+  ~MmapModel();
+
+  MmapModel(const MmapModel&) = delete;
+  MmapModel& operator=(const MmapModel&) = delete;
+
+  // Maps the file at `path` and verifies that it holds a TfLite flatbuffer
+  // whose buffers keep the alignment they were converted with. Any previous
+  // mapping is released first, also when mapping `path` fails.
+  TfLiteStatus Map(const char* path, ErrorReporter* error_reporter);
+
+  // Releases the mapping. model() returns nullptr afterwards.
+  void Unmap();
+
+  // Returns the mapped model, or nullptr if nothing is mapped.
+  const Model* model() const {
+    return data_ != nullptr ? GetModel(data_) : nullptr;
+  }
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_TOOLS_MMAP_MODEL_MMAP_MODEL_H_
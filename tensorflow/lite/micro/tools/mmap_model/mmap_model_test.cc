@@ -0,0 +1,124 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/tools/mmap_model/mmap_model.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/examples/hello_world/hello_world_model_data.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace {
+
+constexpr size_t kTensorArenaSize = 2000;
+alignas(16) uint8_t tensor_arena[kTensorArenaSize];
+
+// Writes `size` bytes of `data` to a new temporary file whose path is stored
+// in `path`.
+bool WriteTempFile(const void* data, size_t size, char* path) {
+  strcpy(path, "/tmp/mmap_model_test_XXXXXX");
+  FILE* file = fdopen(mkstemp(path), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool written = fwrite(data, 1, size, file) == size;
+  fclose(file);
+  return written;
+}
+
+float RunModel(const tflite::Model* model, float x) {
+  tflite::AllOpsResolver op_resolver;
+  tflite::MicroInterpreter interpreter(model, op_resolver, tensor_arena,
+                                       kTensorArenaSize,
+                                       tflite::GetMicroErrorReporter());
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    return -1.0f;
+  }
+  interpreter.input(0)->data.f[0] = x;
+  if (interpreter.Invoke() != kTfLiteOk) {
+    return -1.0f;
+  }
+  return interpreter.output(0)->data.f[0];
+}
+
+}  // namespace
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(TestMappedModelMatchesCompiledModel) {
+  char path[64];
+  TF_LITE_MICRO_EXPECT(WriteTempFile(g_hello_world_model_data,
+                                     g_hello_world_model_data_size, path));
+
+  tflite::MmapModel mmap_model;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, mmap_model.Map(path, tflite::GetMicroErrorReporter()));
+  TF_LITE_MICRO_EXPECT_EQ(static_cast<size_t>(g_hello_world_model_data_size),
+                          mmap_model.size());
+  TF_LITE_MICRO_EXPECT(mmap_model.model() != nullptr);
+
+  const float mapped_y = RunModel(mmap_model.model(), 1.0f);
+  const float compiled_y =
+      RunModel(tflite::GetModel(g_hello_world_model_data), 1.0f);
+  TF_LITE_MICRO_EXPECT_EQ(compiled_y, mapped_y);
+
+  mmap_model.Unmap();
+  TF_LITE_MICRO_EXPECT(mmap_model.model() == nullptr);
+  remove(path);
+}
+
+TF_LITE_MICRO_TEST(TestMissingFileFails) {
+  tflite::MmapModel mmap_model;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteError, mmap_model.Map("/tmp/mmap_model_test_does_not_exist",
+                                   tflite::GetMicroErrorReporter()));
+  TF_LITE_MICRO_EXPECT(mmap_model.model() == nullptr);
+}
+
+TF_LITE_MICRO_TEST(TestFileThatIsNotAModelFails) {
+  const char text[] = "This is a text file and not a TfLite flatbuffer.";
+  char path[64];
+  TF_LITE_MICRO_EXPECT(WriteTempFile(text, sizeof(text), path));
+
+  tflite::MmapModel mmap_model;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteError, mmap_model.Map(path, tflite::GetMicroErrorReporter()));
+  TF_LITE_MICRO_EXPECT(mmap_model.model() == nullptr);
+  remove(path);
+}
+
+TF_LITE_MICRO_TEST(TestFailedMapReleasesPreviousModel) {
+  char path[64];
+  TF_LITE_MICRO_EXPECT(WriteTempFile(g_hello_world_model_data,
+                                     g_hello_world_model_data_size, path));
+  char empty_path[64];
+  TF_LITE_MICRO_EXPECT(WriteTempFile("", 0, empty_path));
+
+  tflite::MmapModel mmap_model;
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteOk, mmap_model.Map(path, tflite::GetMicroErrorReporter()));
+  TF_LITE_MICRO_EXPECT_EQ(
+      kTfLiteError,
+      mmap_model.Map(empty_path, tflite::GetMicroErrorReporter()));
+  TF_LITE_MICRO_EXPECT(mmap_model.model() == nullptr);
+  remove(path);
+  remove(empty_path);
+}
+
+TF_LITE_MICRO_TESTS_END